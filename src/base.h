@@ -43,6 +43,7 @@
 
 #define DEFAULT_DEBUG          0
 #define DEFAULT_POSIX_PARALLEL 0
+#define DEFAULT_POSIX_MMAP     0
 #define DEFAULT_ERROR_CHECKING 1
 
 /* ---------------------------------------------------------------- */
@@ -55,6 +56,10 @@
 #  define POSIX_PARALLEL DEFAULT_POSIX_PARALLEL
 #endif /* #ifndef POSIX_PARALLEL */
 
+#ifndef POSIX_MMAP
+#  define POSIX_MMAP DEFAULT_POSIX_MMAP
+#endif /* #ifndef POSIX_MMAP */
+
 /* Flag to check for programmer errors.             */
 /* This does not apply to errors of any other sort. */
 #ifndef ERROR_CHECKING
@@ -87,6 +92,18 @@
 #  define UNLESS_POSIX_PARALLEL(when_false, when_true)  when_false
 #endif /* #if POSIX_PARALLEL */
 
+#if POSIX_MMAP
+#  define WHEN_POSIX_MMAP(a)                        a
+#  define WHEN_NPOSIX_MMAP(a)
+#  define IF_POSIX_MMAP(    when_true,  when_false) when_true
+#  define UNLESS_POSIX_MMAP(when_false, when_true)  when_true
+#else  /* #if POSIX_MMAP */
+#  define WHEN_POSIX_MMAP(a)
+#  define WHEN_NPOSIX_MMAP(a)                       a
+#  define IF_POSIX_MMAP(    when_true,  when_false) when_false
+#  define UNLESS_POSIX_MMAP(when_false, when_true)  when_false
+#endif /* #if POSIX_MMAP */
+
 #if ERROR_CHECKING
 #  define WHEN_ERROR_CHECKING(a)                        a
 #  define WHEN_NERROR_CHECKING(a)
@@ -101,4 +118,41 @@
 
 /* ---------------------------------------------------------------- */
 
+/*
+ * Atomics.
+ *
+ * The few words shared between threads without a lock go through these, so
+ * that there is one place that knows how to order them:
+ *
+ *   ATOMIC_LOAD(p):           "*p", with acquire ordering.
+ *   ATOMIC_STORE(p, v):       "*p = v", with release ordering.
+ *   ATOMIC_CAS(p, old, new):  If "*p == old", "*p = new" and 1; otherwise 0.
+ *                             Full barrier.
+ *   ATOMIC_FENCE():           Full (sequentially consistent) barrier.
+ *
+ * Without POSIX_PARALLEL there is only one thread, and these are plain
+ * accesses.  With it, a compiler with GCC-style builtins is required.
+ */
+
+#if !POSIX_PARALLEL
+#  define ATOMIC_LOAD(p)          (*(p))
+#  define ATOMIC_STORE(p, v)      ((void) (*(p) = (v)))
+#  define ATOMIC_CAS(p, old, new) (*(p) == (old) ? (*(p) = (new), 1) : 0)
+#  define ATOMIC_FENCE()          ((void) 0)
+#elif defined(__ATOMIC_ACQUIRE)
+#  define ATOMIC_LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#  define ATOMIC_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#  define ATOMIC_CAS(p, old, new) __sync_bool_compare_and_swap((p), (old), (new))
+#  define ATOMIC_FENCE()          __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#elif defined(__GNUC__)
+#  define ATOMIC_LOAD(p)          __sync_fetch_and_add((p), 0)
+#  define ATOMIC_STORE(p, v)      ((void) (__sync_synchronize(), *(p) = (v)))
+#  define ATOMIC_CAS(p, old, new) __sync_bool_compare_and_swap((p), (old), (new))
+#  define ATOMIC_FENCE()          __sync_synchronize()
+#else
+#  error "POSIX_PARALLEL requires GCC-style atomic builtins."
+#endif
+
+/* ---------------------------------------------------------------- */
+
 #endif /* ifndef BASE_H */
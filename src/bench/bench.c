@@ -0,0 +1,143 @@
+/*
+ * opencurry: bench/bench.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/*
+ * stdio.h:
+ *  - fprintf
+ *  - printf
+ *  - stderr
+ */
+#include <stdio.h>
+
+/* string.h:
+ *   - strcmp
+ */
+#include <string.h>
+
+/* time.h:
+ *   - clock
+ *   - clock_gettime
+ */
+#include <time.h>
+
+#include "../base.h"
+#include "bench.h"
+
+#include "bench_thread_cache.h"
+#include "bench_memory_tracker.h"
+#include "bench_struct_info.h"
+
+/* ---------------------------------------------------------------- */
+
+bench_t *all_benches[] =
+  { &thread_cache_bench
+  , &memory_tracker_bench
+  , &struct_info_bench
+
+  , NULL
+  };
+
+int bench_all(int argc, char **argv)
+{
+  bench_t **bench;
+  int       status;
+  int       i;
+
+  status = 0;
+
+  if (argc <= 1)
+  {
+    for (bench = all_benches; *bench; ++bench)
+    {
+      printf("# %s: %s\n", (*bench)->name, (*bench)->description);
+      status |= (*bench)->run(argc, argv);
+    }
+
+    return status;
+  }
+
+  for (i = 1; i < argc; ++i)
+  {
+    for (bench = all_benches; *bench; ++bench)
+      if (strcmp((*bench)->name, argv[i]) == 0)
+        break;
+
+    if (!*bench)
+    {
+      fprintf(stderr, "bench_all: unknown benchmark: \"%s\"\n", argv[i]);
+      status |= 1;
+      continue;
+    }
+
+    printf("# %s: %s\n", (*bench)->name, (*bench)->description);
+    status |= (*bench)->run(argc, argv);
+  }
+
+  return status;
+}
+
+/* ---------------------------------------------------------------- */
+
+double bench_seconds(void)
+{
+#if POSIX_PARALLEL
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    return 0.0;
+
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#else  /* #if POSIX_PARALLEL */
+  return (double) clock() / (double) CLOCKS_PER_SEC;
+#endif /* #if POSIX_PARALLEL */
+}
+
+void bench_report(const char *name, const char *label, size_t ops, double seconds)
+{
+  if (seconds <= 0.0)
+    seconds = 1e-9;
+
+  printf
+    ( "%-24s %-32s %12.0f ops/s  (%lu ops in %.3f s)\n"
+    , name
+    , label
+    , (double) ops / seconds
+    , (unsigned long) ops
+    , seconds
+    );
+}
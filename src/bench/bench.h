@@ -0,0 +1,83 @@
+/*
+ * opencurry: bench/bench.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * bench/bench.h
+ * ------
+ *
+ * Microbenchmarks.
+ *
+ * Unlike the unit tests, benchmarks make no assertions; each one prints its
+ * timings to stdout and returns 0 on success.
+ */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+/* stddef.h:
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "../base.h"
+
+typedef int (*bench_fun_t)(int argc, char **argv);
+
+typedef struct bench_s bench_t;
+struct bench_s
+{
+  bench_fun_t  run;
+  const char  *name;
+  const char  *description;
+};
+
+/* NULL-terminated. */
+extern bench_t *all_benches[];
+
+/*
+ * Run the benchmarks named on the command line, or all of them if none are
+ * named.
+ */
+int bench_all(int argc, char **argv);
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Wall-clock seconds since an arbitrary point.
+ *
+ * Without POSIX_PARALLEL, this falls back to processor time.
+ */
+double bench_seconds(void);
+
+/* Print one result line: "<name>  <label>  <ops/s>". */
+void bench_report(const char *name, const char *label, size_t ops, double seconds);
+
+#endif /* ifndef BENCH_BENCH_H */
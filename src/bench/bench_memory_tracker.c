@@ -0,0 +1,118 @@
+/*
+ * opencurry: bench/bench_memory_tracker.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "../base.h"
+#include "bench.h"
+#include "bench_memory_tracker.h"
+
+#include "../type_base_memory_manager.h"
+#include "../type_base_memory_tracker.h"
+
+#include "../util.h"
+
+/* ---------------------------------------------------------------- */
+
+bench_t memory_tracker_bench =
+  {  bench_memory_tracker_run
+  , "memory_tracker"
+  , "Tracked allocation churn and teardown: lookup mode vs. intrusive mode."
+  };
+
+/* ---------------------------------------------------------------- */
+
+#define BENCH_MEMORY_TRACKER_SLOTS      4096
+#define BENCH_MEMORY_TRACKER_ITERATIONS 200000
+
+static void *slots[BENCH_MEMORY_TRACKER_SLOTS];
+
+/*
+ * Fill a working set of tracked blocks, repeatedly replace a pseudo-randomly
+ * chosen one, and then release whatever is left with "memory_tracker_free".
+ */
+static void bench_memory_tracker_with(const char *label, int intrusive)
+{
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+  char              row[64];
+  double            start;
+  double            churned;
+  double            end;
+  unsigned long     state;
+  size_t            i;
+
+  tracker = memory_tracker_init(&memory_tracker, &malloc_manager, NULL);
+  if (!tracker || !memory_tracker_set_intrusive(tracker, intrusive))
+    return;
+
+  start = bench_seconds();
+
+  for (i = 0; i < BENCH_MEMORY_TRACKER_SLOTS; ++i)
+    slots[i] = track_mmalloc(tracker, 32, NULL);
+
+  state = 42;
+  for (i = 0; i < BENCH_MEMORY_TRACKER_ITERATIONS; ++i)
+  {
+    size_t slot;
+
+    state = state * 1103515245UL + 12345UL;
+    slot  = (size_t) ((state >> 8) % BENCH_MEMORY_TRACKER_SLOTS);
+
+    track_mfree(tracker, slots[slot]);
+    slots[slot] = track_mmalloc(tracker, (size_t) ((state >> 16) % 256) + 1, NULL);
+  }
+
+  churned = bench_seconds();
+
+  memory_tracker_free(tracker);
+
+  end = bench_seconds();
+
+  snprintf(row, sizeof(row), "%s, churn", label);
+  bench_report("memory_tracker", row, BENCH_MEMORY_TRACKER_SLOTS + 2 * BENCH_MEMORY_TRACKER_ITERATIONS, churned - start);
+
+  snprintf(row, sizeof(row), "%s, memory_tracker_free", label);
+  bench_report("memory_tracker", row, BENCH_MEMORY_TRACKER_SLOTS, end - churned);
+}
+
+int bench_memory_tracker_run(int argc, char **argv)
+{
+  bench_memory_tracker_with("lookup",    FALSE());
+  bench_memory_tracker_with("intrusive", TRUE());
+
+  return 0;
+}
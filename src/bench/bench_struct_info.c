@@ -0,0 +1,159 @@
+/*
+ * opencurry: bench/bench_struct_info.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* stdio.h:
+ *   - printf
+ */
+#include <stdio.h>
+
+#include "../base.h"
+#include "bench.h"
+#include "bench_struct_info.h"
+
+#include "../type_base.h"
+
+#include "../util.h"
+
+/* ---------------------------------------------------------------- */
+
+bench_t struct_info_bench =
+  {  bench_struct_info_run
+  , "struct_info"
+  , "Iterating the fields of described structs."
+  };
+
+/* ---------------------------------------------------------------- */
+
+#define BENCH_STRUCT_INFO_ITERATIONS 1000000
+
+static void *bench_struct_info_count_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  size_t *count;
+
+  count = last_accumulation;
+  *count += field_info->field_size;
+
+  return count;
+}
+
+/* Copy and compare a struct with many plain fields. */
+static void bench_struct_info_dup_cmp(void)
+{
+  const struct_info_t *struct_info;
+  memory_tracker_t     src;
+  memory_tracker_t     dest;
+  int                  differences;
+  size_t               i;
+  double               start;
+  double               end;
+
+  struct_info = type_is_struct(memory_tracker_type());
+
+  src  = memory_tracker_defaults;
+  dest = memory_tracker_defaults;
+
+  start = bench_seconds();
+
+  for (i = 0; i < BENCH_STRUCT_INFO_ITERATIONS; ++i)
+  {
+    src.journal_num = i;
+    struct_dup(struct_info, &dest, &src, 1, 0, 0, NULL);
+  }
+
+  end = bench_seconds();
+
+  bench_report("struct_info", "struct_dup memory_tracker_t", BENCH_STRUCT_INFO_ITERATIONS, end - start);
+
+  differences = 0;
+  start       = bench_seconds();
+
+  for (i = 0; i < BENCH_STRUCT_INFO_ITERATIONS; ++i)
+  {
+    if (struct_cmp(struct_info, &dest, &src, 0, NULL) != 0)
+      ++differences;
+  }
+
+  end = bench_seconds();
+
+  bench_report("struct_info", "struct_cmp memory_tracker_t", BENCH_STRUCT_INFO_ITERATIONS, end - start);
+
+  if (differences)
+    printf("struct_info  struct_cmp found %d differences\n", differences);
+}
+
+int bench_struct_info_run(int argc, char **argv)
+{
+  const type_t *(*types[4])(void);
+  size_t          fields;
+  size_t          sum;
+  size_t          i;
+  size_t          j;
+  double          start;
+  double          end;
+
+  types[0] = memory_tracker_type;
+  types[1] = memory_manager_type;
+  types[2] = template_cons_type;
+  types[3] = struct_info_type;
+
+  fields = 0;
+  for (j = 0; j < ARRAY_NUM(types); ++j)
+    fields += struct_info_num_fields(type_is_struct(types[j]()));
+
+  printf("struct_info  sizeof(struct_info_t) = %d, fields described = %d\n", (int) sizeof(struct_info_t), (int) fields);
+
+  sum   = 0;
+  start = bench_seconds();
+
+  for (i = 0; i < BENCH_STRUCT_INFO_ITERATIONS; ++i)
+  {
+    const struct_info_t *struct_info;
+
+    struct_info = type_is_struct(types[i % ARRAY_NUM(types)]());
+
+    struct_info_iterate_fields(struct_info, bench_struct_info_count_field, NULL, &sum);
+  }
+
+  end = bench_seconds();
+
+  bench_report("struct_info", "iterate_fields", BENCH_STRUCT_INFO_ITERATIONS, end - start);
+
+  bench_struct_info_dup_cmp();
+
+  return sum == 0;
+}
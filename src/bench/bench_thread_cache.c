@@ -0,0 +1,178 @@
+/*
+ * opencurry: bench/bench_thread_cache.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "../base.h"
+#include "bench.h"
+#include "bench_thread_cache.h"
+
+#include "../type_base_memory_manager.h"
+#include "../type_base_thread_cache.h"
+
+#include "../util.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_create
+ *   - pthread_join
+ *   - pthread_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+
+bench_t thread_cache_bench =
+  {  bench_thread_cache_run
+  , "thread_cache"
+  , "Multi-threaded small allocation churn: malloc_manager vs. thread_cache_manager."
+  };
+
+/* ---------------------------------------------------------------- */
+
+#define BENCH_THREAD_CACHE_MAX_THREADS 8
+#define BENCH_THREAD_CACHE_SLOTS       64
+#define BENCH_THREAD_CACHE_ITERATIONS  1000000
+
+typedef struct bench_thread_cache_worker_s bench_thread_cache_worker_t;
+struct bench_thread_cache_worker_s
+{
+  const memory_manager_t *manager;
+  unsigned long           seed;
+  size_t                  ops;
+};
+
+/*
+ * Each worker keeps a small working set of live blocks, and repeatedly
+ * replaces a pseudo-randomly chosen one with a block of a different size.
+ */
+static void *bench_thread_cache_worker(void *worker_raw)
+{
+  bench_thread_cache_worker_t *worker = worker_raw;
+  void                        *slots[BENCH_THREAD_CACHE_SLOTS];
+  unsigned long                state;
+  size_t                       i;
+
+  for (i = 0; i < BENCH_THREAD_CACHE_SLOTS; ++i)
+    slots[i] = NULL;
+
+  state = worker->seed;
+  for (i = 0; i < BENCH_THREAD_CACHE_ITERATIONS; ++i)
+  {
+    size_t slot;
+    size_t size;
+
+    state = state * 1103515245UL + 12345UL;
+
+    slot = (size_t) ((state >> 8)  % BENCH_THREAD_CACHE_SLOTS);
+    size = (size_t) ((state >> 16) % 512) + 1;
+
+    if (slots[slot])
+      memory_manager_mfree(worker->manager, slots[slot]);
+
+    slots[slot] = memory_manager_mmalloc(worker->manager, size);
+    if (slots[slot])
+      *((char *) slots[slot]) = (char) i;
+  }
+
+  for (i = 0; i < BENCH_THREAD_CACHE_SLOTS; ++i)
+    if (slots[i])
+      memory_manager_mfree(worker->manager, slots[i]);
+
+  worker->ops = 2 * BENCH_THREAD_CACHE_ITERATIONS;
+
+  return worker;
+}
+
+static void bench_thread_cache_with(const char *label, const memory_manager_t *manager, size_t num_threads)
+{
+  bench_thread_cache_worker_t workers[BENCH_THREAD_CACHE_MAX_THREADS];
+  char                        row[64];
+  double                      start;
+  double                      end;
+  size_t                      ops;
+  size_t                      i;
+
+#if POSIX_PARALLEL
+  pthread_t threads[BENCH_THREAD_CACHE_MAX_THREADS];
+#endif /* #if POSIX_PARALLEL */
+
+  for (i = 0; i < num_threads; ++i)
+  {
+    workers[i].manager = manager;
+    workers[i].seed    = 42 + (unsigned long) i;
+    workers[i].ops     = 0;
+  }
+
+  start = bench_seconds();
+
+#if POSIX_PARALLEL
+  for (i = 0; i < num_threads; ++i)
+    pthread_create(&threads[i], NULL, bench_thread_cache_worker, &workers[i]);
+  for (i = 0; i < num_threads; ++i)
+    pthread_join(threads[i], NULL);
+#else  /* #if POSIX_PARALLEL */
+  for (i = 0; i < num_threads; ++i)
+    bench_thread_cache_worker(&workers[i]);
+#endif /* #if POSIX_PARALLEL */
+
+  end = bench_seconds();
+
+  ops = 0;
+  for (i = 0; i < num_threads; ++i)
+    ops += workers[i].ops;
+
+  snprintf(row, sizeof(row), "%s, %lu thread(s)", label, (unsigned long) num_threads);
+  bench_report("thread_cache", row, ops, end - start);
+}
+
+int bench_thread_cache_run(int argc, char **argv)
+{
+  size_t num_threads;
+
+  for
+    ( num_threads = 1
+    ; num_threads <= IF_POSIX_PARALLEL(BENCH_THREAD_CACHE_MAX_THREADS, 1)
+    ; num_threads *= 2
+    )
+  {
+    bench_thread_cache_with("malloc_manager",       &malloc_manager,       num_threads);
+    bench_thread_cache_with("thread_cache_manager", &thread_cache_manager, num_threads);
+  }
+
+  return 0;
+}
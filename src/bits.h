@@ -39,6 +39,12 @@
 #define BITS_H
 #include "base.h"
 
+/* limits.h:
+ *   - INT_MAX
+ *   - INT_MIN
+ */
+#include <limits.h>
+
 /*
  * We use an extra pair of parentheses around arguments and around macro
  * invocations to handle more argument expressions.
@@ -276,12 +282,19 @@ long sign_long(long num);
  * CMP with distance.
  *
  * CMP(check, baseline) * DISTANCE(check, baseline), except if the sign of the
- * result differs from CMP(check, baseline), just return -1, 0, or 1 of the
- * corresponding sign.
+ * result differs from CMP(check, baseline), or the distance doesn't fit in an
+ * "int", just return -1, 0, or 1 of the corresponding sign.
+ *
+ * (Otherwise e.g. two pointers differing only in their upper bits would
+ * compare equal once the result is narrowed to an "int".)
  */
 #define CMP_DISTANCE(check, baseline)                                         \
   ( (  ( SIGN(     ((signed long) (check)) - ((signed long) (baseline)) ) )   \
     == ( SIGN((CMP(               (check),                  (baseline)))) )   \
+    && (           ((signed long) (check)) - ((signed long) (baseline))   )   \
+    >= ((signed long) (INT_MIN))                                              \
+    && (           ((signed long) (check)) - ((signed long) (baseline))   )   \
+    <= ((signed long) (INT_MAX))                                              \
     )                                                                         \
   ? (  (           ((signed long) (check)) - ((signed long) (baseline))   ) ) \
   : (  (      (CMP(               (check),                  (baseline)))  ) ) \
@@ -30,7 +30,578 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* string.h:
+ *   - memcpy
+ *   - memset
+ */
+#include <string.h>
+
 #include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_mutex_destroy
+ *   - pthread_mutex_init
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_t
+ *   - pthread_mutex_unlock
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
 #include "mempool.h"
 
-void mempool_placeholder(void) { }
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_memory_manager.h"
+#include "type_base_memory_tracker.h"
+#include "type_base_type.h"
+
+#include "bits.h"
+
+/* ---------------------------------------------------------------- */
+/* mempool_t                                                        */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Each chunk starts with a header; the union keeps the blocks that follow it
+ * suitably aligned for any object, and block sizes are rounded up to a
+ * multiple of the same alignment.
+ */
+typedef union mempool_chunk_u mempool_chunk_t;
+union mempool_chunk_u
+{
+  struct
+  {
+    mempool_chunk_t *next;
+    size_t           size;
+  } info;
+
+  void        *align_ptr;
+  long         align_long;
+  long double  align_ldouble;
+};
+
+#define MEMPOOL_ALIGNMENT (sizeof(mempool_chunk_t))
+
+#define MEMPOOL_CHUNK_BLOCKS(chunk) \
+  ((char *) (((mempool_chunk_t *) (chunk)) + 1))
+
+#if POSIX_PARALLEL
+#  define MEMPOOL_LOCK(pool)   pthread_mutex_lock  (&(pool)->lock)
+#  define MEMPOOL_UNLOCK(pool) pthread_mutex_unlock(&(pool)->lock)
+#else  /* #if POSIX_PARALLEL */
+#  define MEMPOOL_LOCK(pool)
+#  define MEMPOOL_UNLOCK(pool)
+#endif /* #if POSIX_PARALLEL */
+
+mempool_t *mempool_init(mempool_t *pool, const memory_manager_t *inner, size_t object_size)
+{
+  size_t block_size;
+
+#if ERROR_CHECKING
+  if (!pool)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  /* Every block must at least hold the free list link. */
+  block_size = object_size;
+  if (block_size < sizeof(void *))
+    block_size = sizeof(void *);
+
+  if (block_size > ((size_t) (-1)) - MEMPOOL_ALIGNMENT)
+    return NULL;
+
+  block_size = (block_size + MEMPOOL_ALIGNMENT - 1) / MEMPOOL_ALIGNMENT * MEMPOOL_ALIGNMENT;
+
+  pool->inner             = require_memory_manager(inner);
+  pool->object_size       = object_size;
+  pool->block_size        = block_size;
+  pool->free_list         = NULL;
+  pool->free_num          = 0;
+  pool->chunks            = NULL;
+  pool->chunks_num        = 0;
+  pool->next_chunk_blocks = MEMPOOL_MIN_CHUNK_BLOCKS;
+  pool->carve             = NULL;
+  pool->carve_end         = NULL;
+  pool->live_num          = 0;
+
+  /* The table relies on "mcalloc" zeroing. */
+  hash_table_init(&pool->forwarded, NULL, 0, pool->inner->mcalloc ? pool->inner : &malloc_manager);
+
+#if POSIX_PARALLEL
+  if (pthread_mutex_init(&pool->lock, NULL) != 0)
+    return NULL;
+#endif /* #if POSIX_PARALLEL */
+
+  pool->initialized = 1;
+
+  return pool;
+}
+
+size_t mempool_deinit(mempool_t *pool)
+{
+  size_t           num_freed;
+  mempool_chunk_t *chunk;
+  mempool_chunk_t *next;
+
+#if ERROR_CHECKING
+  if (!pool)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (!pool->initialized)
+    return 0;
+
+  num_freed = 0;
+
+  for (chunk = pool->chunks; chunk; chunk = next)
+  {
+    next = chunk->info.next;
+
+    memory_manager_mfree(pool->inner, chunk);
+    ++num_freed;
+  }
+
+  {
+    size_t      cursor;
+    const tval *forwarded;
+
+    cursor = 0;
+    while (hash_table_next(&pool->forwarded, &cursor, &forwarded, NULL))
+    {
+      memory_manager_mfree(pool->inner, (void *) forwarded);
+      ++num_freed;
+    }
+
+    hash_table_deinit(&pool->forwarded);
+  }
+
+  pool->free_list  = NULL;
+  pool->free_num   = 0;
+  pool->chunks     = NULL;
+  pool->chunks_num = 0;
+  pool->carve      = NULL;
+  pool->carve_end  = NULL;
+  pool->live_num   = 0;
+
+#if POSIX_PARALLEL
+  pthread_mutex_destroy(&pool->lock);
+#endif /* #if POSIX_PARALLEL */
+
+  pool->initialized = 0;
+
+  return num_freed;
+}
+
+/* Obtain a new chunk, twice as large as the last, to carve blocks from. */
+static int mempool_refill(mempool_t *pool)
+{
+  size_t           blocks;
+  size_t           size;
+  mempool_chunk_t *chunk;
+
+  blocks = pool->next_chunk_blocks;
+
+  if (blocks > (((size_t) (-1)) - sizeof(mempool_chunk_t)) / pool->block_size)
+    return 0;
+
+  size  = sizeof(mempool_chunk_t) + blocks * pool->block_size;
+  chunk = memory_manager_mmalloc(pool->inner, size);
+  if (!chunk)
+    return 0;
+
+  chunk->info.next = pool->chunks;
+  chunk->info.size = size;
+
+  pool->chunks = chunk;
+  ++pool->chunks_num;
+
+  pool->carve     = MEMPOOL_CHUNK_BLOCKS(chunk);
+  pool->carve_end = pool->carve + blocks * pool->block_size;
+
+  if (2 * blocks > blocks)
+    pool->next_chunk_blocks = 2 * blocks;
+
+  return 1;
+}
+
+void *mempool_malloc(mempool_t *pool)
+{
+  void *block;
+
+#if ERROR_CHECKING
+  if (!pool || !pool->initialized)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  MEMPOOL_LOCK(pool);
+
+  block = pool->free_list;
+  if (block)
+  {
+    pool->free_list = *(void **) block;
+    --pool->free_num;
+  }
+  else
+  {
+    if (pool->carve == pool->carve_end && !mempool_refill(pool))
+    {
+      MEMPOOL_UNLOCK(pool);
+      return NULL;
+    }
+
+    block        = pool->carve;
+    pool->carve += pool->block_size;
+  }
+
+  ++pool->live_num;
+
+  MEMPOOL_UNLOCK(pool);
+
+  return block;
+}
+
+/* Find the chunk holding "ptr".  The newest chunks are the largest. */
+static mempool_chunk_t *mempool_find_chunk(const mempool_t *pool, const void *ptr)
+{
+  mempool_chunk_t *chunk;
+  const char      *byte = ptr;
+
+  for (chunk = pool->chunks; chunk; chunk = chunk->info.next)
+  {
+    const char *begin = MEMPOOL_CHUNK_BLOCKS(chunk);
+    const char *end   = ((const char *) chunk) + chunk->info.size;
+
+    if (byte >= begin && byte < end)
+      return chunk;
+  }
+
+  return NULL;
+}
+
+size_t mempool_free(mempool_t *pool, void *ptr)
+{
+#if ERROR_CHECKING
+  if (!pool || !pool->initialized)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (!ptr)
+    return 0;
+
+  MEMPOOL_LOCK(pool);
+
+#if ERROR_CHECKING
+  if (!mempool_find_chunk(pool, ptr))
+  {
+    MEMPOOL_UNLOCK(pool);
+    return 0;
+  }
+#endif /* #if ERROR_CHECKING */
+
+  *(void **) ptr  = pool->free_list;
+  pool->free_list = ptr;
+  ++pool->free_num;
+
+  --pool->live_num;
+
+  MEMPOOL_UNLOCK(pool);
+
+  return 1;
+}
+
+int mempool_owns(mempool_t *pool, const void *ptr)
+{
+  int owns;
+
+#if ERROR_CHECKING
+  if (!pool)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (!ptr || !pool->initialized)
+    return 0;
+
+  MEMPOOL_LOCK(pool);
+  owns = mempool_find_chunk(pool, ptr) != NULL;
+  MEMPOOL_UNLOCK(pool);
+
+  return owns;
+}
+
+int mempool_forwarded(mempool_t *pool, const void *ptr)
+{
+  int forwarded;
+
+#if ERROR_CHECKING
+  if (!pool)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (!ptr || !pool->initialized)
+    return 0;
+
+  MEMPOOL_LOCK(pool);
+  forwarded = hash_table_contains(&pool->forwarded, ptr);
+  MEMPOOL_UNLOCK(pool);
+
+  return forwarded;
+}
+
+size_t mempool_live_num(const mempool_t *pool)
+{
+#if ERROR_CHECKING
+  if (!pool)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  return pool->live_num;
+}
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+/* Record "ptr", from "inner", as forwarded; frees it and returns NULL on failure. */
+static void *mempool_forward(mempool_t *pool, void *ptr)
+{
+  void **value;
+
+  if (!ptr)
+    return NULL;
+
+  MEMPOOL_LOCK(pool);
+  value = hash_table_insert(&pool->forwarded, ptr, NULL);
+  MEMPOOL_UNLOCK(pool);
+
+  if (!value)
+  {
+    memory_manager_mfree(pool->inner, ptr);
+    return NULL;
+  }
+
+  return ptr;
+}
+
+/* Forget "ptr", returning whether it was forwarded. */
+static int mempool_unforward(mempool_t *pool, const void *ptr)
+{
+  int removed;
+
+  MEMPOOL_LOCK(pool);
+  removed = hash_table_remove(&pool->forwarded, ptr, NULL);
+  MEMPOOL_UNLOCK(pool);
+
+  return removed;
+}
+
+static void *mempool_manager_mmalloc(const memory_manager_t *self, size_t size)
+{
+  mempool_t *pool = self->state;
+
+  if (size > pool->block_size)
+    return mempool_forward(pool, memory_manager_mmalloc(pool->inner, size));
+
+  return mempool_malloc(pool);
+}
+
+static size_t mempool_manager_mfree(const memory_manager_t *self, void *ptr)
+{
+  mempool_t *pool = self->state;
+
+  if (!ptr)
+    return 0;
+
+  if (!mempool_owns(pool, ptr))
+  {
+    mempool_unforward(pool, ptr);
+    return memory_manager_mfree(pool->inner, ptr);
+  }
+
+  return mempool_free(pool, ptr);
+}
+
+static void *mempool_manager_mrealloc(const memory_manager_t *self, void *ptr, size_t size)
+{
+  mempool_t *pool = self->state;
+  void      *moved;
+
+  if (!ptr)
+    return mempool_manager_mmalloc(self, size);
+
+  if (!mempool_owns(pool, ptr))
+  {
+    if (!mempool_forwarded(pool, ptr))
+      return memory_manager_mrealloc(pool->inner, ptr, size);
+
+    moved = memory_manager_mrealloc(pool->inner, ptr, size);
+    if (!moved)
+      return NULL;
+
+    if (moved != ptr)
+    {
+      mempool_unforward(pool, ptr);
+      moved = mempool_forward(pool, moved);
+    }
+
+    return moved;
+  }
+
+  /* Blocks are fixed-size. */
+  if (size <= pool->block_size)
+    return ptr;
+
+  moved = mempool_forward(pool, memory_manager_mmalloc(pool->inner, size));
+  if (!moved)
+    return NULL;
+
+  memcpy(moved, ptr, pool->block_size);
+  mempool_free(pool, ptr);
+
+  return moved;
+}
+
+static void *mempool_manager_mcalloc(const memory_manager_t *self, size_t nmemb, size_t size)
+{
+  mempool_t *pool = self->state;
+  void      *block;
+
+  if (size && nmemb > ((size_t) (-1)) / size)
+    return NULL;
+
+  if (nmemb * size > pool->block_size)
+    return mempool_forward(pool, memory_manager_mcalloc(pool->inner, nmemb, size));
+
+  block = mempool_malloc(pool);
+  if (block)
+    memset(block, 0, nmemb * size);
+
+  return block;
+}
+
+memory_manager_t *mempool_manager_init(memory_manager_t *dest, mempool_t *pool)
+{
+#if ERROR_CHECKING
+  if (!pool || !pool->initialized)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  dest =
+    memory_manager_init
+      ( dest
+
+      , mempool_manager_mmalloc
+      , mempool_manager_mfree
+      , mempool_manager_mrealloc
+      , mempool_manager_mcalloc
+      );
+  if (!dest)
+    return NULL;
+
+  dest->state      = (void *) pool;
+  dest->state_size = sizeof(mempool_t);
+
+  return dest;
+}
+
+/* ---------------------------------------------------------------- */
+/* type_pool_t                                                      */
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+static pthread_mutex_t type_pool_init_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* #if POSIX_PARALLEL */
+
+type_pool_t *type_pool_require(type_pool_t *type_pool, const type_t *type)
+{
+#if ERROR_CHECKING
+  if (!type_pool || !type)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  /* Pairs with the release below, so that the pool is seen set up. */
+  if (ATOMIC_LOAD(&type_pool->initialized))
+    return type_pool;
+
+#if POSIX_PARALLEL
+  pthread_mutex_lock(&type_pool_init_lock);
+#endif /* #if POSIX_PARALLEL */
+
+  if (!type_pool->initialized)
+  {
+    if
+      (  mempool_init(&type_pool->pool, &malloc_manager, type_size(type, NULL))
+      && mempool_manager_init(&type_pool->manager, &type_pool->pool)
+      )
+    {
+      ATOMIC_STORE(&type_pool->initialized, 1);
+    }
+  }
+
+#if POSIX_PARALLEL
+  pthread_mutex_unlock(&type_pool_init_lock);
+#endif /* #if POSIX_PARALLEL */
+
+  if (!ATOMIC_LOAD(&type_pool->initialized))
+    return NULL;
+
+  return type_pool;
+}
+
+/* Pooled values are owned by the pool, not by a memory tracker. */
+memory_tracker_t *type_pool_mem(const type_t *self, type_pool_t *type_pool, tval *val_raw)
+{
+  return NULL;
+}
+
+void *type_pool_mem_init(const type_t *self, type_pool_t *type_pool, tval *val_raw, int is_dynamically_allocated)
+{
+  return type_pool_require(type_pool, self);
+}
+
+int type_pool_mem_is_dyn(const type_t *self, type_pool_t *type_pool, tval *val)
+{
+  if (!type_pool_require(type_pool, self))
+    return -1;
+
+  if (mempool_owns(&type_pool->pool, val) || mempool_forwarded(&type_pool->pool, val))
+    return TRUE();
+
+  return FALSE();
+}
+
+int type_pool_mem_free(const type_t *self, type_pool_t *type_pool, tval *val)
+{
+  if (!type_pool_require(type_pool, self))
+    return -1;
+
+  if (!val)
+    return -3;
+
+  /* Arrays were too large for a block, and came from the inner manager. */
+  if (!mempool_owns(&type_pool->pool, val))
+  {
+    if (!mempool_unforward(&type_pool->pool, val))
+      return 0;
+
+    memory_manager_mfree(type_pool->pool.inner, val);
+    return 1;
+  }
+
+  return (int) mempool_free(&type_pool->pool, val);
+}
+
+const memory_manager_t *type_pool_default_memory_manager(const type_t *self, type_pool_t *type_pool, tval *val)
+{
+  if (!type_pool_require(type_pool, self))
+    return NULL;
+
+  return &type_pool->manager;
+}
@@ -33,11 +33,202 @@
 /*
  * mempool.h
  * ------
+ *
+ * Fixed-size object pools.
+ *
+ * A pool hands out blocks of a single size from chunks obtained from an inner
+ * memory manager.  Freed blocks go onto a free list and are handed out again
+ * before any fresh block is carved; each new chunk is twice the size of the
+ * last, so a pool holds few chunks, and blocks carved from a chunk are
+ * adjacent in memory.
+ *
+ * A pool can also back a "memory_manager_t", and, through "type_pool_t",
+ * every dynamically allocated value of a type.
  */
 
-
 #ifndef MEMPOOL_H
 #define MEMPOOL_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
 #include "base.h"
 
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_mutex_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_memory_manager.h"
+#include "type_base_memory_tracker.h"
+#include "type_base_hash_table.h"
+
+#include "util.h"
+
+/* ---------------------------------------------------------------- */
+/* mempool_t                                                        */
+/* ---------------------------------------------------------------- */
+
+/* Number of blocks in a pool's first chunk. */
+#define MEMPOOL_MIN_CHUNK_BLOCKS 32
+
+typedef struct mempool_s mempool_t;
+struct mempool_s
+{
+  /* Where chunks come from. */
+  const memory_manager_t *inner;
+
+  /* Requested object size, and the size of each block after alignment. */
+  size_t object_size;
+  size_t block_size;
+
+  /* Freed blocks, linked through their first word. */
+  void   *free_list;
+  size_t  free_num;
+
+  /* Chunks, newest first, linked through their headers. */
+  void   *chunks;
+  size_t  chunks_num;
+
+  /* Number of blocks in the next chunk. */
+  size_t  next_chunk_blocks;
+
+  /* The uncarved remainder of the newest chunk. */
+  char   *carve;
+  char   *carve_end;
+
+  /* Blocks currently handed out. */
+  size_t  live_num;
+
+  /* Requests too large for a block, that the memory manager front-end */
+  /* forwarded to "inner".                                             */
+  hash_table_t forwarded;
+
+#if POSIX_PARALLEL
+  pthread_mutex_t lock;
+#endif /* #if POSIX_PARALLEL */
+
+  int initialized;
+};
+
+/* ---------------------------------------------------------------- */
+
+/* If "inner" is NULL, "default_memory_manager" is used. */
+mempool_t *mempool_init(mempool_t *pool, const memory_manager_t *inner, size_t object_size);
+
+/*
+ * Release every chunk back to the inner manager, invalidating every block.
+ * Forwarded requests that are still live are freed too.
+ *
+ * Returns the number of chunks and forwarded requests freed.
+ */
+size_t mempool_deinit(mempool_t *pool);
+
+void   *mempool_malloc(mempool_t *pool);
+
+/* Returns 1 if "ptr" was a block of "pool", and 0 otherwise. */
+size_t  mempool_free  (mempool_t *pool, void *ptr);
+
+/* Is "ptr" inside one of the pool's chunks? */
+int     mempool_owns  (mempool_t *pool, const void *ptr);
+
+/* Did the memory manager front-end forward "ptr" to the inner manager? */
+int     mempool_forwarded(mempool_t *pool, const void *ptr);
+
+size_t  mempool_live_num(const mempool_t *pool);
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Initialize a memory manager that allocates from "pool".
+ *
+ * Requests that fit in a block are served by the pool; larger ones, such as
+ * arrays, are forwarded to the pool's inner manager and recorded, so that
+ * "mempool_forwarded" knows them.  "mfree" tells the two apart by address,
+ * and passes any other pointer to the inner manager.
+ */
+memory_manager_t *mempool_manager_init(memory_manager_t *dest, mempool_t *pool);
+
+/* ---------------------------------------------------------------- */
+/* type_pool_t                                                      */
+/* ---------------------------------------------------------------- */
+
+/*
+ * A pool for every dynamically allocated value of a type.
+ *
+ * Values are owned by the pool rather than recorded in a memory tracker, so
+ * "type_init" and "type_free" on a pooled type amount to popping and pushing
+ * the free list.  Arrays don't fit in a block; they are forwarded to the
+ * inner manager, and freed back to it.
+ *
+ * A "type_pool_t" should be zero-initialized, e.g. with static storage; it is
+ * set up on first use, with its block size taken from "type_size".
+ *
+ * A type opts in by assigning its "mem", "mem_init", "mem_is_dyn",
+ * "mem_free", and "default_memory_manager" methods to the functions that
+ * "DEF_TYPE_POOL" defines:
+ *
+ * > DEF_TYPE_POOL(mytype)
+ * >
+ * > const type_t mytype_def =
+ * >   { type_type
+ * >
+ * >   , /-* ...                    *-/ ...
+ * >   , /-* mem                    *-/ mytype_pool_mem
+ * >   , /-* mem_init               *-/ mytype_pool_mem_init
+ * >   , /-* mem_is_dyn             *-/ mytype_pool_mem_is_dyn
+ * >   , /-* mem_free               *-/ mytype_pool_mem_free
+ * >   , /-* default_memory_manager *-/ mytype_pool_default_memory_manager
+ * >   , /-* ...                    *-/ ...
+ * >   };
+ */
+typedef struct type_pool_s type_pool_t;
+struct type_pool_s
+{
+  mempool_t        pool;
+  memory_manager_t manager;
+
+  int initialized;
+};
+
+/* Set up "type_pool" for "type" if needed; returns NULL on failure. */
+type_pool_t *type_pool_require(type_pool_t *type_pool, const type_t *type);
+
+memory_tracker_t       *type_pool_mem                   (const type_t *self, type_pool_t *type_pool, tval *val_raw);
+void                   *type_pool_mem_init              (const type_t *self, type_pool_t *type_pool, tval *val_raw, int is_dynamically_allocated);
+int                     type_pool_mem_is_dyn            (const type_t *self, type_pool_t *type_pool, tval *val);
+int                     type_pool_mem_free              (const type_t *self, type_pool_t *type_pool, tval *val);
+const memory_manager_t *type_pool_default_memory_manager(const type_t *self, type_pool_t *type_pool, tval *val);
+
+#define DEF_TYPE_POOL(type_name)                                                      \
+  static type_pool_t CAT(type_name, _pool);                                           \
+                                                                                      \
+  static memory_tracker_t *CAT(type_name, _pool_mem)                                  \
+    (const type_t *self, tval *val_raw)                                               \
+    { return type_pool_mem(self, &CAT(type_name, _pool), val_raw); }                  \
+  static void *CAT(type_name, _pool_mem_init)                                         \
+    (const type_t *self, tval *val_raw, int is_dynamically_allocated)                 \
+    { return type_pool_mem_init(self, &CAT(type_name, _pool), val_raw, is_dynamically_allocated); } \
+  static int CAT(type_name, _pool_mem_is_dyn)                                         \
+    (const type_t *self, tval *val)                                                   \
+    { return type_pool_mem_is_dyn(self, &CAT(type_name, _pool), val); }               \
+  static int CAT(type_name, _pool_mem_free)                                           \
+    (const type_t *self, tval *val)                                                   \
+    { return type_pool_mem_free(self, &CAT(type_name, _pool), val); }                 \
+  static const memory_manager_t *CAT(type_name, _pool_default_memory_manager)         \
+    (const type_t *self, tval *val)                                                   \
+    { return type_pool_default_memory_manager(self, &CAT(type_name, _pool), val); }
+
 #endif /* ifndef MEMPOOL_H */
@@ -56,8 +56,15 @@
 #include "test_type_base_compare.h"
 #include "test_type_base_vector.h"
 #include "test_type_base_memory_manager.h"
+#include "test_type_base_thread_cache.h"
+#include "test_type_base_mmap_manager.h"
 #include "test_type_base_lookup.h"
+#include "test_type_base_epoch.h"
 #include "test_type_base_memory_tracker.h"
+#include "test_type_base_memory_stats.h"
+#include "test_type_base_hash_table.h"
+#include "test_type_base_serialize.h"
+#include "test_type_base_registry.h"
 #include "test_type_base_universal.h"
 #include "test_type_base_c.h"
 #include "test_type_base_cast.h"
@@ -113,8 +120,15 @@ unit_test_t *all_tests[] =
   , &type_base_compare_test
   , &type_base_vector_test
   , &type_base_memory_manager_test
+  , &type_base_thread_cache_test
+  , &type_base_mmap_manager_test
   , &type_base_lookup_test
+  , &type_base_epoch_test
   , &type_base_memory_tracker_test
+  , &type_base_memory_stats_test
+  , &type_base_hash_table_test
+  , &type_base_serialize_test
+  , &type_base_registry_test
   , &type_base_universal_test
   , &type_base_c_test
   , &type_base_cast_test
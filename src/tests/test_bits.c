@@ -299,6 +299,10 @@ unit_test_result_t bits_consistency_test_run(unit_test_context_t *context)
     TASSERT2( inteq, "cmp_distance  7  2", (int) cmp_distance_int( 7,  2), (int) CMP_DISTANCE( 7,  2) );
     TASSERT2( inteq, "cmp_distance  7  7", (int) cmp_distance_int( 7,  7), (int) CMP_DISTANCE( 7,  7) );
 
+    /* Distances that don't fit in an "int" still keep their sign. */
+    TASSERT2( inteq, "cmp_distance high bits  1", (int) SIGN(cmp_distance_ulong(3UL << (4 * sizeof(long)), 2UL << (4 * sizeof(long)))),  1 );
+    TASSERT2( inteq, "cmp_distance high bits -1", (int) SIGN(cmp_distance_ulong(2UL << (4 * sizeof(long)), 3UL << (4 * sizeof(long)))), -1 );
+
     /* ---------------------------------------------------------------- */
 
     TASSERT2( inteq, "sign of 9:        8 -1 7", (int) sign_case_int(9,        8, -1, 7), (int) SIGN_CASE(9,        8, -1, 7) );
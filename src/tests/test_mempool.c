@@ -30,12 +30,23 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/* stdlib.h:
+ *   - div_t
+ */
+#include <stdlib.h>
+
 #include "../base.h"
 #include "testing.h"
 #include "test_mempool.h"
 
 #include "../mempool.h"
 
+#include "../type_base_prim.h"
+#include "../type_base_typed.h"
+#include "../type_base_memory_manager.h"
+#include "../type_base_type.h"
+#include "../type_base_ext.h"
+
 int test_mempool_cli(int argc, char **argv)
 {
   return run_test_suite(mempool_test);
@@ -52,7 +63,11 @@ unit_test_t mempool_test =
 
 /* Array of mempool tests. */
 unit_test_t *mempool_tests[] =
-  { NULL
+  { &mempool_blocks_test
+  , &mempool_manager_test
+  , &type_pool_test
+
+  , NULL
   };
 
 unit_test_result_t test_mempool_run(unit_test_context_t *context)
@@ -62,3 +77,315 @@ unit_test_result_t test_mempool_run(unit_test_context_t *context)
 
 /* ---------------------------------------------------------------- */
 
+
+unit_test_t mempool_blocks_test =
+  {  mempool_blocks_test_run
+  , "mempool_blocks_test"
+  , "Allocating, recycling, and packing fixed-size blocks."
+  };
+
+unit_test_result_t mempool_blocks_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  mempool_t  mempool;
+  mempool_t *pool;
+
+  pool = mempool_init(&mempool, NULL, 24);
+
+  ENCLOSE()
+  {
+    enum { num_blocks = 3 * MEMPOOL_MIN_CHUNK_BLOCKS };
+
+    char   *blocks[num_blocks];
+    char   *recycled;
+    size_t  i;
+    int     static_val;
+
+    ASSERT1( true, IS_TRUE(pool) );
+    ASSERT1( true, pool->block_size >= 24 );
+    ASSERT1( true, pool->block_size % sizeof(void *) == 0 );
+
+    for (i = 0; i < num_blocks; ++i)
+    {
+      blocks[i] = mempool_malloc(pool);
+      ASSERT1( true, IS_TRUE(blocks[i]) );
+    }
+
+    /* The first chunk, then one twice as large. */
+    ASSERT2( sizeeq, pool->chunks_num, 2 );
+    ASSERT2( sizeeq, mempool_live_num(pool), num_blocks );
+
+    /* Consecutive blocks are adjacent. */
+    ASSERT2( objpeq, blocks[1], blocks[0] + pool->block_size );
+    ASSERT2( objpeq, blocks[num_blocks - 1], blocks[num_blocks - 2] + pool->block_size );
+
+    ASSERT2( inteq, mempool_owns(pool, blocks[0]),              1 );
+    ASSERT2( inteq, mempool_owns(pool, blocks[num_blocks - 1]), 1 );
+    ASSERT2( inteq, mempool_owns(pool, &static_val),            0 );
+
+    /* Freed blocks are handed out again, most recent first. */
+    ASSERT2( sizeeq, mempool_free(pool, blocks[5]), 1 );
+    ASSERT2( sizeeq, mempool_free(pool, blocks[7]), 1 );
+    ASSERT2( sizeeq, pool->free_num, 2 );
+
+    recycled = mempool_malloc(pool);
+    ASSERT2( objpeq, recycled, blocks[7] );
+    recycled = mempool_malloc(pool);
+    ASSERT2( objpeq, recycled, blocks[5] );
+
+    ASSERT2( sizeeq, pool->free_num, 0 );
+    ASSERT2( sizeeq, mempool_live_num(pool), num_blocks );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq, mempool_deinit(pool), 2 );
+    ASSERT2( sizeeq, mempool_deinit(pool), 0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t mempool_manager_test =
+  {  mempool_manager_test_run
+  , "mempool_manager_test"
+  , "Allocating through the mempool memory_manager_t front-end."
+  };
+
+unit_test_result_t mempool_manager_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  mempool_t         mempool;
+  mempool_t        *pool;
+  memory_manager_t  memory_manager;
+  memory_manager_t *manager;
+
+  pool    = mempool_init(&mempool, NULL, sizeof(long) * 4);
+  manager = mempool_manager_init(&memory_manager, pool);
+
+  ENCLOSE()
+  {
+    long *small;
+    long *large;
+
+    ASSERT1( true, IS_TRUE(pool) );
+    ASSERT1( true, IS_TRUE(manager) );
+
+    small = memory_manager_mcalloc(manager, 4, sizeof(*small));
+    ASSERT1( true, IS_TRUE(small) );
+    ASSERT2( inteq, (int) small[3], 0 );
+    ASSERT2( inteq, mempool_owns(pool, small), 1 );
+
+    /* Too large for a block: forwarded to the inner manager. */
+    large = memory_manager_mmalloc(manager, 64 * sizeof(*large));
+    ASSERT1( true, IS_TRUE(large) );
+    ASSERT2( inteq, mempool_owns(pool, large), 0 );
+    ASSERT2( inteq, mempool_forwarded(pool, large), 1 );
+    ASSERT2( sizeeq, mempool_live_num(pool), 1 );
+
+    /* Growing a block moves it out of the pool. */
+    small[0] = 42;
+    small    = memory_manager_mrealloc(manager, small, 16 * sizeof(*small));
+    ASSERT1( true, IS_TRUE(small) );
+    ASSERT2( inteq, (int) small[0], 42 );
+    ASSERT2( inteq, mempool_owns(pool, small), 0 );
+    ASSERT2( inteq, mempool_forwarded(pool, small), 1 );
+    ASSERT2( sizeeq, mempool_live_num(pool), 0 );
+
+    ASSERT2( sizeeq, memory_manager_mfree(manager, small), 1 );
+    ASSERT2( sizeeq, memory_manager_mfree(manager, large), 1 );
+    ASSERT2( inteq, mempool_forwarded(pool, small), 0 );
+    ASSERT2( inteq, mempool_forwarded(pool, large), 0 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq, mempool_deinit(pool), 1 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+/* A struct type whose dynamically allocated values come from a pool. */
+
+typedef struct pooled_pair_s pooled_pair_t;
+struct pooled_pair_s
+{
+  int first;
+  int second;
+};
+
+static const type_t *pooled_pair_type(void);
+
+static const char          *pooled_pair_type_name     (const type_t *self);
+static size_t               pooled_pair_type_size     (const type_t *self, const tval *val);
+static const struct_info_t *pooled_pair_type_is_struct(const type_t *self);
+static const tval          *pooled_pair_type_has_default(const type_t *self);
+
+static const pooled_pair_t pooled_pair_default = { 0, 0 };
+
+DEF_TYPE_POOL(pooled_pair)
+
+static const type_t pooled_pair_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ pooled_pair_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ pooled_pair_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ pooled_pair_type_size
+  , /* @is_struct             */ pooled_pair_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ pooled_pair_type_has_default
+  , /* mem                    */ pooled_pair_pool_mem
+  , /* mem_init               */ pooled_pair_pool_mem_init
+  , /* mem_is_dyn             */ pooled_pair_pool_mem_is_dyn
+  , /* mem_free               */ pooled_pair_pool_mem_free
+  , /* default_memory_manager */ pooled_pair_pool_default_memory_manager
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *pooled_pair_type(void)
+  { return &pooled_pair_type_def; }
+
+static const char          *pooled_pair_type_name     (const type_t *self)
+  { return "pooled_pair_t"; }
+
+static size_t               pooled_pair_type_size     (const type_t *self, const tval *val)
+  { return sizeof(pooled_pair_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(pooled_pair)
+static const struct_info_t *pooled_pair_type_is_struct(const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(pooled_pair);
+
+    /* int first;  */
+    /* int second; */
+    STRUCT_INFO_RADD(int_type(), first);
+    STRUCT_INFO_RADD(int_type(), second);
+
+    STRUCT_INFO_DONE();
+  }
+
+static const tval          *pooled_pair_type_has_default(const type_t *self)
+  { return type_has_default_value(self, &pooled_pair_default); }
+
+unit_test_t type_pool_test =
+  {  type_pool_test_run
+  , "type_pool_test"
+  , "Dynamically allocating values of a type from its pool."
+  };
+
+unit_test_result_t type_pool_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  const type_t           *type;
+  const memory_manager_t *manager;
+
+  type    = pooled_pair_type();
+  manager = type_default_memory_manager(type, NULL);
+
+  ENCLOSE()
+  {
+    pooled_pair_t *first;
+    pooled_pair_t *second;
+    pooled_pair_t *recycled;
+    pooled_pair_t  automatic;
+    size_t         live;
+
+    ASSERT2( objpeq, manager, &pooled_pair_pool.manager );
+    ASSERT2( sizeeq, pooled_pair_pool.pool.object_size, sizeof(pooled_pair_t) );
+
+    live = mempool_live_num(&pooled_pair_pool.pool);
+
+    first  = type_init(type, NULL);
+    second = type_init(type, NULL);
+    ASSERT1( true, IS_TRUE(first)  );
+    ASSERT1( true, IS_TRUE(second) );
+    ASSERT2( inteq, first->second, 0 );
+
+    ASSERT2( sizeeq, mempool_live_num(&pooled_pair_pool.pool), live + 2 );
+
+    /* Values of the type are packed together. */
+    ASSERT2( objpeq, (char *) second, ((char *) first) + pooled_pair_pool.pool.block_size );
+
+    ASSERT2( inteq, type_mem_is_dyn(type, first),      1 );
+    ASSERT2( inteq, type_mem_is_dyn(type, &automatic), 0 );
+
+    /* Freeing is a push onto the free list. */
+    ASSERT1( true, type_free(type, first) >= 1 );
+    ASSERT2( inteq, type_mem_free(type, &automatic), 0 );
+    ASSERT2( sizeeq, mempool_live_num(&pooled_pair_pool.pool), live + 1 );
+
+    /* The freed value is reused by the next allocation. */
+    recycled = type_init(type, NULL);
+    ASSERT2( objpeq, recycled, first );
+    ASSERT2( inteq,  recycled->first, 0 );
+
+    ASSERT1( true, type_free(type, recycled) >= 1 );
+    ASSERT1( true, type_free(type, second)   >= 1 );
+    ASSERT2( sizeeq, mempool_live_num(&pooled_pair_pool.pool), live );
+  }
+
+  ENCLOSE()
+  {
+    pooled_pair_t *pairs;
+
+    /* Arrays don't fit in a block, and are freed back to the inner manager. */
+    pairs = type_init_array(type, NULL, 3);
+    ASSERT1( true, IS_TRUE(pairs) );
+    ASSERT2( inteq, mempool_owns(&pooled_pair_pool.pool, pairs), 0 );
+    ASSERT2( inteq, mempool_forwarded(&pooled_pair_pool.pool, pairs), 1 );
+    ASSERT2( inteq, type_mem_is_dyn(type, pairs), 1 );
+    ASSERT2( sizeeq, type_free_array(type, pairs, 3), 2 );
+    ASSERT2( inteq, mempool_forwarded(&pooled_pair_pool.pool, pairs), 0 );
+  }
+
+  ENCLOSE()
+  {
+    primdiv_t *quotient;
+
+    /* Library types opt in too. */
+    quotient = type_init(div_type(), NULL);
+    ASSERT1( true, IS_TRUE(quotient) );
+    ASSERT2( inteq, quotient->rem, 0 );
+    ASSERT2( inteq, type_mem_is_dyn(div_type(), quotient), 1 );
+    ASSERT2( objpeq, memory_tracker_owner(quotient), NULL );
+    ASSERT1( true, type_free(div_type(), quotient) >= 1 );
+  }
+
+  return result;
+}
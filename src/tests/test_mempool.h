@@ -51,4 +51,15 @@ unit_test_result_t test_mempool_run(unit_test_context_t *context);
 
 /* ---------------------------------------------------------------- */
 
+extern unit_test_t mempool_blocks_test;
+unit_test_result_t mempool_blocks_test_run(unit_test_context_t *context);
+
+extern unit_test_t mempool_manager_test;
+unit_test_result_t mempool_manager_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_pool_test;
+unit_test_result_t type_pool_test_run(unit_test_context_t *context);
+
+/* ---------------------------------------------------------------- */
+
 #endif /* ifndef TESTS_TEST_MEMPOOL_H */
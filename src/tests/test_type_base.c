@@ -30,11 +30,18 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+
 #include "../base.h"
+
+#if POSIX_PARALLEL
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
 #include "testing.h"
 #include "test_type_base.h"
 
 #include "../type_base.h"
+#include "../type_base_memory_tracker.h"
 
 int test_type_base_cli(int argc, char **argv)
 {
@@ -52,7 +59,26 @@ unit_test_t type_base_test =
 
 /* Array of type_base tests. */
 unit_test_t *type_base_tests[] =
-  { NULL
+  { &ref_traversal_test
+  , &ref_traversal_table_test
+  , &struct_dup_test
+  , &struct_info_fields_test
+  , &struct_info_plan_test
+  , &struct_info_once_test
+  , &struct_info_static_test
+  , &type_hash_test
+  , &type_hash_cycle_test
+  , &struct_embedded_test
+  , &struct_info_pod_test
+  , &template_cons_default_image_test
+  , &type_init_array_test
+  , &type_subtype_memo_test
+  , &struct_info_typed_field_test
+  , &struct_cmp_deep_test
+  , &type_shared_ref_test
+  , &type_remote_free_test
+
+  , NULL
   };
 
 unit_test_result_t test_type_base_run(unit_test_context_t *context)
@@ -62,3 +88,1920 @@ unit_test_result_t test_type_base_run(unit_test_context_t *context)
 
 /* ---------------------------------------------------------------- */
 
+unit_test_t ref_traversal_test =
+  {  ref_traversal_test_run
+  , "ref_traversal_test"
+  , "Adding, finding, and removing tagged references."
+  };
+
+unit_test_result_t ref_traversal_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    ref_traversal_t  ref_traversal;
+    int              values[4];
+    void            *a;
+    void            *b;
+
+    a = &values[0];
+    b = &values[1];
+
+    ASSERT2( objpeq, ref_traversal_init_empty(&ref_traversal), &ref_traversal );
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 0 );
+
+    /* A NULL set is empty. */
+    ASSERT2( objpeq, ref_traversal_exists(NULL, a), NULL );
+
+    ASSERT2( objpeq, ref_traversal_add(&ref_traversal, a), a );
+    ASSERT2( objpeq, ref_traversal_add(&ref_traversal, a), NULL );
+    ASSERT2( objpeq, ref_traversal_exists(&ref_traversal, a), a );
+    ASSERT2( objpeq, ref_traversal_exists(&ref_traversal, b), NULL );
+
+    /* NULL is never a member. */
+    ASSERT2( objpeq, ref_traversal_add(&ref_traversal, NULL), NULL );
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 1 );
+
+    /* Tags are independent. */
+    ASSERT2( objpeq, ref_traversal_tagged_exists(&ref_traversal, 1, a), NULL );
+    ASSERT2( objpeq, ref_traversal_tagged_add(&ref_traversal, 1, a), a );
+    ASSERT2( objpeq, ref_traversal_tagged_exists(&ref_traversal, 1, a), a );
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 2 );
+
+    /* remove returns NULL on success; take returns the reference. */
+    ASSERT2( objpeq, ref_traversal_remove(&ref_traversal, a), NULL );
+    ASSERT2( objpeq, ref_traversal_remove(&ref_traversal, a), a );
+    ASSERT2( objpeq, ref_traversal_tagged_exists(&ref_traversal, 1, a), a );
+    ASSERT2( objpeq, ref_traversal_tagged_take(&ref_traversal, 1, a), a );
+    ASSERT2( objpeq, ref_traversal_tagged_take(&ref_traversal, 1, a), NULL );
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 0 );
+
+    /* Memoization. */
+    ASSERT2( objpeq, ref_traversal_tagged_memoized(&ref_traversal, 2, a), NULL );
+    ASSERT2( objpeq, ref_traversal_tagged_memoize(&ref_traversal, 2, a, b), a );
+    ASSERT2( objpeq, ref_traversal_tagged_memoized(&ref_traversal, 2, a), b );
+    ASSERT2( objpeq, ref_traversal_tagged_add(&ref_traversal, 2, a), NULL );
+
+    ASSERT2( objpeq, ref_traversal_init_with_one(&ref_traversal, b), &ref_traversal );
+    ASSERT2( objpeq, ref_traversal_exists(&ref_traversal, b), b );
+
+    tval_free(&ref_traversal);
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 0 );
+  }
+
+  return result;
+}
+
+unit_test_t ref_traversal_table_test =
+  {  ref_traversal_table_test_run
+  , "ref_traversal_table_test"
+  , "Sets larger than their inline storage."
+  };
+
+unit_test_result_t ref_traversal_table_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    ref_traversal_t  ref_traversal;
+    char            *values;
+    size_t           num;
+    size_t           i;
+    size_t           found;
+
+    num    = 32 * REF_TRAVERSAL_INLINE_NUM;
+    values = malloc(num);
+    ASSERT1( true, IS_TRUE(values) );
+
+    ref_traversal_init_empty(&ref_traversal);
+
+    for (i = 0; i < num; ++i)
+    {
+      ASSERT2( objpeq, ref_traversal_tagged_add(&ref_traversal, (unsigned char) (i & 1), values + i), values + i );
+    }
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), num );
+
+    /* The same reference as another kind is another member. */
+    ASSERT2( objpeq, ref_traversal_tagged_as_add   (&ref_traversal, 1, values, values + 1), values + 1 );
+    ASSERT2( objpeq, ref_traversal_tagged_as_add   (&ref_traversal, 1, values, values + 1), NULL );
+    ASSERT2( objpeq, ref_traversal_tagged_as_exists(&ref_traversal, 1, NULL,   values + 1), values + 1 );
+    ASSERT2( objpeq, ref_traversal_tagged_as_remove(&ref_traversal, 1, values, values + 1), NULL );
+    ASSERT2( objpeq, ref_traversal_tagged_as_exists(&ref_traversal, 1, values, values + 1), NULL );
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), num );
+
+    /* Remove every other value, then churn through the removed slots. */
+    for (i = 0; i < num; i += 2)
+    {
+      ASSERT2( objpeq, ref_traversal_tagged_remove(&ref_traversal, 0, values + i), NULL );
+    }
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), num / 2 );
+
+    for (i = 0; i < 4 * num; ++i)
+    {
+      ASSERT2( objpeq, ref_traversal_tagged_add   (&ref_traversal, 2, values + i % num), values + i % num );
+      ASSERT2( objpeq, ref_traversal_tagged_remove(&ref_traversal, 2, values + i % num), NULL );
+    }
+
+    found = 0;
+    for (i = 0; i < num; ++i)
+    {
+      if (ref_traversal_tagged_exists(&ref_traversal, (unsigned char) (i & 1), values + i))
+        ++found;
+    }
+    ASSERT2( sizeeq, found, num / 2 );
+    ASSERT2( objpeq, ref_traversal_tagged_exists(&ref_traversal, 0, values + 1), NULL );
+
+    ref_traversal_clear(&ref_traversal);
+    ASSERT2( sizeeq, ref_traversal_num(&ref_traversal), 0 );
+    ASSERT2( objpeq, ref_traversal_exists(&ref_traversal, values + 1), NULL );
+
+    free(values);
+  }
+
+  return result;
+}
+
+unit_test_t struct_dup_test =
+  {  struct_dup_test_run
+  , "struct_dup_test"
+  , "Copying and comparing structs field by field."
+  };
+
+unit_test_result_t struct_dup_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const struct_info_t *struct_info;
+    ref_traversal_t      vals;
+    div_t                src;
+    div_t                dest;
+
+    struct_info = type_is_struct(div_type());
+    ASSERT1( true, IS_TRUE(struct_info) );
+
+    src.quot  = 7;
+    src.rem   = 3;
+    dest.quot = 0;
+    dest.rem  = 0;
+
+    ASSERT2( objpeq, struct_dup(struct_info, &dest, &src, 1, 0, 0, NULL), NULL );
+    ASSERT2( inteq, dest.quot, 7 );
+    ASSERT2( inteq, dest.rem,  3 );
+
+    ASSERT2( inteq, struct_cmp(struct_info, &dest, &src, 0, NULL), 0 );
+    dest.rem = 4;
+    ASSERT1( true, struct_cmp(struct_info, &dest, &src, 0, NULL) != 0 );
+
+    /* Values still being copied are loops; they are released afterwards. */
+    ref_traversal_init_empty(&vals);
+    ref_traversal_tagged_as_add(&vals, STRUCT_DUP_VALS_TAG_SRC, struct_info, &src);
+    ASSERT1( true, IS_TRUE(struct_dup(struct_info, &dest, &src, 1, 0, 0, &vals)) );
+    ASSERT2( inteq, dest.rem, 4 );
+
+    ref_traversal_tagged_as_remove(&vals, STRUCT_DUP_VALS_TAG_SRC, struct_info, &src);
+    ASSERT2( objpeq, struct_dup(struct_info, &dest, &src, 1, 0, 0, &vals), NULL );
+    ASSERT2( inteq, dest.rem, 3 );
+    ASSERT2( sizeeq, ref_traversal_num(&vals), 0 );
+
+    ref_traversal_clear(&vals);
+  }
+
+  return result;
+}
+
+unit_test_t struct_info_fields_test =
+  {  struct_info_fields_test_run
+  , "struct_info_fields_test"
+  , "Field arrays are sized to the fields described."
+  };
+
+unit_test_result_t struct_info_fields_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const struct_info_t *struct_info;
+
+    /* More fields than the initial allocation. */
+    struct_info = type_is_struct(memory_tracker_type());
+    ASSERT1( true, IS_TRUE(struct_info) );
+    ASSERT1( true, struct_info->fields_len > STRUCT_INFO_MIN_FIELDS_SIZE );
+    ASSERT2( sizeeq, struct_info->fields_size, struct_info->fields_len + 1 );
+    ASSERT2( inteq, is_field_terminator(&struct_info->fields[struct_info->fields_len]), 1 );
+    ASSERT2( sizeeq, struct_info_num_fields(struct_info), struct_info->fields_len );
+    ASSERT2( inteq, verify_struct_info(struct_info, NULL, 0), verify_struct_info_success );
+
+    /* Field defaults still come from the description. */
+    ASSERT1( true, IS_TRUE(struct_info->fields[0].default_value) );
+    ASSERT1( true, struct_info->fields[0].default_value == struct_info->field_default_value );
+
+    /* Fewer. */
+    struct_info = type_is_struct(div_type());
+    ASSERT2( sizeeq, struct_info->fields_len,  2 );
+    ASSERT2( sizeeq, struct_info->fields_size, 3 );
+
+    ASSERT2( inteq, verify_struct_info(&struct_info_defaults, NULL, 0), verify_struct_info_success );
+  }
+
+  return result;
+}
+
+unit_test_t struct_info_plan_test =
+  {  struct_info_plan_test_run
+  , "struct_info_plan_test"
+  , "Copying and comparing adjacent plain fields in bulk."
+  };
+
+unit_test_result_t struct_info_plan_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const struct_info_t      *struct_info;
+    const struct_info_plan_t *plan;
+    memory_tracker_t          src;
+    memory_tracker_t          dest;
+    size_t                    i;
+
+    struct_info = type_is_struct(memory_tracker_type());
+    plan        = struct_info_plan(struct_info);
+    ASSERT1( true, IS_TRUE(plan) );
+
+    /* Built once. */
+    ASSERT2( objpeq, struct_info_plan(struct_info), plan );
+    ASSERT2( objpeq, struct_info->plan, plan );
+
+    ASSERT2( sizeeq, plan->fields_num, struct_info_num_fields(struct_info) );
+    ASSERT1( true, plan->steps_num < plan->fields_num );
+
+    for (i = 0; i < plan->steps_num; ++i)
+    {
+      if (plan->steps[i].field_info)
+      {
+        ASSERT1( true, plan->steps[i].field_info->is_metadata || plan->steps[i].field_info->is_recursible_ref );
+      }
+    }
+
+    src  = memory_tracker_defaults;
+    dest = memory_tracker_defaults;
+
+    src.journal_num     = 3;
+    src.intrusive_num   = 5;
+    src.checkpoints_num = 7;
+    src.retire          = 1;
+
+    ASSERT1( true, struct_cmp(struct_info, &dest, &src, 0, NULL) != 0 );
+
+    ASSERT2( objpeq, struct_dup(struct_info, &dest, &src, 1, 0, 0, NULL), NULL );
+    ASSERT2( sizeeq, dest.journal_num,     3 );
+    ASSERT2( sizeeq, dest.intrusive_num,   5 );
+    ASSERT2( sizeeq, dest.checkpoints_num, 7 );
+    ASSERT2( inteq,  dest.retire,          1 );
+
+    ASSERT2( inteq, struct_cmp(struct_info, &dest, &src, 0, NULL), 0 );
+
+    /* Ordered by the first differing byte, as "field_memcmp" does. */
+    dest.journal_num = 2;
+    ASSERT2( inteq, struct_cmp(struct_info, &dest, &src, 0, NULL), -1 );
+    ASSERT2( inteq, struct_cmp(struct_info, &src, &dest, 0, NULL),  1 );
+  }
+
+  return result;
+}
+
+/* A struct type described only by these tests, so it is built here first. */
+
+typedef struct once_triple_s once_triple_t;
+struct once_triple_s
+{
+  int    a;
+  long   b;
+  size_t c;
+};
+
+static const type_t *once_triple_type(void);
+
+static const char          *once_triple_type_name     (const type_t *self);
+static size_t               once_triple_type_size     (const type_t *self, const tval *val);
+static const struct_info_t *once_triple_type_is_struct(const type_t *self);
+
+static const type_t once_triple_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ once_triple_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ once_triple_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ once_triple_type_size
+  , /* @is_struct             */ once_triple_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *once_triple_type(void)
+  { return &once_triple_type_def; }
+
+static const char          *once_triple_type_name     (const type_t *self)
+  { return "once_triple_t"; }
+
+static size_t               once_triple_type_size     (const type_t *self, const tval *val)
+  { return sizeof(once_triple_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(once_triple)
+static const struct_info_t *once_triple_type_is_struct(const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(once_triple);
+
+    /* int    a; */
+    /* long   b; */
+    /* size_t c; */
+    STRUCT_INFO_RADD(int_type(),  a);
+    STRUCT_INFO_RADD(long_type(), b);
+    STRUCT_INFO_RADD(size_type(), c);
+
+    STRUCT_INFO_DONE();
+  }
+
+#define ONCE_TEST_THREADS 8
+
+#if POSIX_PARALLEL
+static void *once_test_describe(void *context)
+{
+  *((const struct_info_t **) context) = type_is_struct(once_triple_type());
+  return NULL;
+}
+#endif /* #if POSIX_PARALLEL */
+
+unit_test_t struct_info_once_test =
+  {  struct_info_once_test_run
+  , "struct_info_once_test"
+  , "Concurrent first uses build a struct_info once."
+  };
+
+unit_test_result_t struct_info_once_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    struct_info_once_t   once = { STRUCT_INFO_ONCE_UNSTARTED };
+    const struct_info_t *described[ONCE_TEST_THREADS];
+    size_t               i;
+
+    /* The builder, including when it re-enters, then everyone else. */
+    ASSERT2( inteq, struct_info_once_begin(&once), 1 );
+    ASSERT2( inteq, struct_info_once_begin(&once), 0 );
+    ASSERT2( inteq, once.state, STRUCT_INFO_ONCE_BUILDING );
+    struct_info_once_end(&once);
+    ASSERT2( inteq, once.state, STRUCT_INFO_ONCE_DONE );
+    ASSERT2( inteq, struct_info_once_begin(&once), 0 );
+
+    /* A builder that gives up releases everyone else too. */
+    once.state = STRUCT_INFO_ONCE_UNSTARTED;
+    ASSERT2( inteq, struct_info_once_begin(&once), 1 );
+    struct_info_once_fail(&once);
+    ASSERT2( inteq, once.state, STRUCT_INFO_ONCE_FAILED );
+    ASSERT2( inteq, struct_info_once_begin(&once), 0 );
+
+#if POSIX_PARALLEL
+    {
+      pthread_t threads[ONCE_TEST_THREADS];
+
+      for (i = 0; i < ONCE_TEST_THREADS; ++i)
+        pthread_create(&threads[i], NULL, once_test_describe, &described[i]);
+      for (i = 0; i < ONCE_TEST_THREADS; ++i)
+        pthread_join(threads[i], NULL);
+    }
+#else  /* #if POSIX_PARALLEL */
+    for (i = 0; i < ONCE_TEST_THREADS; ++i)
+      described[i] = type_is_struct(once_triple_type());
+#endif /* #if POSIX_PARALLEL */
+
+    /* Every caller saw the finished struct_info. */
+    for (i = 0; i < ONCE_TEST_THREADS; ++i)
+    {
+      ASSERT1( true, IS_TRUE(described[i]) );
+      ASSERT2( objpeq, described[i], described[0] );
+      ASSERT2( sizeeq, described[i]->fields_len, 3 );
+    }
+
+    ASSERT2( objpeq, type_is_struct(once_triple_type()), described[0] );
+  }
+
+  return result;
+}
+
+unit_test_t struct_info_static_test =
+  {  struct_info_static_test_run
+  , "struct_info_static_test"
+  , "Prebuilt struct_info tables verify."
+  };
+
+unit_test_result_t struct_info_static_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const type_t *(*types[3])(void);
+    size_t          i;
+
+    types[0] = div_type;
+    types[1] = ldiv_type;
+    types[2] = memory_tracker_type;
+
+    for (i = 0; i < ARRAY_NUM(types); ++i)
+    {
+      const struct_info_t *struct_info;
+      const field_info_t  *last;
+
+      struct_info = type_is_struct(types[i]());
+
+      ASSERT1( true, IS_TRUE(struct_info) );
+      ASSERT2( inteq, verify_struct_info(struct_info, NULL, 0), verify_struct_info_success );
+      ASSERT2( inteq, struct_info->has_memory_tracker, 0 );
+
+      /* The last field ends the struct, save for trailing padding. */
+      last = struct_info_index_field(struct_info, struct_info->fields_len - 1);
+      ASSERT1( true, IS_TRUE(last) );
+      ASSERT1( true, (size_t) last->field_pos + last->field_size <= type_size(types[i](), NULL) );
+      ASSERT1( true, (size_t) last->field_pos + last->field_size + sizeof(long) > type_size(types[i](), NULL) );
+    }
+  }
+
+  return result;
+}
+
+unit_test_t type_hash_test =
+  {  type_hash_test_run
+  , "type_hash_test"
+  , "Equal values hash equally."
+  };
+
+unit_test_result_t type_hash_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    int              i;
+    int              j;
+    div_t            a;
+    div_t            b;
+    memory_tracker_t c;
+    memory_tracker_t d;
+
+    i = 42;
+    j = 42;
+    ASSERT2( sizeeq, hash_with_type(int_type(), &i), hash_with_type(int_type(), &j) );
+    j = 43;
+    ASSERT1( true, hash_with_type(int_type(), &i) != hash_with_type(int_type(), &j) );
+
+    /* Structs combine their fields' hashes. */
+    a.quot = 7; a.rem = 2;
+    b.quot = 7; b.rem = 2;
+    ASSERT2( inteq,  cmp_with_type(div_type(), &a, &b), 0 );
+    ASSERT2( sizeeq, hash_with_type(div_type(), &a), hash_with_type(div_type(), &b) );
+    b.rem = 3;
+    ASSERT1( true, hash_with_type(div_type(), &a) != hash_with_type(div_type(), &b) );
+
+    /* Metadata fields are ignored, as "cmp" ignores them. */
+    c = memory_tracker_defaults;
+    d = memory_tracker_defaults;
+    ASSERT2( sizeeq, hash_with_type(memory_tracker_type(), &c), hash_with_type(memory_tracker_type(), &d) );
+    d.retire = 1;
+    ASSERT1( true, hash_with_type(memory_tracker_type(), &c) != hash_with_type(memory_tracker_type(), &d) );
+
+    ASSERT2( sizeeq, type_hash(NULL, &i, 0, NULL), 0 );
+    ASSERT2( sizeeq, type_hash(int_type(), NULL, 0, NULL), 0 );
+  }
+
+  return result;
+}
+
+/* A linked node whose "next" hashes and compares what it points to. */
+
+typedef struct hash_node_s hash_node_t;
+struct hash_node_s
+{
+  int          id;
+  hash_node_t *next;
+};
+
+static const type_t *hash_node_type(void);
+static const type_t *hash_node_ref_type(void);
+
+static const char          *hash_node_type_name         (const type_t *self);
+static size_t               hash_node_type_size         (const type_t *self, const tval *val);
+static const struct_info_t *hash_node_type_is_struct    (const type_t *self);
+
+static const char          *hash_node_ref_type_name     (const type_t *self);
+static size_t               hash_node_ref_type_size     (const type_t *self, const tval *val);
+static size_t               hash_node_ref_type_hash     (const type_t *self, const tval *val, int deep, ref_traversal_t *vals);
+static const type_t        *hash_node_ref_type_deref    (const type_t *self, const tval *val, const tval **out_ref);
+
+static const type_t hash_node_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ hash_node_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ hash_node_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ hash_node_type_size
+  , /* @is_struct             */ hash_node_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t hash_node_ref_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ hash_node_ref_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ hash_node_ref_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ hash_node_ref_type_size
+  , /* @is_struct             */ type_is_not_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ type_has_deref_cmp
+  , /* hash                   */ hash_node_ref_type_hash
+  , /* deref                  */ hash_node_ref_type_deref
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *hash_node_type(void)
+  { return &hash_node_type_def; }
+
+static const type_t *hash_node_ref_type(void)
+  { return &hash_node_ref_type_def; }
+
+static const char          *hash_node_type_name         (const type_t *self)
+  { return "hash_node_t"; }
+
+static size_t               hash_node_type_size         (const type_t *self, const tval *val)
+  { return sizeof(hash_node_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(hash_node)
+static const struct_info_t *hash_node_type_is_struct    (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(hash_node);
+
+    /* int          id;   */
+    /* hash_node_t *next; */
+    STRUCT_INFO_RADD(int_type(),           id);
+    STRUCT_INFO_RADD(hash_node_ref_type(), next);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+
+    STRUCT_INFO_DONE();
+  }
+
+static const char          *hash_node_ref_type_name     (const type_t *self)
+  { return "hash_node_t *"; }
+
+static size_t               hash_node_ref_type_size     (const type_t *self, const tval *val)
+  { return sizeof(hash_node_t *); }
+
+static size_t               hash_node_ref_type_hash     (const type_t *self, const tval *val, int deep, ref_traversal_t *vals)
+  {
+    const hash_node_t *next = *((hash_node_t * const *) val);
+
+    if (!next)
+      return 0;
+
+    return type_hash(hash_node_type(), next, deep, vals);
+  }
+
+static const type_t        *hash_node_ref_type_deref    (const type_t *self, const tval *val, const tval **out_ref)
+  {
+    if (out_ref)
+      *out_ref = *((hash_node_t * const *) val);
+
+    return hash_node_type();
+  }
+
+unit_test_t type_hash_cycle_test =
+  {  type_hash_cycle_test_run
+  , "type_hash_cycle_test"
+  , "Deep hashing terminates on cycles."
+  };
+
+unit_test_result_t type_hash_cycle_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    hash_node_t a;
+    hash_node_t b;
+    hash_node_t c;
+    hash_node_t d;
+
+    /* a -> b -> a, and c -> d -> c. */
+    a.id = 1; a.next = &b;
+    b.id = 2; b.next = &a;
+    c.id = 1; c.next = &d;
+    d.id = 2; d.next = &c;
+
+    ASSERT2( sizeeq, hash_with_type(hash_node_type(), &a), hash_with_type(hash_node_type(), &c) );
+
+    /* Deep hashes see through the reference. */
+    d.id = 3;
+    ASSERT1( true, hash_with_type(hash_node_type(), &a) != hash_with_type(hash_node_type(), &c) );
+
+    /* Shallow hashes only see the address. */
+    ASSERT1( true, hash_with_type_deep(hash_node_type(), &a, 0) != hash_with_type_deep(hash_node_type(), &c, 0) );
+    c.next = &b;
+    ASSERT2( sizeeq, hash_with_type_deep(hash_node_type(), &a, 0), hash_with_type_deep(hash_node_type(), &c, 0) );
+  }
+
+  return result;
+}
+
+/* A node embedded at offset 0, so both share an address. */
+
+typedef struct hash_wrap_s hash_wrap_t;
+struct hash_wrap_s
+{
+  hash_node_t node;
+  int         extra;
+};
+
+static const type_t *hash_wrap_type(void);
+
+static const char          *hash_wrap_type_name         (const type_t *self);
+static size_t               hash_wrap_type_size         (const type_t *self, const tval *val);
+static const struct_info_t *hash_wrap_type_is_struct    (const type_t *self);
+
+static const type_t hash_wrap_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ hash_wrap_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ hash_wrap_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ hash_wrap_type_size
+  , /* @is_struct             */ hash_wrap_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *hash_wrap_type(void)
+  { return &hash_wrap_type_def; }
+
+static const char          *hash_wrap_type_name         (const type_t *self)
+  { return "hash_wrap_t"; }
+
+static size_t               hash_wrap_type_size         (const type_t *self, const tval *val)
+  { return sizeof(hash_wrap_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(hash_wrap)
+static const struct_info_t *hash_wrap_type_is_struct    (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(hash_wrap);
+
+    /* hash_node_t node;  */
+    /* int         extra; */
+    STRUCT_INFO_RADD(hash_node_type(), node);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+    STRUCT_INFO_RADD(int_type(),       extra);
+
+    STRUCT_INFO_DONE();
+  }
+
+unit_test_t struct_embedded_test =
+  {  struct_embedded_test_run
+  , "struct_embedded_test"
+  , "A struct embedded at offset 0 is not a loop."
+  };
+
+unit_test_result_t struct_embedded_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const struct_info_t *struct_info;
+    hash_node_t          tail;
+    hash_wrap_t          a;
+    hash_wrap_t          b;
+    hash_wrap_t          c;
+
+    struct_info = type_is_struct(hash_wrap_type());
+    ASSERT1( true, IS_TRUE(struct_info) );
+
+    tail.id   = 9;
+    tail.next = NULL;
+
+    a.node.id = 1; a.node.next = &tail; a.extra = 2;
+    b.node.id = 1; b.node.next = &tail; b.extra = 2;
+    c.node.id = 0; c.node.next = NULL;  c.extra = 0;
+
+    /* "node" is reached at the address of its container, as another kind. */
+    ASSERT1( true, hash_with_type(hash_wrap_type(), &a) != STRUCT_HASH_CYCLE );
+    ASSERT2( sizeeq, hash_with_type(hash_wrap_type(), &a), hash_with_type(hash_wrap_type(), &b) );
+    b.node.id = 3;
+    ASSERT1( true, hash_with_type(hash_wrap_type(), &a) != hash_with_type(hash_wrap_type(), &b) );
+
+    ASSERT1( true, struct_cmp(struct_info, &a, &b, 1, NULL) != 0 );
+    b.node.id = 1;
+    ASSERT2( inteq, struct_cmp(struct_info, &a, &b, 1, NULL), 0 );
+
+    /* Copy "node" itself, but not what its "next" refers to. */
+    ASSERT2( objpeq, struct_dup(struct_info, &c, &a, 1, -1, 0, NULL), NULL );
+    ASSERT2( inteq, c.node.id, 1 );
+    ASSERT2( inteq, c.extra,   2 );
+    ASSERT2( inteq, struct_cmp(struct_info, &c, &a, 1, NULL), 0 );
+  }
+
+  return result;
+}
+
+unit_test_t struct_info_pod_test =
+  {  struct_info_pod_test_run
+  , "struct_info_pod_test"
+  , "Plain old data structs copy and compare as bytes."
+  };
+
+unit_test_result_t struct_info_pod_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    div_t          a[4];
+    div_t          b[4];
+    once_triple_t  c[2];
+    once_triple_t  d[2];
+    size_t         i;
+
+    /* Contiguous plain fields. */
+    ASSERT2( sizeeq, struct_info_pod_size(type_is_struct(div_type())), sizeof(div_t) );
+    ASSERT2( sizeeq, type_pod_size(div_type()), sizeof(div_t) );
+
+    /* Padding between fields, a reference, and no fields at all. */
+    ASSERT2( sizeeq, type_pod_size(once_triple_type()), 0 );
+    ASSERT2( sizeeq, type_pod_size(hash_node_type()),   0 );
+    ASSERT2( sizeeq, type_pod_size(int_type()),         0 );
+
+    for (i = 0; i < ARRAY_NUM(a); ++i)
+    {
+      a[i].quot = (int) i;
+      a[i].rem  = (int) i + 1;
+    }
+
+    ASSERT2( objpeq, type_dup_array(div_type(), b, a, ARRAY_NUM(a), 0, 0), b );
+    for (i = 0; i < ARRAY_NUM(a); ++i)
+      ASSERT2( inteq, cmp_with_type(div_type(), &b[i], &a[i]), 0 );
+
+    ASSERT2( objpeq, type_dup(div_type(), &b[0], &a[3], 1, 0, 0, NULL), &b[0] );
+    ASSERT2( inteq,  b[0].quot, 3 );
+
+    /* Still ordered as the fields would be. */
+    ASSERT2( inteq, cmp_with_type(div_type(), &a[1], &a[2]), -1 );
+    ASSERT2( inteq, cmp_with_type(div_type(), &a[2], &a[1]),  1 );
+
+    ASSERT2( sizeeq, hash_with_type(div_type(), &a[3]), hash_with_type(div_type(), &b[0]) );
+
+    /* Other structs are still copied field by field. */
+    for (i = 0; i < ARRAY_NUM(c); ++i)
+    {
+      c[i].a = (int)    i;
+      c[i].b = (long)   i + 1;
+      c[i].c = (size_t) i + 2;
+    }
+
+    ASSERT2( objpeq, type_dup_array(once_triple_type(), d, c, ARRAY_NUM(c), 0, 0), d );
+    for (i = 0; i < ARRAY_NUM(c); ++i)
+      ASSERT2( inteq, cmp_with_type(once_triple_type(), &d[i], &c[i]), 0 );
+  }
+
+  return result;
+}
+
+/* A value that owns a node, allocated by the field's default. */
+
+typedef struct node_owner_s node_owner_t;
+struct node_owner_s
+{
+  int          id;
+  hash_node_t *node;
+};
+
+static const type_t *node_owner_type(void);
+
+static const char          *node_owner_type_name     (const type_t *self);
+static size_t               node_owner_type_size     (const type_t *self, const tval *val);
+static const struct_info_t *node_owner_type_is_struct(const type_t *self);
+
+static const type_t node_owner_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ node_owner_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ node_owner_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ node_owner_type_size
+  , /* @is_struct             */ node_owner_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *node_owner_type(void)
+  { return &node_owner_type_def; }
+
+static const char          *node_owner_type_name     (const type_t *self)
+  { return "node_owner_t"; }
+
+static size_t               node_owner_type_size     (const type_t *self, const tval *val)
+  { return sizeof(node_owner_t); }
+
+static size_t               node_owner_node_default  (const field_info_t *self, void *dest_field_mem)
+  {
+    hash_node_t *node;
+
+    if (dest_field_mem)
+    {
+      node = malloc(sizeof(*node));
+      if (node)
+      {
+        node->id   = 9;
+        node->next = NULL;
+      }
+
+      *((hash_node_t **) dest_field_mem) = node;
+    }
+
+    return self->field_size;
+  }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(node_owner)
+static const struct_info_t *node_owner_type_is_struct(const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(node_owner);
+
+    /* int          id;   */
+    /* hash_node_t *node; */
+    STRUCT_INFO_RADD(int_type(),           id);
+    STRUCT_INFO_RADD(hash_node_ref_type(), node);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+    STRUCT_INFO_LAST()->default_value     = node_owner_node_default;
+
+    STRUCT_INFO_DONE();
+  }
+
+unit_test_t template_cons_default_image_test =
+  {  template_cons_default_image_test_run
+  , "template_cons_default_image_test"
+  , "Default initialization copies an image of the defaults built once."
+  };
+
+unit_test_result_t template_cons_default_image_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const void      *image;
+    template_cons_t  cons;
+    template_cons_t  val;
+    once_triple_t    a;
+    once_triple_t    b;
+    hash_node_t      n;
+    hash_node_t     *m;
+    node_owner_t     o;
+    node_owner_t     p;
+
+    /* Built once, from each field's default. */
+    image = struct_info_default_image(type_is_struct(once_triple_type()));
+    ASSERT1( true, IS_TRUE(image) );
+    ASSERT2( objpeq, struct_info_default_image(type_is_struct(once_triple_type())), image );
+    ASSERT2( inteq,  ((const once_triple_t *) image)->a, 0 );
+    ASSERT2( sizeeq, ((const once_triple_t *) image)->c, 0 );
+
+    /* Without initials, the defaults are copied in. */
+    a.a = 3;
+    a.b = 5;
+    a.c = 7;
+    cons = template_cons_default(&a);
+    ASSERT2( objpeq, type_init(once_triple_type(), (tval *) &cons), &a );
+    ASSERT2( inteq,  a.a, 0 );
+    ASSERT2( sizeeq, a.c, 0 );
+
+    /* With initials. */
+    b.a = 3;
+    b.b = 5;
+    b.c = 7;
+    cons = template_cons_copy(&a, &b);
+    ASSERT2( objpeq, type_init(once_triple_type(), (tval *) &cons), &a );
+    ASSERT2( inteq,  cmp_with_type(once_triple_type(), &a, &b), 0 );
+
+    /* Zeroed, with neither. */
+    cons = template_cons_default(&a);
+    cons.force_no_defaults = 1;
+    ASSERT2( objpeq, type_init(once_triple_type(), (tval *) &cons), &a );
+    ASSERT2( inteq,  a.a, 0 );
+
+    /* References are defaults too. */
+    n.id   = 3;
+    n.next = &n;
+    cons = template_cons_default(&n);
+    ASSERT2( objpeq, type_init(hash_node_type(), (tval *) &cons), &n );
+    ASSERT2( inteq,  n.id, 0 );
+    ASSERT2( objpeq, n.next, NULL );
+
+    /* Allocated values are tracked before their fields are copied. */
+    m = type_init(hash_node_type(), NULL);
+    ASSERT1( true, IS_TRUE(m) );
+    ASSERT2( inteq,  m->id, 0 );
+    ASSERT2( objpeq, m->next, NULL );
+    ASSERT1( true, type_free(hash_node_type(), m) >= 1 );
+
+    /* A default that allocates is left out of the image, and is written
+     * again for each value instead of being shared.
+     */
+    image = struct_info_default_image(type_is_struct(node_owner_type()));
+    ASSERT1( true, IS_TRUE(image) );
+    ASSERT2( objpeq, ((const node_owner_t *) image)->node, NULL );
+    ASSERT2( sizeeq, struct_info_plan(type_is_struct(node_owner_type()))->default_fixups_num, 1 );
+    ASSERT2( sizeeq, struct_info_plan(type_is_struct(once_triple_type()))->default_fixups_num, 0 );
+
+    cons = template_cons_default(&o);
+    ASSERT2( objpeq, type_init(node_owner_type(), (tval *) &cons), &o );
+    cons = template_cons_default(&p);
+    ASSERT2( objpeq, type_init(node_owner_type(), (tval *) &cons), &p );
+    ASSERT1( true, IS_TRUE(o.node) );
+    ASSERT1( true, IS_TRUE(p.node) );
+    ASSERT1( true, o.node != p.node );
+    ASSERT2( inteq, o.node->id, 9 );
+    ASSERT2( inteq, p.node->id, 9 );
+    free(o.node);
+    free(p.node);
+
+    /* The type's own default value is preferred, and keeps the type. */
+    val = template_cons_defaults;
+    val.force_no_defaults = 1;
+    val.user              = &val;
+    ASSERT2( objpeq, template_cons_init_tval_defaults((tval *) &val, NULL, NULL, 0), &val );
+    ASSERT2( funpeq, (tests_funp_t) val.type, (tests_funp_t) template_cons_type );
+    ASSERT2( inteq,  val.force_no_defaults, 0 );
+    ASSERT2( objpeq, val.user, NULL );
+  }
+
+  return result;
+}
+
+/* A value with its own memory tracker. */
+
+typedef struct tracked_cell_s tracked_cell_t;
+struct tracked_cell_s
+{
+  memory_tracker_t memory;
+  int              id;
+};
+
+static const type_t *tracked_cell_type(void);
+
+static const char          *tracked_cell_type_name      (const type_t *self);
+static size_t               tracked_cell_type_size      (const type_t *self, const tval *val);
+static const struct_info_t *tracked_cell_type_is_struct (const type_t *self);
+
+static const type_t tracked_cell_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ tracked_cell_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ tracked_cell_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ tracked_cell_type_size
+  , /* @is_struct             */ tracked_cell_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *tracked_cell_type(void)
+  { return &tracked_cell_type_def; }
+
+static const char          *tracked_cell_type_name      (const type_t *self)
+  { return "tracked_cell_t"; }
+
+static size_t               tracked_cell_type_size      (const type_t *self, const tval *val)
+  { return sizeof(tracked_cell_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(tracked_cell)
+static const struct_info_t *tracked_cell_type_is_struct (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(tracked_cell);
+
+    /* memory_tracker_t memory; */
+    /* int              id;     */
+    STRUCT_INFO_RADD(memory_tracker_type(), memory);
+    STRUCT_INFO_LAST()->is_metadata = 1;
+    STRUCT_INFO_RADD(int_type(),            id);
+
+    STRUCT_INFO_DONE();
+  }
+
+static size_t tracked_cell_cleanup(void *context)
+{
+  ++*((size_t *) context);
+
+  return 1;
+}
+
+unit_test_t type_init_array_test =
+  {  type_init_array_test_run
+  , "type_init_array_test"
+  , "Arrays of values are allocated, initialized, and freed as one block."
+  };
+
+unit_test_result_t type_init_array_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    template_cons_t   cons;
+    once_triple_t    *a;
+    once_triple_t     b;
+    div_t            *c;
+    div_t             d;
+    hash_node_t      *n;
+    tracked_cell_t   *cells;
+    size_t            cleanups;
+    size_t            i;
+    memory_tracker_t *tracker;
+
+    /* Tracked types free through their tracker, and "type_free" returns 1
+     * whether or not the tracker held the block; check the tracker.
+     */
+    tracker = type_mem(once_triple_type(), NULL);
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    /* Defaults. */
+    a = type_init_array(once_triple_type(), NULL, 5);
+    ASSERT1( true, IS_TRUE(a) );
+    for (i = 0; i < 5; ++i)
+    {
+      ASSERT2( inteq,  a[i].a, 0 );
+      ASSERT2( sizeeq, a[i].c, 0 );
+    }
+    ASSERT1( true, tracked_mmalloc(tracker, a) != UNTRACKED );
+    ASSERT1( true, type_free_array(once_triple_type(), a, 5) >= 1 );
+    ASSERT2( inteq, tracked_mmalloc(tracker, a), UNTRACKED );
+
+    /* Shared initials, copied field by field. */
+    b.a = 3;
+    b.b = 5;
+    b.c = 7;
+    cons = template_cons_initials(NULL, &b);
+    cons.force_no_defaults = 1;
+    a = type_init_array(once_triple_type(), &cons, 3);
+    ASSERT1( true, IS_TRUE(a) );
+    for (i = 0; i < 3; ++i)
+      ASSERT2( inteq, cmp_with_type(once_triple_type(), &a[i], &b), 0 );
+    ASSERT1( true, type_free_array(once_triple_type(), a, 3) >= 1 );
+    ASSERT2( inteq, tracked_mmalloc(tracker, a), UNTRACKED );
+
+    /* Plain old data fills the block from the first value. */
+    d.quot = 11;
+    d.rem  = 13;
+    cons = template_cons_initials(NULL, &d);
+    cons.force_no_defaults = 1;
+    c = type_init_array(div_type(), &cons, 7);
+    ASSERT1( true, IS_TRUE(c) );
+    for (i = 0; i < 7; ++i)
+      ASSERT2( inteq, cmp_with_type(div_type(), &c[i], &d), 0 );
+
+    /* "div_t" is pooled; the array is too large for a pool block, and is
+     * still dynamic, and freed.
+     */
+    ASSERT2( inteq,  type_mem_is_dyn(div_type(), c), 1 );
+    ASSERT2( sizeeq, type_free_array(div_type(), c, 7), 2 );
+
+    c = type_init_array(div_type(), NULL, 2);
+    ASSERT1( true, IS_TRUE(c) );
+    ASSERT2( inteq,  c[1].quot, 0 );
+    ASSERT2( inteq,  type_mem_is_dyn(div_type(), c), 1 );
+    ASSERT2( sizeeq, type_free_array(div_type(), c, 2), 2 );
+
+    /* One value. */
+    n = type_init_array(hash_node_type(), NULL, 1);
+    ASSERT1( true, IS_TRUE(n) );
+    ASSERT2( objpeq, n->next, NULL );
+    ASSERT1( true, tracked_mmalloc(type_mem(hash_node_type(), NULL), n) != UNTRACKED );
+    ASSERT1( true, type_free_array(hash_node_type(), n, 1) >= 1 );
+    ASSERT2( inteq, tracked_mmalloc(type_mem(hash_node_type(), NULL), n), UNTRACKED );
+
+    /* Each value has its own tracker, and is freed with it. */
+    cells = type_init_array(tracked_cell_type(), NULL, 4);
+    ASSERT1( true, IS_TRUE(cells) );
+    cleanups = 0;
+    for (i = 0; i < 4; ++i)
+    {
+      manual_allocation_t cleanup;
+
+      ASSERT1( true, cells[i].memory.type == memory_tracker_type );
+      ASSERT2( objpeq, cells[i].memory.dynamic_container, i == 0 ? (void *) cells : NULL );
+
+      cleanup.cleanup = tracked_cell_cleanup;
+      cleanup.context = &cleanups;
+      ASSERT1( true, track_manual_allocation(&cells[i].memory, cleanup) >= 0 );
+    }
+    ASSERT1( true, type_free_array(tracked_cell_type(), cells, 4) >= 1 );
+    ASSERT2( sizeeq, cleanups, 4 );
+
+    /* "dest" can't be provided, and there are no empty arrays. */
+    cons = template_cons_default(&b);
+    ASSERT2( objpeq, type_init_array(once_triple_type(), &cons, 2), NULL );
+    ASSERT2( objpeq, type_init_array(once_triple_type(), NULL,  0), NULL );
+  }
+
+  return result;
+}
+
+/* A type that counts how often it is asked about subtypes. */
+
+static const type_t *memo_super_type(void);
+
+static const char          *memo_super_type_name      (const type_t *self);
+static size_t               memo_super_type_size      (const type_t *self, const tval *val);
+static const type_t        *memo_super_type_is_subtype(const type_t *self, const type_t *is_subtype);
+
+static const type_t memo_super_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ memo_super_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ memo_super_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ memo_super_type_size
+  , /* @is_struct             */ NULL
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ memo_super_type_is_subtype
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static int memo_super_queries = 0;
+static int memo_super_resolves = 0;
+
+static const type_t *memo_super_type(void)
+  { ++memo_super_resolves; return &memo_super_type_def; }
+
+static const char          *memo_super_type_name      (const type_t *self)
+  { return "memo_super_t"; }
+
+static size_t               memo_super_type_size      (const type_t *self, const tval *val)
+  { return 0; }
+
+/* "once_triple_t" is a subtype. */
+static const type_t        *memo_super_type_is_subtype(const type_t *self, const type_t *is_subtype)
+{
+  ++memo_super_queries;
+
+  if (is_subtype == self || is_subtype == once_triple_type())
+    return self;
+
+  return NULL;
+}
+
+unit_test_t type_subtype_memo_test =
+  {  type_subtype_memo_test_run
+  , "type_subtype_memo_test"
+  , "Subtype queries consult the types' methods once per pair."
+  };
+
+unit_test_result_t type_subtype_memo_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    type_subtype_memo_invalidate();
+    memo_super_queries = 0;
+
+    ASSERT2( objpeq, is_subtype(once_triple_type(), memo_super_type()), memo_super_type() );
+    ASSERT2( inteq,  memo_super_queries, 1 );
+
+    ASSERT2( objpeq, is_subtype(once_triple_type(), memo_super_type()), memo_super_type() );
+    ASSERT2( objpeq, is_supertype(memo_super_type(), once_triple_type()), memo_super_type() );
+    ASSERT2( inteq,  memo_super_queries, 1 );
+
+    /* Negative answers too. */
+    ASSERT2( objpeq, is_subtype(int_type(), memo_super_type()), NULL );
+    ASSERT2( objpeq, is_subtype(int_type(), memo_super_type()), NULL );
+    ASSERT2( inteq,  memo_super_queries, 2 );
+
+    /* Asked again after invalidation. */
+    type_subtype_memo_invalidate();
+    ASSERT2( objpeq, is_subtype(once_triple_type(), memo_super_type()), memo_super_type() );
+    ASSERT2( inteq,  memo_super_queries, 3 );
+  }
+
+  return result;
+}
+
+unit_test_t struct_info_typed_field_test =
+  {  struct_info_typed_field_test_run
+  , "struct_info_typed_field_test"
+  , "Typed fields are resolved once, by the plan, and tval types are cached."
+  };
+
+unit_test_result_t struct_info_typed_field_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    const struct_info_t *struct_info;
+    template_cons_t      cons;
+    typed_t              typed;
+    int                  resolves;
+
+    /* The same answer whether or not the plan has resolved it. */
+    struct_info = type_is_struct(template_cons_type());
+    ASSERT2( objpeq, struct_info_has_typed_field(struct_info), struct_info_index_field(struct_info, STRUCT_INFO_TYPED_FIELD) );
+    ASSERT1( true, IS_TRUE(struct_info_plan(struct_info)) );
+    ASSERT2( objpeq, struct_info_plan(struct_info)->typed_field, struct_info_index_field(struct_info, STRUCT_INFO_TYPED_FIELD) );
+    ASSERT2( objpeq, struct_info_has_typed_field(struct_info), struct_info_index_field(struct_info, STRUCT_INFO_TYPED_FIELD) );
+
+    struct_info = type_is_struct(once_triple_type());
+    ASSERT1( true, IS_TRUE(struct_info_plan(struct_info)) );
+    ASSERT2( objpeq, struct_info_has_typed_field(struct_info), NULL );
+
+    cons = template_cons_defaults;
+    ASSERT2( objpeq, typeof(&cons), template_cons_type() );
+
+    cons.type = NULL;
+    ASSERT2( objpeq, typeof(&cons), NULL );
+    ASSERT2( objpeq, TVAL_TYPEOF(&cons), NULL );
+    ASSERT2( objpeq, typeof(NULL), NULL );
+
+    /* A type is resolved with a call once, then read from the cache, */
+    /* unless another type already holds its slot.                    */
+    typed = memo_super_type;
+    ASSERT2( objpeq, typeof(&typed), &memo_super_type_def );
+
+    resolves = memo_super_resolves;
+    ASSERT2( objpeq, TVAL_TYPEOF(&typed),           &memo_super_type_def );
+    ASSERT2( objpeq, typeof_indirect(&typed),       &memo_super_type_def );
+    ASSERT2( objpeq, TYPED_TYPEOF(memo_super_type), &memo_super_type_def );
+
+    if (TYPED_CACHED(memo_super_type) == &memo_super_type_def)
+    {
+      ASSERT2( inteq, memo_super_resolves, resolves );
+    }
+  }
+
+  return result;
+}
+
+unit_test_t struct_cmp_deep_test =
+  {  struct_cmp_deep_test_run
+  , "struct_cmp_deep_test"
+  , "Deep comparison follows long chains and cycles without recursing."
+  };
+
+unit_test_result_t struct_cmp_deep_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    hash_node_t     *a;
+    hash_node_t     *b;
+    hash_node_t      c[2];
+    hash_node_t      d[2];
+    hash_wrap_t     *w;
+    hash_wrap_t     *x;
+    ref_traversal_t  vals;
+    size_t           num;
+    size_t           i;
+
+    /* Far deeper than recursion through "type_cmp" could go. */
+    num = 100000;
+    a   = malloc(num * sizeof(*a));
+    b   = malloc(num * sizeof(*b));
+    ASSERT1( true, IS_TRUE(a) );
+    ASSERT1( true, IS_TRUE(b) );
+
+    for (i = 0; i < num; ++i)
+    {
+      a[i].id   = (int) i;
+      a[i].next = i + 1 < num ? &a[i + 1] : NULL;
+      b[i].id   = (int) i;
+      b[i].next = i + 1 < num ? &b[i + 1] : NULL;
+    }
+
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), a, b), 0 );
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), a, a), 0 );
+
+    /* The first difference decides, however deep. */
+    b[num - 1].id = (int) num;
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), a, b), -1 );
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), b, a),  1 );
+
+    /* A shorter chain sorts first. */
+    b[num - 1].id   = (int) (num - 1);
+    a[num - 2].next = NULL;
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), a, b), -1 );
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), b, a),  1 );
+
+    /* Shallow comparisons only see the addresses. */
+    a[num - 2].next = &a[num - 1];
+    ASSERT1( true, cmp_with_type_deep(hash_node_type(), a, b, 0) != 0 );
+
+    /* Loops terminate, near the top and deep down. */
+    c[0].id = 1; c[0].next = &c[1];
+    c[1].id = 2; c[1].next = &c[0];
+    d[0].id = 1; d[0].next = &d[1];
+    d[1].id = 2; d[1].next = &d[0];
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), c, d), -1 );
+
+    a[num - 1].next = &a[0];
+    b[num - 1].next = &b[0];
+    ASSERT2( inteq, cmp_with_type(hash_node_type(), a, b), -1 );
+
+    /* The caller's "vals" are left as they were given. */
+    ref_traversal_init_empty(&vals);
+    ASSERT2( inteq,  type_cmp(hash_node_type(), a, b, CMP_WITH_TYPE_DEFAULT_DEEP, &vals), -1 );
+    ASSERT2( sizeeq, ref_traversal_num(&vals), 0 );
+    a[num - 1].next = NULL;
+    b[num - 1].next = NULL;
+    ASSERT2( inteq,  type_cmp(hash_node_type(), a, b, CMP_WITH_TYPE_DEFAULT_DEEP, &vals), 0 );
+    ASSERT2( sizeeq, ref_traversal_num(&vals), 0 );
+    ref_traversal_clear(&vals);
+
+    /* Embedded recursible fields are frames too: each "node" is followed
+     * in place, then its "next" into the following wrap's "node".
+     */
+    w = malloc(num * sizeof(*w));
+    x = malloc(num * sizeof(*x));
+    ASSERT1( true, IS_TRUE(w) );
+    ASSERT1( true, IS_TRUE(x) );
+
+    for (i = 0; i < num; ++i)
+    {
+      w[i].node.id   = (int) i;
+      w[i].node.next = i + 1 < num ? &w[i + 1].node : NULL;
+      w[i].extra     = 1;
+      x[i].node.id   = (int) i;
+      x[i].node.next = i + 1 < num ? &x[i + 1].node : NULL;
+      x[i].extra     = 1;
+    }
+
+    ASSERT2( inteq, cmp_with_type(hash_wrap_type(), w, x), 0 );
+
+    x[num - 1].node.id = (int) num;
+    ASSERT2( inteq, cmp_with_type(hash_wrap_type(), w, x), -1 );
+    x[num - 1].node.id = (int) (num - 1);
+
+    x[0].extra = 2;
+    ASSERT2( inteq, cmp_with_type(hash_wrap_type(), w, x), -1 );
+    x[0].extra = 1;
+
+    w[num - 1].node.next = &w[0].node;
+    x[num - 1].node.next = &x[0].node;
+    ASSERT2( inteq, cmp_with_type(hash_wrap_type(), w, x), -1 );
+
+    free(x);
+    free(w);
+
+    free(b);
+    free(a);
+  }
+
+  return result;
+}
+
+/* A linked node whose "next" is shared by copies until it is modified. */
+
+typedef struct cow_node_s cow_node_t;
+struct cow_node_s
+{
+  memory_tracker_t  memory;
+  int               id;
+  cow_node_t       *next;
+};
+
+static const type_t *cow_node_type(void);
+static const type_t *cow_node_ref_type(void);
+
+static const char          *cow_node_type_name          (const type_t *self);
+static size_t               cow_node_type_size          (const type_t *self, const tval *val);
+static const struct_info_t *cow_node_type_is_struct     (const type_t *self);
+static size_t               cow_node_type_free          (const type_t *self, tval *val);
+
+static const char          *cow_node_ref_type_name      (const type_t *self);
+static size_t               cow_node_ref_type_size      (const type_t *self, const tval *val);
+static const type_t        *cow_node_ref_type_deref     (const type_t *self, const tval *val, const tval **out_ref);
+
+static const type_t cow_node_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ cow_node_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ cow_node_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ cow_node_type_size
+  , /* @is_struct             */ cow_node_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ cow_node_type_free
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t cow_node_ref_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ cow_node_ref_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ cow_node_ref_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ cow_node_ref_type_size
+  , /* @is_struct             */ type_is_not_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ type_has_shared_ref_dup
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ type_has_deref_cmp
+  , /* hash                   */ type_has_deref_hash
+  , /* deref                  */ cow_node_ref_type_deref
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *cow_node_type(void)
+  { return &cow_node_type_def; }
+
+static const type_t *cow_node_ref_type(void)
+  { return &cow_node_ref_type_def; }
+
+static const char          *cow_node_type_name          (const type_t *self)
+  { return "cow_node_t"; }
+
+static size_t               cow_node_type_size          (const type_t *self, const tval *val)
+  { return sizeof(cow_node_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(cow_node)
+static const struct_info_t *cow_node_type_is_struct     (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(cow_node);
+
+    /* memory_tracker_t  memory; */
+    /* int               id;     */
+    /* cow_node_t       *next;   */
+    STRUCT_INFO_RADD(memory_tracker_type(), memory);
+    STRUCT_INFO_LAST()->is_metadata = 1;
+    STRUCT_INFO_RADD(int_type(),            id);
+    STRUCT_INFO_RADD(cow_node_ref_type(),   next);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+
+    STRUCT_INFO_DONE();
+  }
+
+static size_t               cow_node_type_free          (const type_t *self, tval *val)
+  {
+    cow_node_t *node = val;
+
+    type_ref_release(cow_node_ref_type(), &node->next);
+
+    return template_cons_basic_freer(self, val);
+  }
+
+static const char          *cow_node_ref_type_name      (const type_t *self)
+  { return "cow_node_t *"; }
+
+static size_t               cow_node_ref_type_size      (const type_t *self, const tval *val)
+  { return sizeof(cow_node_t *); }
+
+static const type_t        *cow_node_ref_type_deref     (const type_t *self, const tval *val, const tval **out_ref)
+  {
+    if (out_ref)
+      *out_ref = val ? *((cow_node_t * const *) val) : NULL;
+
+    return cow_node_type();
+  }
+
+unit_test_t type_shared_ref_test =
+  {  type_shared_ref_test_run
+  , "type_shared_ref_test"
+  , "Recursive copies share referenced values until they are modified."
+  };
+
+unit_test_result_t type_shared_ref_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    cow_node_t *a[3];
+    cow_node_t *copy;
+    cow_node_t *mutable;
+    cow_node_t *shallow;
+    size_t      i;
+
+    /* a[0] -> a[1] -> a[2]. */
+    for (i = 0; i < ARRAY_NUM(a); ++i)
+    {
+      a[i] = type_init(cow_node_type(), NULL);
+      ASSERT1( true, IS_TRUE(a[i]) );
+      a[i]->id = (int) i;
+    }
+    a[0]->next = a[1];
+    a[1]->next = a[2];
+
+    /* Only the root is copied. */
+    copy = type_dup(cow_node_type(), NULL, a[0], 1, 1, 0, NULL);
+    ASSERT1( true, IS_TRUE(copy) );
+    ASSERT1( true, copy != a[0] );
+    ASSERT2( objpeq, copy->next, a[1] );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 1 );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[2]->memory), 0 );
+    ASSERT2( objpeq, type_is_mutable(cow_node_type(), a[1]), NULL );
+    ASSERT2( inteq,  cmp_with_type(cow_node_type(), copy, a[0]), 0 );
+
+    /* Modifying the shared value copies it, sharing what it refers to. */
+    mutable = type_ref_mutable(cow_node_ref_type(), &copy->next);
+    ASSERT1( true, IS_TRUE(mutable) );
+    ASSERT1( true, mutable != a[1] );
+    ASSERT2( objpeq, copy->next,    mutable );
+    ASSERT2( objpeq, mutable->next, a[2] );
+    ASSERT2( objpeq, a[0]->next,    a[1] );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 0 );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[2]->memory), 1 );
+
+    mutable->id = 10;
+    ASSERT2( inteq, a[1]->id, 1 );
+    ASSERT2( inteq, cmp_with_type(cow_node_type(), copy, a[0]), 1 );
+
+    /* Now it is this copy's own. */
+    ASSERT2( objpeq, type_ref_mutable(cow_node_ref_type(), &copy->next), mutable );
+
+    /* Freeing the copy only drops its shares. */
+    ASSERT1( true, type_free(cow_node_type(), copy) >= 1 );
+    ASSERT2( inteq, memory_tracker_is_shared(&a[2]->memory), 0 );
+    ASSERT2( inteq, a[2]->id, 2 );
+
+    /* A shallow copy of a reference adds an owner too. */
+    shallow = NULL;
+    ASSERT2( objpeq, type_dup(cow_node_ref_type(), &shallow, &a[0]->next, 1, 0, 0, NULL), &shallow );
+    ASSERT2( objpeq, shallow, a[1] );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 1 );
+
+    ASSERT2( sizeeq, type_ref_release(cow_node_ref_type(), &shallow), 0 );
+    ASSERT2( objpeq, shallow, NULL );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 0 );
+    ASSERT2( inteq,  a[1]->id, 1 );
+
+    /* So does a shallow copy of a struct holding one. */
+    copy = type_dup(cow_node_type(), NULL, a[0], 1, 0, 0, NULL);
+    ASSERT1( true, IS_TRUE(copy) );
+    ASSERT2( objpeq, copy->next, a[1] );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 1 );
+
+    ASSERT1( true, type_free(cow_node_type(), copy) >= 1 );
+    ASSERT2( inteq,  memory_tracker_is_shared(&a[1]->memory), 0 );
+    ASSERT2( inteq,  a[1]->id, 1 );
+
+    ASSERT1( true, type_free(cow_node_type(), a[0]) >= 1 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+/* Free a value that another thread allocated. */
+static void *type_remote_free_test_worker(void *val)
+{
+  if (type_free(hash_node_type(), val) < 1)
+    return NULL;
+
+  return val;
+}
+#endif /* #if POSIX_PARALLEL */
+
+unit_test_t type_remote_free_test =
+  {  type_remote_free_test_run
+  , "type_remote_free_test"
+  , "Typed values freed on another thread are handed back to their owner."
+  };
+
+unit_test_result_t type_remote_free_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+#if POSIX_PARALLEL
+  ENCLOSE()
+  {
+    memory_tracker_t *tracker;
+    hash_node_t      *node;
+    pthread_t         thread;
+    void             *status;
+
+    tracker = thread_typed_dyn_memory_tracker();
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    node = type_init(hash_node_type(), NULL);
+    ASSERT1( true, IS_TRUE(node) );
+    ASSERT2( objpeq, memory_tracker_owner(node), tracker );
+
+    ASSERT2( inteq, pthread_create(&thread, NULL, type_remote_free_test_worker, node), 0 );
+    ASSERT2( inteq, pthread_join(thread, &status), 0 );
+    ASSERT2( objpeq, status, node );
+
+    /* Queued to this thread, which frees it when next it asks. */
+    ASSERT1( true, tracked_byte_allocation(tracker, node) >= 0 );
+
+    ASSERT2( objpeq, thread_typed_dyn_memory_tracker(), tracker );
+    ASSERT1( true, tracked_byte_allocation(tracker, node) < 0 );
+
+    /* Values on the stack have no owner. */
+    ASSERT2( objpeq, memory_tracker_owner(&node), NULL );
+  }
+#endif /* #if POSIX_PARALLEL */
+
+  return result;
+}
@@ -51,6 +51,62 @@ unit_test_result_t test_type_base_run(unit_test_context_t *context);
 
 /* ---------------------------------------------------------------- */
 
+extern unit_test_t ref_traversal_test;
+unit_test_result_t ref_traversal_test_run(unit_test_context_t *context);
+
+extern unit_test_t ref_traversal_table_test;
+unit_test_result_t ref_traversal_table_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_dup_test;
+unit_test_result_t struct_dup_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_fields_test;
+unit_test_result_t struct_info_fields_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_plan_test;
+unit_test_result_t struct_info_plan_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_once_test;
+unit_test_result_t struct_info_once_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_static_test;
+unit_test_result_t struct_info_static_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_hash_test;
+unit_test_result_t type_hash_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_hash_cycle_test;
+unit_test_result_t type_hash_cycle_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_embedded_test;
+unit_test_result_t struct_embedded_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_pod_test;
+unit_test_result_t struct_info_pod_test_run(unit_test_context_t *context);
+
+extern unit_test_t template_cons_default_image_test;
+unit_test_result_t template_cons_default_image_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_init_array_test;
+unit_test_result_t type_init_array_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_subtype_memo_test;
+unit_test_result_t type_subtype_memo_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_info_typed_field_test;
+unit_test_result_t struct_info_typed_field_test_run(unit_test_context_t *context);
+
+extern unit_test_t struct_cmp_deep_test;
+unit_test_result_t struct_cmp_deep_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_shared_ref_test;
+unit_test_result_t type_shared_ref_test_run(unit_test_context_t *context);
+
+extern unit_test_t type_remote_free_test;
+unit_test_result_t type_remote_free_test_run(unit_test_context_t *context);
+
+/* ---------------------------------------------------------------- */
+
 /* TODO: intpair_t */
 
 #endif /* ifndef TESTS_TEST_TYPE_BASE_H */
@@ -30,6 +30,13 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/* string.h:
+ *   - memcmp
+ *   - memset
+ *   - strncmp
+ */
+#include <string.h>
+
 #include "../base.h"
 #include "testing.h"
 #include "test_type_base_compare.h"
@@ -58,6 +65,7 @@ unit_test_t type_base_compare_test =
 unit_test_t *type_base_compare_tests[] =
   { &ordering_equalities_test
   , &comparers_test
+  , &bulk_compare_test
 
   , NULL
   };
@@ -427,3 +435,92 @@ unit_test_result_t comparers_test_run(unit_test_context_t *context)
 
   return result;
 }
+
+unit_test_t bulk_compare_test =
+  {  bulk_compare_test_run
+  , "bulk_compare_test"
+  , "Bulk comparisons agree with \"memcmp\" and \"strncmp\"."
+  };
+
+unit_test_result_t bulk_compare_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    unsigned char check[160];
+    unsigned char baseline[160];
+    size_t        offset;
+    size_t        size;
+    size_t        i;
+
+    /* Every size across the vector and word paths, at every alignment, */
+    /* with a difference at every position, either way.                */
+    for (offset = 0; offset < 4; ++offset)
+    {
+      for (size = 0; size <= 130; ++size)
+      {
+        for (i = 0; i < sizeof(check); ++i)
+          check[i] = baseline[i] = (unsigned char) (i * 7 + 1);
+
+        ASSERT2( inteq, mem_cmp(check + offset, baseline + offset, size), 0 );
+        ASSERT2( inteq, mem_eq (check + offset, baseline + offset, size), 1 );
+
+        for (i = 0; i < size; ++i)
+        {
+          baseline[offset + i] = (unsigned char) (check[offset + i] + 0x80);
+
+          ASSERT2( inteq, mem_cmp(check + offset, baseline + offset, size), SIGN(memcmp(check + offset, baseline + offset, size)) );
+          ASSERT2( inteq, mem_cmp(baseline + offset, check + offset, size), SIGN(memcmp(baseline + offset, check + offset, size)) );
+          ASSERT2( inteq, mem_eq (check + offset, baseline + offset, size), 0 );
+
+          baseline[offset + i] = check[offset + i];
+        }
+
+        /* Differences past "size" don't count. */
+        baseline[offset + size] = (unsigned char) (check[offset + size] + 1);
+        ASSERT2( inteq, mem_cmp(check + offset, baseline + offset, size), 0 );
+        ASSERT2( inteq, mem_eq (check + offset, baseline + offset, size), 1 );
+      }
+    }
+
+    /* Strings end at their terminators, or after "n" bytes. */
+    memset(check,    'a', sizeof(check));
+    memset(baseline, 'a', sizeof(baseline));
+    check   [sizeof(check)    - 1] = '\0';
+    baseline[sizeof(baseline) - 1] = '\0';
+
+    for (size = 0; size < sizeof(check) - 1; size += 5)
+    {
+      check[size] = '\0';
+
+      for (i = 0; i < sizeof(check); i += 3)
+      {
+        ASSERT2( inteq, strn_cmp((const char *) check,    (const char *) baseline, i), SIGN(strncmp((const char *) check,    (const char *) baseline, i)) );
+        ASSERT2( inteq, strn_cmp((const char *) baseline, (const char *) check,    i), SIGN(strncmp((const char *) baseline, (const char *) check,    i)) );
+        ASSERT2( inteq, strn_eq ((const char *) check,    (const char *) baseline, i), strncmp((const char *) check, (const char *) baseline, i) == 0 );
+      }
+
+      /* Bytes after both terminators don't count. */
+      baseline[size] = '\0';
+      baseline[size + 1] = 'b';
+      ASSERT2( inteq, strn_cmp((const char *) check, (const char *) baseline, sizeof(check)), 0 );
+      ASSERT2( inteq, strn_eq ((const char *) check, (const char *) baseline, sizeof(check)), 1 );
+      baseline[size + 1] = 'a';
+      baseline[size]     = 'a';
+
+      check[size] = 'a';
+    }
+
+    /* As comparers. */
+    ASSERT2( inteq, call_callback_compare(callback_compare_mem_eq(4),  "abcd",  "abcd"),  ORDERING_EQ );
+    ASSERT2( inteq, call_callback_compare(callback_compare_mem_eq(4),  "abcd",  "abce"),  ORDERING_GT );
+    ASSERT2( inteq, call_callback_compare(callback_compare_mem_eq(3),  "abcd",  "abce"),  ORDERING_EQ );
+    ASSERT2( inteq, call_callback_compare(callback_compare_strn_eq(8), "ab",    "ab"),    ORDERING_EQ );
+    ASSERT2( inteq, call_callback_compare(callback_compare_strn_eq(8), "ab",    "abc"),   ORDERING_GT );
+    ASSERT2( inteq, call_callback_compare(callback_compare_mem(4),     "abcd",  "abce"),  ORDERING_LT );
+    ASSERT2( inteq, call_callback_compare(callback_compare_strn(8),    "abc",   "ab"),    ORDERING_GT );
+  }
+
+  return result;
+}
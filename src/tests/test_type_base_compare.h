@@ -57,4 +57,7 @@ unit_test_result_t ordering_equalities_test_run(unit_test_context_t *context);
 extern unit_test_t comparers_test;
 unit_test_result_t comparers_test_run(unit_test_context_t *context);
 
+extern unit_test_t bulk_compare_test;
+unit_test_result_t bulk_compare_test_run(unit_test_context_t *context);
+
 #endif /* ifndef TESTS_TEST_TYPE_BASE_COMPARE_H */
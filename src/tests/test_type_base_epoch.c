@@ -0,0 +1,281 @@
+/*
+ * opencurry: tests/test_type_base_epoch.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../base.h"
+
+#if POSIX_PARALLEL
+#include <pthread.h>
+#include <sched.h>
+#endif /* #if POSIX_PARALLEL */
+
+#include "testing.h"
+#include "test_type_base_epoch.h"
+
+#include "../type_base_epoch.h"
+#include "../type_base_memory_tracker.h"
+
+int test_type_base_epoch_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_epoch_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_epoch tests. */
+unit_test_t type_base_epoch_test =
+  {  test_type_base_epoch_run
+  , "test_type_base_epoch"
+  , "type_base_epoch tests."
+  };
+
+/* Array of type_base_epoch tests. */
+unit_test_t *type_base_epoch_tests[] =
+  { &epoch_retire_test
+  , &epoch_reader_thread_test
+  , &epoch_tracker_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_epoch_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_epoch_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+static size_t epoch_test_cleanup(void *context)
+{
+  size_t *cleanups = context;
+  size_t  num;
+
+  /* Cleanups may run on whichever thread advances the epoch. */
+  do
+  {
+    num = ATOMIC_LOAD(cleanups);
+  } while (!ATOMIC_CAS(cleanups, num, num + 1));
+
+  return 1;
+}
+
+unit_test_t epoch_retire_test =
+  {  epoch_retire_test_run
+  , "epoch_retire_test"
+  , "Retired values outlive the critical sections they were retired in."
+  };
+
+unit_test_result_t epoch_retire_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    size_t cleanups;
+    int    i;
+
+    cleanups = 0;
+
+    ASSERT2( inteq, epoch_is_active(), 0 );
+
+    ASSERT2( inteq, epoch_enter(), 1 );
+    ASSERT2( inteq, epoch_enter(), 1 );
+    ASSERT2( inteq, epoch_is_active(), 1 );
+
+    ASSERT2( sizeeq, epoch_retire(epoch_test_cleanup, &cleanups), 1 );
+    ASSERT2( sizeeq, epoch_retired_num(), 1 );
+
+    /* Nothing is freed while the section is active. */
+    for (i = 0; i < 4; ++i)
+      epoch_collect();
+    ASSERT2( sizeeq, cleanups, 0 );
+
+    epoch_exit();
+    ASSERT2( inteq, epoch_is_active(), 1 );
+    for (i = 0; i < 4; ++i)
+      epoch_collect();
+    ASSERT2( sizeeq, cleanups, 0 );
+
+    epoch_exit();
+    ASSERT2( inteq, epoch_is_active(), 0 );
+
+    ASSERT1( true, epoch_synchronize() >= 1 );
+    ASSERT2( sizeeq, cleanups, 1 );
+    ASSERT2( sizeeq, epoch_retired_num(), 0 );
+
+    /* Retiring collects periodically. */
+    for (i = 0; i < 2 * EPOCH_COLLECT_INTERVAL; ++i)
+      epoch_retire(epoch_test_cleanup, &cleanups);
+    ASSERT1( true, cleanups > 1 );
+
+    epoch_synchronize();
+    ASSERT2( sizeeq, cleanups, 1 + 2 * EPOCH_COLLECT_INTERVAL );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+static volatile int epoch_reader_thread_test_entered = 0;
+static volatile int epoch_reader_thread_test_release = 0;
+
+static void *epoch_reader_thread_test_reader(void *context)
+{
+  if (!epoch_enter())
+    return NULL;
+
+  ATOMIC_STORE(&epoch_reader_thread_test_entered, 1);
+
+  while (!ATOMIC_LOAD(&epoch_reader_thread_test_release))
+    sched_yield();
+
+  epoch_exit();
+
+  return context;
+}
+#endif /* #if POSIX_PARALLEL */
+
+unit_test_t epoch_reader_thread_test =
+  {  epoch_reader_thread_test_run
+  , "epoch_reader_thread_test"
+  , "Another thread's critical section holds back reclamation."
+  };
+
+unit_test_result_t epoch_reader_thread_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+#if POSIX_PARALLEL
+  ENCLOSE()
+  {
+    pthread_t reader;
+    void     *joined;
+    size_t    cleanups;
+    int       i;
+
+    cleanups = 0;
+
+    ATOMIC_STORE(&epoch_reader_thread_test_entered, 0);
+    ATOMIC_STORE(&epoch_reader_thread_test_release, 0);
+
+    ASSERT2( inteq, pthread_create(&reader, NULL, epoch_reader_thread_test_reader, &cleanups), 0 );
+
+    while (!ATOMIC_LOAD(&epoch_reader_thread_test_entered))
+      sched_yield();
+
+    epoch_retire(epoch_test_cleanup, &cleanups);
+
+    for (i = 0; i < 8; ++i)
+      epoch_collect();
+    ASSERT2( sizeeq, ATOMIC_LOAD(&cleanups), 0 );
+
+    ATOMIC_STORE(&epoch_reader_thread_test_release, 1);
+
+    ASSERT2( inteq, pthread_join(reader, &joined), 0 );
+    ASSERT2( objpeq, joined, &cleanups );
+
+    epoch_synchronize();
+    ASSERT2( sizeeq, ATOMIC_LOAD(&cleanups), 1 );
+  }
+#endif /* #if POSIX_PARALLEL */
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t epoch_tracker_test =
+  {  epoch_tracker_test_run
+  , "epoch_tracker_test"
+  , "Memory trackers retiring instead of freeing."
+  };
+
+unit_test_result_t epoch_tracker_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+
+  tracker = memory_tracker_init(&memory_tracker, NULL, NULL);
+
+  ENCLOSE()
+  {
+    size_t  cleanups;
+    void   *block;
+
+    cleanups = 0;
+
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    tracker->retire = TRUE();
+
+    ASSERT2( inteq, epoch_enter(), 1 );
+    {
+      block = track_mmalloc(tracker, 64, NULL);
+      ASSERT1( true, IS_TRUE(block) );
+
+      ASSERT1( true, track_manual_allocation(tracker, manual_allocation(epoch_test_cleanup, &cleanups)) >= 0 );
+
+      /* Untracked and retired. */
+      ASSERT2( sizeeq, track_mfree(tracker, block), 2 );
+      ASSERT2( inteq,  tracked_byte_allocation(tracker, block), UNTRACKED );
+
+      ASSERT2( sizeeq, track_manual_free(tracker, manual_allocation(epoch_test_cleanup, &cleanups)), 2 );
+
+      ASSERT2( sizeeq, epoch_retired_num(), 2 );
+
+      epoch_collect();
+      epoch_collect();
+      ASSERT2( sizeeq, cleanups, 0 );
+    }
+    epoch_exit();
+
+    ASSERT2( sizeeq, epoch_synchronize(), 2 );
+    ASSERT2( sizeeq, cleanups, 1 );
+
+    /* Intrusive blocks too. */
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, TRUE()), tracker );
+
+    block = track_mmalloc(tracker, 64, NULL);
+    ASSERT1( true, IS_TRUE(block) );
+    ASSERT2( sizeeq, track_mfree(tracker, block), 2 );
+    ASSERT2( sizeeq, epoch_retired_num(), 1 );
+
+    ASSERT2( sizeeq, epoch_synchronize(), 1 );
+  }
+
+  memory_tracker_free(tracker);
+
+  return result;
+}
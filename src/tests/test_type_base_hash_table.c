@@ -0,0 +1,320 @@
+/*
+ * opencurry: tests/test_type_base_hash_table.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stdlib.h:
+ *   - div_t
+ */
+#include <stdlib.h>
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_hash_table.h"
+
+#include "../type_base.h"
+#include "../type_base_hash_table.h"
+
+int test_type_base_hash_table_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_hash_table_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_hash_table tests. */
+unit_test_t type_base_hash_table_test =
+  {  test_type_base_hash_table_run
+  , "test_type_base_hash_table"
+  , "type_base_hash_table tests."
+  };
+
+/* Array of type_base_hash_table tests. */
+unit_test_t *type_base_hash_table_tests[] =
+  { &hash_table_map_test
+  , &hash_table_remove_test
+  , &hash_table_identity_test
+  , &hash_table_struct_key_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_hash_table_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_hash_table_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* Enough keys to grow the table several times. */
+#define HASH_TABLE_TEST_KEYS 1000
+
+unit_test_t hash_table_map_test =
+  {  hash_table_map_test_run
+  , "hash_table_map_test"
+  , "Inserting, finding, and replacing keys compared by value."
+  };
+
+unit_test_result_t hash_table_map_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  hash_table_t  hash_table;
+  hash_table_t *table;
+
+  static int keys  [HASH_TABLE_TEST_KEYS];
+  static int values[HASH_TABLE_TEST_KEYS];
+
+  table = hash_table_init(&hash_table, int_type(), 0, NULL);
+
+  ENCLOSE()
+  {
+    size_t  i;
+    int     inserted;
+    int     other;
+    void  **value;
+
+    for (i = 0; i < HASH_TABLE_TEST_KEYS; ++i)
+    {
+      keys  [i] = (int) i * 7 - 300;
+      values[i] = (int) i;
+    }
+
+    ASSERT2( sizeeq, hash_table_num(table), 0 );
+    ASSERT2( objpeq, hash_table_find(table, &keys[0]), NULL );
+
+    for (i = 0; i < HASH_TABLE_TEST_KEYS; ++i)
+    {
+      value = hash_table_insert(table, &keys[i], &inserted);
+      ASSERT1( true, IS_TRUE(value) );
+      ASSERT2( inteq, inserted, 1 );
+      ASSERT2( objpeq, *value, NULL );
+      *value = &values[i];
+    }
+
+    ASSERT2( sizeeq, hash_table_num(table), HASH_TABLE_TEST_KEYS );
+    ASSERT1( true, IS_TRUE(table->size * 3 >= HASH_TABLE_TEST_KEYS * 4) );
+
+    /* Keys are found by value, not by address. */
+    for (i = 0; i < HASH_TABLE_TEST_KEYS; ++i)
+    {
+      other = keys[i];
+
+      value = hash_table_find(table, &other);
+      ASSERT1( true, IS_TRUE(value) );
+      ASSERT2( objpeq, *value, &values[i] );
+      ASSERT2( objpeq, hash_table_find_key(table, &other), &keys[i] );
+    }
+
+    other = -301;
+    ASSERT2( objpeq, hash_table_find(table, &other), NULL );
+    ASSERT2( inteq,  hash_table_contains(table, &other), 0 );
+
+    /* Inserting an existing key finds it. */
+    value = hash_table_insert(table, &keys[5], &inserted);
+    ASSERT2( inteq,  inserted, 0 );
+    ASSERT2( objpeq, *value, &values[5] );
+
+    ASSERT2( objpeq, hash_table_put(table, &keys[5], &values[6]), &values[5] );
+    ASSERT2( objpeq, *hash_table_find(table, &keys[5]), &values[6] );
+    ASSERT2( sizeeq, hash_table_num(table), HASH_TABLE_TEST_KEYS );
+
+    hash_table_clear(table);
+    ASSERT2( sizeeq, hash_table_num(table), 0 );
+    ASSERT2( objpeq, hash_table_find(table, &keys[5]), NULL );
+  }
+
+  hash_table_deinit(table);
+
+  return result;
+}
+
+unit_test_t hash_table_remove_test =
+  {  hash_table_remove_test_run
+  , "hash_table_remove_test"
+  , "Removing keys, reusing their slots, and iterating."
+  };
+
+unit_test_result_t hash_table_remove_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  hash_table_t  hash_table;
+  hash_table_t *table;
+
+  static int keys[HASH_TABLE_TEST_KEYS];
+
+  table = hash_table_init(&hash_table, int_type(), 0, NULL);
+
+  ENCLOSE()
+  {
+    size_t      i;
+    size_t      cursor;
+    size_t      seen;
+    size_t      size;
+    const tval *key;
+    void       *value;
+
+    for (i = 0; i < HASH_TABLE_TEST_KEYS; ++i)
+    {
+      keys[i] = (int) i;
+      ASSERT2( objpeq, hash_table_put(table, &keys[i], &keys[i]), NULL );
+    }
+
+    /* Remove the odd keys. */
+    for (i = 1; i < HASH_TABLE_TEST_KEYS; i += 2)
+    {
+      value = NULL;
+      ASSERT2( inteq,  hash_table_remove(table, &keys[i], &value), 1 );
+      ASSERT2( objpeq, value, &keys[i] );
+      ASSERT2( inteq,  hash_table_remove(table, &keys[i], NULL), 0 );
+    }
+
+    ASSERT2( sizeeq, hash_table_num(table), HASH_TABLE_TEST_KEYS / 2 );
+
+    for (i = 0; i < HASH_TABLE_TEST_KEYS; ++i)
+      ASSERT2( inteq, hash_table_contains(table, &keys[i]), (int) (i % 2 == 0) );
+
+    /* Iteration visits each remaining entry once. */
+    cursor = 0;
+    seen   = 0;
+    while (hash_table_next(table, &cursor, &key, &value))
+    {
+      ASSERT2( objpeq, key, value );
+      ASSERT2( inteq,  *((const int *) key) % 2, 0 );
+      ++seen;
+    }
+    ASSERT2( sizeeq, seen, HASH_TABLE_TEST_KEYS / 2 );
+
+    /* Reinserting the removed keys reuses their slots without growing. */
+    size = table->size;
+    for (i = 1; i < HASH_TABLE_TEST_KEYS; i += 2)
+      ASSERT2( objpeq, hash_table_put(table, &keys[i], &keys[i]), NULL );
+
+    ASSERT2( sizeeq, hash_table_num(table), HASH_TABLE_TEST_KEYS );
+    ASSERT2( sizeeq, table->size, size );
+
+    /* Removing the current entry while iterating. */
+    cursor = 0;
+    while (hash_table_next(table, &cursor, &key, &value))
+      ASSERT2( inteq, hash_table_remove(table, key, NULL), 1 );
+
+    ASSERT2( sizeeq, hash_table_num(table), 0 );
+  }
+
+  hash_table_deinit(table);
+
+  return result;
+}
+
+unit_test_t hash_table_identity_test =
+  {  hash_table_identity_test_run
+  , "hash_table_identity_test"
+  , "Tables without a key type compare keys by address."
+  };
+
+unit_test_result_t hash_table_identity_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  hash_table_t  hash_table;
+  hash_table_t *table;
+
+  table = hash_table_init(&hash_table, NULL, 0, NULL);
+
+  ENCLOSE()
+  {
+    static const char int_name[]  = "int";
+    static const char char_name[] = "char";
+
+    int a = 3;
+    int b = 3;
+
+    /* e.g. a cache keyed by type. */
+    ASSERT2( objpeq, hash_table_put(table, int_type(),  (void *) int_name),  NULL );
+    ASSERT2( objpeq, hash_table_put(table, char_type(), (void *) char_name), NULL );
+
+    ASSERT2( sizeeq, hash_table_num(table), 2 );
+    ASSERT2( objpeq, *hash_table_find(table, int_type()),  int_name );
+    ASSERT2( objpeq, *hash_table_find(table, char_type()), char_name );
+    ASSERT2( objpeq, hash_table_find(table, long_type()),  NULL );
+
+    /* Equal values at different addresses are different keys. */
+    ASSERT2( objpeq, hash_table_put(table, &a, &a), NULL );
+    ASSERT2( objpeq, hash_table_find(table, &b), NULL );
+    ASSERT2( objpeq, *hash_table_find(table, &a), &a );
+  }
+
+  hash_table_deinit(table);
+
+  return result;
+}
+
+unit_test_t hash_table_struct_key_test =
+  {  hash_table_struct_key_test_run
+  , "hash_table_struct_key_test"
+  , "Struct keys hash and compare by their fields."
+  };
+
+unit_test_result_t hash_table_struct_key_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  hash_table_t  hash_table;
+  hash_table_t *table;
+
+  table = hash_table_init(&hash_table, div_type(), 1, NULL);
+
+  ENCLOSE()
+  {
+    div_t a;
+    div_t b;
+    div_t c;
+
+    a.quot = 7; a.rem = 2;
+    b.quot = 7; b.rem = 2;
+    c.quot = 2; c.rem = 7;
+
+    ASSERT2( sizeeq, hash_table_hash_key(table, &a), hash_table_hash_key(table, &b) );
+
+    ASSERT2( objpeq, hash_table_put(table, &a, &a), NULL );
+    ASSERT2( objpeq, hash_table_put(table, &b, &b), &a );
+    ASSERT2( sizeeq, hash_table_num(table), 1 );
+
+    ASSERT2( objpeq, hash_table_find(table, &c), NULL );
+    ASSERT2( objpeq, hash_table_put(table, &c, &c), NULL );
+    ASSERT2( sizeeq, hash_table_num(table), 2 );
+    ASSERT2( objpeq, *hash_table_find(table, &c), &c );
+  }
+
+  hash_table_deinit(table);
+
+  return result;
+}
@@ -0,0 +1,66 @@
+/*
+ * opencurry: tests/test_type_base_hash_table.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * tests/test_type_base_hash_table.h
+ * ------
+ */
+
+#ifndef TESTS_TEST_TYPE_BASE_HASH_TABLE_H
+#define TESTS_TEST_TYPE_BASE_HASH_TABLE_H
+#include "../base.h"
+#include "testing.h"
+
+#include "../util.h"
+
+int test_type_base_hash_table_cli(int argc, char **argv);
+
+extern unit_test_t type_base_hash_table_test;
+extern unit_test_t *type_base_hash_table_tests[];
+
+unit_test_result_t test_type_base_hash_table_run(unit_test_context_t *context);
+
+/* ---------------------------------------------------------------- */
+
+extern unit_test_t hash_table_map_test;
+unit_test_result_t hash_table_map_test_run(unit_test_context_t *context);
+
+extern unit_test_t hash_table_remove_test;
+unit_test_result_t hash_table_remove_test_run(unit_test_context_t *context);
+
+extern unit_test_t hash_table_identity_test;
+unit_test_result_t hash_table_identity_test_run(unit_test_context_t *context);
+
+extern unit_test_t hash_table_struct_key_test;
+unit_test_result_t hash_table_struct_key_test_run(unit_test_context_t *context);
+
+#endif /* ifndef TESTS_TEST_TYPE_BASE_HASH_TABLE_H */
@@ -35,6 +35,7 @@
 #include "test_type_base_memory_manager.h"
 
 #include "../type_base_memory_manager.h"
+#include "../type_base_mmap_manager.h"
 
 int test_type_base_memory_manager_cli(int argc, char **argv)
 {
@@ -52,7 +53,10 @@ unit_test_t type_base_memory_manager_test =
 
 /* Array of type_base_memory_manager tests. */
 unit_test_t *type_base_memory_manager_tests[] =
-  { NULL
+  { &memory_manager_aligned_test
+  , &memory_manager_hinted_test
+
+  , NULL
   };
 
 unit_test_result_t test_type_base_memory_manager_run(unit_test_context_t *context)
@@ -62,3 +66,83 @@ unit_test_result_t test_type_base_memory_manager_run(unit_test_context_t *contex
 
 /* ---------------------------------------------------------------- */
 
+unit_test_t memory_manager_aligned_test =
+  {  memory_manager_aligned_test_run
+  , "memory_manager_aligned_test"
+  , "Aligned allocation, with and without manager support."
+  };
+
+unit_test_result_t memory_manager_aligned_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    static const size_t alignments[] = { 1, 8, 64, 4096 };
+
+    size_t  i;
+    char   *block;
+
+    for (i = 0; i < sizeof(alignments) / sizeof(*alignments); ++i)
+    {
+      /* Fallback through "mmalloc". */
+      block = memory_manager_mmalloc_aligned(&malloc_manager, alignments[i], 100);
+      ASSERT1( true, IS_TRUE(block) );
+      ASSERT2( sizeeq, ((size_t) block) % alignments[i], 0 );
+      block[0] = block[99] = 'x';
+      ASSERT2( sizeeq, memory_manager_mfree_aligned(&malloc_manager, block), 1 );
+
+      /* Native. */
+      block = memory_manager_mmalloc_aligned(&mmap_manager, alignments[i], 100);
+      ASSERT1( true, IS_TRUE(block) );
+      ASSERT2( sizeeq, ((size_t) block) % alignments[i], 0 );
+      block[0] = block[99] = 'x';
+      ASSERT2( sizeeq, memory_manager_mfree_aligned(&mmap_manager, block), 1 );
+    }
+
+    /* Not a power of two. */
+    ASSERT2( objpeq, memory_manager_mmalloc_aligned(&malloc_manager, 24, 100), NULL );
+    ASSERT2( objpeq, memory_manager_mmalloc_aligned(&mmap_manager,   24, 100), NULL );
+    ASSERT2( objpeq, memory_manager_mmalloc_aligned(&malloc_manager,  0, 100), NULL );
+  }
+
+  return result;
+}
+
+unit_test_t memory_manager_hinted_test =
+  {  memory_manager_hinted_test_run
+  , "memory_manager_hinted_test"
+  , "Hinted allocation falls back to mmalloc and mcalloc."
+  };
+
+unit_test_result_t memory_manager_hinted_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    unsigned char *block;
+    size_t         i;
+
+    ASSERT2( inteq, memory_manager_supports_hints(&malloc_manager), 0 );
+    ASSERT2( inteq, memory_manager_supports_hints(&mmap_manager),   1 );
+
+    block = memory_manager_mmalloc_hinted(&malloc_manager, 256, MEMORY_HINT_HUGE_PAGES | MEMORY_HINT_ZEROED);
+    ASSERT1( true, IS_TRUE(block) );
+    for (i = 0; i < 256; ++i)
+      if (block[i])
+        break;
+    ASSERT2( sizeeq, i, 256 );
+
+    /* Hinted blocks are ordinary blocks. */
+    block = memory_manager_mrealloc(&malloc_manager, block, 512);
+    ASSERT1( true, IS_TRUE(block) );
+    ASSERT2( sizeeq, memory_manager_mfree(&malloc_manager, block), 1 );
+
+    block = memory_manager_mmalloc_hinted(&malloc_manager, 256, MEMORY_HINT_COLD);
+    ASSERT1( true, IS_TRUE(block) );
+    ASSERT2( sizeeq, memory_manager_mfree(&malloc_manager, block), 1 );
+  }
+
+  return result;
+}
@@ -51,4 +51,12 @@ unit_test_result_t test_type_base_memory_manager_run(unit_test_context_t *contex
 
 /* ---------------------------------------------------------------- */
 
+extern unit_test_t memory_manager_aligned_test;
+unit_test_result_t memory_manager_aligned_test_run(unit_test_context_t *context);
+
+extern unit_test_t memory_manager_hinted_test;
+unit_test_result_t memory_manager_hinted_test_run(unit_test_context_t *context);
+
+/* ---------------------------------------------------------------- */
+
 #endif /* ifndef TESTS_TEST_TYPE_BASE_MEMORY_MANAGER_H */
@@ -0,0 +1,313 @@
+/*
+ * opencurry: tests/test_type_base_memory_stats.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_memory_stats.h"
+
+#include "../type_base_memory_stats.h"
+
+/* Blocks "memory_stats_deinit" frees for the calling thread's counters. */
+#if POSIX_PARALLEL
+#define LOCAL_COUNTERS_NUM 1
+#else  /* #if POSIX_PARALLEL */
+#define LOCAL_COUNTERS_NUM 0
+#endif /* #if POSIX_PARALLEL */
+
+int test_type_base_memory_stats_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_memory_stats_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_memory_stats tests. */
+unit_test_t type_base_memory_stats_test =
+  {  test_type_base_memory_stats_run
+  , "test_type_base_memory_stats"
+  , "type_base_memory_stats tests."
+  };
+
+/* Array of type_base_memory_stats tests. */
+unit_test_t *type_base_memory_stats_tests[] =
+  { &memory_stats_counts_test
+  , &memory_stats_sites_test
+  , &memory_stats_tracker_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_memory_stats_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_memory_stats_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t memory_stats_counts_test =
+  {  memory_stats_counts_test_run
+  , "memory_stats_counts_test"
+  , "Counting allocations, frees, and live and peak bytes."
+  };
+
+unit_test_result_t memory_stats_counts_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_stats_t           memory_stats;
+  memory_stats_t          *stats;
+  memory_manager_t         memory_manager;
+  memory_manager_t        *manager;
+  memory_stats_snapshot_t  snapshot;
+
+  stats   = memory_stats_init(&memory_stats, NULL);
+  manager = memory_stats_manager_init(&memory_manager, stats);
+
+  ENCLOSE()
+  {
+    char *a;
+    char *b;
+
+    ASSERT1( true, IS_TRUE(stats) );
+    ASSERT1( true, IS_TRUE(manager) );
+    ASSERT2( objpeq, memory_manager_stats(manager),         stats );
+    ASSERT2( objpeq, memory_manager_stats(&malloc_manager), NULL );
+
+    ASSERT2( sizeeq, memory_stats_histogram_bucket(0),   0 );
+    ASSERT2( sizeeq, memory_stats_histogram_bucket(1),   1 );
+    ASSERT2( sizeeq, memory_stats_histogram_bucket(100), 7 );
+    ASSERT2( sizeeq, memory_stats_histogram_bucket(128), 8 );
+
+    /* ---------------------------------------------------------------- */
+
+    a = memory_manager_mmalloc(manager, 100);
+    b = memory_manager_mcalloc(manager, 10, 3);
+    ASSERT1( true, IS_TRUE(a) );
+    ASSERT1( true, IS_TRUE(b) );
+    ASSERT2( inteq, b[29], 0 );
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.allocs,        2 );
+    ASSERT2( ulongeq, snapshot.frees,         0 );
+    ASSERT2( inteq,   snapshot.live_bytes,    130 );
+    ASSERT2( inteq,   snapshot.peak_bytes,    130 );
+    ASSERT2( ulongeq, snapshot.histogram[7],  1 );
+    ASSERT2( ulongeq, snapshot.histogram[5],  1 );
+
+    a = memory_manager_mrealloc(manager, a, 200);
+    ASSERT1( true, IS_TRUE(a) );
+
+    ASSERT2( sizeeq, memory_manager_mfree(manager, a), 1 );
+    ASSERT2( sizeeq, memory_manager_mfree(manager, b), 1 );
+
+    /* As with "free", NULL is ignored, and isn't counted. */
+    ASSERT2( sizeeq, memory_manager_mfree(manager, NULL), 0 );
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.allocs,        2 );
+    ASSERT2( ulongeq, snapshot.reallocs,      1 );
+    ASSERT2( ulongeq, snapshot.frees,         2 );
+    ASSERT2( inteq,   snapshot.live_bytes,    0 );
+    ASSERT2( inteq,   snapshot.peak_bytes,    230 );
+    ASSERT2( ulongeq, snapshot.total_bytes,   330 );
+
+    /* ---------------------------------------------------------------- */
+
+    memory_stats_reset(stats);
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.allocs,        0 );
+    ASSERT2( inteq,   snapshot.peak_bytes,    0 );
+
+    /* The thread resets its own counters before counting again. */
+    a = memory_manager_mmalloc(manager, 10);
+    ASSERT1( true, IS_TRUE(a) );
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.allocs,        1 );
+    ASSERT2( ulongeq, snapshot.reallocs,      0 );
+    ASSERT2( inteq,   snapshot.live_bytes,    10 );
+    ASSERT2( ulongeq, snapshot.total_bytes,   10 );
+
+    memory_manager_mfree(manager, a);
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq, memory_stats_deinit(stats), LOCAL_COUNTERS_NUM );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t memory_stats_sites_test =
+  {  memory_stats_sites_test_run
+  , "memory_stats_sites_test"
+  , "Per-call-site counters."
+  };
+
+unit_test_result_t memory_stats_sites_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_stats_t      memory_stats;
+  memory_stats_t     *stats;
+  memory_manager_t    memory_manager;
+  memory_manager_t   *manager;
+  memory_stats_site_t sites[4];
+
+  stats   = memory_stats_init(&memory_stats, NULL);
+  manager = memory_stats_manager_init(&memory_manager, stats);
+
+  ENCLOSE()
+  {
+    void   *small[3];
+    void   *big;
+    size_t  i;
+
+    ASSERT1( true, IS_TRUE(manager) );
+
+    for (i = 0; i < 3; ++i)
+      small[i] = MEMORY_MANAGER_MMALLOC_SITE(manager, 8);
+    big = MEMORY_MANAGER_MMALLOC_SITE(manager, 1000);
+
+    /* Not attributed to any site. */
+    memory_manager_mfree(manager, memory_manager_mmalloc(manager, 5));
+
+    ASSERT2( sizeeq, memory_stats_read_sites(stats, sites, 4), 2 );
+
+    /* Sorted by live bytes. */
+    ASSERT2( inteq,   sites[0].live_bytes, 1000 );
+    ASSERT2( ulongeq, sites[0].allocs,     1 );
+    ASSERT2( inteq,   sites[1].live_bytes, 24 );
+    ASSERT2( ulongeq, sites[1].allocs,     3 );
+    ASSERT2( inteq,   sites[1].line,       sites[0].line - 1 );
+    ASSERT3( nstreq,  64, sites[0].file,   __FILE__ );
+
+    for (i = 0; i < 3; ++i)
+      memory_manager_mfree(manager, small[i]);
+    memory_manager_mfree(manager, big);
+
+    ASSERT2( sizeeq, memory_stats_read_sites(stats, sites, 1), 1 );
+    ASSERT2( inteq,   sites[0].live_bytes, 0 );
+
+    /* Non-stats managers are passed through. */
+    big = MEMORY_MANAGER_MMALLOC_SITE(&malloc_manager, 16);
+    ASSERT1( true, IS_TRUE(big) );
+    memory_manager_mfree(&malloc_manager, big);
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq, memory_stats_deinit(stats), LOCAL_COUNTERS_NUM );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t memory_stats_tracker_test =
+  {  memory_stats_tracker_test_run
+  , "memory_stats_tracker_test"
+  , "Attaching memory statistics to a memory tracker."
+  };
+
+unit_test_result_t memory_stats_tracker_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_stats_t           stats;
+  memory_stats_t           late_stats;
+  memory_tracker_t         tracker;
+  memory_tracker_t         late_tracker;
+  memory_stats_snapshot_t  snapshot;
+
+  tracker      = memory_tracker_defaults;
+  late_tracker = memory_tracker_defaults;
+
+  ENCLOSE()
+  {
+    int *intp;
+    int *early;
+
+    ASSERT1( true, IS_TRUE(memory_stats_attach_tracker(&stats, &tracker)) );
+
+    intp = track_mmalloc(&tracker, sizeof(*intp), NULL);
+    ASSERT1( true, IS_TRUE(intp) );
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(&stats, &snapshot)) );
+    ASSERT2( not_ulongeq, snapshot.allocs, 0 );
+    ASSERT2( not_inteq,   snapshot.live_bytes, 0 );
+
+    track_mfree(&tracker, intp);
+    memory_tracker_free(&tracker);
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(&stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.frees, snapshot.allocs );
+    ASSERT2( inteq,   snapshot.live_bytes, 0 );
+
+    /* ---------------------------------------------------------------- */
+
+    /* Attach to a tracker that has already allocated its containers. */
+    early = track_mmalloc(&late_tracker, sizeof(*early), NULL);
+    ASSERT1( true, IS_TRUE(early) );
+
+    ASSERT1( true, IS_TRUE(memory_stats_attach_tracker(&late_stats, &late_tracker)) );
+
+    intp = track_mmalloc(&late_tracker, sizeof(*intp), NULL);
+    ASSERT1( true, IS_TRUE(intp) );
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(&late_stats, &snapshot)) );
+    ASSERT2( not_ulongeq, snapshot.allocs, 0 );
+    ASSERT2( not_inteq,   snapshot.live_bytes, 0 );
+
+    /* Blocks from before attaching are not counted. */
+    track_mfree(&late_tracker, early);
+    track_mfree(&late_tracker, intp);
+    memory_tracker_free(&late_tracker);
+
+    ASSERT1( true, IS_TRUE(memory_stats_read(&late_stats, &snapshot)) );
+    ASSERT2( ulongeq, snapshot.frees, snapshot.allocs );
+    ASSERT2( inteq,   snapshot.live_bytes, 0 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq,     memory_stats_deinit(&stats),      LOCAL_COUNTERS_NUM );
+    ASSERT2( not_sizeeq, memory_stats_deinit(&late_stats), 0 );
+  }
+
+  return result;
+}
@@ -31,6 +31,11 @@
  */
 
 #include "../base.h"
+
+#if POSIX_PARALLEL
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
 #include "testing.h"
 #include "test_type_base_memory_tracker.h"
 
@@ -53,6 +58,12 @@ unit_test_t type_base_memory_tracker_test =
 /* Array of type_base_memory_tracker tests. */
 unit_test_t *type_base_memory_tracker_tests[] =
   { &memory_tracking_test
+  , &intrusive_tracking_test
+  , &dependency_cycle_test
+  , &dependency_chain_test
+  , &checkpoint_test
+  , &thread_tracker_test
+  , &deferred_free_test
 
   , NULL
   };
@@ -117,3 +128,628 @@ unit_test_result_t memory_tracking_test_run(unit_test_context_t *context)
 
   return result;
 }
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t intrusive_tracking_test =
+  {  intrusive_tracking_test_run
+  , "intrusive_tracking_test"
+  , "Testing header-based memory tracking."
+  };
+
+unit_test_result_t intrusive_tracking_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+
+  memory_tracker_t  other_memory_tracker;
+  memory_tracker_t *other;
+
+  tracker = memory_tracker_init(&memory_tracker,       NULL, NULL);
+  other   = memory_tracker_init(&other_memory_tracker, NULL, NULL);
+
+  ENCLOSE()
+  {
+    int   index;
+    int  *a;
+    int  *b;
+    int  *c;
+    char *buf;
+    int  *foreign;
+
+    ASSERT1( true, IS_TRUE(tracker) );
+    ASSERT1( true, IS_TRUE(other)   );
+
+    /* Trackers with explicitly registered blocks can't become intrusive. */
+    foreign = memory_manager_mmalloc(default_memory_manager, sizeof(*foreign));
+    ASSERT1( true, IS_TRUE(foreign) );
+
+    ASSERT1( true, track_byte_allocation(other, foreign) >= 0 );
+    ASSERT2( objpeq, memory_tracker_set_intrusive(other, TRUE()), NULL );
+    ASSERT2( objpeq, untrack_byte_allocation(other, foreign), foreign );
+
+    memory_manager_mfree(default_memory_manager, foreign);
+
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, TRUE()), tracker );
+    ASSERT2( objpeq, memory_tracker_set_intrusive(other,   TRUE()), other   );
+
+    /* ---------------------------------------------------------------- */
+
+    a = track_mmalloc(tracker, sizeof(*a), &index);
+    ASSERT1( true, IS_TRUE(a) );
+    ASSERT2( inteq, index, 0 );
+
+    b = track_mmalloc(tracker, sizeof(*b), &index);
+    ASSERT1( true, IS_TRUE(b) );
+    ASSERT2( inteq, index, 1 );
+
+    c = track_mmalloc(tracker, sizeof(*c), &index);
+    ASSERT1( true, IS_TRUE(c) );
+    ASSERT2( inteq, index, 2 );
+
+    *a = 1;
+    *b = 2;
+    *c = 3;
+
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), 3 );
+
+    /* The mode can't change while blocks are live. */
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, FALSE()), NULL );
+
+    /* ---------------------------------------------------------------- */
+
+    /* Pointers are verified by their owner. */
+    foreign = track_mmalloc(other, sizeof(*foreign), NULL);
+    ASSERT1( true, IS_TRUE(foreign) );
+
+    ASSERT2( inteq, tracked_mmalloc(tracker, a),       0         );
+    ASSERT2( inteq, tracked_mmalloc(tracker, foreign), UNTRACKED );
+    ASSERT2( inteq, tracked_mmalloc(other,   foreign), 0         );
+
+    ASSERT2( sizeeq, track_mfree(tracker, foreign), 0 );
+    ASSERT2( sizeeq, track_mfree(other,   foreign), 2 );
+
+    /* ---------------------------------------------------------------- */
+
+    /* Freeing the first block moves the last one into its slot. */
+    ASSERT2( sizeeq, track_mfree(tracker, a), 2 );
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), 2 );
+
+    ASSERT2( inteq, tracked_mmalloc(tracker, c), 0 );
+    ASSERT2( inteq, tracked_mmalloc(tracker, b), 1 );
+    ASSERT2( inteq, *b, 2 );
+    ASSERT2( inteq, *c, 3 );
+
+    /* ---------------------------------------------------------------- */
+
+    c = track_mrealloc(tracker, c, 64 * sizeof(*c), &index);
+    ASSERT1( true, IS_TRUE(c) );
+    ASSERT2( inteq, index, 0 );
+    ASSERT2( inteq, *c, 3 );
+    ASSERT2( inteq, tracked_mmalloc(tracker, c), 0 );
+
+    buf = track_mcalloc(tracker, DEFAULT_BUF_SIZE, sizeof(char), NULL);
+    ASSERT1( true, IS_TRUE(buf) );
+    ASSERT2( inteq, buf[DEFAULT_BUF_SIZE - 1], 0 );
+
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), 3 );
+
+    /* ---------------------------------------------------------------- */
+
+    /* Blocks without a header cannot be registered explicitly. */
+    foreign = memory_manager_mmalloc(default_memory_manager, sizeof(*foreign));
+    ASSERT1( true, IS_TRUE(foreign) );
+
+    ASSERT1( true, track_byte_allocation(tracker, foreign) < 0 );
+    ASSERT2( inteq, tracked_byte_allocation(tracker, foreign), UNTRACKED );
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), 3 );
+
+    memory_manager_mfree(default_memory_manager, foreign);
+  }
+
+  /* Remaining blocks are freed with the tracker. */
+  ENCLOSE()
+  {
+    ASSERT2( not_inteq, memory_tracker_free(tracker), 0 );
+    ASSERT2( not_inteq, memory_tracker_free(other),   0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t dependency_cycle_test =
+  {  dependency_cycle_test_run
+  , "dependency_cycle_test"
+  , "Freeing cyclic dependencies."
+  };
+
+unit_test_result_t dependency_cycle_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+
+  tracker = memory_tracker_init(&memory_tracker, NULL, NULL);
+
+  ENCLOSE()
+  {
+    int   a_index;
+    int   b_index;
+    int   c_index;
+    int   d_index;
+    void *a;
+    void *b;
+    void *c;
+    void *d;
+
+    size_t num_dependencies;
+
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    a = track_mmalloc(tracker, 8, &a_index);
+    b = track_mmalloc(tracker, 8, &b_index);
+    c = track_mmalloc(tracker, 8, &c_index);
+    d = track_mmalloc(tracker, 8, &d_index);
+    ASSERT1( true, IS_TRUE(a && b && c && d) );
+
+    /* a -> b -> c -> a, and c -> d. */
+    ASSERT1( true, track_depends(tracker, a_t_byte, a_index, a_t_byte, b_index) >= 0 );
+    ASSERT1( true, track_depends(tracker, a_t_byte, b_index, a_t_byte, c_index) >= 0 );
+    ASSERT1( true, track_depends(tracker, a_t_byte, c_index, a_t_byte, a_index) >= 0 );
+    ASSERT1( true, track_depends(tracker, a_t_byte, c_index, a_t_byte, d_index) >= 0 );
+
+    /* Duplicates are nops. */
+    ASSERT2( inteq
+      , track_depends  (tracker, a_t_byte, c_index, a_t_byte, d_index)
+      , tracked_depends(tracker, a_t_byte, c_index, a_t_byte, d_index)
+      );
+
+    ASSERT1( true, tracked_dependency_key(tracker, a_t_byte, c_index, NULL, 0, &num_dependencies) >= 0 );
+    ASSERT2( sizeeq, num_dependencies, 2 );
+
+    /* ---------------------------------------------------------------- */
+
+    /* Freeing "b"'s dependents frees everything else, but not "b". */
+    ASSERT2( sizeeq, free_byte_allocation_dependencies(tracker, b), 3 * 2 + 4 );
+
+    ASSERT2( inteq, tracked_byte_allocation(tracker, a), UNTRACKED );
+    ASSERT2( inteq, tracked_byte_allocation(tracker, c), UNTRACKED );
+    ASSERT2( inteq, tracked_byte_allocation(tracker, d), UNTRACKED );
+    ASSERT2( inteq, tracked_byte_allocation(tracker, b), b_index   );
+
+    ASSERT2( inteq, tracked_dependency_key(tracker, a_t_byte, c_index, NULL, 0, &num_dependencies), UNTRACKED );
+    ASSERT2( sizeeq, num_dependencies, 0 );
+
+    ASSERT2( sizeeq, track_mfree(tracker, b), 2 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( not_inteq, memory_tracker_free(tracker), 0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t dependency_chain_test =
+  {  dependency_chain_test_run
+  , "dependency_chain_test"
+  , "Freeing a long chain of dependencies."
+  };
+
+#define DEPENDENCY_CHAIN_LENGTH 4096
+
+unit_test_result_t dependency_chain_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+
+  tracker = memory_tracker_init(&memory_tracker, NULL, NULL);
+
+  ENCLOSE()
+  {
+    void   *root;
+    void   *last;
+    int     root_index;
+    int     last_index;
+    int     index;
+    size_t  i;
+
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    root = track_mmalloc(tracker, 8, &root_index);
+    ASSERT1( true, IS_TRUE(root) );
+
+    last       = root;
+    last_index = root_index;
+    for (i = 1; i < DEPENDENCY_CHAIN_LENGTH; ++i)
+    {
+      last = track_mmalloc(tracker, 8, &index);
+      if (!last)
+        break;
+
+      if (track_depends(tracker, a_t_byte, last_index, a_t_byte, index) < 0)
+        break;
+
+      last_index = index;
+    }
+    ASSERT2( sizeeq, i, DEPENDENCY_CHAIN_LENGTH );
+
+    /* Each allocation is untracked and freed; each edge is removed. */
+    ASSERT2( sizeeq, track_mfree(tracker, root), 3 * DEPENDENCY_CHAIN_LENGTH - 1 );
+
+    ASSERT2( inteq, tracked_byte_allocation(tracker, root), UNTRACKED );
+    ASSERT2( inteq, tracked_byte_allocation(tracker, last), UNTRACKED );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( not_inteq, memory_tracker_free(tracker), 0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t checkpoint_test =
+  {  checkpoint_test_run
+  , "checkpoint_test"
+  , "Memory tracker checkpoints, rollback, and commit."
+  };
+
+unit_test_result_t checkpoint_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t  memory_tracker;
+  memory_tracker_t *tracker;
+
+  tracker = memory_tracker_init(&memory_tracker, NULL, NULL);
+
+  ENCLOSE()
+  {
+    memory_tracker_checkpoint_t outer;
+    memory_tracker_checkpoint_t inner;
+    memory_tracker_checkpoint_t replaced;
+
+    void *kept;
+    void *moved;
+    void *dependent;
+    void *committed;
+    void *discarded;
+    void *freed;
+    int   dependent_index;
+    int   discarded_index;
+
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    kept      = track_mmalloc(tracker, 8, NULL);
+    moved     = track_mmalloc(tracker, 8, NULL);
+    dependent = track_mmalloc(tracker, 8, &dependent_index);
+    ASSERT1( true, IS_TRUE(kept && moved && dependent) );
+
+    ASSERT2( objpeq, memory_tracker_checkpoint(tracker, &outer), &outer );
+
+    /* A block from before the checkpoint survives being moved. */
+    moved = track_mrealloc(tracker, moved, 4096, NULL);
+    ASSERT1( true, IS_TRUE(moved) );
+
+    /* Committing a nested checkpoint leaves its allocations to the outer one. */
+    ASSERT2( objpeq, memory_tracker_checkpoint(tracker, &inner), &inner );
+
+    committed = track_mmalloc(tracker, 8, NULL);
+    ASSERT1( true, IS_TRUE(committed) );
+
+    ASSERT2( objpeq, memory_tracker_commit(tracker, &inner), tracker );
+    ASSERT2( objpeq, memory_tracker_commit(tracker, &inner), NULL    );
+
+    /* A stale handle cannot end a newer checkpoint at its depth. */
+    ASSERT2( objpeq, memory_tracker_checkpoint(tracker, &replaced), &replaced );
+    ASSERT2( sizeeq, replaced.depth, inner.depth );
+
+    ASSERT2( sizeeq, memory_tracker_rollback(tracker, &inner),    0       );
+    ASSERT2( objpeq, memory_tracker_commit  (tracker, &inner),    NULL    );
+    ASSERT2( objpeq, memory_tracker_commit  (tracker, &replaced), tracker );
+
+    /* A discarded block with a dependent from before the checkpoint. */
+    discarded = track_mmalloc(tracker, 8, &discarded_index);
+    ASSERT1( true, IS_TRUE(discarded) );
+    ASSERT1( true, track_depends(tracker, a_t_byte, discarded_index, a_t_byte, dependent_index) >= 0 );
+
+    /* Already freed blocks are skipped. */
+    freed = track_mmalloc(tracker, 8, NULL);
+    ASSERT1( true, IS_TRUE(freed) );
+    ASSERT2( sizeeq, track_mfree(tracker, freed), 2 );
+
+    /* ---------------------------------------------------------------- */
+
+    /* "committed" and "discarded", then "dependent", each untracked and */
+    /* freed, and one edge removed.                                      */
+    ASSERT2( sizeeq, memory_tracker_rollback(tracker, &outer), 3 * 2 + 1 );
+    ASSERT2( sizeeq, memory_tracker_rollback(tracker, &outer), 0 );
+
+    ASSERT2( inteq,     tracked_byte_allocation(tracker, committed), UNTRACKED );
+    ASSERT2( inteq,     tracked_byte_allocation(tracker, discarded), UNTRACKED );
+    ASSERT2( inteq,     tracked_byte_allocation(tracker, dependent), UNTRACKED );
+    ASSERT2( not_inteq, tracked_byte_allocation(tracker, kept),      UNTRACKED );
+    ASSERT2( not_inteq, tracked_byte_allocation(tracker, moved),     UNTRACKED );
+
+    ASSERT2( sizeeq, tracker->checkpoints_num, 0 );
+    ASSERT2( sizeeq, tracker->journal_num,     0 );
+
+    /* Only a tracker without such blocks can become intrusive. */
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, TRUE()), NULL );
+
+    ASSERT2( sizeeq, track_mfree(tracker, kept),  2 );
+    ASSERT2( sizeeq, track_mfree(tracker, moved), 2 );
+  }
+
+  ENCLOSE()
+  {
+    memory_tracker_checkpoint_t checkpoint;
+
+    void *kept;
+    void *discarded;
+
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, TRUE()), tracker );
+
+    kept = track_mmalloc(tracker, 8, NULL);
+    ASSERT1( true, IS_TRUE(kept) );
+
+    ASSERT2( objpeq, memory_tracker_checkpoint(tracker, &checkpoint), &checkpoint );
+
+    discarded = track_mmalloc(tracker, 8, NULL);
+    ASSERT1( true, IS_TRUE(discarded) );
+    discarded = track_mmalloc(tracker, 8, NULL);
+    ASSERT1( true, IS_TRUE(discarded) );
+
+    ASSERT2( sizeeq, memory_tracker_rollback(tracker, &checkpoint), 2 * 2 );
+
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), 1 );
+    ASSERT2( inteq,  tracked_mmalloc(tracker, kept), 0 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( not_inteq, memory_tracker_free(tracker), 0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+#define THREAD_TRACKER_TEST_BLOCKS 256
+
+#if POSIX_PARALLEL
+/* Free another thread's blocks, and return this thread's tracker. */
+static void *thread_tracker_test_worker(void *blocks_raw)
+{
+  void             **blocks = blocks_raw;
+  memory_tracker_t  *tracker;
+  size_t             i;
+
+  tracker = thread_memory_tracker();
+  if (!tracker)
+    return NULL;
+
+  for (i = 0; i < THREAD_TRACKER_TEST_BLOCKS; ++i)
+    if (track_mfree(tracker, blocks[i]) != 2)
+      return NULL;
+
+  return tracker;
+}
+#endif /* #if POSIX_PARALLEL */
+
+unit_test_t thread_tracker_test =
+  {  thread_tracker_test_run
+  , "thread_tracker_test"
+  , "Per-thread memory trackers and handing blocks back to their owner."
+  };
+
+unit_test_result_t thread_tracker_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  memory_tracker_t *tracker;
+  memory_tracker_t *typed_dyn;
+
+  tracker   = thread_memory_tracker();
+  typed_dyn = thread_typed_dyn_memory_tracker();
+
+  ENCLOSE()
+  {
+    ASSERT1( true, IS_TRUE(tracker) );
+    ASSERT1( true, IS_TRUE(typed_dyn) );
+
+    ASSERT2( objpeq,     thread_memory_tracker(),           tracker   );
+    ASSERT2( objpeq,     thread_typed_dyn_memory_tracker(), typed_dyn );
+    ASSERT2( not_objpeq, tracker,                           typed_dyn );
+
+    /* Nothing handed back yet. */
+    ASSERT2( sizeeq, memory_tracker_drain(tracker), 0 );
+  }
+
+#if POSIX_PARALLEL
+  ENCLOSE()
+  {
+    void      *blocks[THREAD_TRACKER_TEST_BLOCKS];
+    size_t     live;
+    size_t     i;
+    pthread_t  thread;
+    void      *status;
+
+    ASSERT2( objpeq, tracker->owner_thread, typed_dyn->owner_thread );
+
+    live = memory_tracker_intrusive_num(tracker);
+
+    for (i = 0; i < THREAD_TRACKER_TEST_BLOCKS; ++i)
+    {
+      blocks[i] = track_mmalloc(tracker, 8 + i, NULL);
+      ASSERT1( true, IS_TRUE(blocks[i]) );
+    }
+
+    ASSERT2( inteq, pthread_create(&thread, NULL, thread_tracker_test_worker, blocks), 0 );
+    ASSERT2( inteq, pthread_join(thread, &status), 0 );
+
+    /* The worker had trackers of its own. */
+    ASSERT1( true, IS_TRUE(status) );
+    ASSERT2( not_objpeq, status, tracker );
+
+    /* Its frees were only queued to this thread. */
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), live + THREAD_TRACKER_TEST_BLOCKS );
+
+    ASSERT2( sizeeq, memory_tracker_drain(tracker), 2 * THREAD_TRACKER_TEST_BLOCKS );
+    ASSERT2( sizeeq, memory_tracker_intrusive_num(tracker), live );
+  }
+
+  /* The typed tracker's blocks name their owner, whatever their size. */
+  ENCLOSE()
+  {
+    char   *small;
+    char   *large;
+    size_t  i;
+
+    small = track_mmalloc(typed_dyn, 24, NULL);
+    large = track_mcalloc(typed_dyn, 1, 100000, NULL);
+    ASSERT1( true, IS_TRUE(small && large) );
+
+    ASSERT2( objpeq, memory_tracker_owner(small), typed_dyn );
+    ASSERT2( objpeq, memory_tracker_owner(large), typed_dyn );
+    ASSERT2( inteq,  large[99999], 0 );
+
+    for (i = 0; i < 24; ++i)
+      small[i] = (char) i;
+
+    /* Growing moves a block across size classes and into a span of its own. */
+    small = track_mrealloc(typed_dyn, small, 50000, NULL);
+    ASSERT1( true, IS_TRUE(small) );
+    ASSERT2( objpeq, memory_tracker_owner(small), typed_dyn );
+    ASSERT2( inteq, small[23], 23 );
+
+    ASSERT2( sizeeq, track_mfree(typed_dyn, small), 2 );
+    ASSERT2( sizeeq, track_mfree(typed_dyn, large), 2 );
+
+    /* Released spans no longer name an owner. */
+    ASSERT2( objpeq, memory_tracker_owner(large), NULL );
+  }
+#endif /* #if POSIX_PARALLEL */
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+#define DEFERRED_FREE_TEST_BLOCKS 256
+
+/* Count cleanups; read only after a flush. */
+static size_t deferred_free_test_cleanup(void *context)
+{
+  ++*((size_t *) context);
+  return 1;
+}
+
+unit_test_t deferred_free_test =
+  {  deferred_free_test_run
+  , "deferred_free_test"
+  , "Handing memory trackers to the background reclaimer."
+  };
+
+unit_test_result_t deferred_free_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    memory_tracker_t  memory_tracker;
+    memory_tracker_t *tracker;
+
+    size_t cleanups;
+    size_t i;
+    int    index;
+    int    last_index;
+
+    cleanups = 0;
+
+    tracker = memory_tracker_init(&memory_tracker, NULL, NULL);
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    tracker->deferred = TRUE();
+
+    /* A chain of dependents, ending in a manual allocation. */
+    last_index = -1;
+    for (i = 0; i < DEFERRED_FREE_TEST_BLOCKS; ++i)
+    {
+      ASSERT1( true, IS_TRUE(track_mmalloc(tracker, 16, &index)) );
+
+      if (last_index >= 0)
+      {
+        ASSERT1( true, track_depends(tracker, a_t_byte, last_index, a_t_byte, index) >= 0 );
+      }
+
+      last_index = index;
+    }
+
+    index = track_manual_allocation(tracker, manual_allocation(deferred_free_test_cleanup, &cleanups));
+    ASSERT1( true, index >= 0 );
+    ASSERT1( true, track_depends(tracker, a_t_byte, last_index, a_t_manual, index) >= 0 );
+
+    /* Queued, and "tracker" is left freed. */
+    ASSERT2( sizeeq, memory_tracker_free(tracker), 1 );
+    ASSERT2( objpeq, tracker->byte_allocations, NULL );
+    ASSERT2( objpeq, tracker->dependency_graph, NULL );
+
+    /* Counted even if the reclaimer finished before the flush. */
+    ASSERT1( true, memory_tracker_reclaim_flush() > DEFERRED_FREE_TEST_BLOCKS );
+    ASSERT2( sizeeq, memory_tracker_reclaim_flush(), 0 );
+    ASSERT2( sizeeq, memory_tracker_reclaim_pending(), 0 );
+    ASSERT2( sizeeq, cleanups, 1 );
+  }
+
+  ENCLOSE()
+  {
+    memory_tracker_t *tracker;
+
+    size_t i;
+
+    /* A dynamically allocated tracker is freed by the reclaimer. */
+    tracker = memory_tracker_init(NULL, NULL, NULL);
+    ASSERT1( true, IS_TRUE(tracker) );
+
+    ASSERT2( objpeq, memory_tracker_set_intrusive(tracker, TRUE()), tracker );
+
+    for (i = 0; i < DEFERRED_FREE_TEST_BLOCKS; ++i)
+      ASSERT1( true, IS_TRUE(track_mmalloc(tracker, 16, NULL)) );
+
+    ASSERT2( sizeeq, memory_tracker_defer(tracker), 1 );
+
+    /* Stopping waits for the queue; the reclaimer restarts on demand. */
+    memory_tracker_reclaim_stop();
+    ASSERT2( sizeeq, memory_tracker_reclaim_pending(), 0 );
+
+    /* The next flush reports what stopping freed. */
+    ASSERT1( true, memory_tracker_reclaim_flush() > DEFERRED_FREE_TEST_BLOCKS );
+
+    tracker = memory_tracker_init(NULL, NULL, NULL);
+    ASSERT1( true, IS_TRUE(tracker) );
+    ASSERT1( true, IS_TRUE(track_mmalloc(tracker, 16, NULL)) );
+
+    ASSERT2( sizeeq, memory_tracker_defer(tracker), 1 );
+    ASSERT1( true, memory_tracker_reclaim_flush() > 0 );
+    ASSERT2( sizeeq, memory_tracker_reclaim_pending(), 0 );
+
+    memory_tracker_reclaim_stop();
+  }
+
+  return result;
+}
@@ -54,4 +54,22 @@ unit_test_result_t test_type_base_memory_tracker_run(unit_test_context_t *contex
 extern unit_test_t memory_tracking_test;
 unit_test_result_t memory_tracking_test_run(unit_test_context_t *context);
 
+extern unit_test_t intrusive_tracking_test;
+unit_test_result_t intrusive_tracking_test_run(unit_test_context_t *context);
+
+extern unit_test_t dependency_cycle_test;
+unit_test_result_t dependency_cycle_test_run(unit_test_context_t *context);
+
+extern unit_test_t dependency_chain_test;
+unit_test_result_t dependency_chain_test_run(unit_test_context_t *context);
+
+extern unit_test_t checkpoint_test;
+unit_test_result_t checkpoint_test_run(unit_test_context_t *context);
+
+extern unit_test_t thread_tracker_test;
+unit_test_result_t thread_tracker_test_run(unit_test_context_t *context);
+
+extern unit_test_t deferred_free_test;
+unit_test_result_t deferred_free_test_run(unit_test_context_t *context);
+
 #endif /* ifndef TESTS_TEST_TYPE_BASE_MEMORY_TRACKER_H */
@@ -0,0 +1,208 @@
+/*
+ * opencurry: tests/test_type_base_mmap_manager.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_mmap_manager.h"
+
+#include "../type_base_memory_manager.h"
+#include "../type_base_mmap_manager.h"
+#include "../type_base_lookup.h"
+
+int test_type_base_mmap_manager_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_mmap_manager_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_mmap_manager tests. */
+unit_test_t type_base_mmap_manager_test =
+  {  test_type_base_mmap_manager_run
+  , "test_type_base_mmap_manager"
+  , "type_base_mmap_manager tests."
+  };
+
+/* Array of type_base_mmap_manager tests. */
+unit_test_t *type_base_mmap_manager_tests[] =
+  { &mmap_large_test
+  , &mmap_huge_pages_test
+  , &mmap_lookup_expand_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_mmap_manager_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_mmap_manager_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t mmap_large_test =
+  {  mmap_large_test_run
+  , "mmap_large_test"
+  , "Large requests are mapped; small ones are forwarded."
+  };
+
+unit_test_result_t mmap_large_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    unsigned char *small;
+    unsigned char *large;
+    size_t         large_size;
+    size_t         i;
+
+    large_size = global_mmap_config.threshold;
+
+    small = memory_manager_mmalloc(&mmap_manager, 100);
+    ASSERT1( true, IS_TRUE(small) );
+    ASSERT2( inteq, mmap_is_mapped(small), 0 );
+
+    large = memory_manager_mcalloc(&mmap_manager, 1, large_size);
+    ASSERT1( true, IS_TRUE(large) );
+    ASSERT2( inteq, mmap_is_mapped(large), IF_POSIX_MMAP(1, 0) );
+
+    for (i = 0; i < large_size; ++i)
+      if (large[i])
+        break;
+    ASSERT2( sizeeq, i, large_size );
+
+    /* Growing moves contents across the threshold. */
+    for (i = 0; i < 100; ++i)
+      small[i] = (unsigned char) i;
+
+    small = memory_manager_mrealloc(&mmap_manager, small, large_size);
+    ASSERT1( true, IS_TRUE(small) );
+    ASSERT2( inteq, mmap_is_mapped(small), IF_POSIX_MMAP(1, 0) );
+
+    for (i = 0; i < 100; ++i)
+      if (small[i] != (unsigned char) i)
+        break;
+    ASSERT2( sizeeq, i, 100 );
+
+    large[large_size - 1] = 'x';
+
+    ASSERT2( sizeeq, memory_manager_mfree(&mmap_manager, small), 1 );
+    ASSERT2( sizeeq, memory_manager_mfree(&mmap_manager, large), 1 );
+  }
+
+  return result;
+}
+
+unit_test_t mmap_huge_pages_test =
+  {  mmap_huge_pages_test_run
+  , "mmap_huge_pages_test"
+  , "Huge-page requests are mapped at huge-page boundaries."
+  };
+
+unit_test_result_t mmap_huge_pages_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    unsigned char *block;
+
+    block = memory_manager_mmalloc_hinted(&mmap_manager, 4096, MEMORY_HINT_HUGE_PAGES | MEMORY_HINT_HOT);
+    ASSERT1( true, IS_TRUE(block) );
+    ASSERT1( true, IS_TRUE(mmap_hints(block) & MEMORY_HINT_HUGE_PAGES) );
+    ASSERT1( true, IS_TRUE(mmap_hints(block) & MEMORY_HINT_HOT) );
+
+#if POSIX_MMAP
+    ASSERT2( inteq, mmap_is_mapped(block), 1 );
+    ASSERT2( sizeeq, ((size_t) (block - MMAP_MANAGER_HEADER_SIZE)) % global_mmap_config.huge_page_size, 0 );
+#endif /* #if POSIX_MMAP */
+
+    block[0] = block[4095] = 'x';
+
+    /* Resizing within the mapping keeps the block in place. */
+#if POSIX_MMAP
+    ASSERT2( objpeq, memory_manager_mrealloc(&mmap_manager, block, 8192), block );
+#endif /* #if POSIX_MMAP */
+
+    ASSERT2( sizeeq, memory_manager_mfree(&mmap_manager, block), 1 );
+  }
+
+  return result;
+}
+
+unit_test_t mmap_lookup_expand_test =
+  {  mmap_lookup_expand_test_run
+  , "mmap_lookup_expand_test"
+  , "Lookups request huge pages for large arrays."
+  };
+
+unit_test_result_t mmap_lookup_expand_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  lookup_t  lookup_def;
+  lookup_t *lookup;
+  size_t    huge_pages_min_size;
+
+  huge_pages_min_size        = lookup_huge_pages_min_size;
+  lookup_huge_pages_min_size = 64 * sizeof(int);
+
+  lookup = lookup_init_empty(&lookup_def, sizeof(int));
+
+  ENCLOSE()
+  {
+    ASSERT1( true, IS_TRUE(lookup) );
+
+    /* Below the minimum: no hint. */
+    ASSERT2( objpeq, lookup_expand(lookup, 16, &mmap_manager), lookup );
+    ASSERT2( inteq, mmap_hints(lookup->values) & MEMORY_HINT_HUGE_PAGES, 0 );
+
+    ((int *) lookup->values)[15] = 15;
+
+    /* Crossing the minimum moves the array. */
+    ASSERT2( objpeq, lookup_expand(lookup, 256, &mmap_manager), lookup );
+    ASSERT1( true, IS_TRUE(mmap_hints(lookup->values) & MEMORY_HINT_HUGE_PAGES) );
+    ASSERT2( inteq, ((int *) lookup->values)[15], 15 );
+
+    ((int *) lookup->values)[255] = 255;
+
+    ASSERT2( objpeq, lookup_expand(lookup, 512, &mmap_manager), lookup );
+    ASSERT2( inteq, ((int *) lookup->values)[15],  15  );
+    ASSERT2( inteq, ((int *) lookup->values)[255], 255 );
+  }
+
+  lookup_deinit(lookup, &mmap_manager);
+
+  lookup_huge_pages_min_size = huge_pages_min_size;
+
+  return result;
+}
@@ -0,0 +1,161 @@
+/*
+ * opencurry: tests/test_type_base_registry.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* string.h:
+ *   - strcmp
+ */
+#include <string.h>
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_registry.h"
+
+#include "../type_base.h"
+#include "../type_base_registry.h"
+
+int test_type_base_registry_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_registry_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_registry tests. */
+unit_test_t type_base_registry_test =
+  {  test_type_base_registry_run
+  , "test_type_base_registry"
+  , "type_base_registry tests."
+  };
+
+/* Array of type_base_registry tests. */
+unit_test_t *type_base_registry_tests[] =
+  { &type_registry_lookup_test
+  , &type_registry_conflict_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_registry_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_registry_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t type_registry_lookup_test =
+  {  type_registry_lookup_test_run
+  , "type_registry_lookup_test"
+  , "Registered types are found by name and dense id."
+  };
+
+unit_test_result_t type_registry_lookup_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    size_t num;
+    size_t int_id;
+    size_t div_id;
+    type_t unregistered;
+
+    /* Other tests may have registered types already. */
+    num = type_registry_num();
+
+    int_id = type_register(int_type());
+    div_id = type_register(div_type());
+    ASSERT1( true, int_id != TYPE_REGISTRY_NO_ID );
+    ASSERT1( true, div_id != TYPE_REGISTRY_NO_ID );
+    ASSERT1( true, int_id != div_id );
+    ASSERT1( true, type_registry_num() <= num + 2 );
+    ASSERT1( true, int_id <= type_registry_num() );
+    ASSERT1( true, div_id <= type_registry_num() );
+
+    /* Registering again. */
+    ASSERT2( sizeeq, type_register(int_type()), int_id );
+    ASSERT2( sizeeq, type_registry_id(int_type()), int_id );
+    ASSERT2( sizeeq, type_registry_id(div_type()), div_id );
+
+    ASSERT2( objpeq, type_registry_by_id(int_id), int_type() );
+    ASSERT2( objpeq, type_registry_by_id(div_id), div_type() );
+    ASSERT2( objpeq, type_registry_by_id(TYPE_REGISTRY_NO_ID), NULL );
+    ASSERT2( objpeq, type_registry_by_id(type_registry_num() + 1), NULL );
+
+    ASSERT2( objpeq, type_registry_by_name(type_name(int_type())), int_type() );
+    ASSERT2( objpeq, type_registry_by_name(type_name(div_type())), div_type() );
+    ASSERT2( objpeq, type_registry_by_name("no such type"), NULL );
+
+    /* Names are interned once. */
+    ASSERT1( true, IS_TRUE(type_registry_name(int_type())) );
+    ASSERT2( objpeq, type_registry_name(int_type()), type_registry_name(int_type()) );
+    ASSERT2( inteq,  strcmp(type_registry_name(int_type()), type_name(int_type())), 0 );
+
+    /* Builtins are registered first, and a copy doesn't share their id. */
+    ASSERT2( objpeq, type_registry_by_id(1), type_type() );
+    ASSERT1( true, type_registry_id(ldiv_type()) != TYPE_REGISTRY_NO_ID );
+
+    unregistered = *ldiv_type();
+    ASSERT2( sizeeq, type_registry_id(&unregistered), TYPE_REGISTRY_NO_ID );
+    ASSERT2( objpeq, type_registry_name(&unregistered), NULL );
+  }
+
+  return result;
+}
+
+unit_test_t type_registry_conflict_test =
+  {  type_registry_conflict_test_run
+  , "type_registry_conflict_test"
+  , "A name can only be registered by one type."
+  };
+
+unit_test_result_t type_registry_conflict_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    type_t impostor;
+
+    /* Same methods, and so the same name, at another address. */
+    impostor = *long_type();
+
+    ASSERT1( true, type_register(long_type()) != TYPE_REGISTRY_NO_ID );
+    ASSERT2( sizeeq, type_register(&impostor), TYPE_REGISTRY_NO_ID );
+    ASSERT2( sizeeq, type_registry_id(&impostor), TYPE_REGISTRY_NO_ID );
+
+    ASSERT2( objpeq, type_registry_by_name(type_name(long_type())), long_type() );
+
+    ASSERT2( sizeeq, type_register(NULL), TYPE_REGISTRY_NO_ID );
+  }
+
+  return result;
+}
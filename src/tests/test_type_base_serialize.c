@@ -0,0 +1,629 @@
+/*
+ * opencurry: tests/test_type_base_serialize.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stdlib.h:
+ *   - div_t
+ */
+#include <stdlib.h>
+
+/* string.h:
+ *   - memcpy
+ */
+#include <string.h>
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_serialize.h"
+
+#include "../type_base.h"
+#include "../type_base_serialize.h"
+
+int test_type_base_serialize_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_serialize_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_serialize tests. */
+unit_test_t type_base_serialize_test =
+  {  test_type_base_serialize_run
+  , "test_type_base_serialize"
+  , "type_base_serialize tests."
+  };
+
+/* Array of type_base_serialize tests. */
+unit_test_t *type_base_serialize_tests[] =
+  { &serialize_plain_test
+  , &serialize_refs_test
+  , &serialize_in_place_test
+  , &serialize_reject_test
+  , &serialize_embedded_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_serialize_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_serialize_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* Typed nodes, referencing each other through "next" and "other". */
+
+typedef struct serial_node_s serial_node_t;
+struct serial_node_s
+{
+  typed_t        type;
+
+  int            id;
+  serial_node_t *next;
+  serial_node_t *other;
+};
+
+static const type_t *serial_node_type(void);
+static const type_t *serial_node_ref_type(void);
+
+static const char          *serial_node_type_name        (const type_t *self);
+static size_t               serial_node_type_size        (const type_t *self, const tval *val);
+static const struct_info_t *serial_node_type_is_struct   (const type_t *self);
+
+static const char          *serial_node_ref_type_name    (const type_t *self);
+static size_t               serial_node_ref_type_size    (const type_t *self, const tval *val);
+static const type_t        *serial_node_ref_type_deref   (const type_t *self, const tval *val, const tval **out_ref);
+
+static const type_t serial_node_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ serial_node_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_typed
+
+  , /* @name                  */ serial_node_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ serial_node_type_size
+  , /* @is_struct             */ serial_node_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t serial_node_ref_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ serial_node_ref_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_untyped
+
+  , /* @name                  */ serial_node_ref_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ serial_node_ref_type_size
+  , /* @is_struct             */ type_is_not_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ serial_node_ref_type_deref
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *serial_node_type(void)
+  { return &serial_node_type_def; }
+
+static const type_t *serial_node_ref_type(void)
+  { return &serial_node_ref_type_def; }
+
+static const char          *serial_node_type_name        (const type_t *self)
+  { return "serial_node_t"; }
+
+static size_t               serial_node_type_size        (const type_t *self, const tval *val)
+  { return sizeof(serial_node_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(serial_node)
+static const struct_info_t *serial_node_type_is_struct   (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(serial_node);
+
+    /* typed_t        type;  */
+    /* int            id;    */
+    /* serial_node_t *next;  */
+    /* serial_node_t *other; */
+    STRUCT_INFO_RADD(typed_type(),           type);
+    STRUCT_INFO_RADD(int_type(),             id);
+    STRUCT_INFO_RADD(serial_node_ref_type(), next);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+    STRUCT_INFO_RADD(serial_node_ref_type(), other);
+    STRUCT_INFO_LAST()->is_recursible_ref = 1;
+
+    STRUCT_INFO_DONE();
+  }
+
+static const char          *serial_node_ref_type_name    (const type_t *self)
+  { return "serial_node_t *"; }
+
+static size_t               serial_node_ref_type_size    (const type_t *self, const tval *val)
+  { return sizeof(serial_node_t *); }
+
+static const type_t        *serial_node_ref_type_deref   (const type_t *self, const tval *val, const tval **out_ref)
+  {
+    if (out_ref)
+      *out_ref = val ? *((serial_node_t * const *) val) : NULL;
+
+    return serial_node_type();
+  }
+
+static serial_node_t *serial_node_init(serial_node_t *node, int id, serial_node_t *next, serial_node_t *other)
+{
+  node->type  = serial_node_type;
+  node->id    = id;
+  node->next  = next;
+  node->other = other;
+
+  return node;
+}
+
+/* Typed pairs, embedding a typed node. */
+
+typedef struct serial_pair_s serial_pair_t;
+struct serial_pair_s
+{
+  typed_t       type;
+
+  serial_node_t inner;
+  int           tag;
+};
+
+static const type_t *serial_pair_type(void);
+
+static const char          *serial_pair_type_name        (const type_t *self);
+static size_t               serial_pair_type_size        (const type_t *self, const tval *val);
+static const struct_info_t *serial_pair_type_is_struct   (const type_t *self);
+
+static const type_t serial_pair_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ serial_pair_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ type_is_typed
+
+  , /* @name                  */ serial_pair_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ serial_pair_type_size
+  , /* @is_struct             */ serial_pair_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ NULL
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ NULL
+
+  , /* parity                 */ ""
+  };
+
+static const type_t *serial_pair_type(void)
+  { return &serial_pair_type_def; }
+
+static const char          *serial_pair_type_name        (const type_t *self)
+  { return "serial_pair_t"; }
+
+static size_t               serial_pair_type_size        (const type_t *self, const tval *val)
+  { return sizeof(serial_pair_t); }
+
+DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(serial_pair)
+static const struct_info_t *serial_pair_type_is_struct   (const type_t *self)
+  {
+    STRUCT_INFO_BEGIN(serial_pair);
+
+    /* typed_t       type;  */
+    /* serial_node_t inner; */
+    /* int           tag;   */
+    STRUCT_INFO_RADD(typed_type(),       type);
+    STRUCT_INFO_RADD(serial_node_type(), inner);
+    STRUCT_INFO_RADD(int_type(),         tag);
+
+    STRUCT_INFO_DONE();
+  }
+
+/* Size of each value in an image. */
+static size_t serial_aligned(size_t size)
+{
+  return (size + TYPE_SERIAL_ALIGNMENT - 1) / TYPE_SERIAL_ALIGNMENT * TYPE_SERIAL_ALIGNMENT;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t serialize_plain_test =
+  {  serialize_plain_test_run
+  , "serialize_plain_test"
+  , "Values without references round-trip."
+  };
+
+unit_test_result_t serialize_plain_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    type_serial_align_t buf[16];
+
+    size_t size;
+    int    i;
+    div_t  d;
+    void  *image;
+    tval  *read;
+
+    i = 42;
+
+    /* Sizing. */
+    size = type_serialize(int_type(), &i, NULL, 0, NULL);
+    ASSERT2( sizeeq, size, serial_aligned(sizeof(type_serial_header_t)) + serial_aligned(sizeof(int)) );
+    ASSERT1( true, size <= sizeof(buf) );
+
+    /* Too small: nothing is written. */
+    memset(buf, 0, sizeof(buf));
+    ASSERT2( sizeeq, type_serialize(int_type(), &i, buf, size - 1, NULL), size );
+    ASSERT2( objpeq, type_serial_header(buf, sizeof(buf)), NULL );
+
+    ASSERT2( sizeeq, type_serialize(int_type(), &i, buf, sizeof(buf), NULL), size );
+    ASSERT2( objpeq, type_serial_header(buf, sizeof(buf)), buf );
+    ASSERT2( sizeeq, type_serial_header(buf, sizeof(buf))->size, size );
+
+    read = type_deserialize(int_type(), buf, size, NULL, &image);
+    ASSERT1( true, IS_TRUE(read) );
+    ASSERT2( inteq, *((const int *) read), 42 );
+    memory_manager_mfree(NULL, image);
+
+    /* A struct. */
+    d.quot = 7;
+    d.rem  = -2;
+
+    image = type_serialize_alloc(div_type(), &d, NULL, &size);
+    ASSERT1( true, IS_TRUE(image) );
+    ASSERT2( sizeeq, size, serial_aligned(sizeof(type_serial_header_t)) + serial_aligned(sizeof(div_t)) );
+
+    read = type_deserialize_in_place(div_type(), image, size, NULL);
+    ASSERT1( true, IS_TRUE(read) );
+    ASSERT2( inteq, cmp_with_type(div_type(), read, &d), 0 );
+    memory_manager_mfree(NULL, image);
+  }
+
+  return result;
+}
+
+unit_test_t serialize_refs_test =
+  {  serialize_refs_test_run
+  , "serialize_refs_test"
+  , "Shared and cyclic references are written once and read back."
+  };
+
+unit_test_result_t serialize_refs_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    serial_node_t  a;
+    serial_node_t  b;
+    serial_node_t  c;
+    serial_node_t *ra;
+    size_t         size;
+    size_t         node_size;
+    void          *buf;
+    void          *image;
+
+    /* a -> b -> c -> a, and a and b both refer to c. */
+    serial_node_init(&a, 1, &b, &c);
+    serial_node_init(&b, 2, &c, &c);
+    serial_node_init(&c, 3, &a, NULL);
+
+    buf = type_serialize_alloc(serial_node_type(), &a, NULL, &size);
+    ASSERT1( true, IS_TRUE(buf) );
+
+    node_size = serial_aligned(sizeof(serial_node_t));
+    ASSERT2( sizeeq, size, serial_aligned(sizeof(type_serial_header_t)) + 3 * node_size );
+
+    ra = type_deserialize(serial_node_type(), buf, size, NULL, &image);
+    ASSERT1( true, IS_TRUE(ra) );
+
+    /* Everything lives in the image. */
+    ASSERT1( true, (char *) ra        >= (char *) image && (char *) ra        < (char *) image + size );
+    ASSERT1( true, (char *) ra->next  >= (char *) image && (char *) ra->next  < (char *) image + size );
+    ASSERT1( true, (char *) ra->other >= (char *) image && (char *) ra->other < (char *) image + size );
+
+    ASSERT2( inteq,  ra->id,                   1 );
+    ASSERT2( inteq,  ra->next->id,             2 );
+    ASSERT2( inteq,  ra->other->id,            3 );
+    ASSERT2( objpeq, ra->next->next,           ra->other );
+    ASSERT2( objpeq, ra->next->other,          ra->other );
+    ASSERT2( objpeq, ra->other->next,          ra );
+    ASSERT2( objpeq, ra->other->other,         NULL );
+    ASSERT2( funpeq, (tests_funp_t) ra->type,       (tests_funp_t) serial_node_type );
+    ASSERT2( funpeq, (tests_funp_t) ra->other->type, (tests_funp_t) serial_node_type );
+
+    /* The original is untouched. */
+    ASSERT2( objpeq, a.next, &b );
+
+    memory_manager_mfree(NULL, image);
+    memory_manager_mfree(NULL, buf);
+  }
+
+  return result;
+}
+
+unit_test_t serialize_in_place_test =
+  {  serialize_in_place_test_run
+  , "serialize_in_place_test"
+  , "Images are read over themselves without copying."
+  };
+
+unit_test_result_t serialize_in_place_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    serial_node_t  a;
+    serial_node_t  b;
+    serial_node_t *ra;
+    size_t         size;
+    char          *buf;
+    typed_t        stale;
+
+    serial_node_init(&a, 10, &b, NULL);
+    serial_node_init(&b, 20, NULL, &b);
+
+    buf = type_serialize_alloc(serial_node_type(), &a, NULL, &size);
+    ASSERT1( true, IS_TRUE(buf) );
+
+    /* A writer in another process would have its own "type". */
+    stale = typed_default;
+    memcpy(buf + serial_aligned(sizeof(type_serial_header_t)), &stale, sizeof(stale));
+
+    ra = type_deserialize_in_place(serial_node_type(), buf, size, NULL);
+    ASSERT2( objpeq, (char *) ra, buf + serial_aligned(sizeof(type_serial_header_t)) );
+
+    ASSERT2( funpeq, (tests_funp_t) ra->type, (tests_funp_t) serial_node_type );
+    ASSERT2( inteq,  ra->id,                  10 );
+    ASSERT2( inteq,  ra->next->id,            20 );
+    ASSERT2( objpeq, ra->next->next,          NULL );
+    ASSERT2( objpeq, ra->next->other,         ra->next );
+
+    memory_manager_mfree(NULL, buf);
+  }
+
+  return result;
+}
+
+unit_test_t serialize_reject_test =
+  {  serialize_reject_test_run
+  , "serialize_reject_test"
+  , "Invalid and foreign images are rejected."
+  };
+
+unit_test_result_t serialize_reject_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    serial_node_t  a;
+    serial_node_t  b;
+    size_t         size;
+    char          *buf;
+    char          *copy;
+    void          *image;
+    size_t         next_pos;
+    size_t         bad;
+
+    type_serial_header_t *header;
+
+    serial_node_init(&a, 1, &b, NULL);
+    serial_node_init(&b, 2, NULL, NULL);
+
+    buf  = type_serialize_alloc(serial_node_type(), &a, NULL, &size);
+    copy = memory_manager_mmalloc(NULL, size);
+    ASSERT1( true, IS_TRUE(buf) );
+    ASSERT1( true, IS_TRUE(copy) );
+
+    header   = (type_serial_header_t *) copy;
+    next_pos = serial_aligned(sizeof(type_serial_header_t)) + OFFSET_FIELD(serial_node_t, next);
+
+    /* Sanity. */
+    memcpy(copy, buf, size);
+    ASSERT1( true, IS_TRUE(type_deserialize_in_place(serial_node_type(), copy, size, NULL)) );
+
+    /* Truncated. */
+    ASSERT2( objpeq, type_deserialize(serial_node_type(), buf, size - 1, NULL, &image), NULL );
+    ASSERT2( objpeq, type_deserialize(serial_node_type(), buf, 3,        NULL, &image), NULL );
+    ASSERT2( objpeq, image, NULL );
+
+    /* Not an image. */
+    memcpy(copy, buf, size);
+    header->magic[0] = 'x';
+    ASSERT2( objpeq, type_deserialize_in_place(serial_node_type(), copy, size, NULL), NULL );
+
+    /* Another version. */
+    memcpy(copy, buf, size);
+    header->version = TYPE_SERIAL_VERSION + 1;
+    ASSERT2( objpeq, type_deserialize_in_place(serial_node_type(), copy, size, NULL), NULL );
+
+    /* Another root type. */
+    memcpy(copy, buf, size);
+    ASSERT2( objpeq, type_deserialize_in_place(div_type(), copy, size, NULL), NULL );
+
+    /* References outside the image, or between values. */
+    memcpy(copy, buf, size);
+    bad = size;
+    memcpy(copy + next_pos, &bad, sizeof(bad));
+    ASSERT2( objpeq, type_deserialize_in_place(serial_node_type(), copy, size, NULL), NULL );
+
+    memcpy(copy, buf, size);
+    bad = serial_aligned(sizeof(type_serial_header_t)) + TYPE_SERIAL_ALIGNMENT;
+    memcpy(copy + next_pos, &bad, sizeof(bad));
+    ASSERT2( objpeq, type_deserialize_in_place(serial_node_type(), copy, size, NULL), NULL );
+
+    /* A failed read leaves the image as it was. */
+    ASSERT2( inteq, memcmp(copy + next_pos, &bad, sizeof(bad)), 0 );
+
+    memory_manager_mfree(NULL, copy);
+    memory_manager_mfree(NULL, buf);
+  }
+
+  return result;
+}
+
+unit_test_t serialize_embedded_test =
+  {  serialize_embedded_test_run
+  , "serialize_embedded_test"
+  , "Embedded typed values get the reader's types; function pointers are rejected."
+  };
+
+unit_test_result_t serialize_embedded_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  ENCLOSE()
+  {
+    serial_pair_t  pair;
+    serial_pair_t *read;
+    size_t         size;
+    size_t         root;
+    char          *buf;
+
+    pair.type = serial_pair_type;
+    pair.tag  = 7;
+    serial_node_init(&pair.inner, 3, NULL, NULL);
+
+    buf = type_serialize_alloc(serial_pair_type(), &pair, NULL, &size);
+    ASSERT1( true, IS_TRUE(buf) );
+
+    /* As if written by a process with its types elsewhere. */
+    root = serial_aligned(sizeof(type_serial_header_t));
+    memset(buf + root + OFFSET_FIELD(serial_pair_t, type),  0xA5, sizeof(typed_t));
+    memset(buf + root + OFFSET_FIELD(serial_pair_t, inner)
+                      + OFFSET_FIELD(serial_node_t, type),  0xA5, sizeof(typed_t));
+
+    read = type_deserialize_in_place(serial_pair_type(), buf, size, NULL);
+    ASSERT1( true, IS_TRUE(read) );
+    ASSERT1( true, read->type       == serial_pair_type );
+    ASSERT1( true, read->inner.type == serial_node_type );
+    ASSERT2( inteq, read->inner.id, 3 );
+    ASSERT2( inteq, read->tag,      7 );
+
+    memory_manager_mfree(NULL, buf);
+
+    /* Nothing could restore a manager's methods. */
+    ASSERT2( sizeeq, type_serialize(memory_manager_type(), &malloc_manager, NULL, 0, NULL), 0 );
+  }
+
+  return result;
+}
@@ -0,0 +1,286 @@
+/*
+ * opencurry: tests/test_type_base_thread_cache.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../base.h"
+#include "testing.h"
+#include "test_type_base_thread_cache.h"
+
+#include "../type_base_thread_cache.h"
+
+#if POSIX_PARALLEL
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+int test_type_base_thread_cache_cli(int argc, char **argv)
+{
+  return run_test_suite(type_base_thread_cache_test);
+}
+
+/* ---------------------------------------------------------------- */
+
+/* type_base_thread_cache tests. */
+unit_test_t type_base_thread_cache_test =
+  {  test_type_base_thread_cache_run
+  , "test_type_base_thread_cache"
+  , "type_base_thread_cache tests."
+  };
+
+/* Array of type_base_thread_cache tests. */
+unit_test_t *type_base_thread_cache_tests[] =
+  { &thread_cache_reuse_test
+  , &thread_cache_batch_test
+  , &thread_cache_manager_test
+
+  , NULL
+  };
+
+unit_test_result_t test_type_base_thread_cache_run(unit_test_context_t *context)
+{
+  return run_tests(context, type_base_thread_cache_tests);
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t thread_cache_reuse_test =
+  {  thread_cache_reuse_test_run
+  , "thread_cache_reuse_test"
+  , "Freed blocks are reused by the next allocation of the same size class."
+  };
+
+unit_test_result_t thread_cache_reuse_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  thread_cache_t  thread_cache;
+  thread_cache_t *cache;
+
+  cache = thread_cache_init(&thread_cache, NULL);
+
+  ENCLOSE()
+  {
+    char *a;
+    char *b;
+    char *large;
+
+    ASSERT1( true, IS_TRUE(cache) );
+
+    ASSERT2( sizeeq, thread_cache_size_class(1),     0 );
+    ASSERT2( sizeeq, thread_cache_size_class(16),    0 );
+    ASSERT2( sizeeq, thread_cache_size_class(17),    1 );
+    ASSERT2( sizeeq, thread_cache_size_class(THREAD_CACHE_MAX_CLASS_SIZE),     THREAD_CACHE_NUM_CLASSES - 1 );
+    ASSERT2( sizeeq, thread_cache_size_class(THREAD_CACHE_MAX_CLASS_SIZE + 1), THREAD_CACHE_LARGE_CLASS );
+
+    /* ---------------------------------------------------------------- */
+
+    a = thread_cache_malloc(cache, 24);
+    ASSERT1( true, IS_TRUE(a) );
+
+    ASSERT2( sizeeq, thread_cache_free(cache, a), 1 );
+
+    b = thread_cache_malloc(cache, 20);
+    ASSERT2( objpeq, b, a );
+
+    /* Growing within the size class keeps the block. */
+    strlcpy(b, "love", 20);
+    a = thread_cache_realloc(cache, b, 32);
+    ASSERT2( objpeq, a, b );
+
+    /* Growing past it moves the contents. */
+    b = thread_cache_realloc(cache, a, 1000);
+    ASSERT1( true, IS_TRUE(b) );
+    ASSERT3( nstreq, 20, b, "love" );
+
+    ASSERT2( sizeeq, thread_cache_free(cache, b), 1 );
+
+    /* ---------------------------------------------------------------- */
+
+    large = thread_cache_calloc(cache, THREAD_CACHE_MAX_CLASS_SIZE, 2);
+    ASSERT1( true, IS_TRUE(large) );
+    ASSERT2( inteq, large[THREAD_CACHE_MAX_CLASS_SIZE], 0 );
+
+    ASSERT2( sizeeq, thread_cache_free(cache, large), 1 );
+
+    /* As with "free", NULL is ignored. */
+    ASSERT2( sizeeq, thread_cache_free(cache, NULL), 0 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( not_sizeeq, thread_cache_deinit(cache), 0 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+unit_test_t thread_cache_batch_test =
+  {  thread_cache_batch_test_run
+  , "thread_cache_batch_test"
+  , "Magazine overflow returns a batch to the central pool."
+  };
+
+unit_test_result_t thread_cache_batch_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  thread_cache_t  thread_cache;
+  thread_cache_t *cache;
+
+  cache = thread_cache_init(&thread_cache, NULL);
+
+  ENCLOSE()
+  {
+    enum { num_blocks = THREAD_CACHE_MAGAZINE_SIZE + 1 };
+    void   *blocks[num_blocks];
+    size_t  i;
+
+    ASSERT1( true, IS_TRUE(cache) );
+
+    for (i = 0; i < num_blocks; ++i)
+    {
+      blocks[i] = thread_cache_malloc(cache, 8);
+      ASSERT1( true, IS_TRUE(blocks[i]) );
+    }
+
+    ASSERT2( sizeeq, thread_cache_central_num(cache, 0), 0 );
+
+    for (i = 0; i < num_blocks; ++i)
+      ASSERT2( sizeeq, thread_cache_free(cache, blocks[i]), 1 );
+
+    ASSERT2( sizeeq, thread_cache_central_num(cache, 0), THREAD_CACHE_BATCH_SIZE );
+
+    /* Three chunks were carved; after a flush, the central pool has them all. */
+    ASSERT2( sizeeq, thread_cache_flush(cache), THREAD_CACHE_MAGAZINE_SIZE );
+    ASSERT2( sizeeq, thread_cache_central_num(cache, 0), 3 * THREAD_CACHE_BATCH_SIZE );
+
+    /* The next allocation takes a batch back. */
+    ASSERT1( true, IS_TRUE(blocks[0] = thread_cache_malloc(cache, 8)) );
+    ASSERT2( sizeeq, thread_cache_central_num(cache, 0), 2 * THREAD_CACHE_BATCH_SIZE );
+    ASSERT2( sizeeq, thread_cache_free(cache, blocks[0]), 1 );
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( sizeeq, thread_cache_deinit(cache), 3 );
+  }
+
+  return result;
+}
+
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+static void *thread_cache_manager_test_worker(void *manager_raw)
+{
+  const memory_manager_t *manager = manager_raw;
+  void                   *blocks[16];
+  size_t                  i;
+  size_t                  j;
+
+  for (i = 0; i < 1024; ++i)
+  {
+    for (j = 0; j < 16; ++j)
+      blocks[j] = memory_manager_mmalloc(manager, 8 + 8 * j);
+    for (j = 0; j < 16; ++j)
+      if (!blocks[j] || memory_manager_mfree(manager, blocks[j]) != 1)
+        return NULL;
+  }
+
+  return manager_raw;
+}
+#endif /* #if POSIX_PARALLEL */
+
+unit_test_t thread_cache_manager_test =
+  {  thread_cache_manager_test_run
+  , "thread_cache_manager_test"
+  , "Allocating through the thread cache memory_manager_t front-end."
+  };
+
+unit_test_result_t thread_cache_manager_test_run(unit_test_context_t *context)
+{
+  unit_test_result_t result = assert_success(context);
+
+  thread_cache_t    thread_cache;
+  thread_cache_t   *cache;
+  memory_manager_t  memory_manager;
+  memory_manager_t *manager;
+
+  cache   = thread_cache_init(&thread_cache, NULL);
+  manager = thread_cache_manager_init(&memory_manager, cache);
+
+  ENCLOSE()
+  {
+    int *intp;
+
+    ASSERT1( true, IS_TRUE(cache) );
+    ASSERT1( true, IS_TRUE(manager) );
+
+    intp = memory_manager_mcalloc(manager, 4, sizeof(*intp));
+    ASSERT1( true, IS_TRUE(intp) );
+    ASSERT2( inteq, intp[3], 0 );
+    ASSERT2( sizeeq, memory_manager_mfree(manager, intp), 1 );
+
+    /* The global front-end. */
+    intp = memory_manager_mmalloc(&thread_cache_manager, sizeof(*intp));
+    ASSERT1( true, IS_TRUE(intp) );
+    ASSERT2( sizeeq, memory_manager_mfree(&thread_cache_manager, intp), 1 );
+
+#if POSIX_PARALLEL
+    {
+      enum { num_threads = 4 };
+      pthread_t threads[num_threads];
+      void     *status;
+      size_t    i;
+
+      for (i = 0; i < num_threads; ++i)
+        ASSERT2( inteq, pthread_create(&threads[i], NULL, thread_cache_manager_test_worker, manager), 0 );
+
+      for (i = 0; i < num_threads; ++i)
+      {
+        ASSERT2( inteq, pthread_join(threads[i], &status), 0 );
+        ASSERT2( objpeq, status, manager );
+      }
+
+      /* Exited threads handed their magazines back. */
+      ASSERT2( not_sizeeq, thread_cache_central_num(cache, 0), 0 );
+    }
+#endif /* #if POSIX_PARALLEL */
+  }
+
+  ENCLOSE()
+  {
+    ASSERT2( not_sizeeq, thread_cache_deinit(cache), 0 );
+  }
+
+  return result;
+}
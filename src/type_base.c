@@ -70,36 +70,28 @@
 #include <time.h>
 
 #include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_cond_t
+ *   - pthread_mutex_t
+ *   - pthread_self
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
 #include "type_base.h"
 
 #include "type_base_ext.h"
 
+#include "mempool.h"
+
 #include "util.h"
 
 /* ---------------------------------------------------------------- */
 /* ref_traversal_t                                                  */
 /* ---------------------------------------------------------------- */
 
-/* TODO */
-#ifdef TODO
-/* TODO */
-const type_t *ref_traversal_type(void);
-extern const type_t ref_traversal_type_def;
-typedef struct ref_traversal_s ref_traversal_t;
-struct ref_traversal_s
-{
-  typed_t type;
-
-  memory_tracker_t memory;
-
-  /* TODO void TODO_on_loop; */
-
-  void   **history;
-  size_t   history_num;
-  size_t   history_size;
-  size_t   history_len;
-};
-
 /* ref_traversal type. */
 
 const type_t *ref_traversal_type(void)
@@ -108,9 +100,11 @@ const type_t *ref_traversal_type(void)
 static const char          *ref_traversal_type_name       (const type_t *self);
 static size_t               ref_traversal_type_size       (const type_t *self, const tval *val);
 static const struct_info_t *ref_traversal_type_is_struct  (const type_t *self);
-static tval                *ref_traversal_type_init       (const type_t *self, tval *cons);
+static size_t               ref_traversal_type_free       (const type_t *self, tval *val);
 static const tval          *ref_traversal_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *ref_traversal_type_registry_entry = NULL;
+
 const type_t ref_traversal_type_def =
   { type_type
 
@@ -134,8 +128,8 @@ const type_t ref_traversal_type_def =
   , /* is_supertype           */ NULL
 
   , /* cons_type              */ NULL
-  , /* init                   */ ref_traversal_type_init
-  , /* free                   */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ ref_traversal_type_free
   , /* has_default            */ ref_traversal_type_has_default
   , /* mem                    */ NULL
   , /* mem_init               */ NULL
@@ -148,6 +142,10 @@ const type_t ref_traversal_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &ref_traversal_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -158,70 +156,398 @@ static const char          *ref_traversal_type_name       (const type_t *self)
 static size_t               ref_traversal_type_size       (const type_t *self, const tval *val)
   { return sizeof(ref_traversal_t); }
 
-/* TODO */
-#ifdef TODO
-DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(ref_traversal)
+/* The table is owned by the value, so a field-by-field copy would share it. */
 static const struct_info_t *ref_traversal_type_is_struct  (const type_t *self)
+  { return type_is_not_struct(self); }
+
+static size_t               ref_traversal_type_free       (const type_t *self, tval *val)
+{
+  ref_traversal_clear((ref_traversal_t *) val);
+
+  return type_has_template_cons_basic_freer(self, val);
+}
+
+static const tval          *ref_traversal_type_has_default(const type_t *self)
+  { return type_has_default_value(self, &ref_traversal_defaults); }
+
+/* ---------------------------------------------------------------- */
+
+const ref_traversal_t ref_traversal_defaults =
+  REF_TRAVERSAL_DEFAULTS;
+
+/* ---------------------------------------------------------------- */
+
+/* ref_traversal methods. */
+
+/* Entries for the chains of "table", once the inline entries overflow. */
+struct ref_traversal_chunk_s
+{
+  ref_traversal_chunk_t *next;
+  ref_traversal_entry_t  entries[REF_TRAVERSAL_CHUNK_NUM];
+};
+
+static const memory_manager_t *ref_traversal_memory_manager(const ref_traversal_t *ref_traversal)
+{
+  if (ref_traversal->memory_manager)
+    return ref_traversal->memory_manager;
+  else
+    return default_memory_manager;
+}
+
+/* Add a chunk of free entries.  0 on success. */
+static int ref_traversal_add_chunk(ref_traversal_t *ref_traversal)
+{
+  ref_traversal_chunk_t *chunk;
+  size_t                 i;
+
+  chunk = memory_manager_mmalloc(ref_traversal_memory_manager(ref_traversal), sizeof(*chunk));
+  if (!chunk)
+    return -1;
+
+  chunk->next           = ref_traversal->chunks;
+  ref_traversal->chunks = chunk;
+
+  for (i = 0; i < REF_TRAVERSAL_CHUNK_NUM; ++i)
   {
-    STRUCT_INFO_BEGIN(ref_traversal);
+    chunk->entries[i].next      = ref_traversal->free_entries;
+    ref_traversal->free_entries = &chunk->entries[i];
+  }
 
-    /* typed_t type */
-    STRUCT_INFO_RADD(typed_type(), type);
+  return 0;
+}
 
-    /* ptrdiff_t     field_pos;  */
-    STRUCT_INFO_RADD(objp_type(),    TODO);
+/* Find a triple in the table or inline storage, or NULL. */
+static ref_traversal_entry_t *ref_traversal_find(const ref_traversal_t *ref_traversal, size_t tag, const void *kind, const void *reference)
+{
+  const ref_traversal_entry_t *entry;
 
-    STRUCT_INFO_DONE();
+  if (!ref_traversal || !reference)
+    return NULL;
+
+  if (!ref_traversal->chunks)
+  {
+    const ref_traversal_entry_t *end;
+
+    end = ref_traversal->inline_entries + ref_traversal->num;
+    for (entry = ref_traversal->inline_entries; entry < end; ++entry)
+    {
+      if (entry->reference == reference && entry->tag == tag && entry->kind == kind)
+        return (ref_traversal_entry_t *) entry;
+    }
+
+    return NULL;
   }
-#endif /* #ifdef TODO */
+  else
+  {
+    void **chain;
 
-/*
-static tval                *ref_traversal_type_init       (const type_t *self, tval *cons)
+    chain = hash_table_find(&ref_traversal->table, reference);
+    if (!chain)
+      return NULL;
+
+    for (entry = *chain; entry; entry = entry->next)
+    {
+      if (entry->tag == tag && entry->kind == kind)
+        return (ref_traversal_entry_t *) entry;
+    }
+
+    return NULL;
+  }
+}
+
+/* Link a triple, known to be absent, into the table.  NULL if the table
+ * could not grow.
+ */
+static ref_traversal_entry_t *ref_traversal_table_place(ref_traversal_t *ref_traversal, size_t tag, const void *kind, const void *reference)
 {
-  ref_traversal_t *val;
+  ref_traversal_entry_t *entry;
+  void                 **chain;
+  int                    inserted;
+
+  if (!ref_traversal->free_entries && ref_traversal_add_chunk(ref_traversal))
+    return NULL;
 
-  if ((!val = type_has_template_cons_basic_initializer(self, cons)))
+  chain = hash_table_insert(&ref_traversal->table, reference, &inserted);
+  if (!chain)
     return NULL;
 
-  val->is_mutable = val;
+  entry                       = ref_traversal->free_entries;
+  ref_traversal->free_entries = entry->next;
+
+  entry->reference = reference;
+  entry->tag       = tag;
+  entry->kind      = kind;
+  entry->value     = NULL;
+  entry->next      = *chain;
 
-  TODO
+  *chain = entry;
+
+  return entry;
 }
-*/
 
-static const tval          *ref_traversal_type_has_default(const type_t *self)
-  { return type_has_default_value(self, &ref_traversal_defaults); }
+/* Move the inline entries into the table.  0 on success. */
+static int ref_traversal_spill(ref_traversal_t *ref_traversal)
+{
+  size_t i;
 
-/* ---------------------------------------------------------------- */
+  hash_table_init(&ref_traversal->table, NULL, 0, ref_traversal->memory_manager);
 
-const ref_traversal_t ref_traversal_defaults =
-  REF_TRAVERSAL_DEFAULTS;
-#endif /* #ifdef TODO */
+  /* Neither can fail once both have succeeded, since a chunk holds every
+   * inline entry.
+   */
+  if (hash_table_reserve(&ref_traversal->table, REF_TRAVERSAL_INLINE_NUM + 1))
+    return -1;
 
-/* ---------------------------------------------------------------- */
+  if (ref_traversal_add_chunk(ref_traversal))
+  {
+    hash_table_deinit(&ref_traversal->table);
+    return -1;
+  }
+
+  for (i = 0; i < ref_traversal->num; ++i)
+  {
+    const ref_traversal_entry_t *old;
+
+    old = &ref_traversal->inline_entries[i];
+    ref_traversal_table_place(ref_traversal, old->tag, old->kind, old->reference)->value = old->value;
+  }
+
+  return 0;
+}
+
+/* Insert a triple known to be absent.  NULL if the set could not grow. */
+static ref_traversal_entry_t *ref_traversal_insert(ref_traversal_t *ref_traversal, size_t tag, const void *kind, const void *reference)
+{
+  ref_traversal_entry_t *entry;
+
+  if (!ref_traversal->chunks)
+  {
+    if (ref_traversal->num < REF_TRAVERSAL_INLINE_NUM)
+    {
+      entry = &ref_traversal->inline_entries[ref_traversal->num++];
+
+      entry->reference = reference;
+      entry->tag       = tag;
+      entry->kind      = kind;
+      entry->value     = NULL;
+      entry->next      = NULL;
+
+      return entry;
+    }
+
+    if (ref_traversal_spill(ref_traversal))
+      return NULL;
+  }
+
+  entry = ref_traversal_table_place(ref_traversal, tag, kind, reference);
+  if (entry)
+    ++ref_traversal->num;
+
+  return entry;
+}
+
+static void ref_traversal_erase(ref_traversal_t *ref_traversal, ref_traversal_entry_t *entry)
+{
+  if (!ref_traversal->chunks)
+  {
+    /* Keep inline storage dense. */
+    *entry = ref_traversal->inline_entries[--ref_traversal->num];
+  }
+  else
+  {
+    void                 **chain;
+    ref_traversal_entry_t *prev;
+
+    chain = hash_table_find(&ref_traversal->table, entry->reference);
+
+    if (*chain == entry)
+    {
+      *chain = entry->next;
+    }
+    else
+    {
+      for (prev = *chain; prev->next != entry; prev = prev->next)
+        ;
+      prev->next = entry->next;
+    }
+
+    if (!*chain)
+      hash_table_remove(&ref_traversal->table, entry->reference, NULL);
+
+    entry->reference            = NULL;
+    entry->value                = NULL;
+    entry->next                 = ref_traversal->free_entries;
+    ref_traversal->free_entries = entry;
+
+    --ref_traversal->num;
+  }
+}
 
-/* ref_traversal methods.
+ref_traversal_t *ref_traversal_clear(ref_traversal_t *ref_traversal)
+{
+  if (!ref_traversal)
+    return NULL;
+
+  if (ref_traversal->chunks)
+  {
+    hash_table_deinit(&ref_traversal->table);
+
+    while (ref_traversal->chunks)
+    {
+      ref_traversal_chunk_t *chunk;
+
+      chunk                 = ref_traversal->chunks;
+      ref_traversal->chunks = chunk->next;
+
+      memory_manager_mfree(ref_traversal_memory_manager(ref_traversal), chunk);
+    }
+  }
+
+  ref_traversal->num          = 0;
+  ref_traversal->chunks       = NULL;
+  ref_traversal->free_entries = NULL;
+
+  return ref_traversal;
+}
+
+/* Only the first "num" inline entries are ever read, and "table" only once
+ * "chunks" is set, so chunk iteration need not pay for copying the whole of
+ * "ref_traversal_defaults".
  */
-#ifndef TODO
 ref_traversal_t *ref_traversal_init_empty(ref_traversal_t *dest)
-{ /* TODO */ return NULL; }
+{
+  if (!dest)
+    return NULL;
+
+  dest->type           = ref_traversal_type;
+  dest->memory_manager = NULL;
+  dest->num            = 0;
+  dest->chunks         = NULL;
+  dest->free_entries   = NULL;
+
+  return dest;
+}
+
 ref_traversal_t *ref_traversal_init_with_one(ref_traversal_t *dest, void *reference)
-{ /* TODO */ return NULL; }
+{
+  if (!ref_traversal_init_empty(dest))
+    return NULL;
+
+  ref_traversal_add(dest, reference);
+
+  return dest;
+}
+
+ref_traversal_t *ref_traversal_init_with_memory_manager(ref_traversal_t *dest, const memory_manager_t *memory_manager)
+{
+  if (!ref_traversal_init_empty(dest))
+    return NULL;
+
+  dest->memory_manager = memory_manager;
+
+  return dest;
+}
+
+size_t ref_traversal_num(const ref_traversal_t *ref_traversal)
+{
+  if (!ref_traversal)
+    return 0;
+
+  return ref_traversal->num;
+}
+
 void *ref_traversal_add   (      ref_traversal_t *ref_traversal, void *reference)
-{ /* TODO */ return NULL; }
+  { return ref_traversal_tagged_add   (ref_traversal, 0, reference); }
 void *ref_traversal_remove(      ref_traversal_t *ref_traversal, void *reference)
-{ /* TODO */ return NULL; }
+  { return ref_traversal_tagged_remove(ref_traversal, 0, reference); }
+void *ref_traversal_take  (      ref_traversal_t *ref_traversal, void *reference)
+  { return ref_traversal_tagged_take  (ref_traversal, 0, reference); }
 void *ref_traversal_exists(const ref_traversal_t *ref_traversal, void *reference)
-{ /* TODO */ return NULL; }
+  { return ref_traversal_tagged_exists(ref_traversal, 0, reference); }
+
 void *ref_traversal_tagged_add   (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
-{ /* TODO */ return NULL; }
+  { return ref_traversal_tagged_as_add   (ref_traversal, tag, NULL, reference); }
 void *ref_traversal_tagged_remove(      ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
-{ /* TODO */ return NULL; }
-void *ref_traversal_tagged_take  (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
-{ /* TODO */ return NULL; }
+  { return ref_traversal_tagged_as_remove(ref_traversal, tag, NULL, reference); }
 void *ref_traversal_tagged_exists(const ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
-{ /* TODO */ return NULL; }
-#endif /* #ifndef TODO */
+  { return ref_traversal_tagged_as_exists(ref_traversal, tag, NULL, reference); }
+
+void *ref_traversal_tagged_take  (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
+{
+  ref_traversal_entry_t *entry;
+
+  entry = ref_traversal_find(ref_traversal, tag, NULL, reference);
+  if (!entry)
+    return NULL;
+
+  ref_traversal_erase(ref_traversal, entry);
+
+  return reference;
+}
+
+void *ref_traversal_tagged_as_add   (      ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference)
+{
+  if (!ref_traversal || !reference)
+    return NULL;
+
+  if (ref_traversal_find(ref_traversal, tag, kind, reference))
+    return NULL;
+
+  if (!ref_traversal_insert(ref_traversal, tag, kind, reference))
+    return NULL;
+
+  return reference;
+}
+
+void *ref_traversal_tagged_as_remove(      ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference)
+{
+  ref_traversal_entry_t *entry;
+
+  entry = ref_traversal_find(ref_traversal, tag, kind, reference);
+  if (!entry)
+    return reference;
+
+  ref_traversal_erase(ref_traversal, entry);
+
+  return NULL;
+}
+
+void *ref_traversal_tagged_as_exists(const ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference)
+{
+  if (!ref_traversal_find(ref_traversal, tag, kind, reference))
+    return NULL;
+
+  return reference;
+}
+
+void *ref_traversal_tagged_memoize (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference, void *value)
+{
+  ref_traversal_entry_t *entry;
+
+  if (!ref_traversal || !reference)
+    return NULL;
+
+  entry = ref_traversal_find(ref_traversal, tag, NULL, reference);
+  if (!entry)
+    entry = ref_traversal_insert(ref_traversal, tag, NULL, reference);
+  if (!entry)
+    return NULL;
+
+  entry->value = value;
+
+  return reference;
+}
+
+void *ref_traversal_tagged_memoized(const ref_traversal_t *ref_traversal, unsigned char tag, void *reference)
+{
+  ref_traversal_entry_t *entry;
+
+  entry = ref_traversal_find(ref_traversal, tag, NULL, reference);
+  if (!entry)
+    return NULL;
+
+  return entry->value;
+}
 
 /* ---------------------------------------------------------------- */
 /* struct_info_t and field_info_t                                   */
@@ -237,6 +563,8 @@ static size_t               field_info_type_size       (const type_t *self, cons
 static const struct_info_t *field_info_type_is_struct  (const type_t *self);
 static const tval          *field_info_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *field_info_type_registry_entry = NULL;
+
 const type_t field_info_type_def =
   { type_type
 
@@ -274,6 +602,10 @@ const type_t field_info_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &field_info_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -408,46 +740,12 @@ const void *field_info_cref(const field_info_t *field_info,  const void *base)
 
 int field_memcmp(const field_info_t *field_info, const void *field_val1, const void *field_val2)
 {
-  size_t i;
-  size_t size = field_info->field_size;
-
   if (!field_val1)
     return FIELD_MEMCMP_ERR_NULL_FIELD_VAL1;
   if (!field_val2)
     return FIELD_MEMCMP_ERR_NULL_FIELD_VAL2;
 
-  for (i = 0; i < size; ++i)
-  {
-    unsigned char b1 = ((const unsigned char *) field_val1)[i];
-    unsigned char b2 = ((const unsigned char *) field_val2)[i];
-
-    if      (b1 > b2)
-    {
-      int i1         = (int) b1;
-      int i2         = (int) b2;
-
-      int difference = i2 - i1;
-
-      if (difference <= 0)
-        difference = 1;
-
-      return difference;
-    }
-    else if (b1 < b2)
-    {
-      int i1         = (int) b1;
-      int i2         = (int) b2;
-
-      int difference = i2 - i1;
-
-      if (difference >= 0)
-        difference = -1;
-
-      return difference;
-    }
-  }
-
-  return 0;
+  return mem_cmp(field_val1, field_val2, field_info->field_size);
 }
 
 void *field_memcpy(const field_info_t *field_info, void *dest, const void *src)
@@ -621,6 +919,12 @@ verify_field_info_status_t verify_field_info(const field_info_t *field_info, cha
 }
 
 
+/* Whether even a shallow copy of the field must add an owner to its referent. */
+static int field_is_shared_ref(const field_info_t *field_info)
+{
+  return field_info->field_type && field_info->field_type->dup == type_has_shared_ref_dup;
+}
+
 /* NULL on success. */
 /* TODO: memory_manager! */
 const char *field_dup(const field_info_t *field_info, void *dest, const void *src, int defaults_src_unused, int rec_copy, int dup_metadata, ref_traversal_t *vals)
@@ -636,7 +940,7 @@ const char *field_dup(const field_info_t *field_info, void *dest, const void *sr
 
   /* TODO: We're verifying this each time a field is dup'd! */
   verify_status = verify_field_info(field_info, err_buf, err_buf_size);
-  if (!verify_status)
+  if (verify_status != verify_field_info_success)
     return err_buf;
 
   if (!dest)
@@ -650,7 +954,7 @@ const char *field_dup(const field_info_t *field_info, void *dest, const void *sr
       return NULL;
   }
 
-  if (field_info->is_recursible_ref && rec_copy != 0)
+  if (field_info->is_recursible_ref && (rec_copy != 0 || field_is_shared_ref(field_info)))
   {
     tval *type_dup_status;
 
@@ -683,7 +987,14 @@ const char *field_dup(const field_info_t *field_info, void *dest, const void *sr
     {
       int wrote_default;
 
-      wrote_default = is_field_template_unused(field_info, src, dest, NULL, dest);
+      wrote_default =
+        is_field_template_unused
+          ( field_info
+          , field_info_cref(field_info, src)
+          , field_info_ref (field_info, dest)
+          , NULL
+          , field_info_ref (field_info, dest)
+          );
 
       if (wrote_default < 0)
       {
@@ -726,6 +1037,8 @@ static size_t               struct_info_type_size       (const type_t *self, con
 static const struct_info_t *struct_info_type_is_struct  (const type_t *self);
 static const tval          *struct_info_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *struct_info_type_registry_entry = NULL;
+
 const type_t struct_info_type_def =
   { type_type
 
@@ -763,6 +1076,10 @@ const type_t struct_info_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &struct_info_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -781,19 +1098,32 @@ static const struct_info_t *struct_info_type_is_struct  (const type_t *self)
     /* typed_t type */
     STRUCT_INFO_RADD(typed_type(), type);
 
-    /* field_info_t fields[STRUCT_INFO_NUM_FIELDS]; */
-    /* size_t       fields_len;                     */
-    STRUCT_INFO_RADD(array_type(), fields);
+    /* field_info_t *fields;      */
+    /* size_t        fields_len;  */
+    /* size_t        fields_size; */
+    STRUCT_INFO_RADD(objp_type(),  fields);
     STRUCT_INFO_RADD(size_type(),  fields_len);
+    STRUCT_INFO_RADD(size_type(),  fields_size);
 
     /* struct_info_t *tail; */
     STRUCT_INFO_RADD(objp_type(),  tail);
 
+    /* size_t (*field_default_value)        (...); */
+    /* size_t (*field_template_unused_value)(...); */
+    STRUCT_INFO_RADD(funp_type(),  field_default_value);
+    STRUCT_INFO_RADD(funp_type(),  field_template_unused_value);
+
     /* int       has_memory_tracker; */
     /* size_t    memory_tracker_field; */
     STRUCT_INFO_RADD(int_type(),   has_memory_tracker);
     STRUCT_INFO_RADD(size_type(),  memory_tracker_field);
 
+    /* const struct_info_plan_t *plan; */
+    STRUCT_INFO_RADD(objp_type(),  plan);
+
+    /* const void               *default_image; */
+    STRUCT_INFO_RADD(objp_type(),  default_image);
+
     STRUCT_INFO_DONE();
   }
 
@@ -803,31 +1133,92 @@ static const tval          *struct_info_type_has_default(const type_t *self)
 /* ---------------------------------------------------------------- */
 
 const struct_info_t struct_info_defaults =
-  { struct_info_type
+  STRUCT_INFO_DEFAULTS;
 
-  , { { field_info_type, (size_t) (-1) } }
-  , 0
+const field_info_t * const field_terminator = &terminating_field_info;
 
-  , NULL
+/* TODO: field_type: void_type? */
+const field_info_t terminating_field_info =
+  FIELD_INFO_TERMINATOR;
 
-  , 0
-  , 0
-  };
+/* ---------------------------------------------------------------- */
 
-const field_info_t * const field_terminator = &terminating_field_info;
+/*
+ * Once-initialization.
+ *
+ * A finished "struct_info" costs callers a single acquiring read.  Until
+ * then, a shared lock and condition guard each state change, and waiters
+ * sleep on the condition until the builder ends or fails.
+ */
 
-const field_info_t terminating_field_info =
-  { field_info_type
+#if POSIX_PARALLEL
+static pthread_mutex_t struct_info_once_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  struct_info_once_done = PTHREAD_COND_INITIALIZER;
+#endif /* #if POSIX_PARALLEL */
 
-  , (size_t) (-1)
-  , 0
-  , NULL /* TODO: void_type? */
+int  struct_info_once_begin(struct_info_once_t *once)
+{
+  int build;
+  int state;
 
-  , 0
-  , NULL
-  };
+  state = ATOMIC_LOAD(&once->state);
+  if (state == STRUCT_INFO_ONCE_DONE || state == STRUCT_INFO_ONCE_FAILED)
+    return 0;
 
-/* ---------------------------------------------------------------- */
+#if POSIX_PARALLEL
+  pthread_mutex_lock(&struct_info_once_lock);
+
+  while
+    (  once->state == STRUCT_INFO_ONCE_BUILDING
+    && !pthread_equal(once->builder, pthread_self())
+    )
+  {
+    pthread_cond_wait(&struct_info_once_done, &struct_info_once_lock);
+  }
+#endif /* #if POSIX_PARALLEL */
+
+  build = once->state == STRUCT_INFO_ONCE_UNSTARTED;
+  if (build)
+  {
+#if POSIX_PARALLEL
+    once->builder = pthread_self();
+#endif /* #if POSIX_PARALLEL */
+    ATOMIC_STORE(&once->state, STRUCT_INFO_ONCE_BUILDING);
+  }
+
+#if POSIX_PARALLEL
+  pthread_mutex_unlock(&struct_info_once_lock);
+#endif /* #if POSIX_PARALLEL */
+
+  return build;
+}
+
+/* Leave the building state, waking waiters. */
+static void struct_info_once_finish(struct_info_once_t *once, int state)
+{
+#if POSIX_PARALLEL
+  pthread_mutex_lock(&struct_info_once_lock);
+#endif /* #if POSIX_PARALLEL */
+
+  ATOMIC_STORE(&once->state, state);
+
+#if POSIX_PARALLEL
+  pthread_cond_broadcast(&struct_info_once_done);
+  pthread_mutex_unlock(&struct_info_once_lock);
+#endif /* #if POSIX_PARALLEL */
+}
+
+void struct_info_once_end  (struct_info_once_t *once)
+{
+  struct_info_once_finish(once, STRUCT_INFO_ONCE_DONE);
+}
+
+void struct_info_once_fail (struct_info_once_t *once)
+{
+  struct_info_once_finish(once, STRUCT_INFO_ONCE_FAILED);
+}
+
+/* ---------------------------------------------------------------- */
 
 struct_info_t *struct_info_init
   ( struct_info_t *struct_info
@@ -835,27 +1226,43 @@ struct_info_t *struct_info_init
   , size_t      (*template_unused_value)(const field_info_t *self, void *dest_field_mem)
   )
 {
-  field_info_t *final_field;
-
   if (!struct_info)
     return NULL;
 
   struct_info->type = struct_info_type;
 
-  struct_info->fields_len = 0;
+  struct_info->fields      = NULL;
+  struct_info->fields_len  = 0;
+  struct_info->fields_size = 0;
 
   struct_info->tail = NULL;
 
+  struct_info->field_default_value         = default_value;
+  struct_info->field_template_unused_value = template_unused_value;
+
   struct_info->has_memory_tracker   = 0;
   struct_info->memory_tracker_field = 0;
 
-  /* Store default_value and template_unused_value in the last element until
-   * done writing the struct_info.
-   */
-  final_field = ARRAY_FINAL_REF(struct_info->fields);
-  final_field->type                  = field_info_type;
-  final_field->default_value         = default_value;
-  final_field->template_unused_value = template_unused_value;
+  struct_info->plan          = NULL;
+  struct_info->default_image = NULL;
+
+  return struct_info;
+}
+
+/* Resize "fields" to "fields_size" elements.  NULL on failure. */
+static struct_info_t *struct_info_resize_fields(struct_info_t *struct_info, size_t fields_size)
+{
+  field_info_t *fields;
+
+  if (fields_size == struct_info->fields_size)
+    return struct_info;
+
+  fields = memory_manager_mrealloc(default_memory_manager, struct_info->fields, fields_size * sizeof(*fields));
+  if (!fields)
+    return NULL;
+
+  struct_info->fields      = fields;
+  struct_info->fields_size = fields_size;
 
   return struct_info;
 }
@@ -870,6 +1277,42 @@ struct_info_t *struct_info_add_field_info(struct_info_t *struct_info, const fiel
   if (struct_info->fields_len >= STRUCT_INFO_NUM_FIELDS)
     return NULL;
 
+  /* The fields are changing; any plan or image is out of date. */
+  if (struct_info->plan)
+  {
+    memory_manager_mfree(default_memory_manager, (void *) struct_info->plan);
+    struct_info->plan = NULL;
+  }
+  if (struct_info->default_image)
+  {
+    memory_manager_mfree(default_memory_manager, (void *) struct_info->default_image);
+    struct_info->default_image = NULL;
+  }
+
+  if (is_field_terminator(field_info))
+  {
+    /* Done adding fields: trim storage to its final size. */
+    if (!struct_info_resize_fields(struct_info, struct_info->fields_len + 1))
+      return NULL;
+
+    struct_info->fields[struct_info->fields_len] = *field_info;
+
+    return struct_info;
+  }
+
+  /* Leave room for the terminator. */
+  if (struct_info->fields_len + 2 > struct_info->fields_size)
+  {
+    size_t fields_size;
+
+    fields_size = struct_info->fields_size * 2;
+    if (fields_size < STRUCT_INFO_MIN_FIELDS_SIZE)
+      fields_size = STRUCT_INFO_MIN_FIELDS_SIZE;
+
+    if (!struct_info_resize_fields(struct_info, fields_size))
+      return NULL;
+  }
+
   if
     (  !struct_info->has_memory_tracker
     && is_subtype(field_info->field_type, memory_tracker_type())
@@ -880,8 +1323,7 @@ struct_info_t *struct_info_add_field_info(struct_info_t *struct_info, const fiel
   }
 
   struct_info->fields[struct_info->fields_len] = *field_info;
-  if (!is_field_terminator(field_info))
-    ++struct_info->fields_len;
+  ++struct_info->fields_len;
 
   return struct_info;
 }
@@ -923,8 +1365,8 @@ struct_info_t *struct_info_add_field
 
   field_info_def.is_recursible_ref = 0;
 
-  field_info_def.default_value         = ARRAY_FINAL_ELEM(struct_info->fields).default_value;
-  field_info_def.template_unused_value = ARRAY_FINAL_ELEM(struct_info->fields).template_unused_value;
+  field_info_def.default_value         = struct_info->field_default_value;
+  field_info_def.template_unused_value = struct_info->field_template_unused_value;
 
   return struct_info_add_field_info(struct_info, &field_info_def);
 }
@@ -977,7 +1419,7 @@ void *struct_info_iterate_chunks
       break;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return accumulation;
 }
@@ -1034,7 +1476,7 @@ void *struct_info_iterate_fields
       break;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return accumulation;
 }
@@ -1069,7 +1511,7 @@ void *struct_info_iterate_chunks_mutable
       break;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return accumulation;
 }
@@ -1126,7 +1568,7 @@ void *struct_info_iterate_fields_mutable
       break;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return accumulation;
 }
@@ -1147,14 +1589,14 @@ size_t struct_info_num_fields(const struct_info_t *struct_info)
     if (struct_info->fields_len >= STRUCT_INFO_NUM_FIELDS)
     {
       /* Error: struct_info's fields_len is too big for this chunk. */
-      tval_free(struct_infos);
+      ref_traversal_clear(struct_infos);
       return 0;
     }
 
     num_defined_fields += struct_info->fields_len;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return num_defined_fields;
 }
@@ -1178,7 +1620,7 @@ size_t struct_info_num_tails(const struct_info_t *struct_info)
     ++num_chunks;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return (size_t) (size_less_null(num_chunks));
 }
@@ -1219,7 +1661,7 @@ const field_info_t *struct_info_index_field(const struct_info_t *struct_info, si
     }
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return field_info;
 }
@@ -1260,18 +1702,15 @@ field_info_t *struct_info_index_field_mutable(struct_info_t *struct_info, size_t
     }
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return field_info;
 }
 
-const field_info_t *struct_info_has_typed_field(const struct_info_t *struct_info)
+static const field_info_t *struct_info_find_typed_field(const struct_info_t *struct_info)
 {
   const field_info_t *field_info;
 
-  if (!struct_info)
-      return NULL;
-
   field_info = struct_info_index_field(struct_info, STRUCT_INFO_TYPED_FIELD);
 
   if (!field_info)
@@ -1283,6 +1722,21 @@ const field_info_t *struct_info_has_typed_field(const struct_info_t *struct_info
   return field_info;
 }
 
+const field_info_t *struct_info_has_typed_field(const struct_info_t *struct_info)
+{
+  const struct_info_plan_t *plan;
+
+  if (!struct_info)
+      return NULL;
+
+  /* Resolved when the plan was built. */
+  plan = ATOMIC_LOAD(&struct_info->plan);
+  if (plan)
+    return plan->typed_field;
+
+  return struct_info_find_typed_field(struct_info);
+}
+
 const field_info_t *struct_info_has_memory_tracker(const struct_info_t *struct_info)
 {
   if (!struct_info)
@@ -1390,11 +1844,17 @@ verify_struct_info_status_t verify_struct_info_chunk(const struct_info_t *struct
   }
 
   /* Make sure fields is field-terminated. */
-  if (num_fields < STRUCT_INFO_NUM_FIELDS)
+  /*                                       */
+  /* A chunk with no field storage at all  */
+  /* is empty.                             */
+  if (num_fields < STRUCT_INFO_NUM_FIELDS && (struct_info->fields || num_fields > 0))
   {
     int terminated;
 
-    terminated = is_field_terminator(&struct_info->fields[num_fields]);
+    if (num_fields >= struct_info->fields_size)
+      terminated = 0;
+    else
+      terminated = is_field_terminator(&struct_info->fields[num_fields]);
     if (terminated < 0)
     {
       /* Something went wrong. */
@@ -1583,11 +2043,317 @@ verify_struct_info_status_t verify_struct_info(const struct_info_t *struct_info,
       break;
   }
 
-  tval_free(struct_infos);
+  ref_traversal_clear(struct_infos);
 
   return status;
 }
 
+/* ---------------------------------------------------------------- */
+
+/* Copy and compare plans. */
+
+/* Fields that are copied and compared as plain bytes can be merged. */
+static int is_field_plain(const field_info_t *field_info)
+{
+  return !field_info->is_metadata && !field_info->is_recursible_ref;
+}
+
+/* A recursible reference with its own default may allocate it, so each
+ * value initialized from the default image calls it again.
+ */
+static int is_field_default_fixup(const field_info_t *field_info)
+{
+  size_t (*default_value)(const field_info_t *self, void *dest_mem);
+
+  if (field_info->is_metadata || !field_info->is_recursible_ref)
+    return 0;
+
+  default_value = field_info->default_value;
+  if (!default_value)
+    default_value = field_info_defaults.default_value;
+
+  return default_value && default_value != default_value_zero;
+}
+
+/* Plans and default images are published once, with a compare-and-swap. */
+#define STRUCT_INFO_PLAN_PUBLISH(struct_info, plan) \
+  ATOMIC_CAS(&(struct_info)->plan, NULL, (plan))
+#define STRUCT_INFO_DEFAULT_IMAGE_PUBLISH(struct_info, image) \
+  ATOMIC_CAS(&(struct_info)->default_image, NULL, (image))
+
+static void *struct_info_plan_count_step(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  const field_info_t **last;
+  size_t              *steps_num;
+
+  last      = context;
+  steps_num = last_accumulation;
+
+  if
+    (  !*last
+    || !is_field_plain(*last)
+    || !is_field_plain(field_info)
+    || (*last)->field_pos + (ptrdiff_t) (*last)->field_size != field_info->field_pos
+    )
+  {
+    ++*steps_num;
+  }
+
+  *last = field_info;
+
+  return steps_num;
+}
+
+static void *struct_info_plan_add_step(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  struct_info_plan_t      *plan;
+  struct_info_plan_step_t *step;
+
+  plan = last_accumulation;
+
+  ++plan->fields_num;
+
+  if (plan->steps_num > 0)
+  {
+    step = &plan->steps[plan->steps_num - 1];
+
+    if
+      (  !step->field_info
+      && is_field_plain(field_info)
+      && step->pos + (ptrdiff_t) step->size == field_info->field_pos
+      )
+    {
+      step->size += field_info->field_size;
+      return plan;
+    }
+  }
+
+  step = &plan->steps[plan->steps_num++];
+
+  /* Values referenced by the field likely have its type. */
+  typed_cache_add(field_info->field_type);
+
+  step->pos        = field_info->field_pos;
+  step->size       = field_info->field_size;
+  step->field_info = is_field_plain(field_info) ? NULL : field_info;
+
+  return plan;
+}
+
+static void *struct_info_plan_count_fixup(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  size_t *fixups_num;
+
+  fixups_num = last_accumulation;
+
+  if (is_field_default_fixup(field_info))
+    ++*fixups_num;
+
+  return fixups_num;
+}
+
+static void *struct_info_plan_add_fixup(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  struct_info_plan_t *plan;
+
+  plan = last_accumulation;
+
+  if (is_field_default_fixup(field_info))
+    plan->default_fixups[plan->default_fixups_num++] = field_info;
+
+  return plan;
+}
+
+const struct_info_plan_t *struct_info_plan(const struct_info_t *struct_info)
+{
+  const field_info_t *last;
+  struct_info_plan_t *plan;
+  size_t              steps_num;
+  size_t              fixups_num;
+
+  if (!struct_info)
+    return NULL;
+
+  plan = (struct_info_plan_t *) ATOMIC_LOAD(&struct_info->plan);
+  if (plan)
+    return plan;
+
+  if (verify_struct_info(struct_info, NULL, 0) != verify_struct_info_success)
+    return NULL;
+
+  /* Count the steps, then allocate the plan and its steps together. */
+  last      = NULL;
+  steps_num = 0;
+  struct_info_iterate_fields(struct_info, struct_info_plan_count_step, &last, &steps_num);
+
+  fixups_num = 0;
+  struct_info_iterate_fields(struct_info, struct_info_plan_count_fixup, NULL, &fixups_num);
+
+  plan =
+    memory_manager_mmalloc
+      ( default_memory_manager
+      , sizeof(*plan) + (steps_num + 1) * sizeof(*plan->steps) + fixups_num * sizeof(*plan->default_fixups)
+      );
+  if (!plan)
+    return NULL;
+
+  plan->steps      = (struct_info_plan_step_t *) (plan + 1);
+  plan->steps_num  = 0;
+  plan->fields_num = 0;
+  struct_info_iterate_fields(struct_info, struct_info_plan_add_step, NULL, plan);
+
+  plan->default_fixups     = (const field_info_t **) (plan->steps + steps_num + 1);
+  plan->default_fixups_num = 0;
+  struct_info_iterate_fields(struct_info, struct_info_plan_add_fixup, NULL, plan);
+
+  if (plan->steps_num == 1 && !plan->steps[0].field_info && plan->steps[0].pos == 0)
+    plan->pod_size = plan->steps[0].size;
+  else
+    plan->pod_size = 0;
+
+  plan->typed_field = struct_info_find_typed_field(struct_info);
+
+  /* Another thread may have built one first. */
+  if (!STRUCT_INFO_PLAN_PUBLISH((struct_info_t *) struct_info, plan))
+    memory_manager_mfree(default_memory_manager, plan);
+
+  return ATOMIC_LOAD(&struct_info->plan);
+}
+
+size_t struct_info_pod_size(const struct_info_t *struct_info)
+{
+  const struct_info_plan_t *plan;
+
+  plan = struct_info_plan(struct_info);
+  if (!plan)
+    return 0;
+
+  return plan->pod_size;
+}
+
+static void *struct_info_default_image_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  size_t (*default_value)(const field_info_t *self, void *dest_mem);
+
+  void *image;
+
+  image = last_accumulation;
+
+  /* Metadata is never copied from defaults, and each value writes its own
+   * fixups; leave them 0.
+   */
+  if (field_info->is_metadata || is_field_default_fixup(field_info))
+    return image;
+
+  default_value = field_info->default_value;
+  if (!default_value)
+  {
+    default_value = field_info_defaults.default_value;
+    if (!default_value)
+      default_value = default_value_zero;
+  }
+
+  default_value(field_info, field_info_ref(field_info, image));
+
+  return image;
+}
+
+const void *struct_info_default_image(const struct_info_t *struct_info)
+{
+  const struct_info_plan_t      *plan;
+  const struct_info_plan_step_t *step;
+  const struct_info_plan_step_t *end;
+  size_t                         size;
+  void                          *image;
+
+  if (!struct_info)
+    return NULL;
+
+  image = (void *) ATOMIC_LOAD(&struct_info->default_image);
+  if (image)
+    return image;
+
+  /* The plan verifies "struct_info" and gives the extent of its fields. */
+  plan = struct_info_plan(struct_info);
+  if (!plan)
+    return NULL;
+
+  size = 0;
+  end  = plan->steps + plan->steps_num;
+  for (step = plan->steps; step < end; ++step)
+  {
+    if (step->pos + step->size > size)
+      size = step->pos + step->size;
+  }
+
+  image = memory_manager_mcalloc(default_memory_manager, 1, size >= 1 ? size : 1);
+  if (!image)
+    return NULL;
+
+  struct_info_iterate_fields(struct_info, struct_info_default_image_field, NULL, image);
+
+  /* Another thread may have built one first. */
+  if (!STRUCT_INFO_DEFAULT_IMAGE_PUBLISH((struct_info_t *) struct_info, image))
+    memory_manager_mfree(default_memory_manager, image);
+
+  return ATOMIC_LOAD(&struct_info->default_image);
+}
+
+int struct_info_default_fixup(const struct_info_t *struct_info, void *dest)
+{
+  const struct_info_plan_t  *plan;
+  const field_info_t *const *fixup;
+  const field_info_t *const *end;
+  const field_info_t        *field_info;
+
+  size_t (*default_value)(const field_info_t *self, void *dest_mem);
+
+  plan = struct_info_plan(struct_info);
+  if (!plan)
+    return 1;
+
+  end = plan->default_fixups + plan->default_fixups_num;
+  for (fixup = plan->default_fixups; fixup < end; ++fixup)
+  {
+    field_info = *fixup;
+
+    default_value = field_info->default_value;
+    if (!default_value)
+      default_value = field_info_defaults.default_value;
+
+    default_value(field_info, field_info_ref(field_info, dest));
+  }
+
+  return 0;
+}
+
+/* NULL on success. */
+static const char *struct_dup_plan(const struct_info_plan_t *plan, void *dest, const void *src, int rec_copy, int dup_metadata, ref_traversal_t *vals)
+{
+  const struct_info_plan_step_t *step;
+  const struct_info_plan_step_t *end;
+
+  end = plan->steps + plan->steps_num;
+  for (step = plan->steps; step < end; ++step)
+  {
+    if (!step->field_info)
+    {
+      memmove(field_ref(step->pos, dest), field_cref(step->pos, src), step->size);
+    }
+    else
+    {
+      const char *field_error_status;
+
+      field_error_status = field_dup(step->field_info, dest, src, 1, rec_copy, dup_metadata, vals);
+
+      if (field_error_status)
+        return field_error_status;
+    }
+  }
+
+  return NULL;
+}
+
 /* NULL on success. */
 static const char *struct_dup_recurse(const struct_info_t *struct_info, void *dest, const void *src, int defaults_src_unused, int rec_copy, int dup_metadata, ref_traversal_t *vals)
 {
@@ -1596,7 +2362,14 @@ static const char *struct_dup_recurse(const struct_info_t *struct_info, void *de
   static const size_t err_buf_size = sizeof(err_buf);
   /* static const size_t err_buf_num  = sizeof(err_buf) / sizeof(err_buf[0]); */
 
-  size_t i;
+  const char *result;
+
+  const struct_info_plan_t *plan;
+
+  /* What "src" and "dest" are tracked as, since "struct_info" walks tails. */
+  const struct_info_t      *kind;
+
+  ref_traversal_t *struct_infos, ref_traversal;
 
   verify_struct_info_status_t verify_status;
 
@@ -1606,184 +2379,781 @@ static const char *struct_dup_recurse(const struct_info_t *struct_info, void *de
   if (dest == src)
     return NULL;
 
-  if (!ref_traversal_tagged_add(vals, STRUCT_DUP_VALS_TAG_SRC,  (void *) src))
+  kind = struct_info;
+
+  /* Plans are only built for verified struct_infos. */
+  plan = NULL;
+  if (defaults_src_unused)
+    plan = struct_info_plan(struct_info);
+
+  if (!plan)
+  {
+    verify_status = verify_struct_info(struct_info, err_buf, err_buf_size);
+    if (verify_status != verify_struct_info_success)
+    {
+      return err_buf;
+    }
+  }
+
+  /* Only values still being copied further up are loops; they are removed
+   * again below, so shared substructure can be reached more than once.
+   */
+  if (!ref_traversal_tagged_as_add(vals, STRUCT_DUP_VALS_TAG_SRC,  kind, (void *) src))
     return "Error: struct_dup_recurse: infinite loop in_recursible_ref field in src.\n";
-  if (!ref_traversal_tagged_add(vals, STRUCT_DUP_VALS_TAG_DEST, (void *) dest))
+  if (!ref_traversal_tagged_as_add(vals, STRUCT_DUP_VALS_TAG_DEST, kind, (void *) dest))
+  {
+    ref_traversal_tagged_as_remove(vals, STRUCT_DUP_VALS_TAG_SRC, kind, (void *) src);
     return "Error: struct_dup_recurse: infinite loop in_recursible_ref field in dest.\n";
+  }
 
-  /* TODO: We're verifying this each time a struct is dup'd! */
-  verify_status = verify_struct_info(struct_info, err_buf, err_buf_size);
-  if (!verify_status)
+  /* Copy in bulk, or each field of each chunk when "src" fields can select
+   * defaults.
+   */
+  if (plan)
   {
-    return err_buf;
+    result = struct_dup_plan(plan, dest, src, rec_copy, dup_metadata, vals);
+
+    ref_traversal_tagged_as_remove(vals, STRUCT_DUP_VALS_TAG_DEST, kind, (void *) dest);
+    ref_traversal_tagged_as_remove(vals, STRUCT_DUP_VALS_TAG_SRC,  kind, (void *) src);
+
+    return result;
+  }
+
+  result = NULL;
+  for
+    ( struct_infos = ref_traversal_init_with_one(&ref_traversal, (void *) struct_info)
+    ; struct_info && !result
+    ; struct_info  = ref_traversal_add(struct_infos, struct_info->tail)
+    )
+  {
+    size_t i;
+
+    for (i = 0; i < struct_info->fields_len; ++i)
+    {
+      result = field_dup(&struct_info->fields[i], dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
+
+      if (result)
+        break;
+    }
   }
 
-  /* Copy each field. */
-  for (i = 0; i < struct_info->fields_len; ++i)
+  ref_traversal_clear(struct_infos);
+
+  ref_traversal_tagged_as_remove(vals, STRUCT_DUP_VALS_TAG_DEST, kind, (void *) dest);
+  ref_traversal_tagged_as_remove(vals, STRUCT_DUP_VALS_TAG_SRC,  kind, (void *) src);
+
+  return result;
+}
+
+const char *struct_dup(const struct_info_t *struct_info, void *dest, const void *src, int defaults_src_unused, int rec_copy, int dup_metadata, ref_traversal_t *vals)
+{
+  size_t pod_size;
+
+  /* Plain old data: one copy, unless it would be a loop. */
+  if
+    (  defaults_src_unused && dest && src
+    && (pod_size = struct_info_pod_size(struct_info))
+    && !ref_traversal_tagged_as_exists(vals, STRUCT_DUP_VALS_TAG_SRC,  struct_info, (void *) src)
+    && !ref_traversal_tagged_as_exists(vals, STRUCT_DUP_VALS_TAG_DEST, struct_info, (void *) dest)
+    )
   {
-    const char *field_error_status;
+    memmove(dest, src, pod_size);
+    return NULL;
+  }
 
-    field_error_status = field_dup(&struct_info->fields[i], dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
+  if (vals)
+  {
+    return struct_dup_recurse(struct_info, dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
+  }
+  else
+  {
+    const char *result;
+
+    ref_traversal_t vals_def;
+
+    ref_traversal_init_empty(&vals_def);
+    {
+      result = struct_dup_recurse(struct_info, dest, src, defaults_src_unused, rec_copy, dup_metadata, &vals_def);
+    } ref_traversal_clear(&vals_def);
+
+    return result;
+  }
+}
+
+typedef struct
+{ const void *check;
+  const void *baseline;
+  int deep;
+  ref_traversal_t *vals;
+} struct_cmp_context_t;
+typedef struct
+{ int result;
+} struct_cmp_accumulation_t;
+static const struct_cmp_accumulation_t struct_cmp_initial = { 0 };
+
+static void *struct_cmp_with_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  struct_cmp_context_t      *tcontext;
+  struct_cmp_accumulation_t *taccumulation;
+
+  if (!context || !last_accumulation || !field_info)
+  {
+    WRITE_OUTPUT(out_iteration_break, 1);
+    return NULL;
+  }
+
+  tcontext      = context;
+  taccumulation = last_accumulation;
+
+  if (taccumulation->result != 0)
+  {
+    /* Already found a difference. */
+    WRITE_OUTPUT(out_iteration_break, 1);
+    return taccumulation;
+  }
+
+  if (field_info->is_metadata)
+  {
+    /* Skip this field. */
+    return taccumulation;
+  }
+
+  /* Recurse? */
+  if
+    (  (field_info->is_recursible_ref)
+    && (tcontext->deep != 0)
+    )
+  {
+    int subdeep;
+
+    subdeep = tcontext->deep;
+    if (subdeep < 0)
+      ++subdeep;
+
+    taccumulation->result =
+      type_cmp
+        ( field_info->field_type
+        , field_info_cref(field_info, tcontext->check)
+        , field_info_cref(field_info, tcontext->baseline)
+        , subdeep
+        , tcontext->vals
+        );
+  }
+  else
+  {
+    taccumulation->result =
+      field_memcmp
+        ( field_info
+        , field_info_cref(field_info, tcontext->check)
+        , field_info_cref(field_info, tcontext->baseline)
+        );
+  }
+
+  if (taccumulation->result != 0)
+    WRITE_OUTPUT(out_iteration_break, 1);
+
+  return taccumulation;
+}
+
+/*
+ * Structs with a plan are compared iteratively, depth-first, with an explicit
+ * stack of frames instead of the C stack, so that long chains of references,
+ * such as linked lists, can be compared without overflowing it.
+ *
+ * Recursible fields are followed by pushing a frame when they lead to a
+ * struct with a plan and the standard "cmp": either the field is such a
+ * struct itself, embedded in the value, or its type compares through
+ * "type_has_deref_cmp" to one.  Any other recursible field is compared with
+ * its field type's "cmp".
+ *
+ * Loops are detected as "struct_cmp_recurse" does, but the first
+ * "STRUCT_CMP_SCAN_DEPTH" frames are checked by scanning the stack.  Only
+ * deeper frames, or every frame once a field type's "cmp" needs "vals", are
+ * tagged in a "ref_traversal_t", which is only initialized then.
+ */
+#define STRUCT_CMP_INLINE_FRAMES 32
+#define STRUCT_CMP_SCAN_DEPTH    16
+
+typedef struct
+{ const struct_info_plan_step_t *step;
+  const struct_info_plan_step_t *end;
+  const struct_info_t *struct_info;
+  const void *check;
+  const void *baseline;
+  int deep;
+  int tagged;
+} struct_cmp_frame_t;
+
+typedef struct
+{ struct_cmp_frame_t  inline_frames[STRUCT_CMP_INLINE_FRAMES];
+  struct_cmp_frame_t *frames;
+  size_t              frames_size;
+  size_t              frames_num;
+
+  /* The caller's "vals", or "local_vals" once tracking is needed. */
+  ref_traversal_t    *vals;
+  ref_traversal_t     local_vals;
+
+  /* Whether every frame, not only deep ones, is tagged in "vals". */
+  int                 tag_all;
+} struct_cmp_state_t;
+
+static int struct_cmp_state_tag(struct_cmp_state_t *state, struct_cmp_frame_t *frame)
+{
+  if (!state->vals)
+  {
+    ref_traversal_init_empty(&state->local_vals);
+    state->vals = &state->local_vals;
+  }
+
+  if (!ref_traversal_tagged_as_add(state->vals, STRUCT_CMP_VALS_TAG_CHECK,    frame->struct_info, (void *) frame->check))
+    return -1;
+  if (!ref_traversal_tagged_as_add(state->vals, STRUCT_CMP_VALS_TAG_BASELINE, frame->struct_info, (void *) frame->baseline))
+  {
+    ref_traversal_tagged_as_remove(state->vals, STRUCT_CMP_VALS_TAG_CHECK, frame->struct_info, (void *) frame->check);
+    return -1;
+  }
+
+  frame->tagged = 1;
+  return 0;
+}
+
+/* Is either value already being compared by a frame on the stack? */
+static int struct_cmp_state_is_loop(const struct_cmp_state_t *state, const struct_info_t *struct_info, const void *check, const void *baseline)
+{
+  size_t i;
+  size_t scan;
+
+  scan = state->frames_num;
+  if (scan > STRUCT_CMP_SCAN_DEPTH)
+    scan = STRUCT_CMP_SCAN_DEPTH;
+
+  for (i = 0; i < scan; ++i)
+  {
+    if
+      (  state->frames[i].struct_info == struct_info
+      && (state->frames[i].check == check || state->frames[i].baseline == baseline)
+      )
+      return 1;
+  }
+
+  return
+    (  ref_traversal_tagged_as_exists(state->vals, STRUCT_CMP_VALS_TAG_CHECK,    struct_info, (void *) check)
+    || ref_traversal_tagged_as_exists(state->vals, STRUCT_CMP_VALS_TAG_BASELINE, struct_info, (void *) baseline)
+    );
+}
+
+/* Returns 0 on success. */
+static int struct_cmp_state_push(struct_cmp_state_t *state, const struct_info_t *struct_info, const struct_info_plan_t *plan, const void *check, const void *baseline, int deep)
+{
+  struct_cmp_frame_t *frame;
+
+  if (state->frames_num >= state->frames_size)
+  {
+    struct_cmp_frame_t *frames;
+    size_t              frames_size;
+
+    frames_size = 2 * state->frames_size;
+
+    if (state->frames == state->inline_frames)
+    {
+      frames = memory_manager_mmalloc(default_memory_manager, frames_size * sizeof(*frames));
+      if (frames)
+        memcpy(frames, state->frames, state->frames_num * sizeof(*frames));
+    }
+    else
+    {
+      frames = memory_manager_mrealloc(default_memory_manager, state->frames, frames_size * sizeof(*frames));
+    }
+
+    if (!frames)
+      return -1;
+
+    state->frames      = frames;
+    state->frames_size = frames_size;
+  }
+
+  frame = &state->frames[state->frames_num];
+  frame->step        = plan->steps;
+  frame->end         = plan->steps + plan->steps_num;
+  frame->struct_info = struct_info;
+  frame->check       = check;
+  frame->baseline    = baseline;
+  frame->deep        = deep;
+  frame->tagged      = 0;
+
+  if (state->tag_all || state->frames_num >= STRUCT_CMP_SCAN_DEPTH)
+  {
+    if (struct_cmp_state_tag(state, frame))
+      return -1;
+  }
+
+  ++state->frames_num;
+  return 0;
+}
+
+static void struct_cmp_state_pop(struct_cmp_state_t *state)
+{
+  struct_cmp_frame_t *frame;
+
+  frame = &state->frames[--state->frames_num];
+
+  if (frame->tagged)
+  {
+    ref_traversal_tagged_as_remove(state->vals, STRUCT_CMP_VALS_TAG_BASELINE, frame->struct_info, (void *) frame->baseline);
+    ref_traversal_tagged_as_remove(state->vals, STRUCT_CMP_VALS_TAG_CHECK,    frame->struct_info, (void *) frame->check);
+  }
+}
+
+/*
+ * Tag every frame, so that a field type's "cmp" can detect loops back into
+ * the stack.
+ *
+ * Returns NULL on failure.
+ */
+static ref_traversal_t *struct_cmp_state_vals(struct_cmp_state_t *state)
+{
+  size_t i;
+
+  if (!state->tag_all)
+  {
+    state->tag_all = 1;
+
+    for (i = 0; i < state->frames_num; ++i)
+    {
+      if (!state->frames[i].tagged && struct_cmp_state_tag(state, &state->frames[i]))
+        return NULL;
+    }
+  }
+
+  return state->vals;
+}
+
+/* Does "type" compare as "type_has_standard_cmp" does? */
+static int struct_cmp_is_standard(const type_t *type)
+{
+  return !type->cmp || type->cmp == default_type_cmp || type->cmp == type_has_standard_cmp;
+}
+
+/*
+ * If "field_info" can be followed with a new frame, return the type to
+ * compare, and write the values: the field itself if it is embedded, or
+ * what it refers to.
+ */
+static const type_t *struct_cmp_field_ref(const field_info_t *field_info, const void *check, const void *baseline, const tval **out_check_ref, const tval **out_baseline_ref)
+{
+  const type_t *field_type;
+  const type_t *ref_type;
+
+  field_type = field_info->field_type;
+  if (!field_type)
+    return NULL;
+
+  if (struct_cmp_is_standard(field_type))
+  {
+    *out_check_ref    = field_info_cref(field_info, check);
+    *out_baseline_ref = field_info_cref(field_info, baseline);
+
+    return field_type;
+  }
+
+  if (field_type->cmp != type_has_deref_cmp)
+    return NULL;
+
+  ref_type = type_deref(field_type, field_info_cref(field_info, check), out_check_ref);
+  if (!ref_type || !struct_cmp_is_standard(ref_type))
+    return NULL;
+
+  type_deref(field_type, field_info_cref(field_info, baseline), out_baseline_ref);
+
+  return ref_type;
+}
+
+static int struct_cmp_iterate(const struct_info_t *struct_info, const struct_info_plan_t *plan, const void *check, const void *baseline, int deep, ref_traversal_t *vals)
+{
+  struct_cmp_state_t state;
+  int                result;
+
+  state.frames      = state.inline_frames;
+  state.frames_size = STRUCT_CMP_INLINE_FRAMES;
+  state.frames_num  = 0;
+  state.vals        = vals;
+  state.tag_all     = 0;
+
+  if (check == baseline)
+    return 0;
+
+  /* Infinite recursion in "copyable_ref" field. */
+  if (struct_cmp_state_is_loop(&state, struct_info, check, baseline))
+    return -1;
+
+  if (struct_cmp_state_push(&state, struct_info, plan, check, baseline, deep))
+    result = -1;
+  else
+    result = 0;
+
+  while (result == 0 && state.frames_num > 0)
+  {
+    struct_cmp_frame_t            *frame;
+    const struct_info_plan_step_t *step;
+    const field_info_t            *field_info;
+    int                            subdeep;
+
+    const type_t                  *ref_type;
+    const tval                    *check_ref;
+    const tval                    *baseline_ref;
+    const struct_info_t           *ref_struct_info;
+    const struct_info_plan_t      *ref_plan;
+    ref_traversal_t               *field_vals;
+
+    frame = &state.frames[state.frames_num - 1];
+
+    if (frame->step >= frame->end)
+    {
+      struct_cmp_state_pop(&state);
+      continue;
+    }
+
+    step = frame->step++;
+
+    if (!step->field_info)
+    {
+      result = mem_cmp(field_cref(step->pos, frame->check), field_cref(step->pos, frame->baseline), step->size);
+      continue;
+    }
+
+    field_info = step->field_info;
+
+    if (field_info->is_metadata)
+      continue;
+
+    if (!field_info->is_recursible_ref || frame->deep == 0)
+    {
+      result =
+        field_memcmp
+          ( field_info
+          , field_info_cref(field_info, frame->check)
+          , field_info_cref(field_info, frame->baseline)
+          );
+      continue;
+    }
+
+    subdeep = frame->deep;
+    if (subdeep < 0)
+      ++subdeep;
+
+    ref_type = struct_cmp_field_ref(field_info, frame->check, frame->baseline, &check_ref, &baseline_ref);
+    if (ref_type)
+    {
+      if (check_ref == baseline_ref)
+        continue;
+      else if (!check_ref)
+      {
+        result = -1;
+        continue;
+      }
+      else if (!baseline_ref)
+      {
+        result = 1;
+        continue;
+      }
+
+      ref_struct_info = type_is_struct(ref_type);
+      ref_plan        = ref_struct_info ? struct_info_plan(ref_struct_info) : NULL;
+      if (ref_plan)
+      {
+        if (struct_cmp_state_is_loop(&state, ref_struct_info, check_ref, baseline_ref))
+          result = -1;
+        else if (struct_cmp_state_push(&state, ref_struct_info, ref_plan, check_ref, baseline_ref, subdeep))
+          result = -1;
+        continue;
+      }
+    }
+
+    field_vals = struct_cmp_state_vals(&state);
+    if (!field_vals)
+    {
+      result = -1;
+      continue;
+    }
+
+    result =
+      type_cmp
+        ( field_info->field_type
+        , field_info_cref(field_info, frame->check)
+        , field_info_cref(field_info, frame->baseline)
+        , subdeep
+        , field_vals
+        );
+  }
+
+  while (state.frames_num > 0)
+    struct_cmp_state_pop(&state);
+
+  if (state.frames != state.inline_frames)
+    memory_manager_mfree(default_memory_manager, state.frames);
+
+  if (state.vals == &state.local_vals)
+    ref_traversal_clear(&state.local_vals);
+
+  return result;
+}
+
+static int struct_cmp_recurse(const struct_info_t *struct_info, const void *check, const void *baseline, int deep, ref_traversal_t *vals)
+{
+  struct_cmp_context_t      context;
+  struct_cmp_accumulation_t accumulation =
+    struct_cmp_initial;
+
+  struct_cmp_accumulation_t *result;
+
+  context.check    = check;
+  context.baseline = baseline;
+  context.deep     = deep;
+  context.vals     = vals;
+
+  /* Missing input. */
+  if (!struct_info || !check || !baseline || !vals)
+    return -1;
+
+  if (check == baseline)
+    return 0;
+
+  /* Infinite recursion in "copyable_ref" field. */
+  if (!ref_traversal_tagged_as_add(vals, STRUCT_CMP_VALS_TAG_CHECK,    struct_info, (void *) check))
+    return -1;
+  if (!ref_traversal_tagged_as_add(vals, STRUCT_CMP_VALS_TAG_BASELINE, struct_info, (void *) baseline))
+  {
+    ref_traversal_tagged_as_remove(vals, STRUCT_CMP_VALS_TAG_CHECK, struct_info, (void *) check);
+    return -1;
+  }
+
+  result = struct_info_iterate_fields(struct_info, struct_cmp_with_field, &context, &accumulation);
+
+  ref_traversal_tagged_as_remove(vals, STRUCT_CMP_VALS_TAG_BASELINE, struct_info, (void *) baseline);
+  ref_traversal_tagged_as_remove(vals, STRUCT_CMP_VALS_TAG_CHECK,    struct_info, (void *) check);
+
+  if (!result)
+    return -1;
+
+  return result->result;
+}
 
-    if (field_error_status)
-      return field_error_status;
-  }
+int struct_cmp(const struct_info_t *struct_info, const void *check, const void *baseline, int deep, ref_traversal_t *vals)
+{
+  const struct_info_plan_t *plan;
+  size_t                    pod_size;
 
-  /* Recurse. */
-  if (struct_info->tail)
+  /* Plain old data: one comparison, unless it would be a loop. */
+  if
+    (  check && baseline
+    && (pod_size = struct_info_pod_size(struct_info))
+    && !ref_traversal_tagged_as_exists(vals, STRUCT_CMP_VALS_TAG_CHECK,    struct_info, (void *) check)
+    && !ref_traversal_tagged_as_exists(vals, STRUCT_CMP_VALS_TAG_BASELINE, struct_info, (void *) baseline)
+    )
   {
-    return struct_dup(struct_info->tail, dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
+    return mem_cmp(check, baseline, pod_size);
   }
 
-  /* Done. */
-  return NULL;
-}
+  /* Missing input. */
+  if (!struct_info || !check || !baseline)
+    return -1;
+
+  if ((plan = struct_info_plan(struct_info)))
+    return struct_cmp_iterate(struct_info, plan, check, baseline, deep, vals);
 
-const char *struct_dup(const struct_info_t *struct_info, void *dest, const void *src, int defaults_src_unused, int rec_copy, int dup_metadata, ref_traversal_t *vals)
-{
   if (vals)
   {
-    return struct_dup_recurse(struct_info, dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
+    return struct_cmp_recurse(struct_info, check, baseline, deep, vals);
   }
   else
   {
-    const char *result;
+    int result;
 
     ref_traversal_t vals_def;
 
     ref_traversal_init_empty(&vals_def);
     {
-      result = struct_dup_recurse(struct_info, dest, src, defaults_src_unused, rec_copy, dup_metadata, vals);
-    } tval_free(&vals_def);
+      result = struct_cmp_recurse(struct_info, check, baseline, deep, &vals_def);
+    } ref_traversal_clear(&vals_def);
 
     return result;
   }
 }
 
+/*
+ * Runs of contiguous plain fields are hashed as one block, exactly as the
+ * plan merges them, so that hashes don't depend on whether a plan could be
+ * built.
+ */
 typedef struct
-{ const void *check;
-  const void *baseline;
+{ const void *val;
   int deep;
   ref_traversal_t *vals;
-} struct_cmp_context_t;
+} struct_hash_context_t;
 typedef struct
-{ int result;
-} struct_cmp_accumulation_t;
-static const struct_cmp_accumulation_t struct_cmp_initial = { 0 };
-
-static void *struct_cmp_with_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
-{
-  struct_cmp_context_t      *tcontext;
-  struct_cmp_accumulation_t *taccumulation;
-
-  if (!context || !last_accumulation || !field_info)
-  {
-    WRITE_OUTPUT(out_iteration_break, 1);
-    return NULL;
-  }
+{ size_t hash;
 
-  tcontext      = context;
-  taccumulation = last_accumulation;
+  /* Pending run of plain fields. */
+  ptrdiff_t run_pos;
+  size_t    run_size;
+} struct_hash_accumulation_t;
+static const struct_hash_accumulation_t struct_hash_initial = { 0, 0, 0 };
 
-  if (taccumulation->result != 0)
+static void struct_hash_flush_run(struct_hash_accumulation_t *accumulation, const void *val)
+{
+  if (accumulation->run_size > 0)
   {
-    /* Already found a difference. */
-    WRITE_OUTPUT(out_iteration_break, 1);
-    return taccumulation;
+    accumulation->hash     = hash_combine(accumulation->hash, hash_mem(field_cref(accumulation->run_pos, val), accumulation->run_size));
+    accumulation->run_size = 0;
   }
+}
 
+/* Hash a field that the plan doesn't merge. */
+static size_t struct_hash_special_field(const field_info_t *field_info, const void *val, int deep, ref_traversal_t *vals)
+{
   if (field_info->is_metadata)
-  {
-    /* Skip this field. */
-    return taccumulation;
-  }
+    return 0;
 
-  /* Recurse? */
-  if
-    (  (field_info->is_recursible_ref)
-    && (tcontext->deep != 0)
-    )
+  if (deep != 0)
   {
     int subdeep;
 
-    subdeep = tcontext->deep;
+    subdeep = deep;
     if (subdeep < 0)
       ++subdeep;
 
-    taccumulation->result =
-      type_cmp
-        ( field_info->field_type
-        , field_info_cref(field_info, tcontext->check)
-        , field_info_cref(field_info, tcontext->baseline)
-        , subdeep
-        , tcontext->vals
-        );
+    return type_hash(field_info->field_type, field_info_cref(field_info, val), subdeep, vals);
   }
-  else
+
+  return hash_mem(field_info_cref(field_info, val), field_info->field_size);
+}
+
+static void *struct_hash_with_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  struct_hash_context_t      *tcontext;
+  struct_hash_accumulation_t *taccumulation;
+
+  tcontext      = context;
+  taccumulation = last_accumulation;
+
+  if (is_field_plain(field_info))
   {
-    taccumulation->result =
-      field_memcmp
-        ( field_info
-        , field_info_cref(field_info, tcontext->check)
-        , field_info_cref(field_info, tcontext->baseline)
-        );
+    if
+      (  taccumulation->run_size > 0
+      && taccumulation->run_pos + (ptrdiff_t) taccumulation->run_size == field_info->field_pos
+      )
+    {
+      taccumulation->run_size += field_info->field_size;
+    }
+    else
+    {
+      struct_hash_flush_run(taccumulation, tcontext->val);
+
+      taccumulation->run_pos  = field_info->field_pos;
+      taccumulation->run_size = field_info->field_size;
+    }
   }
+  else
+  {
+    struct_hash_flush_run(taccumulation, tcontext->val);
 
-  if (taccumulation->result != 0)
-    WRITE_OUTPUT(out_iteration_break, 1);
+    if (!field_info->is_metadata)
+      taccumulation->hash = hash_combine(taccumulation->hash, struct_hash_special_field(field_info, tcontext->val, tcontext->deep, tcontext->vals));
+  }
 
   return taccumulation;
 }
 
-static int struct_cmp_recurse(const struct_info_t *struct_info, const void *check, const void *baseline, int deep, ref_traversal_t *vals)
+/* Hash as "struct_hash_with_field" does for each field. */
+static size_t struct_hash_plan(const struct_info_plan_t *plan, const void *val, int deep, ref_traversal_t *vals)
 {
-  struct_cmp_context_t      context;
-  struct_cmp_accumulation_t accumulation =
-    struct_cmp_initial;
+  const struct_info_plan_step_t *step;
+  const struct_info_plan_step_t *end;
 
-  struct_cmp_accumulation_t *result;
+  size_t hash;
 
-  context.check    = check;
-  context.baseline = baseline;
-  context.deep     = deep;
-  context.vals     = vals;
+  hash = 0;
 
-  /* Missing input. */
-  if (!struct_info || !check || !baseline || !vals)
-    return -1;
+  end = plan->steps + plan->steps_num;
+  for (step = plan->steps; step < end; ++step)
+  {
+    if (!step->field_info)
+      hash = hash_combine(hash, hash_mem(field_cref(step->pos, val), step->size));
+    else if (!step->field_info->is_metadata)
+      hash = hash_combine(hash, struct_hash_special_field(step->field_info, val, deep, vals));
+  }
 
-  if (check == baseline)
+  return hash;
+}
+
+static size_t struct_hash_recurse(const struct_info_t *struct_info, const void *val, int deep, ref_traversal_t *vals)
+{
+  const struct_info_plan_t *plan;
+
+  size_t hash;
+
+  if (!struct_info || !val || !vals)
     return 0;
 
   /* Infinite recursion in "copyable_ref" field. */
-  if (!ref_traversal_tagged_add(vals, STRUCT_CMP_VALS_TAG_CHECK,    (void *) check))
-    return -1;
-  if (!ref_traversal_tagged_add(vals, STRUCT_CMP_VALS_TAG_BASELINE, (void *) baseline))
-    return -1;
+  if (!ref_traversal_tagged_as_add(vals, STRUCT_HASH_VALS_TAG, struct_info, (void *) val))
+    return STRUCT_HASH_CYCLE;
 
-  result = struct_info_iterate_fields(struct_info, struct_cmp_with_field, &context, &accumulation);
-  if (!result)
-    return -1;
+  plan = struct_info_plan(struct_info);
+  if (plan)
+  {
+    hash = struct_hash_plan(plan, val, deep, vals);
+  }
+  else
+  {
+    struct_hash_context_t      context;
+    struct_hash_accumulation_t accumulation =
+      struct_hash_initial;
 
-  return result->result;
+    context.val  = val;
+    context.deep = deep;
+    context.vals = vals;
+
+    struct_info_iterate_fields(struct_info, struct_hash_with_field, &context, &accumulation);
+    struct_hash_flush_run(&accumulation, val);
+
+    hash = accumulation.hash;
+  }
+
+  ref_traversal_tagged_as_remove(vals, STRUCT_HASH_VALS_TAG, struct_info, (void *) val);
+
+  return hash;
 }
 
-int struct_cmp(const struct_info_t *struct_info, const void *check, const void *baseline, int deep, ref_traversal_t *vals)
+size_t struct_hash(const struct_info_t *struct_info, const void *val, int deep, ref_traversal_t *vals)
 {
+  size_t pod_size;
+
+  /* Plain old data: one run, as "struct_hash_plan" would hash it. */
+  if
+    (  val
+    && (pod_size = struct_info_pod_size(struct_info))
+    && !ref_traversal_tagged_as_exists(vals, STRUCT_HASH_VALS_TAG, struct_info, (void *) val)
+    )
+  {
+    return hash_combine(0, hash_mem(val, pod_size));
+  }
+
   if (vals)
   {
-    return struct_cmp_recurse(struct_info, check, baseline, deep, vals);
+    return struct_hash_recurse(struct_info, val, deep, vals);
   }
   else
   {
-    int result;
+    size_t result;
 
     ref_traversal_t vals_def;
 
     ref_traversal_init_empty(&vals_def);
     {
-      result = struct_cmp_recurse(struct_info, check, baseline, deep, &vals_def);
-    } tval_free(&vals_def);
+      result = struct_hash_recurse(struct_info, val, deep, &vals_def);
+    } ref_traversal_clear(&vals_def);
 
     return result;
   }
@@ -1803,6 +3173,8 @@ static size_t               template_cons_type_size       (const type_t *self, c
 static const struct_info_t *template_cons_type_is_struct  (const type_t *self);
 static const tval          *template_cons_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *template_cons_type_registry_entry = NULL;
+
 const type_t template_cons_type_def =
   { type_type
 
@@ -1840,6 +3212,10 @@ const type_t template_cons_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &template_cons_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -1905,6 +3281,96 @@ const template_cons_t template_cons_defaults =
 
 /* ---------------------------------------------------------------- */
 
+template_cons_t  template_cons_default(tval *dest)
+{
+  template_cons_t cons = template_cons_defaults;
+
+  cons.dest = dest;
+
+  return cons;
+}
+
+template_cons_t  template_cons_initials(tval *dest, const tval *initials)
+{
+  template_cons_t cons = template_cons_default(dest);
+
+  cons.initials = initials;
+
+  return cons;
+}
+
+template_cons_t  template_cons_copy    (tval *dest, const tval *src)
+{
+  template_cons_t cons = template_cons_initials(dest, src);
+
+  cons.force_no_defaults = 1;
+  cons.initials_copy_rec = 1;
+
+  return cons;
+}
+
+template_cons_t  template_cons_set_error_output  (template_cons_t cons, char *out_init_error_msg, size_t init_error_msg_size)
+{
+  cons.out_init_error_msg  = out_init_error_msg;
+  cons.init_error_msg_size = init_error_msg_size;
+
+  return cons;
+}
+
+template_cons_t  template_cons_set_memory_manager(template_cons_t cons, const memory_manager_t *memory_manager)
+{
+  cons.memory_manager = memory_manager;
+
+  return cons;
+}
+
+/* Initialize "dest" with "cons", as a value of the type "dest" is typed with. */
+static tval *template_cons_init_tval(tval *dest, template_cons_t cons, const memory_manager_t *memory_manager, char *out_init_error_msg, size_t init_error_msg_size)
+{
+  typed_t typed;
+
+  cons = template_cons_set_memory_manager(cons, memory_manager);
+  cons = template_cons_set_error_output  (cons, out_init_error_msg, init_error_msg_size);
+
+  if (!dest || !(typed = *((const typed_t *) dest)))
+  {
+    if (out_init_error_msg)
+      snprintf
+        ( (char *) out_init_error_msg, (size_t) terminator_size(init_error_msg_size)
+        , "Error: template_cons_init_tval: \"dest\" is NULL or untyped!\n"
+          "  Failed to initialize a value without a type.\n"
+        );
+
+    return NULL;
+  }
+
+  return type_init(typed(), (tval *) &cons);
+}
+
+tval            *template_cons_init_tval_defaults(tval *dest,                       const memory_manager_t *memory_manager, char *out_init_error_msg, size_t init_error_msg_size)
+  { return template_cons_init_tval(dest, template_cons_default (dest),           memory_manager, out_init_error_msg, init_error_msg_size); }
+
+tval            *template_cons_init_tval_initials(tval *dest, const tval *initials, const memory_manager_t *memory_manager, char *out_init_error_msg, size_t init_error_msg_size)
+  { return template_cons_init_tval(dest, template_cons_initials(dest, initials), memory_manager, out_init_error_msg, init_error_msg_size); }
+
+tval            *template_cons_init_tval_copy    (tval *dest, const tval *src,      const memory_manager_t *memory_manager, char *out_init_error_msg, size_t init_error_msg_size)
+  { return template_cons_init_tval(dest, template_cons_copy    (dest, src),      memory_manager, out_init_error_msg, init_error_msg_size); }
+
+/* ---------------------------------------------------------------- */
+
+/* Zero a field, and metadata only if "*context" (preserve_metadata) is set. */
+static void *template_cons_zero_field(void *context, void *last_accumulation, const field_info_t *field_info, int *out_iteration_break)
+{
+  const int *preserve_metadata;
+
+  preserve_metadata = context;
+
+  if (!field_info->is_metadata || *preserve_metadata)
+    default_value_zero(field_info, field_info_ref(field_info, last_accumulation));
+
+  return last_accumulation;
+}
+
 /*
  * template_cons_dup_struct:
  *
@@ -1933,6 +3399,10 @@ tval *template_cons_dup_struct
   int               is_allocate;
   int               is_allocate_only;
 
+  const tval       *initials;
+  int               defaults_src_unused;
+  int               is_default_image;
+
   const char       *is_err;
 
   const memory_manager_t *memory_manager;
@@ -2231,12 +3701,54 @@ tval *template_cons_dup_struct
     return NULL;
   }
 
+  initials            = cons->initials;
+  defaults_src_unused = cons->force_no_defaults;
+  is_default_image    = 0;
+  if (!initials)
+  {
+    if (cons->force_no_defaults)
+    {
+      /* No initials and no defaults: zero the fields. */
+      struct_info_iterate_fields(struct_info, template_cons_zero_field, (void *) &cons->preserve_metadata, dest);
+
+      return dest;
+    }
+
+    /* Copy the defaults in bulk rather than choosing each field's default:
+     * the type's default value, otherwise the image of field defaults built
+     * once for "struct_info".
+     */
+    initials = default_initials;
+    if (!initials)
+    {
+      initials         = struct_info_default_image(struct_info);
+      is_default_image = 1;
+    }
+
+    defaults_src_unused = 1;
+
+    if (!initials)
+    {
+      if (is_allocate)
+        memory_manager_mfree(memory_manager, dest);
+
+      if (cons->out_init_error_msg)
+        snprintf
+          ( (char *) cons->out_init_error_msg, (size_t) terminator_size(cons->init_error_msg_size)
+          , "Error: template_cons_dup_struct: no \"initials\" were provided, and the default value image could not be built!\n"
+            "  Failed to initialize a value without initial or default field values.\n"
+          );
+
+      return NULL;
+    }
+  }
+
   is_err =
     struct_dup
       ( struct_info
       , dest
-      , cons->initials
-      , cons->force_no_defaults
+      , initials
+      , defaults_src_unused
       , cons->initials_copy_rec
       , cons->preserve_metadata
       , cons->ref_traversal
@@ -2260,6 +3772,10 @@ tval *template_cons_dup_struct
     return NULL;
   }
 
+  /* Defaults that may allocate were left out of the image; write them. */
+  if (is_default_image)
+    struct_info_default_fixup(struct_info, dest);
+
   /* Done! */
   return dest;
 }
@@ -2340,6 +3856,8 @@ const type_t *void_type(void)
 
 static const char *void_type_name(const type_t *self);
 
+static const struct type_registry_entry_s *void_type_registry_entry = NULL;
+
 const type_t void_type_def =
   { type_type
 
@@ -2377,6 +3895,10 @@ const type_t void_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &void_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2405,6 +3927,8 @@ static const type_t        *genp_type_is_supertype ( const type_t *self
                                                    );
 static const tval          *genp_type_has_default  (const type_t *self);
 
+static const struct type_registry_entry_s *genp_type_registry_entry = NULL;
+
 const type_t genp_type_def =
   { type_type
 
@@ -2442,6 +3966,10 @@ const type_t genp_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &genp_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2485,6 +4013,8 @@ static const type_t        *genpm_type_is_supertype ( const type_t *self
                                                     );
 static const tval          *genpm_type_has_default  (const type_t *self);
 
+static const struct type_registry_entry_s *genpm_type_registry_entry = NULL;
+
 const type_t genpm_type_def =
   { type_type
 
@@ -2522,6 +4052,10 @@ const type_t genpm_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &genpm_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2565,6 +4099,8 @@ static const type_t        *genpc_type_is_supertype ( const type_t *self
                                                     );
 static const tval          *genpc_type_has_default  (const type_t *self);
 
+static const struct type_registry_entry_s *genpc_type_registry_entry = NULL;
+
 const type_t genpc_type_def =
   { type_type
 
@@ -2602,6 +4138,10 @@ const type_t genpc_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &genpc_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2687,6 +4227,8 @@ static const type_t *enum_type_is_supertype( const type_t *self
                                                );
 static const tval   *enum_type_has_default (const type_t *self);
 
+static const struct type_registry_entry_s *enum_type_registry_entry = NULL;
+
 const type_t enum_type_def =
   { type_type
 
@@ -2724,6 +4266,10 @@ const type_t enum_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &enum_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2776,6 +4322,8 @@ const type_t *array_type(void)
 static const char          *array_type_name       (const type_t *self);
 static const tval          *array_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *array_type_registry_entry = NULL;
+
 const type_t array_type_def =
   { type_type
 
@@ -2813,6 +4361,10 @@ const type_t array_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &array_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2834,6 +4386,8 @@ const type_t *union_type(void)
 
 static const char *union_type_name(const type_t *self);
 
+static const struct type_registry_entry_s *union_type_registry_entry = NULL;
+
 const type_t union_type_def =
   { type_type
 
@@ -2871,6 +4425,10 @@ const type_t union_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &union_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2892,6 +4450,11 @@ static size_t               div_type_size       (const type_t *self, const tval
 static const struct_info_t *div_type_is_struct  (const type_t *self);
 static const tval          *div_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *div_type_registry_entry = NULL;
+
+/* Dynamically allocated values are packed together in a pool. */
+DEF_TYPE_POOL(div)
+
 const type_t div_type_def =
   { type_type
 
@@ -2918,17 +4481,21 @@ const type_t div_type_def =
   , /* init                   */ NULL
   , /* free                   */ NULL
   , /* has_default            */ div_type_has_default
-  , /* mem                    */ NULL
-  , /* mem_init               */ NULL
-  , /* mem_is_dyn             */ NULL
-  , /* mem_free               */ NULL
-  , /* default_memory_manager */ NULL
+  , /* mem                    */ div_pool_mem
+  , /* mem_init               */ div_pool_mem_init
+  , /* mem_is_dyn             */ div_pool_mem_is_dyn
+  , /* mem_free               */ div_pool_mem_free
+  , /* default_memory_manager */ div_pool_default_memory_manager
 
   , /* dup                    */ NULL
 
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &div_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -2940,18 +4507,23 @@ static size_t               div_type_size       (const type_t *self, const tval
   { return sizeof(primdiv_t); }
 
 DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(div)
-static const struct_info_t *div_type_is_struct  (const type_t *self)
-  {
-    STRUCT_INFO_BEGIN(div);
-
-    /* int quot */
-    STRUCT_INFO_RADD(int_type(), quot);
+static field_info_t div_fields[] =
+  { /* int quot */
+    STATIC_FIELD_INFO(div, div_t, quot, int_type_def)
 
     /* int rem */
-    STRUCT_INFO_RADD(int_type(), rem);
+  , STATIC_FIELD_INFO(div, div_t, rem,  int_type_def)
 
-    STRUCT_INFO_DONE();
-  }
+  , FIELD_INFO_TERMINATOR
+  };
+static struct_info_t div_struct_info =
+  STATIC_STRUCT_INFO(div, div_fields);
+STATIC_FIELD_INFO_FIRST  (div_t,       quot)
+STATIC_FIELD_INFO_FOLLOWS(div_t, quot, rem)
+STATIC_FIELD_INFO_LAST   (div_t,       rem)
+
+static const struct_info_t *div_type_is_struct  (const type_t *self)
+  { return &div_struct_info; }
 
 static const tval          *div_type_has_default(const type_t *self)
   { return &div_default; }
@@ -2968,6 +4540,11 @@ static size_t               ldiv_type_size       (const type_t *self, const tval
 static const struct_info_t *ldiv_type_is_struct  (const type_t *self);
 static const tval          *ldiv_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *ldiv_type_registry_entry = NULL;
+
+/* Dynamically allocated values are packed together in a pool. */
+DEF_TYPE_POOL(ldiv)
+
 const type_t ldiv_type_def =
   { type_type
 
@@ -2994,17 +4571,21 @@ const type_t ldiv_type_def =
   , /* init                   */ NULL
   , /* free                   */ NULL
   , /* has_default            */ ldiv_type_has_default
-  , /* mem                    */ NULL
-  , /* mem_init               */ NULL
-  , /* mem_is_dyn             */ NULL
-  , /* mem_free               */ NULL
-  , /* default_memory_manager */ NULL
+  , /* mem                    */ ldiv_pool_mem
+  , /* mem_init               */ ldiv_pool_mem_init
+  , /* mem_is_dyn             */ ldiv_pool_mem_is_dyn
+  , /* mem_free               */ ldiv_pool_mem_free
+  , /* default_memory_manager */ ldiv_pool_default_memory_manager
 
   , /* dup                    */ NULL
 
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &ldiv_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -3016,18 +4597,23 @@ static size_t               ldiv_type_size       (const type_t *self, const tval
   { return sizeof(primldiv_t); }
 
 DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(ldiv)
-static const struct_info_t *ldiv_type_is_struct  (const type_t *self)
-  {
-    STRUCT_INFO_BEGIN(ldiv);
-
-    /* long quot */
-    STRUCT_INFO_RADD(long_type(), quot);
+static field_info_t ldiv_fields[] =
+  { /* long quot */
+    STATIC_FIELD_INFO(ldiv, ldiv_t, quot, long_type_def)
 
     /* long rem */
-    STRUCT_INFO_RADD(long_type(), rem);
+  , STATIC_FIELD_INFO(ldiv, ldiv_t, rem,  long_type_def)
 
-    STRUCT_INFO_DONE();
-  }
+  , FIELD_INFO_TERMINATOR
+  };
+static struct_info_t ldiv_struct_info =
+  STATIC_STRUCT_INFO(ldiv, ldiv_fields);
+STATIC_FIELD_INFO_FIRST  (ldiv_t,       quot)
+STATIC_FIELD_INFO_FOLLOWS(ldiv_t, quot, rem)
+STATIC_FIELD_INFO_LAST   (ldiv_t,       rem)
+
+static const struct_info_t *ldiv_type_is_struct  (const type_t *self)
+  { return &ldiv_struct_info; }
 
 static const tval          *ldiv_type_has_default(const type_t *self)
   { return &ldiv_default; }
@@ -46,6 +46,13 @@
 
 #include "base.h"
 
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
 #include "bits.h"
 #include "util.h"
 
@@ -61,6 +68,8 @@
 
 #include "type_base_memory_manager.h"
 
+#include "type_base_hash_table.h"
+
 #include "type_base_lookup.h"
 
 #include "type_base_memory_tracker.h"
@@ -69,47 +78,113 @@
 /* ref_traversal_t                                                  */
 /* ---------------------------------------------------------------- */
 
-/* TODO */
+/*
+ * A set of references, used to detect loops and to remember shared
+ * substructure during recursive traversals such as "struct_dup" and
+ * "struct_cmp".
+ *
+ * Each reference is stored with a small tag, so that the same address can
+ * be tracked independently in different roles (e.g. once as a source and
+ * once as a destination), and optionally with a "kind", such as the
+ * "struct_info_t" it is traversed as: a struct embedded at offset 0 shares
+ * its address with the struct containing it, but is not a loop.  A
+ * (tag, kind, reference) triple can optionally map to a value, so that a
+ * traversal can memoize what it produced for a reference.
+ *
+ * Up to "REF_TRAVERSAL_INLINE_NUM" triples are stored inline, without
+ * allocation; larger sets move to a "hash_table_t" keyed by reference, whose
+ * values chain the triples of each reference.  Either way, adding, finding,
+ * and removing a triple takes constant expected time.
+ *
+ * NULL references are never members.
+ */
 const type_t *ref_traversal_type(void);
 extern const type_t ref_traversal_type_def;
+typedef struct ref_traversal_entry_s ref_traversal_entry_t;
+struct ref_traversal_entry_s
+{
+  const void *reference;
+  size_t      tag;
+  const void *kind;
+  void       *value;
+
+  /* The next triple with the same reference, or the next free entry. */
+  ref_traversal_entry_t *next;
+};
+
+#define REF_TRAVERSAL_INLINE_NUM 8
+#define REF_TRAVERSAL_CHUNK_NUM  32
+
+typedef struct ref_traversal_chunk_s ref_traversal_chunk_t;
+
 typedef struct ref_traversal_s ref_traversal_t;
 struct ref_traversal_s
 {
   typed_t type;
 
-  memory_tracker_t memory;
+  /* If NULL, "default_memory_manager" is used. */
+  const memory_manager_t *memory_manager;
+
+  /* Number of triples in the set. */
+  size_t num;
 
-  ref_traversal_t *is_mutable;
+  /* Used while "chunks" is NULL. */
+  ref_traversal_entry_t inline_entries[REF_TRAVERSAL_INLINE_NUM];
 
-  void   **history;
-  size_t   history_size;
-  size_t   history_num;
-  size_t   history_len;
+  /* Once the inline entries overflow: "table" maps each reference to its
+   * chain of triples, whose entries are allocated "REF_TRAVERSAL_CHUNK_NUM"
+   * at a time and reused through "free_entries".  "table" is only
+   * initialized while "chunks" is not NULL.
+   */
+  hash_table_t           table;
+  ref_traversal_chunk_t *chunks;
+  ref_traversal_entry_t *free_entries;
 };
 
 /* ---------------------------------------------------------------- */
 
-#define REF_TRAVERSAL_DEFAULTS                 \
-  { ref_traversal_type                         \
-                                               \
-  , /* memory       */ MEMORY_TRACKER_DEFAULTS \
-                                               \
-  , /* is_mutable   */ NULL                    \
-                                               \
-  , /* history      */ NULL                    \
-  , /* history_size */ 0                       \
-  , /* history_num  */ 0                       \
-  , /* history_len  */ 0                       \
+#define REF_TRAVERSAL_INLINE_ENTRY_DEFAULTS \
+  { NULL, 0, NULL, NULL, NULL }
+
+#define REF_TRAVERSAL_DEFAULTS                                    \
+  { ref_traversal_type                                            \
+                                                                  \
+  , /* memory_manager */ NULL                                     \
+                                                                  \
+  , /* num            */ 0                                        \
+                                                                  \
+  , /* inline_entries */ { REF_TRAVERSAL_INLINE_ENTRY_DEFAULTS }  \
+                                                                  \
+  , /* table          */ HASH_TABLE_DEFAULTS                      \
+  , /* chunks         */ NULL                                     \
+  , /* free_entries   */ NULL                                     \
   }
 extern const ref_traversal_t ref_traversal_defaults;
 
 /* ---------------------------------------------------------------- */
 
+/* Release the set's table, if any, leaving it empty.  "tval_free" on a
+ * "ref_traversal_t" does this, and also frees the value itself if it was
+ * dynamically allocated.
+ */
+ref_traversal_t *ref_traversal_clear(ref_traversal_t *ref_traversal);
+
 ref_traversal_t *ref_traversal_init_empty(ref_traversal_t *dest);
 ref_traversal_t *ref_traversal_init_with_one(ref_traversal_t *dest, void *reference);
 
+/* Use "memory_manager" (NULL for the default) for the set's table.  Only
+ * valid while the set is empty.
+ */
+ref_traversal_t *ref_traversal_init_with_memory_manager(ref_traversal_t *dest, const memory_manager_t *memory_manager);
+
+/* Number of references, of any tag, in the set. */
+size_t ref_traversal_num(const ref_traversal_t *ref_traversal);
+
 /* Add the reference to "ref_traversal".  If it already exists, return NULL;
  * else return the reference.
+ *
+ * NULL is also returned if the reference is NULL, or if the set could not
+ * grow; callers that use the set to detect loops treat both as a loop.
  */
 void *ref_traversal_add   (      ref_traversal_t *ref_traversal, void *reference);
 
@@ -126,12 +201,28 @@ void *ref_traversal_take  (      ref_traversal_t *ref_traversal, void *reference
 /* A NULL "ref_traversal" is treated as an empty "ref_traversal_t". */
 void *ref_traversal_exists(const ref_traversal_t *ref_traversal, void *reference);
 
-
+/* The untagged variants above use tag 0. */
 void *ref_traversal_tagged_add   (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference);
 void *ref_traversal_tagged_remove(      ref_traversal_t *ref_traversal, unsigned char tag, void *reference);
 void *ref_traversal_tagged_take  (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference);
 void *ref_traversal_tagged_exists(const ref_traversal_t *ref_traversal, unsigned char tag, void *reference);
 
+/* The tagged variants above use a NULL "kind". */
+void *ref_traversal_tagged_as_add   (      ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference);
+void *ref_traversal_tagged_as_remove(      ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference);
+void *ref_traversal_tagged_as_exists(const ref_traversal_t *ref_traversal, unsigned char tag, const void *kind, void *reference);
+
+/* Memoization.
+ *
+ * "ref_traversal_tagged_memoize" associates "value" with the pair, adding
+ * the pair if necessary, and returns the reference, or NULL on failure.
+ *
+ * "ref_traversal_tagged_memoized" returns the value associated with the
+ * pair, or NULL if the pair is absent or has no value.
+ */
+void *ref_traversal_tagged_memoize (      ref_traversal_t *ref_traversal, unsigned char tag, void *reference, void *value);
+void *ref_traversal_tagged_memoized(const ref_traversal_t *ref_traversal, unsigned char tag, void *reference);
+
 /* ---------------------------------------------------------------- */
 /* struct_info_t and field_info_t                                   */
 /* ---------------------------------------------------------------- */
@@ -565,42 +656,71 @@ const char *field_dup(const field_info_t *field_info, void *dest, const void *sr
 
 /* ---------------------------------------------------------------- */
 
-/* TODO */
-
-#define STRUCT_INFO_NUM_FIELDS 1024
+/*
+ * A struct's fields are stored in an array allocated while they are added,
+ * and trimmed to exactly "fields_len" fields plus "field_terminator" when
+ * the terminator is added, so a description costs only what it uses.
+ *
+ * A chunk holds at most "STRUCT_INFO_NUM_FIELDS" fields; larger structs
+ * chain further chunks through "tail".
+ */
+#define STRUCT_INFO_NUM_FIELDS     1024
+#define STRUCT_INFO_MIN_FIELDS_SIZE 8
 const type_t *struct_info_type(void);
 extern const type_t struct_info_type_def;
+typedef struct struct_info_plan_s struct_info_plan_t;
 typedef struct struct_info_s struct_info_t;
 struct struct_info_s
 {
   typed_t type;
 
-  /* Must be terminated by "field_terminator". */
-  field_info_t fields[STRUCT_INFO_NUM_FIELDS];
+  /* Must be terminated by "field_terminator", unless NULL. */
+  field_info_t *fields;
   /* "fields_len" doesn't include the tail. */
-  size_t       fields_len;
+  size_t        fields_len;
+  /* Number of elements allocated for "fields". */
+  size_t        fields_size;
 
   struct_info_t *tail;
 
 
+  /* Used for fields added with "struct_info_add_field". */
+  size_t (*field_default_value)        (const field_info_t *self, void *dest_field_mem);
+  size_t (*field_template_unused_value)(const field_info_t *self, void *dest_field_mem);
+
+
   /* Optional information, for this chunk (excludes tail). */
 
   int       has_memory_tracker;
 
   /* Index into "fields". */
   size_t    memory_tracker_field;
+
+
+  /* Built by "struct_info_plan" on first use; covers the tail too. */
+  const struct_info_plan_t *plan;
+
+  /* Built by "struct_info_default_image" on first use. */
+  const void               *default_image;
 };
 
 #define STRUCT_INFO_DEFAULTS  \
   { struct_info_type          \
                               \
-  , { FIELD_INFO_DEFAULTS }   \
+  , NULL                      \
+  , 0                         \
   , 0                         \
                               \
+  , NULL                      \
+                              \
+  , NULL                      \
   , NULL                      \
                               \
   , 0                         \
   , 0                         \
+                              \
+  , NULL                      \
+  , NULL                      \
   }
 extern const struct_info_t struct_info_defaults;
 
@@ -609,8 +729,62 @@ extern const field_info_t * const field_terminator;
 
 extern const field_info_t terminating_field_info;
 
+#define FIELD_INFO_TERMINATOR       \
+  { field_info_type                 \
+                                    \
+  , (ptrdiff_t) (-1)                \
+  , 0                               \
+  , NULL                            \
+                                    \
+  , 0                               \
+  , 0                               \
+                                    \
+  , NULL                            \
+  , NULL                            \
+  }
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Once-initialization of a lazily built "struct_info".
+ *
+ * "struct_info_once_begin" returns 1 to exactly one caller, which must build
+ * the "struct_info" and then call "struct_info_once_end", or, if it gives up,
+ * "struct_info_once_fail".  Other callers wait until either is called and
+ * then get 0.  A caller that re-enters while it is itself building also gets
+ * 0 immediately, and sees the partially built "struct_info", as before.
+ *
+ * Everything the builder wrote before "struct_info_once_end" or
+ * "struct_info_once_fail" is visible to callers that then get 0.
+ *
+ * A zero-initialized (e.g. static) "struct_info_once_t" is ready for use.
+ * Without POSIX_PARALLEL, no waiting occurs.
+ */
+#define STRUCT_INFO_ONCE_UNSTARTED 0
+#define STRUCT_INFO_ONCE_BUILDING  1
+#define STRUCT_INFO_ONCE_DONE      2
+#define STRUCT_INFO_ONCE_FAILED    3
+
+typedef struct struct_info_once_s struct_info_once_t;
+struct struct_info_once_s
+{
+  volatile int state;
+
+#if POSIX_PARALLEL
+  pthread_t    builder;
+#endif /* #if POSIX_PARALLEL */
+};
+
+int  struct_info_once_begin(struct_info_once_t *once);
+void struct_info_once_end  (struct_info_once_t *once);
+void struct_info_once_fail (struct_info_once_t *once);
+
 /* ---------------------------------------------------------------- */
 
+/* Start an empty description.  Field storage is allocated by the first
+ * field added; a "struct_info" that already has fields must not be
+ * reinitialized.
+ */
 struct_info_t *struct_info_init
   ( struct_info_t *struct_info
   , size_t      (*default_value)        (const field_info_t *self, void *dest_field_mem)
@@ -733,6 +907,86 @@ typedef enum verify_struct_info_status_e verify_struct_info_status_t;
 verify_struct_info_status_t verify_struct_info_chunk(const struct_info_t *struct_info, char *out_err, size_t err_size);
 verify_struct_info_status_t verify_struct_info(const struct_info_t *struct_info, char *out_err, size_t err_size);
 
+/*
+ * A struct_info compiled for "struct_dup" and "struct_cmp".
+ *
+ * Runs of adjacent fields that are neither metadata nor recursible refs are
+ * merged into single ranges that are copied with one "memmove" and compared
+ * with one "memcmp"; only the remaining fields are visited individually.
+ */
+typedef struct struct_info_plan_step_s struct_info_plan_step_t;
+struct struct_info_plan_step_s
+{
+  ptrdiff_t           pos;
+  size_t              size;
+
+  /* NULL for a merged range of plain fields. */
+  const field_info_t *field_info;
+};
+
+struct struct_info_plan_s
+{
+  struct_info_plan_step_t *steps;
+  size_t                   steps_num;
+
+  /* Number of fields the steps cover. */
+  size_t                   fields_num;
+
+  /* Plain old data: when every field is plain and the fields are      */
+  /* contiguous from the start of the struct, the number of bytes they */
+  /* cover; otherwise 0.                                               */
+  size_t                   pod_size;
+
+  /* "struct_info_has_typed_field", resolved once. */
+  const field_info_t      *typed_field;
+
+  /* Recursible references with their own "default_value", which may     */
+  /* allocate.  "struct_info_default_image" leaves them 0, and each value */
+  /* initialized from the image calls their "default_value" itself.      */
+  const field_info_t     **default_fixups;
+  size_t                   default_fixups_num;
+};
+
+/*
+ * Get the plan for a verified "struct_info", building it on first use.
+ *
+ * Returns NULL if "struct_info" does not verify or the plan could not be
+ * allocated; callers then fall back to visiting each field.
+ */
+const struct_info_plan_t *struct_info_plan(const struct_info_t *struct_info);
+
+/*
+ * The plan's "pod_size", or 0.
+ *
+ * Values of plain old data structs are copied, compared, and hashed as
+ * their first "pod_size" bytes, in one call, without any traversal.
+ */
+size_t struct_info_pod_size(const struct_info_t *struct_info);
+
+/*
+ * Get the default value of a verified "struct_info" as an image of its
+ * fields, building it on first use.
+ *
+ * Each field holds the value written by its "default_value", and metadata
+ * fields are 0.  The image covers the fields from the start of the struct
+ * through the end of the last field, and is valid until fields are added.
+ *
+ * The plan's "default_fixups" are also 0 in the image, so that nothing it
+ * allocates is shared; "struct_info_default_fixup" writes them per value.
+ *
+ * Returns NULL if "struct_info" does not verify or the image could not be
+ * allocated.
+ */
+const void *struct_info_default_image(const struct_info_t *struct_info);
+
+/*
+ * Write the default of each of the plan's "default_fixups" into "dest", a
+ * value just copied from "struct_info_default_image".
+ *
+ * Returns 0 on success, and 1 if the plan could not be built.
+ */
+int struct_info_default_fixup(const struct_info_t *struct_info, void *dest);
+
 /*
  * struct_dup:
  *
@@ -760,6 +1014,9 @@ verify_struct_info_status_t verify_struct_info(const struct_info_t *struct_info,
  *   This is used for fields such as memory trackers.
  *
  * Returns NULL on success, and an error message on failure.
+ *
+ * Values being copied are tracked in "ref_traversal" with these tags and
+ * "struct_info" as their kind, as are values being compared or hashed below.
  */
 #define STRUCT_DUP_VALS_TAG_DEST 0
 #define STRUCT_DUP_VALS_TAG_SRC  1
@@ -769,6 +1026,18 @@ const char *struct_dup(const struct_info_t *struct_info, void *dest, const void
 #define STRUCT_CMP_VALS_TAG_BASELINE 1
 int struct_cmp(const struct_info_t *struct_info, const void *check, const void *baseline, int deep, ref_traversal_t *vals);
 
+/*
+ * Hash a struct consistently with "struct_cmp": metadata fields are skipped,
+ * recursible references are hashed with their field type's "hash" while
+ * "deep" allows, and everything else is hashed as bytes.
+ *
+ * A struct reached again while it is being hashed, through a cycle of
+ * references, contributes "STRUCT_HASH_CYCLE" instead.
+ */
+#define STRUCT_HASH_VALS_TAG 2
+#define STRUCT_HASH_CYCLE    ((size_t) 0x2C7C1EUL)
+size_t struct_hash(const struct_info_t *struct_info, const void *val, int deep, ref_traversal_t *vals);
+
 #include "type_base_type.h"
 
 /* ---------------------------------------------------------------- */
@@ -967,6 +1236,10 @@ int template_cons_free_struct_memfree_type
   static const char          *CAT(name, _type_name)       (const type_t *self);                  \
   static size_t               CAT(name, _type_size)       (const type_t *self, const tval *val); \
   static const tval          *CAT(name, _type_has_default)(const type_t *self);                  \
+  static size_t               CAT(name, _type_hash)                                              \
+    (const type_t *self, const tval *val, int deep, ref_traversal_t *vals);                      \
+                                                                                                 \
+  static const struct type_registry_entry_s *CAT(name, _type_registry_entry) = NULL;             \
                                                                                                  \
   const type_t CAT(name, _type_def) =                                                            \
     { type_type                                                                                  \
@@ -1005,6 +1278,10 @@ int template_cons_free_struct_memfree_type
     , /* user                   */ NULL                                                          \
     , /* cuser                  */ NULL                                                          \
     , /* cmp                    */ NULL                                                          \
+    , /* hash                   */ CAT(name, _type_hash)                                         \
+    , /* deref                  */ NULL                                                          \
+                                                                                                 \
+    , /* registry_entry         */ &CAT(name, _type_registry_entry)                              \
                                                                                                  \
     , /* parity                 */ ""                                                            \
     };                                                                                           \
@@ -1016,7 +1293,12 @@ int template_cons_free_struct_memfree_type
     { return sizeof(type); }                                                                     \
                                                                                                  \
   static const tval          *CAT(name, _type_has_default)(const type_t *self)                   \
-    { return default; }
+    { return default; }                                                                          \
+                                                                                                 \
+  /* The same bytes "type_has_standard_cmp" compares, with a constant size. */                   \
+  static size_t               CAT(name, _type_hash)                                              \
+    (const type_t *self, const tval *val, int deep, ref_traversal_t *vals)                       \
+    { return hash_mem(val, sizeof(type)); }
 
 /* General type. */
 const type_t *void_type(void);
@@ -33,11 +33,63 @@
 #include "base.h"
 #include "type_base_compare.h"
 
+/* limits.h:
+ *   - CHAR_BIT
+ */
+#include <limits.h>
+
 /* string.h:
- *   - memcmp
+ *   - memchr
+ *   - memcpy
  */
 #include <string.h>
 
+/*
+ * Vector instructions for the bulk comparisons, when the compiler targets
+ * them.  Build with "-DCOMPARE_SIMD=0" for the portable versions alone.
+ */
+#ifndef COMPARE_SIMD
+#  define COMPARE_SIMD 1
+#endif /* #ifndef COMPARE_SIMD */
+
+#if COMPARE_SIMD && defined(__AVX2__)
+#  define COMPARE_AVX2 1
+#else  /* #if COMPARE_SIMD && defined(__AVX2__) */
+#  define COMPARE_AVX2 0
+#endif /* #if COMPARE_SIMD && defined(__AVX2__) */
+
+#if COMPARE_SIMD && defined(__SSE2__)
+#  define COMPARE_SSE2 1
+#else  /* #if COMPARE_SIMD && defined(__SSE2__) */
+#  define COMPARE_SSE2 0
+#endif /* #if COMPARE_SIMD && defined(__SSE2__) */
+
+#if COMPARE_AVX2
+/* immintrin.h:
+ *   - __m256i
+ *   - _mm256_cmpeq_epi8
+ *   - _mm256_loadu_si256
+ *   - _mm256_movemask_epi8
+ *   - _mm256_or_si256
+ *   - _mm256_testz_si256
+ *   - _mm256_xor_si256
+ */
+#include <immintrin.h>
+#endif /* #if COMPARE_AVX2 */
+
+#if COMPARE_SSE2
+/* emmintrin.h:
+ *   - __m128i
+ *   - _mm_cmpeq_epi8
+ *   - _mm_loadu_si128
+ *   - _mm_movemask_epi8
+ *   - _mm_or_si128
+ *   - _mm_setzero_si128
+ *   - _mm_xor_si128
+ */
+#include <emmintrin.h>
+#endif /* #if COMPARE_SSE2 */
+
 /* stddef.h:
  *   - NULL
  *   - ptrdiff_t
@@ -47,7 +99,6 @@
 
 /* string.h:
  *   - strcmp
- *   - strncmp
  *   - memmove
  *   - memset
  */
@@ -88,6 +139,8 @@ static const type_t *ordering_type_is_supertype( const type_t *self
                                                );
 static const tval   *ordering_type_has_default (const type_t *self);
 
+static const struct type_registry_entry_s *ordering_type_registry_entry = NULL;
+
 const type_t ordering_type_def =
   { type_type
 
@@ -125,6 +178,10 @@ const type_t ordering_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &ordering_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -260,6 +317,8 @@ static const type_t *ordering_relation_type_is_supertype( const type_t *self
                                                         );
 static const tval   *ordering_relation_type_has_default (const type_t *self);
 
+static const struct type_registry_entry_s *ordering_relation_type_registry_entry = NULL;
+
 const type_t ordering_relation_type_def =
   { type_type
 
@@ -297,6 +356,10 @@ const type_t ordering_relation_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &ordering_relation_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -342,6 +405,8 @@ static const type_t        *comparer_type_is_supertype ( const type_t *self
                                                        );
 static const tval          *comparer_type_has_default  (const type_t *self);
 
+static const struct type_registry_entry_s *comparer_type_registry_entry = NULL;
+
 const type_t comparer_type_def =
   { type_type
 
@@ -379,6 +444,10 @@ const type_t comparer_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &comparer_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -436,6 +505,8 @@ static const type_t        *callback_compare_type_is_subtype ( const type_t *sel
 static const struct_info_t *callback_compare_type_is_struct  (const type_t *self);
 static const tval          *callback_compare_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *callback_compare_type_registry_entry = NULL;
+
 const type_t callback_compare_type_def =
   { type_type
 
@@ -473,6 +544,10 @@ const type_t callback_compare_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &callback_compare_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -528,6 +603,8 @@ const type_t *callback_compare_inverted_type(void)
 static const char *callback_compare_inverted_type_name       (const type_t *self);
 static const tval *callback_compare_inverted_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *callback_compare_inverted_type_registry_entry = NULL;
+
 const type_t callback_compare_inverted_type_def =
   { type_type
 
@@ -565,6 +642,10 @@ const type_t callback_compare_inverted_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &callback_compare_inverted_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -607,6 +688,232 @@ int call_callback_compare(callback_compare_t callback_compare, const void *check
     return ORDERING_INVERT(ordering);
 }
 
+/* ---------------------------------------------------------------- */
+/* Bulk comparison.                                                 */
+/* ---------------------------------------------------------------- */
+
+/* Strings are compared in blocks of this many bytes, so that the ends of  */
+/* both are found without reading far past an early difference.            */
+#define STRN_CMP_BLOCK_SIZE 64
+
+/* Order the first "size" bytes, one at a time. */
+static int mem_cmp_bytes(const unsigned char *check, const unsigned char *baseline, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; ++i)
+  {
+    if (check[i] != baseline[i])
+      return check[i] < baseline[i] ? -1 : 1;
+  }
+
+  return 0;
+}
+
+#if COMPARE_SSE2
+/* Index of the lowest clear bit of a byte mask with at least one clear. */
+static size_t mem_cmp_mask_index(unsigned long equal_mask)
+{
+  size_t index;
+
+  for (index = 0; equal_mask & 1; equal_mask >>= 1)
+    ++index;
+
+  return index;
+}
+#endif /* #if COMPARE_SSE2 */
+
+int mem_cmp(const void *check, const void *baseline, size_t size)
+{
+  const unsigned char *check_bytes;
+  const unsigned char *baseline_bytes;
+  size_t               check_word;
+  size_t               baseline_word;
+
+  if (check == baseline)
+    return 0;
+
+  check_bytes    = (const unsigned char *) check;
+  baseline_bytes = (const unsigned char *) baseline;
+
+#if COMPARE_AVX2
+  for (; size >= 32; check_bytes += 32, baseline_bytes += 32, size -= 32)
+  {
+    unsigned long equal_mask;
+
+    equal_mask = 0xFFFFFFFFUL & (unsigned long) (unsigned int)
+      _mm256_movemask_epi8
+        ( _mm256_cmpeq_epi8
+            ( _mm256_loadu_si256((const __m256i *) check_bytes)
+            , _mm256_loadu_si256((const __m256i *) baseline_bytes)
+            )
+        );
+
+    if (equal_mask != 0xFFFFFFFFUL)
+    {
+      size_t index = mem_cmp_mask_index(equal_mask);
+      return check_bytes[index] < baseline_bytes[index] ? -1 : 1;
+    }
+  }
+#endif /* #if COMPARE_AVX2 */
+
+#if COMPARE_SSE2
+  for (; size >= 16; check_bytes += 16, baseline_bytes += 16, size -= 16)
+  {
+    unsigned long equal_mask;
+
+    equal_mask = 0xFFFFUL & (unsigned long) (unsigned int)
+      _mm_movemask_epi8
+        ( _mm_cmpeq_epi8
+            ( _mm_loadu_si128((const __m128i *) check_bytes)
+            , _mm_loadu_si128((const __m128i *) baseline_bytes)
+            )
+        );
+
+    if (equal_mask != 0xFFFFUL)
+    {
+      size_t index = mem_cmp_mask_index(equal_mask);
+      return check_bytes[index] < baseline_bytes[index] ? -1 : 1;
+    }
+  }
+#endif /* #if COMPARE_SSE2 */
+
+  /* Whole words, read unaligned through "memcpy". */
+  for (; size >= sizeof(check_word); check_bytes += sizeof(check_word), baseline_bytes += sizeof(check_word), size -= sizeof(check_word))
+  {
+    memcpy(&check_word,    check_bytes,    sizeof(check_word));
+    memcpy(&baseline_word, baseline_bytes, sizeof(baseline_word));
+
+    if (check_word != baseline_word)
+      return mem_cmp_bytes(check_bytes, baseline_bytes, sizeof(check_word));
+  }
+
+  return mem_cmp_bytes(check_bytes, baseline_bytes, size);
+}
+
+int mem_eq(const void *check, const void *baseline, size_t size)
+{
+  const unsigned char *check_bytes;
+  const unsigned char *baseline_bytes;
+  size_t               check_word;
+  size_t               baseline_word;
+  size_t               difference;
+
+  if (check == baseline)
+    return 1;
+
+  check_bytes    = (const unsigned char *) check;
+  baseline_bytes = (const unsigned char *) baseline;
+
+  /* Two vectors per test. */
+#if COMPARE_AVX2
+  for (; size >= 64; check_bytes += 64, baseline_bytes += 64, size -= 64)
+  {
+    __m256i differences;
+
+    differences =
+      _mm256_or_si256
+        ( _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)  check_bytes      ), _mm256_loadu_si256((const __m256i *)  baseline_bytes      ))
+        , _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (check_bytes + 32)), _mm256_loadu_si256((const __m256i *) (baseline_bytes + 32)))
+        );
+
+    if (!_mm256_testz_si256(differences, differences))
+      return 0;
+  }
+#endif /* #if COMPARE_AVX2 */
+
+#if COMPARE_SSE2
+  for (; size >= 32; check_bytes += 32, baseline_bytes += 32, size -= 32)
+  {
+    __m128i differences;
+
+    differences =
+      _mm_or_si128
+        ( _mm_xor_si128(_mm_loadu_si128((const __m128i *)  check_bytes      ), _mm_loadu_si128((const __m128i *)  baseline_bytes      ))
+        , _mm_xor_si128(_mm_loadu_si128((const __m128i *) (check_bytes + 16)), _mm_loadu_si128((const __m128i *) (baseline_bytes + 16)))
+        );
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(differences, _mm_setzero_si128())) != 0xFFFF)
+      return 0;
+  }
+#endif /* #if COMPARE_SSE2 */
+
+  /* Whole words, read unaligned through "memcpy", and the tail. */
+  difference = 0;
+  for (; size >= sizeof(check_word); check_bytes += sizeof(check_word), baseline_bytes += sizeof(check_word), size -= sizeof(check_word))
+  {
+    memcpy(&check_word,    check_bytes,    sizeof(check_word));
+    memcpy(&baseline_word, baseline_bytes, sizeof(baseline_word));
+
+    difference |= check_word ^ baseline_word;
+  }
+
+  for (; size > 0; ++check_bytes, ++baseline_bytes, --size)
+    difference |= (size_t) (*check_bytes ^ *baseline_bytes);
+
+  return difference == 0;
+}
+
+/* Shared by "strn_cmp" and "strn_eq", which stops at any difference. */
+static int strn_cmp_blocks(const char *check, const char *baseline, size_t n, int equality_only)
+{
+  size_t      block_size;
+  const char *check_end;
+  const char *baseline_end;
+  size_t      check_len;
+  size_t      baseline_len;
+  int         ordering;
+
+  if (check == baseline)
+    return 0;
+
+  for (; n > 0; check += block_size, baseline += block_size, n -= block_size)
+  {
+    block_size = n < STRN_CMP_BLOCK_SIZE ? n : STRN_CMP_BLOCK_SIZE;
+
+    check_end    = memchr(check,    '\0', block_size);
+    baseline_end = memchr(baseline, '\0', block_size);
+
+    check_len    = check_end    ? (size_t) (check_end    - check)    : block_size;
+    baseline_len = baseline_end ? (size_t) (baseline_end - baseline) : block_size;
+
+    if (equality_only)
+    {
+      if (check_len != baseline_len)
+        return 1;
+
+      if (!mem_eq(check, baseline, check_len))
+        return 1;
+    }
+    else
+    {
+      ordering = mem_cmp(check, baseline, check_len < baseline_len ? check_len : baseline_len);
+      if (ordering)
+        return ordering;
+
+      /* The shorter string's terminator sorts first. */
+      if (check_len != baseline_len)
+        return check_len < baseline_len ? -1 : 1;
+    }
+
+    /* Both ended. */
+    if (check_end)
+      return 0;
+  }
+
+  return 0;
+}
+
+int strn_cmp(const char *check, const char *baseline, size_t n)
+{
+  return strn_cmp_blocks(check, baseline, n, 0);
+}
+
+int strn_eq(const char *check, const char *baseline, size_t n)
+{
+  return !strn_cmp_blocks(check, baseline, n, 1);
+}
+
 /* ---------------------------------------------------------------- */
 /* Various comparers.                                               */
 /* ---------------------------------------------------------------- */
@@ -653,11 +960,11 @@ int compare_tval    (void *context, const          tval         *check, const
     return ordering_err_2();
 #endif /* #if ERROR_CHECKING  */
 
-  type = typeof(check);
+  type = TVAL_TYPEOF(check);
 #if ERROR_CHECKING
   if (!type)
     return ordering_err_2();
-  if (!is_type_equivalent(type, typeof(baseline)))
+  if (!is_type_equivalent(type, TVAL_TYPEOF(baseline)))
     return ordering_err_2();
 #endif /* #if ERROR_CHECKING  */
 
@@ -675,11 +982,11 @@ int compare_tvalr   (void *context, const          tval * const *check, const
     return ordering_err_2();
 #endif /* #if ERROR_CHECKING  */
 
-  type = typeof(*check);
+  type = TVAL_TYPEOF(*check);
 #if ERROR_CHECKING
   if (!type)
     return ordering_err_2();
-  if (!is_type_equivalent(type, typeof(*baseline)))
+  if (!is_type_equivalent(type, TVAL_TYPEOF(*baseline)))
     return ordering_err_2();
 #endif /* #if ERROR_CHECKING  */
 
@@ -871,7 +1178,7 @@ int compare_mem     (void *context, const          void         *check, const
   if (n <= 0)
     return ORDERING_SUCCESS(ORDERING_EQ);
 
-  return ORDERING_SUCCESS(memcmp(check, baseline, n));
+  return ORDERING_SUCCESS(mem_cmp(check, baseline, n));
 }
 
 int compare_memr    (void *context, const          void * const *check, const          void * const *baseline)
@@ -890,7 +1197,7 @@ int compare_memr    (void *context, const          void * const *check, const
   if (n <= 0)
     return ORDERING_SUCCESS(ORDERING_EQ);
 
-  return ORDERING_SUCCESS(memcmp(*check, *baseline, n));
+  return ORDERING_SUCCESS(mem_cmp(*check, *baseline, n));
 }
 
 
@@ -909,7 +1216,7 @@ int compare_strn    (void *context, const          char         *check, const
   if (n <= 0)
     return ORDERING_SUCCESS(ORDERING_EQ);
 
-  return ORDERING_SUCCESS(strncmp(check, baseline, n));
+  return ORDERING_SUCCESS(strn_cmp(check, baseline, n));
 }
 
 int compare_strz    (void *context, const          char         *check, const          char         *baseline)
@@ -922,6 +1229,35 @@ int compare_strz    (void *context, const          char         *check, const
   return ORDERING_SUCCESS(strcmp(check, baseline));
 }
 
+/* Equality only. */
+int compare_mem_eq  (void *context, const          void         *check, const          void         *baseline)
+{
+  size_t n;
+
+#if ERROR_CHECKING
+  if (!check || !baseline)
+    return ordering_err_2();
+#endif /* #if ERROR_CHECKING  */
+
+  n = objp_to_size(context);
+
+  return mem_eq(check, baseline, n) ? ORDERING_EQ : ORDERING_GT;
+}
+
+int compare_strn_eq (void *context, const          char         *check, const          char         *baseline)
+{
+  size_t n;
+
+#if ERROR_CHECKING
+  if (!check || !baseline)
+    return ordering_err_2();
+#endif /* #if ERROR_CHECKING  */
+
+  n = objp_to_size(context);
+
+  return strn_eq(check, baseline, n) ? ORDERING_EQ : ORDERING_GT;
+}
+
 
 /* Elements are "const char *". */
 int compare_strnr   (void *context, const          char * const *check, const          char * const *baseline)
@@ -940,7 +1276,7 @@ int compare_strnr   (void *context, const          char * const *check, const
   if (n <= 0)
     return ORDERING_SUCCESS(ORDERING_EQ);
 
-  return ORDERING_SUCCESS(strncmp(*check, *baseline, n));
+  return ORDERING_SUCCESS(strn_cmp(*check, *baseline, n));
 }
 
 int compare_strzr   (void *context, const          char * const *check, const          char * const *baseline)
@@ -1105,6 +1441,16 @@ void *compare_strz_context   (void)
   return NULL;
 }
 
+void *compare_mem_eq_context (size_t n)
+{
+  return (void *) size_to_objp(n);
+}
+
+void *compare_strn_eq_context(size_t n)
+{
+  return (void *) size_to_objp(n);
+}
+
 
 void *compare_strnr_context  (size_t n)
 {
@@ -1161,6 +1507,9 @@ const comparer_t comparer_memr          = (comparer_t) &compare_memr;
 const comparer_t comparer_strn          = (comparer_t) &compare_strn;
 const comparer_t comparer_strz          = (comparer_t) &compare_strz;
 
+const comparer_t comparer_mem_eq        = (comparer_t) &compare_mem_eq;
+const comparer_t comparer_strn_eq       = (comparer_t) &compare_strn_eq;
+
 const comparer_t comparer_strnr         = (comparer_t) &compare_strnr;
 const comparer_t comparer_strzr         = (comparer_t) &compare_strzr;
 
@@ -1392,6 +1741,24 @@ callback_compare_t callback_compare_strz   (void)
       );
 }
 
+callback_compare_t callback_compare_mem_eq (size_t n)
+{
+  return
+    callback_compare
+      ( comparer_mem_eq
+      , compare_mem_eq_context(n)
+      );
+}
+
+callback_compare_t callback_compare_strn_eq(size_t n)
+{
+  return
+    callback_compare
+      ( comparer_strn_eq
+      , compare_strn_eq_context(n)
+      );
+}
+
 
 callback_compare_t callback_compare_strnr  (size_t n)
 {
@@ -1441,3 +1808,58 @@ callback_compare_t callback_compare_invert(callback_compare_t callback_compare)
 
   return callback_compare;
 }
+
+/* ---------------------------------------------------------------- */
+/* Hashing.                                                         */
+/* ---------------------------------------------------------------- */
+
+/* Constants are 32 bits wide so that they fit any "size_t". */
+#define HASH_GOLDEN ((size_t) 0x9E3779B9UL)
+
+size_t hash_mix(size_t key)
+{
+  /* Fold the upper half in first, for 64-bit keys. */
+  key ^= key >> (sizeof(size_t) * CHAR_BIT / 2);
+  key ^= key >> 15;
+  key *= (size_t) 0x85EBCA6BUL;
+  key ^= key >> 13;
+  key *= (size_t) 0xC2B2AE35UL;
+  key ^= key >> 16;
+
+  return key;
+}
+
+size_t hash_combine(size_t seed, size_t hash)
+{
+  return seed ^ (hash + HASH_GOLDEN + (seed << 6) + (seed >> 2));
+}
+
+size_t hash_mem(const void *mem, size_t size)
+{
+  const unsigned char *bytes;
+  size_t               hash;
+  size_t               word;
+
+  if (!mem)
+    return 0;
+
+  bytes = (const unsigned char *) mem;
+  hash  = hash_mix(size ^ HASH_GOLDEN);
+
+  /* Whole words, read unaligned through "memcpy". */
+  for (; size >= sizeof(word); bytes += sizeof(word), size -= sizeof(word))
+  {
+    memcpy(&word, bytes, sizeof(word));
+    hash = hash_mix(hash_combine(hash, word));
+  }
+
+  /* The tail, zero-extended. */
+  if (size > 0)
+  {
+    word = 0;
+    memcpy(&word, bytes, size);
+    hash = hash_mix(hash_combine(hash, word));
+  }
+
+  return hash;
+}
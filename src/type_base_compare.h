@@ -230,6 +230,28 @@ callback_compare_t callback_compare(comparer_t comparer, void *comparer_context)
 
 int                call_callback_compare(callback_compare_t callback_compare, const void *check, const void *baseline);
 
+/* ---------------------------------------------------------------- */
+/* Bulk comparison.                                                 */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Compare memory, and bounded strings, many bytes at a time: 32 with AVX2,
+ * 16 with SSE2, when the compiler targets them and "COMPARE_SIMD" is not 0,
+ * and otherwise a word at a time.
+ *
+ * "mem_cmp" and "strn_cmp" order as "memcmp" and "strncmp" do, but return
+ * only -1, 0, or 1.  "mem_eq" and "strn_eq" only test for equality, and so
+ * need not find the first difference; they return 1 when equal.
+ *
+ * Arrays of integers are equal exactly when their bytes are, so "mem_eq"
+ * also serves for them.
+ */
+int mem_cmp (const void *check, const void *baseline, size_t size);
+int mem_eq  (const void *check, const void *baseline, size_t size);
+
+int strn_cmp(const char *check, const char *baseline, size_t n);
+int strn_eq (const char *check, const char *baseline, size_t n);
+
 /* ---------------------------------------------------------------- */
 /* Various comparers.                                               */
 /* ---------------------------------------------------------------- */
@@ -271,6 +293,11 @@ int compare_memr   (void *context, const          void * const *check, const
 int compare_strn   (void *context, const          char         *check, const          char         *baseline);
 int compare_strz   (void *context, const          char         *check, const          char         *baseline);
 
+/* Equality only: "ORDERING_EQ" when equal, and otherwise "ORDERING_GT",  */
+/* whatever the order.                                                     */
+int compare_mem_eq (void *context, const          void         *check, const          void         *baseline);
+int compare_strn_eq(void *context, const          char         *check, const          char         *baseline);
+
 /* Elements are "const char *". */
 int compare_strnr  (void *context, const          char * const *check, const          char * const *baseline);
 int compare_strzr  (void *context, const          char * const *check, const          char * const *baseline);
@@ -313,6 +340,9 @@ void *compare_memr_context   (size_t n);
 void *compare_strn_context   (size_t n);
 void *compare_strz_context   (void);
 
+void *compare_mem_eq_context (size_t n);
+void *compare_strn_eq_context(size_t n);
+
 void *compare_strnr_context  (size_t n);
 void *compare_strzr_context  (void);
 
@@ -353,6 +383,9 @@ extern const comparer_t comparer_memr;
 extern const comparer_t comparer_strn;
 extern const comparer_t comparer_strz;
 
+extern const comparer_t comparer_mem_eq;
+extern const comparer_t comparer_strn_eq;
+
 extern const comparer_t comparer_strnr;
 extern const comparer_t comparer_strzr;
 
@@ -393,6 +426,9 @@ callback_compare_t callback_compare_memr   (size_t n);
 callback_compare_t callback_compare_strn   (size_t n);
 callback_compare_t callback_compare_strz   (void);
 
+callback_compare_t callback_compare_mem_eq (size_t n);
+callback_compare_t callback_compare_strn_eq(size_t n);
+
 callback_compare_t callback_compare_strnr  (size_t n);
 callback_compare_t callback_compare_strzr  (void);
 
@@ -402,6 +438,24 @@ callback_compare_t callback_compare_invert_stateless(comparer_t comparer);
 
 callback_compare_t callback_compare_invert(callback_compare_t callback_compare);
 
+/* ---------------------------------------------------------------- */
+/* Hashing.                                                         */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Hashes are "size_t"s, for use with hash tables indexed by their low bits.
+ * They are not stable across builds or platforms.
+ */
+
+/* Spread the bits of "key", so that e.g. aligned addresses differ in their low bits. */
+size_t hash_mix(size_t key);
+
+/* Fold "hash" into a running "seed"; order matters. */
+size_t hash_combine(size_t seed, size_t hash);
+
+/* Hash "size" bytes, a word at a time.  0 when "mem" is NULL. */
+size_t hash_mem(const void *mem, size_t size);
+
 /* ---------------------------------------------------------------- */
 /* Post-dependencies.                                               */
 /* ---------------------------------------------------------------- */
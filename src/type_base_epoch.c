@@ -0,0 +1,603 @@
+/*
+ * opencurry: type_base_epoch.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - PTHREAD_MUTEX_INITIALIZER
+ *   - PTHREAD_ONCE_INIT
+ *   - pthread_getspecific
+ *   - pthread_key_create
+ *   - pthread_key_t
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_t
+ *   - pthread_mutex_unlock
+ *   - pthread_once
+ *   - pthread_once_t
+ *   - pthread_setspecific
+ */
+#include <pthread.h>
+
+/* sched.h:
+ *   - sched_yield
+ */
+#include <sched.h>
+#endif /* #if POSIX_PARALLEL */
+
+#include "type_base_prim.h"
+#include "type_base_memory_manager.h"
+#include "type_base_type.h"
+#include "type_base_epoch.h"
+
+#include "util.h"
+
+/* ---------------------------------------------------------------- */
+/* Synchronization.                                                 */
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+static pthread_mutex_t epoch_lock = PTHREAD_MUTEX_INITIALIZER;
+#  define EPOCH_LOCK()   pthread_mutex_lock  (&epoch_lock)
+#  define EPOCH_UNLOCK() pthread_mutex_unlock(&epoch_lock)
+
+#else  /* #if POSIX_PARALLEL */
+#  define EPOCH_LOCK()   do {} while(0)
+#  define EPOCH_UNLOCK() do {} while(0)
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Readers.                                                         */
+/* ---------------------------------------------------------------- */
+
+/*
+ * A thread's reader state.
+ *
+ * Records are linked into "epoch_readers" on a thread's first entry, and
+ * never unlinked; records of exited threads are reused.
+ *
+ * Only the owning thread writes "epoch" and "depth", with releasing stores;
+ * "epoch_try_advance" reads them with acquiring loads.
+ */
+typedef struct epoch_reader_s epoch_reader_t;
+struct epoch_reader_s
+{
+  /* The global epoch observed on entry to the outermost section. */
+  volatile size_t epoch;
+
+  /* Section nesting depth; 0 outside of any section. */
+  volatile size_t depth;
+
+  /* Whether a live thread owns this record. */
+  int in_use;
+
+  epoch_reader_t *next;
+};
+
+static volatile size_t  epoch_global  = 0;
+
+/* Every reader record.  Guarded by "epoch_lock". */
+static epoch_reader_t  *epoch_readers = NULL;
+
+#if POSIX_PARALLEL
+static pthread_key_t   epoch_reader_key;
+static pthread_once_t  epoch_reader_once      = PTHREAD_ONCE_INIT;
+static int             epoch_reader_key_valid = 0;
+
+/* Thread exit: release the record for reuse. */
+static void epoch_reader_release(void *reader_raw)
+{
+  epoch_reader_t *reader = reader_raw;
+
+  if (!reader)
+    return;
+
+  EPOCH_LOCK();
+  {
+    ATOMIC_STORE(&reader->depth, 0);
+    reader->in_use = 0;
+  }
+  EPOCH_UNLOCK();
+}
+
+static void epoch_reader_key_init(void)
+{
+  epoch_reader_key_valid =
+    pthread_key_create(&epoch_reader_key, epoch_reader_release) == 0;
+}
+#else  /* #if POSIX_PARALLEL */
+static epoch_reader_t  epoch_single_reader = { 0, 0, 1, NULL };
+#endif /* #if POSIX_PARALLEL */
+
+/* Get the calling thread's record, registering it on first use. */
+static epoch_reader_t *epoch_reader(void)
+{
+#if POSIX_PARALLEL
+  epoch_reader_t *reader;
+
+  pthread_once(&epoch_reader_once, epoch_reader_key_init);
+  if (!epoch_reader_key_valid)
+    return NULL;
+
+  reader = pthread_getspecific(epoch_reader_key);
+  if (reader)
+    return reader;
+
+  EPOCH_LOCK();
+  {
+    for (reader = epoch_readers; reader; reader = reader->next)
+      if (!reader->in_use)
+        break;
+
+    if (!reader)
+    {
+      reader = memory_manager_mmalloc(&malloc_manager, sizeof(*reader));
+      if (reader)
+      {
+        reader->next  = epoch_readers;
+        epoch_readers = reader;
+      }
+    }
+
+    if (reader)
+    {
+      ATOMIC_STORE(&reader->epoch, ATOMIC_LOAD(&epoch_global));
+      ATOMIC_STORE(&reader->depth, 0);
+      reader->in_use = 1;
+    }
+  }
+  EPOCH_UNLOCK();
+
+  if (!reader)
+    return NULL;
+
+  if (pthread_setspecific(epoch_reader_key, reader) != 0)
+  {
+    epoch_reader_release(reader);
+    return NULL;
+  }
+
+  return reader;
+#else  /* #if POSIX_PARALLEL */
+  if (!epoch_readers)
+    epoch_readers = &epoch_single_reader;
+
+  return &epoch_single_reader;
+#endif /* #if POSIX_PARALLEL */
+}
+
+int epoch_enter(void)
+{
+  epoch_reader_t *reader;
+
+  reader = epoch_reader();
+  if (!reader)
+    return 0;
+
+  if (reader->depth == 0)
+  {
+    ATOMIC_STORE(&reader->epoch, ATOMIC_LOAD(&epoch_global));
+    ATOMIC_STORE(&reader->depth, 1);
+
+    /* Publish the section before reading anything shared. */
+    ATOMIC_FENCE();
+  }
+  else
+  {
+    ATOMIC_STORE(&reader->depth, reader->depth + 1);
+  }
+
+  return 1;
+}
+
+void epoch_exit(void)
+{
+  epoch_reader_t *reader;
+
+  reader = epoch_reader();
+  if (!reader || !reader->depth)
+    return;
+
+  /* Releasing: every read in the section finishes before it is left. */
+  ATOMIC_STORE(&reader->depth, reader->depth - 1);
+}
+
+int epoch_is_active(void)
+{
+  epoch_reader_t *reader;
+
+  reader = epoch_reader();
+
+  return reader && reader->depth > 0;
+}
+
+size_t epoch_current(void)
+{
+  return ATOMIC_LOAD(&epoch_global);
+}
+
+/* ---------------------------------------------------------------- */
+/* Retirement.                                                      */
+/* ---------------------------------------------------------------- */
+
+enum epoch_retired_kind_e
+{
+  e_r_bytes   = 0,
+  e_r_tval    = 1,
+  e_r_cleanup = 2
+};
+typedef enum epoch_retired_kind_e epoch_retired_kind_t;
+
+typedef struct epoch_retired_s epoch_retired_t;
+struct epoch_retired_s
+{
+  epoch_retired_kind_t kind;
+
+  /* The global epoch when retired. */
+  size_t epoch;
+
+  void   *ptr;
+  size_t (*cleanup)(void *context);
+
+  /* For "e_r_bytes". */
+  memory_manager_t manager;
+
+  epoch_retired_t *next;
+};
+
+/* Retired values, oldest first.  Guarded by "epoch_lock". */
+static epoch_retired_t *epoch_retired_head = NULL;
+static epoch_retired_t *epoch_retired_tail = NULL;
+static size_t           epoch_retired_len  = 0;
+
+/* Retirements since the last collection. */
+static size_t           epoch_retired_since_collect = 0;
+
+/*
+ * Records to fall back on when none can be allocated, so that retiring
+ * never has to wait.  Unused ones are linked through "next".  Guarded by
+ * "epoch_lock".
+ */
+#define EPOCH_RETIRED_RESERVE 64
+static epoch_retired_t  epoch_retired_reserve[EPOCH_RETIRED_RESERVE];
+static epoch_retired_t *epoch_retired_reserve_free  = NULL;
+static int              epoch_retired_reserve_ready = 0;
+
+/*
+ * Take a reserved record, or NULL if all are in use.
+ *
+ * Must be called with "epoch_lock" held.
+ */
+static epoch_retired_t *epoch_reserve_take(void)
+{
+  epoch_retired_t *record;
+  size_t           i;
+
+  if (!epoch_retired_reserve_ready)
+  {
+    for (i = 0; i < EPOCH_RETIRED_RESERVE; ++i)
+    {
+      epoch_retired_reserve[i].next = epoch_retired_reserve_free;
+      epoch_retired_reserve_free    = &epoch_retired_reserve[i];
+    }
+
+    epoch_retired_reserve_ready = 1;
+  }
+
+  record = epoch_retired_reserve_free;
+  if (record)
+    epoch_retired_reserve_free = record->next;
+
+  return record;
+}
+
+static int epoch_is_reserved(const epoch_retired_t *record)
+{
+  return
+       record >= &epoch_retired_reserve[0]
+    && record <  &epoch_retired_reserve[EPOCH_RETIRED_RESERVE];
+}
+
+/* Free a record, returning it to the reserve if it came from there. */
+static void epoch_record_free(epoch_retired_t *record)
+{
+  if (!epoch_is_reserved(record))
+  {
+    memory_manager_mfree(&malloc_manager, record);
+    return;
+  }
+
+  EPOCH_LOCK();
+  {
+    record->next               = epoch_retired_reserve_free;
+    epoch_retired_reserve_free = record;
+  }
+  EPOCH_UNLOCK();
+}
+
+/* Free a retired value now. */
+static void epoch_retired_release(epoch_retired_t *retired)
+{
+  switch (retired->kind)
+  {
+    default:
+      break;
+
+    case e_r_bytes:
+      memory_manager_mfree(&retired->manager, retired->ptr);
+      break;
+
+    case e_r_tval:
+      tval_free(retired->ptr);
+      break;
+
+    case e_r_cleanup:
+      retired->cleanup(retired->ptr);
+      break;
+  }
+}
+
+/*
+ * Advance the global epoch if every active reader has observed it.
+ *
+ * Must be called with "epoch_lock" held.
+ */
+static int epoch_try_advance(void)
+{
+  epoch_reader_t *reader;
+  size_t          epoch;
+
+  epoch = epoch_global;
+
+  /* See sections entered before the check. */
+  ATOMIC_FENCE();
+
+  for (reader = epoch_readers; reader; reader = reader->next)
+    if (ATOMIC_LOAD(&reader->depth) && ATOMIC_LOAD(&reader->epoch) != epoch)
+      return 0;
+
+  ATOMIC_STORE(&epoch_global, epoch + 1);
+
+  ATOMIC_FENCE();
+
+  return 1;
+}
+
+/*
+ * Unlink retired values that are safe to free.
+ *
+ * Must be called with "epoch_lock" held.
+ */
+static epoch_retired_t *epoch_take_safe(void)
+{
+  epoch_retired_t *safe;
+  epoch_retired_t *last;
+
+  safe = epoch_retired_head;
+  last = NULL;
+
+  while (epoch_retired_head && epoch_retired_head->epoch + 2 <= ATOMIC_LOAD(&epoch_global))
+  {
+    last               = epoch_retired_head;
+    epoch_retired_head = epoch_retired_head->next;
+
+    --epoch_retired_len;
+  }
+
+  if (!last)
+    return NULL;
+
+  last->next = NULL;
+  if (!epoch_retired_head)
+    epoch_retired_tail = NULL;
+
+  return safe;
+}
+
+/* Free a list of retired values, and their records. */
+static size_t epoch_release_list(epoch_retired_t *list)
+{
+  size_t           num_freed;
+  epoch_retired_t *next;
+
+  num_freed = 0;
+
+  for (; list; list = next)
+  {
+    next = list->next;
+
+    epoch_retired_release(list);
+    epoch_record_free(list);
+
+    ++num_freed;
+  }
+
+  return num_freed;
+}
+
+size_t epoch_collect(void)
+{
+  epoch_retired_t *safe;
+
+  EPOCH_LOCK();
+  {
+    epoch_retired_since_collect = 0;
+
+    epoch_try_advance();
+
+    safe = epoch_take_safe();
+  }
+  EPOCH_UNLOCK();
+
+  /* Freeing may retire more; do it unlocked. */
+  return epoch_release_list(safe);
+}
+
+size_t epoch_synchronize(void)
+{
+  size_t num_freed;
+  size_t target;
+  int    done;
+
+  num_freed = 0;
+
+  target = ATOMIC_LOAD(&epoch_global) + 2;
+
+  for (;;)
+  {
+    num_freed += epoch_collect();
+
+    done = ATOMIC_LOAD(&epoch_global) >= target;
+
+    if (done)
+      break;
+
+#if POSIX_PARALLEL
+    sched_yield();
+#endif /* #if POSIX_PARALLEL */
+  }
+
+  return num_freed;
+}
+
+size_t epoch_retired_num(void)
+{
+  size_t num;
+
+  EPOCH_LOCK();
+  {
+    num = epoch_retired_len;
+  }
+  EPOCH_UNLOCK();
+
+  return num;
+}
+
+/*
+ * Queue a retired value, in a reserved record if none can be allocated.
+ *
+ * Retiring happens inside critical sections, so this must never wait for
+ * the epoch to advance.  Returns 0 if no record is left at all.
+ */
+static size_t epoch_retire_record(const epoch_retired_t *retired)
+{
+  epoch_retired_t *record;
+  int              collect;
+
+  record = memory_manager_mmalloc(&malloc_manager, sizeof(*record));
+
+  EPOCH_LOCK();
+  {
+    if (!record)
+    {
+      record = epoch_reserve_take();
+      if (!record)
+      {
+        EPOCH_UNLOCK();
+        return 0;
+      }
+    }
+
+    *record = *retired;
+    record->next  = NULL;
+    record->epoch = ATOMIC_LOAD(&epoch_global);
+
+    if (epoch_retired_tail)
+      epoch_retired_tail->next = record;
+    else
+      epoch_retired_head       = record;
+    epoch_retired_tail = record;
+
+    ++epoch_retired_len;
+
+    collect =
+         ++epoch_retired_since_collect >= EPOCH_COLLECT_INTERVAL
+      || epoch_is_reserved(record);
+  }
+  EPOCH_UNLOCK();
+
+  if (collect)
+    epoch_collect();
+
+  return 1;
+}
+
+size_t epoch_retire_bytes(const memory_manager_t *memory_manager, void *ptr)
+{
+  epoch_retired_t retired;
+
+  if (!ptr)
+    return 0;
+
+  retired.kind    = e_r_bytes;
+  retired.ptr     = ptr;
+  retired.cleanup = NULL;
+  memory_manager_copy(&retired.manager, require_memory_manager(memory_manager));
+
+  return epoch_retire_record(&retired);
+}
+
+size_t epoch_retire_tval(tval *val)
+{
+  epoch_retired_t retired;
+
+  if (!val)
+    return 0;
+
+  retired.kind    = e_r_tval;
+  retired.ptr     = val;
+  retired.cleanup = NULL;
+  retired.manager = memory_manager_defaults;
+
+  return epoch_retire_record(&retired);
+}
+
+size_t epoch_retire(size_t (*cleanup)(void *context), void *context)
+{
+  epoch_retired_t retired;
+
+  if (!cleanup)
+    return 0;
+
+  retired.kind    = e_r_cleanup;
+  retired.ptr     = context;
+  retired.cleanup = cleanup;
+  retired.manager = memory_manager_defaults;
+
+  return epoch_retire_record(&retired);
+}
@@ -0,0 +1,143 @@
+/*
+ * opencurry: type_base_epoch.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_epoch.h
+ * ------
+ *
+ * Epoch-based reclamation.
+ *
+ * Readers of shared values bracket their accesses with "epoch_enter" and
+ * "epoch_exit".  A writer that unlinks a value from a shared structure
+ * retires it instead of freeing it; the value is freed only once every
+ * reader that could still hold a reference to it has left its critical
+ * section.
+ *
+ * A global epoch counter advances whenever every active reader has observed
+ * the current epoch.  Values retired in epoch "e" are freed once the global
+ * epoch reaches "e + 2", by "epoch_collect", which retiring also runs every
+ * "EPOCH_COLLECT_INTERVAL" retirements.
+ *
+ * Memory trackers with "retire" set retire what their free methods would
+ * free; see "type_base_memory_tracker.h".
+ *
+ * Without POSIX_PARALLEL, there is a single reader.
+ */
+
+#ifndef TYPE_BASE_EPOCH_H
+#define TYPE_BASE_EPOCH_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_tval.h"
+#include "type_base_memory_manager.h"
+
+/* ---------------------------------------------------------------- */
+/* Critical sections.                                               */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Enter and leave a read-side critical section.
+ *
+ * Sections nest; only the outermost pair has an effect.  Both are cheap: no
+ * locks are taken except on a thread's first entry.
+ *
+ * "epoch_enter" returns 0 only if the calling thread could not be
+ * registered, in which case the section must not be entered.
+ */
+int    epoch_enter(void);
+void   epoch_exit (void);
+
+/* Is the calling thread inside a critical section? */
+int    epoch_is_active(void);
+
+/* The global epoch. */
+size_t epoch_current(void);
+
+/* ---------------------------------------------------------------- */
+/* Retirement.                                                      */
+/* ---------------------------------------------------------------- */
+
+/* Retiring runs "epoch_collect" this often. */
+#define EPOCH_COLLECT_INTERVAL 64
+
+/*
+ * Retire a value for freeing once no reader can reach it.
+ *
+ * "epoch_retire_bytes" frees "ptr" with "memory_manager", which is copied;
+ * "epoch_retire_tval" frees "val" with "tval_free"; "epoch_retire" calls
+ * "cleanup" with "context".
+ *
+ * These never wait, so they may be called from within a critical section,
+ * as trackers with "retire" set do on every free.  If no record can be
+ * allocated, one of a small reserve is used and a collection is run; if the
+ * reserve is used up too, the value is left alone, neither retired nor
+ * freed.
+ *
+ * Each returns 1 if the value was retired, and 0 for a NULL value or one
+ * that could not be retired.
+ */
+size_t epoch_retire_bytes(const memory_manager_t *memory_manager, void *ptr);
+size_t epoch_retire_tval (tval *val);
+size_t epoch_retire      (size_t (*cleanup)(void *context), void *context);
+
+/*
+ * Advance the epoch if every active reader has observed it, and free what
+ * was retired at least two epochs ago.
+ *
+ * Returns the number of retired values freed.
+ */
+size_t epoch_collect(void);
+
+/*
+ * Wait until every value retired before the call is freed.
+ *
+ * Must not be called from within a critical section.  Returns the number of
+ * retired values freed.
+ */
+size_t epoch_synchronize(void);
+
+/* Number of values retired but not yet freed. */
+size_t epoch_retired_num(void);
+
+#endif /* ifndef TYPE_BASE_EPOCH_H */
@@ -0,0 +1,474 @@
+/*
+ * opencurry: type_base_hash_table.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+#include "type_base_prim.h"
+#include "type_base_compare.h"
+#include "type_base_memory_manager.h"
+#include "type_base_hash_table.h"
+
+#include "type_base.h"
+
+#include "util.h"
+
+/* ---------------------------------------------------------------- */
+/* hash_table_t type.                                               */
+/* ---------------------------------------------------------------- */
+
+const type_t *hash_table_type(void)
+  { return &hash_table_type_def; }
+
+static const char          *hash_table_type_name       (const type_t *self);
+static size_t               hash_table_type_size       (const type_t *self, const tval *val);
+static const struct_info_t *hash_table_type_is_struct  (const type_t *self);
+static size_t               hash_table_type_free       (const type_t *self, tval *val);
+static const tval          *hash_table_type_has_default(const type_t *self);
+
+static const struct type_registry_entry_s *hash_table_type_registry_entry = NULL;
+
+const type_t hash_table_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ hash_table_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ NULL
+
+  , /* @name                  */ hash_table_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ hash_table_type_size
+  , /* @is_struct             */ hash_table_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ hash_table_type_free
+  , /* has_default            */ hash_table_type_has_default
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &hash_table_type_registry_entry
+
+  , /* parity                 */ ""
+  };
+
+static const char          *hash_table_type_name       (const type_t *self)
+  { return "hash_table_t"; }
+
+static size_t               hash_table_type_size       (const type_t *self, const tval *val)
+  { return sizeof(hash_table_t); }
+
+/* The entries are owned by the value, so a field-by-field copy would share them. */
+static const struct_info_t *hash_table_type_is_struct  (const type_t *self)
+  { return type_is_not_struct(self); }
+
+static size_t               hash_table_type_free       (const type_t *self, tval *val)
+{
+  size_t num_freed;
+
+  num_freed  = hash_table_deinit((hash_table_t *) val);
+  num_freed += type_has_template_cons_basic_freer(self, val);
+
+  return num_freed;
+}
+
+static const tval          *hash_table_type_has_default(const type_t *self)
+  { return type_has_default_value(self, &hash_table_defaults); }
+
+/* ---------------------------------------------------------------- */
+
+const hash_table_t hash_table_defaults =
+  HASH_TABLE_DEFAULTS;
+
+const char hash_table_removed[1] = { 0 };
+
+#define HASH_TABLE_REMOVED ((const tval *) hash_table_removed)
+
+/* ---------------------------------------------------------------- */
+/* hash_table_t methods.                                            */
+/* ---------------------------------------------------------------- */
+
+static const memory_manager_t *hash_table_memory_manager(const hash_table_t *table)
+{
+  if (table->memory_manager)
+    return table->memory_manager;
+  else
+    return default_memory_manager;
+}
+
+hash_table_t *hash_table_init(hash_table_t *table, const type_t *key_type, int deep, const memory_manager_t *memory_manager)
+{
+  if (!table)
+    return NULL;
+
+  *table = hash_table_defaults;
+
+  table->key_type       = key_type;
+  table->deep           = deep;
+  table->memory_manager = memory_manager;
+
+  return table;
+}
+
+size_t hash_table_deinit(hash_table_t *table)
+{
+  size_t num_freed;
+
+  if (!table)
+    return 0;
+
+  num_freed = 0;
+
+  if (table->entries)
+    num_freed += memory_manager_mfree(hash_table_memory_manager(table), table->entries);
+
+  table->entries = NULL;
+  table->size    = 0;
+  table->num     = 0;
+  table->removed = 0;
+
+  return num_freed;
+}
+
+hash_table_t *hash_table_clear(hash_table_t *table)
+{
+  size_t i;
+
+  if (!table)
+    return NULL;
+
+  for (i = 0; i < table->size; ++i)
+  {
+    table->entries[i].key   = NULL;
+    table->entries[i].hash  = 0;
+    table->entries[i].value = NULL;
+  }
+
+  table->num     = 0;
+  table->removed = 0;
+
+  return table;
+}
+
+size_t hash_table_num(const hash_table_t *table)
+{
+  if (!table)
+    return 0;
+
+  return table->num;
+}
+
+size_t hash_table_hash_key(const hash_table_t *table, const tval *key)
+{
+  if (!table->key_type)
+    return hash_mix((size_t) key);
+
+  return type_hash(table->key_type, key, table->deep, NULL);
+}
+
+static int hash_table_keys_equal(const hash_table_t *table, const tval *key, const tval *check)
+{
+  if (key == check)
+    return 1;
+
+  if (!table->key_type)
+    return 0;
+
+  return type_cmp(table->key_type, key, check, table->deep, NULL) == 0;
+}
+
+/* The slot holding "key", or NULL. */
+static hash_table_entry_t *hash_table_lookup(const hash_table_t *table, const tval *key, size_t hash)
+{
+  size_t mask;
+  size_t index;
+  size_t probes;
+
+  if (!table->entries)
+    return NULL;
+
+  mask  = table->size - 1;
+  index = hash & mask;
+  for (probes = 0; probes < table->size; ++probes)
+  {
+    hash_table_entry_t *entry;
+
+    entry = &table->entries[index];
+
+    if (!entry->key)
+      return NULL;
+
+    if
+      (  entry->key  != HASH_TABLE_REMOVED
+      && entry->hash == hash
+      && hash_table_keys_equal(table, entry->key, key)
+      )
+      return entry;
+
+    index = (index + 1) & mask;
+  }
+
+  return NULL;
+}
+
+/* Place an entry, known to be absent, into entries with a free slot. */
+static hash_table_entry_t *hash_table_place(hash_table_entry_t *entries, size_t size, size_t hash, size_t *removed)
+{
+  size_t mask;
+  size_t index;
+
+  mask  = size - 1;
+  index = hash & mask;
+  while (entries[index].key && entries[index].key != HASH_TABLE_REMOVED)
+    index = (index + 1) & mask;
+
+  if (entries[index].key == HASH_TABLE_REMOVED && removed)
+    --*removed;
+
+  return &entries[index];
+}
+
+/* Move every entry into "size" new slots.  0 on success. */
+static int hash_table_resize(hash_table_t *table, size_t size)
+{
+  const memory_manager_t *memory_manager;
+  hash_table_entry_t     *entries;
+  size_t                  i;
+
+  memory_manager = hash_table_memory_manager(table);
+
+  entries = memory_manager_mcalloc(memory_manager, size, sizeof(*entries));
+  if (!entries)
+    return -1;
+
+  for (i = 0; i < table->size; ++i)
+  {
+    const hash_table_entry_t *old;
+
+    old = &table->entries[i];
+    if (!old->key || old->key == HASH_TABLE_REMOVED)
+      continue;
+
+    *hash_table_place(entries, size, old->hash, NULL) = *old;
+  }
+
+  if (table->entries)
+    memory_manager_mfree(memory_manager, table->entries);
+
+  table->entries = entries;
+  table->size    = size;
+  table->removed = 0;
+
+  return 0;
+}
+
+/* The table size that keeps "num" entries at most three quarters full. */
+static size_t hash_table_size_for(size_t num)
+{
+  size_t size;
+
+  size = HASH_TABLE_MIN_SIZE;
+  while (size / 4 * 3 < num)
+    size *= 2;
+
+  return size;
+}
+
+int hash_table_reserve(hash_table_t *table, size_t num)
+{
+  size_t size;
+
+  if (!table)
+    return -1;
+
+  size = hash_table_size_for(num);
+  if (size <= table->size && num + table->removed <= table->size / 4 * 3)
+    return 0;
+
+  return hash_table_resize(table, max_size(size, table->size));
+}
+
+void **hash_table_insert(hash_table_t *table, const tval *key, int *out_inserted)
+{
+  hash_table_entry_t *entry;
+  size_t              hash;
+
+  WRITE_OUTPUT(out_inserted, 0);
+
+  if (!table || !key)
+    return NULL;
+
+  hash = hash_table_hash_key(table, key);
+
+  entry = hash_table_lookup(table, key, hash);
+  if (entry)
+    return &entry->value;
+
+  /* Grow if mostly live; otherwise just reclaim removed slots. */
+  if ((table->num + table->removed + 1) > table->size / 4 * 3)
+  {
+    if (hash_table_resize(table, hash_table_size_for(table->num + 1)))
+      return NULL;
+  }
+
+  entry = hash_table_place(table->entries, table->size, hash, &table->removed);
+
+  entry->key   = key;
+  entry->hash  = hash;
+  entry->value = NULL;
+
+  ++table->num;
+
+  WRITE_OUTPUT(out_inserted, 1);
+  return &entry->value;
+}
+
+void *hash_table_put(hash_table_t *table, const tval *key, void *value)
+{
+  void **slot;
+  void  *previous;
+
+  slot = hash_table_insert(table, key, NULL);
+  if (!slot)
+    return NULL;
+
+  previous = *slot;
+  *slot    = value;
+
+  return previous;
+}
+
+void **hash_table_find(const hash_table_t *table, const tval *key)
+{
+  hash_table_entry_t *entry;
+
+  if (!table || !key)
+    return NULL;
+
+  entry = hash_table_lookup(table, key, hash_table_hash_key(table, key));
+  if (!entry)
+    return NULL;
+
+  return &entry->value;
+}
+
+const tval *hash_table_find_key(const hash_table_t *table, const tval *key)
+{
+  hash_table_entry_t *entry;
+
+  if (!table || !key)
+    return NULL;
+
+  entry = hash_table_lookup(table, key, hash_table_hash_key(table, key));
+  if (!entry)
+    return NULL;
+
+  return entry->key;
+}
+
+int hash_table_contains(const hash_table_t *table, const tval *key)
+{
+  return hash_table_find_key(table, key) != NULL;
+}
+
+int hash_table_remove(hash_table_t *table, const tval *key, void **out_value)
+{
+  hash_table_entry_t *entry;
+
+  WRITE_OUTPUT(out_value, NULL);
+
+  if (!table || !key)
+    return 0;
+
+  entry = hash_table_lookup(table, key, hash_table_hash_key(table, key));
+  if (!entry)
+    return 0;
+
+  WRITE_OUTPUT(out_value, entry->value);
+
+  entry->key   = HASH_TABLE_REMOVED;
+  entry->hash  = 0;
+  entry->value = NULL;
+
+  --table->num;
+  ++table->removed;
+
+  return 1;
+}
+
+int hash_table_next(const hash_table_t *table, size_t *cursor, const tval **out_key, void **out_value)
+{
+  if (!table || !cursor)
+    return 0;
+
+  for (; *cursor < table->size; ++*cursor)
+  {
+    const hash_table_entry_t *entry;
+
+    entry = &table->entries[*cursor];
+    if (!entry->key || entry->key == HASH_TABLE_REMOVED)
+      continue;
+
+    WRITE_OUTPUT(out_key,   entry->key);
+    WRITE_OUTPUT(out_value, entry->value);
+
+    ++*cursor;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * opencurry: type_base_hash_table.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_hash_table.h
+ * ------
+ *
+ * Hash tables over "tval"s.
+ *
+ * A "hash_table_t" maps keys to "void *" values, or, ignoring the values,
+ * is a set of keys.  Keys are hashed and compared with their key type's
+ * "hash" and "cmp" methods, so e.g. two equal structs at different
+ * addresses are the same key.  Without a key type, keys are compared by
+ * address, which suits caches keyed by "type_t *".
+ *
+ * Keys are referenced, not copied: a key must outlive its entry, and must
+ * not change in a way that changes its hash while it is in the table.
+ *
+ * Entries live in a single open-addressing array with linear probing,
+ * which doubles when three quarters full.  Tables are not synchronized.
+ */
+
+#ifndef TYPE_BASE_HASH_TABLE_H
+#define TYPE_BASE_HASH_TABLE_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_tval.h"
+#include "type_base_memory_manager.h"
+
+/* ---------------------------------------------------------------- */
+/* hash_table_t                                                     */
+/* ---------------------------------------------------------------- */
+
+#define HASH_TABLE_MIN_SIZE 16
+
+typedef struct hash_table_entry_s hash_table_entry_t;
+struct hash_table_entry_s
+{
+  /* NULL in an empty slot, or "hash_table_removed" in a removed one. */
+  const tval *key;
+
+  /* The key's hash, so that growing needn't rehash keys. */
+  size_t      hash;
+
+  void       *value;
+};
+
+const type_t *hash_table_type(void);
+extern const type_t hash_table_type_def;
+typedef struct hash_table_s hash_table_t;
+struct hash_table_s
+{
+  typed_t type;
+
+  /* NULL to compare keys by address. */
+  const type_t           *key_type;
+
+  /* "deep" argument for the key type's "hash" and "cmp". */
+  int                     deep;
+
+  /* NULL for "default_memory_manager". */
+  const memory_manager_t *memory_manager;
+
+  /* "size" is 0 or a power of 2. */
+  hash_table_entry_t     *entries;
+  size_t                  size;
+  size_t                  num;
+  size_t                  removed;
+};
+
+#define HASH_TABLE_DEFAULTS                 \
+  { hash_table_type                         \
+                                            \
+  , /* key_type       */ NULL               \
+  , /* deep           */ 0                  \
+                                            \
+  , /* memory_manager */ NULL               \
+                                            \
+  , /* entries        */ NULL               \
+  , /* size           */ 0                  \
+  , /* num            */ 0                  \
+  , /* removed        */ 0                  \
+  }
+extern const hash_table_t hash_table_defaults;
+
+/* Marks removed slots. */
+extern const char hash_table_removed[1];
+
+/* ---------------------------------------------------------------- */
+
+/* Initialize an empty table; nothing is allocated until the first insert. */
+hash_table_t *hash_table_init(hash_table_t *table, const type_t *key_type, int deep, const memory_manager_t *memory_manager);
+
+/* Free the entries, leaving an empty table.  Returns the number of blocks freed. */
+size_t hash_table_deinit(hash_table_t *table);
+
+/* Remove every entry, keeping the storage. */
+hash_table_t *hash_table_clear(hash_table_t *table);
+
+/* Make room for "num" entries without growing.  0 on success. */
+int hash_table_reserve(hash_table_t *table, size_t num);
+
+size_t hash_table_num(const hash_table_t *table);
+
+/* The hash "table" uses for "key". */
+size_t hash_table_hash_key(const hash_table_t *table, const tval *key);
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Find or add "key", returning a reference to its value, or NULL when the
+ * table could not grow.  A new entry's value is NULL.
+ *
+ * "out_inserted" is set to whether the entry is new.
+ */
+void **hash_table_insert(hash_table_t *table, const tval *key, int *out_inserted);
+
+/* Add or replace; returns the previous value, or NULL. */
+void *hash_table_put(hash_table_t *table, const tval *key, void *value);
+
+/* Reference to the value of "key", or NULL when absent. */
+void **hash_table_find(const hash_table_t *table, const tval *key);
+
+/* The key in the table equal to "key", or NULL when absent. */
+const tval *hash_table_find_key(const hash_table_t *table, const tval *key);
+
+int hash_table_contains(const hash_table_t *table, const tval *key);
+
+/* Remove "key", writing its value to "out_value".  1 if removed, 0 if absent. */
+int hash_table_remove(hash_table_t *table, const tval *key, void **out_value);
+
+/*
+ * Iterate over the entries, in no particular order:
+ *
+ * > size_t      cursor = 0;
+ * > const tval *key;
+ * > void       *value;
+ * >
+ * > while (hash_table_next(table, &cursor, &key, &value))
+ * >   ...
+ *
+ * Inserting during iteration may skip or repeat entries; removing the
+ * current entry is allowed.
+ */
+int hash_table_next(const hash_table_t *table, size_t *cursor, const tval **out_key, void **out_value);
+
+#endif /* ifndef TYPE_BASE_HASH_TABLE_H */
@@ -38,6 +38,7 @@
 #include <stddef.h>
 
 /* string.h:
+ *   - memcpy
  *   - memmove
  *   - memset
  */
@@ -80,6 +81,8 @@ static size_t               bnode_type_size       (const type_t *self, const tva
 static const struct_info_t *bnode_type_is_struct  (const type_t *self);
 static const tval          *bnode_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *bnode_type_registry_entry = NULL;
+
 const type_t bnode_type_def =
   { type_type
 
@@ -117,6 +120,10 @@ const type_t bnode_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &bnode_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -171,6 +178,8 @@ static tval                *lookup_type_dup        ( const type_t *self
                                                    , ref_traversal_t *ref_traversal
                                                    );
 
+static const struct type_registry_entry_s *lookup_type_registry_entry = NULL;
+
 const type_t lookup_type_def =
   { type_type
 
@@ -208,6 +217,10 @@ const type_t lookup_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &lookup_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -897,6 +910,47 @@ size_t lookup_get_value_in_use_bit(const lookup_t *lookup, size_t index)
 
 /* ---------------------------------------------------------------- */
 
+size_t lookup_huge_pages_min_size = LOOKUP_DEFAULT_HUGE_PAGES_MIN_SIZE;
+
+static int lookup_wants_huge_pages(const memory_manager_t *memory_manager, size_t size)
+{
+  return
+       lookup_huge_pages_min_size
+    && size >= lookup_huge_pages_min_size
+    && memory_manager_supports_hints(memory_manager)
+    ;
+}
+
+/* "memory_manager_mcalloc", hinting large arrays. */
+static void *lookup_alloc_array(const memory_manager_t *memory_manager, size_t nmemb, size_t size)
+{
+  if (size > 0 && nmemb > ((size_t) (-1)) / size)
+    return NULL;
+
+  if (lookup_wants_huge_pages(memory_manager, nmemb * size))
+    return memory_manager_mmalloc_hinted(memory_manager, nmemb * size, MEMORY_HINT_HUGE_PAGES | MEMORY_HINT_ZEROED);
+  else
+    return memory_manager_mcalloc(memory_manager, nmemb, size);
+}
+
+/* "memory_manager_mrealloc", moving arrays that become large. */
+static void *lookup_realloc_array(const memory_manager_t *memory_manager, void *ptr, size_t old_size, size_t size)
+{
+  void *resized;
+
+  if (!lookup_wants_huge_pages(memory_manager, size) || lookup_wants_huge_pages(memory_manager, old_size))
+    return memory_manager_mrealloc(memory_manager, ptr, size);
+
+  resized = memory_manager_mmalloc_hinted(memory_manager, size, MEMORY_HINT_HUGE_PAGES);
+  if (!resized)
+    return NULL;
+
+  memcpy(resized, ptr, old_size);
+  memory_manager_mfree(memory_manager, ptr);
+
+  return resized;
+}
+
 /* Allocate more memory for additional element slots. */
 /*                                                    */
 /* Does nothing with a "num" argument smaller than    */
@@ -928,7 +982,7 @@ lookup_t *lookup_expand
       return NULL;
 #endif /* #if ERROR_CHECKING  */
 
-    lookup->values = memory_manager_mcalloc(memory_manager, capacity, lookup->value_size);
+    lookup->values = lookup_alloc_array(memory_manager, capacity, lookup->value_size);
     if (!lookup->values)
     {
       lookup->order    = NULL;
@@ -937,7 +991,7 @@ lookup_t *lookup_expand
       return NULL;
     }
 
-    lookup->order  = memory_manager_mcalloc(memory_manager, capacity, sizeof(bnode_t));
+    lookup->order  = lookup_alloc_array(memory_manager, capacity, sizeof(bnode_t));
     if (!lookup->order)
     {
       lookup->values   = NULL;
@@ -963,7 +1017,7 @@ lookup_t *lookup_expand
       return NULL;
 #endif /* #if ERROR_CHECKING  */
 
-    lookup->values = memory_manager_mrealloc(memory_manager, lookup->values, capacity * lookup->value_size);
+    lookup->values = lookup_realloc_array(memory_manager, lookup->values, old_capacity * lookup->value_size, capacity * lookup->value_size);
     if (!lookup->values)
     {
       lookup->order    = NULL;
@@ -972,7 +1026,7 @@ lookup_t *lookup_expand
       return NULL;
     }
 
-    lookup->order  = memory_manager_mrealloc(memory_manager, lookup->order,  capacity * sizeof(bnode_t));
+    lookup->order  = lookup_realloc_array(memory_manager, lookup->order,  old_capacity * sizeof(bnode_t), capacity * sizeof(bnode_t));
     if (!lookup->order)
     {
       lookup->values   = NULL;
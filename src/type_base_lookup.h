@@ -292,6 +292,14 @@ size_t lookup_get_value_in_use_bit(const lookup_t *lookup, size_t index);
 
 /* ---------------------------------------------------------------- */
 
+/*
+ * When expanding, value and order arrays of at least this many bytes are
+ * requested with "MEMORY_HINT_HUGE_PAGES" from memory managers that take
+ * hints.  0 disables the hint.
+ */
+#define LOOKUP_DEFAULT_HUGE_PAGES_MIN_SIZE ((size_t) (2 * 1024 * 1024))
+extern size_t lookup_huge_pages_min_size;
+
 lookup_t *lookup_expand
   ( lookup_t *lookup
   , size_t    capacity
@@ -236,6 +236,8 @@ static const tval          *memory_manager_type_has_default(const type_t *self);
  * >
  * > type_init(our_type_struct, cons);
  */
+static const struct type_registry_entry_s *memory_manager_type_registry_entry = NULL;
+
 const type_t memory_manager_type_def =
   { type_type
 
@@ -273,6 +275,10 @@ const type_t memory_manager_type_def =
   , /* user                   */ NULL /* memory_manager_type_user                    */
   , /* cuser                  */ NULL /* memory_manager_type_cuser                   */
   , /* cmp                    */ NULL /* memory_manager_type_cmp                     */
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &memory_manager_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -326,6 +332,11 @@ static const struct_info_t *memory_manager_type_is_struct  (const type_t *self)
     STRUCT_INFO_RADD(funp_type(), mrealloc);
     STRUCT_INFO_RADD(funp_type(), mcalloc);
 
+    /* manager_mmalloc_aligned_fun_t mmalloc_aligned; */
+    /* manager_mmalloc_hinted_fun_t  mmalloc_hinted;  */
+    STRUCT_INFO_RADD(funp_type(), mmalloc_aligned);
+    STRUCT_INFO_RADD(funp_type(), mmalloc_hinted);
+
     /* manager_on_oom_fun_t on_oom; */
     /* manager_on_err_fun_t on_err; */
     STRUCT_INFO_RADD(funp_type(), on_oom);
@@ -414,6 +425,9 @@ const memory_manager_t malloc_manager =
   , malloc_manager_mrealloc
   , malloc_manager_mcalloc
 
+  , NULL
+  , NULL
+
   , malloc_manager_on_oom
   , malloc_manager_on_err
 
@@ -527,6 +541,9 @@ memory_manager_t *memory_manager_init
   dest->mrealloc   = mrealloc;
   dest->mcalloc    = mcalloc;
 
+  dest->mmalloc_aligned = NULL;
+  dest->mmalloc_hinted  = NULL;
+
   dest->on_oom     = memory_manager_default_on_oom;
   dest->on_err     = memory_manager_default_on_err;
 
@@ -549,6 +566,9 @@ size_t memory_manager_deinit(memory_manager_t *memory_manager)
   memory_manager->on_err     = NULL;
   memory_manager->on_oom     = NULL;
 
+  memory_manager->mmalloc_hinted  = NULL;
+  memory_manager->mmalloc_aligned = NULL;
+
   memory_manager->mcalloc    = NULL;
   memory_manager->mrealloc   = NULL;
   memory_manager->mfree      = NULL;
@@ -594,6 +614,9 @@ memory_manager_t *memory_manager_copy(memory_manager_t *dest, const memory_manag
   dest->mrealloc   = src->mrealloc;
   dest->mcalloc    = src->mcalloc;
 
+  dest->mmalloc_aligned = src->mmalloc_aligned;
+  dest->mmalloc_hinted  = src->mmalloc_hinted;
+
   dest->on_oom     = src->on_oom;
   dest->on_err     = src->on_err;
 
@@ -727,6 +750,79 @@ void  memory_manager_on_err (const memory_manager_t *memory_manager, const char
   on_err(memory_manager, msg);
 }
 
+/* ---------------------------------------------------------------- */
+/* Aligned and hinted allocation.                                   */
+/* ---------------------------------------------------------------- */
+
+void *memory_manager_mmalloc_aligned(const memory_manager_t *memory_manager, size_t alignment, size_t size)
+{
+  char   *raw;
+  size_t  aligned;
+
+  if (!memory_manager)
+    memory_manager = &malloc_manager;
+
+  /* "alignment" must be a power of two. */
+  if (!alignment || (alignment & (alignment - 1)))
+    return NULL;
+
+  if (memory_manager->mmalloc_aligned)
+    return memory_manager->mmalloc_aligned(memory_manager, alignment, size);
+
+  /* Leave room for the original pointer in front of the block. */
+  if (alignment < sizeof(void *))
+    alignment = sizeof(void *);
+
+  if (size > ((size_t) (-1)) - alignment - sizeof(void *))
+    return NULL;
+
+  raw = memory_manager_mmalloc(memory_manager, size + alignment + sizeof(void *));
+  if (!raw)
+    return NULL;
+
+  aligned = ((size_t) (raw + sizeof(void *)) + alignment - 1) & ~(alignment - 1);
+
+  ((void **) aligned)[-1] = raw;
+
+  return (void *) aligned;
+}
+
+size_t memory_manager_mfree_aligned(const memory_manager_t *memory_manager, void *ptr)
+{
+  if (!memory_manager)
+    memory_manager = &malloc_manager;
+
+  if (!ptr)
+    return 0;
+
+  if (memory_manager->mmalloc_aligned)
+    return memory_manager_mfree(memory_manager, ptr);
+
+  return memory_manager_mfree(memory_manager, ((void **) ptr)[-1]);
+}
+
+void *memory_manager_mmalloc_hinted(const memory_manager_t *memory_manager, size_t size, unsigned int hints)
+{
+  if (!memory_manager)
+    memory_manager = &malloc_manager;
+
+  if (memory_manager->mmalloc_hinted)
+    return memory_manager->mmalloc_hinted(memory_manager, size, hints);
+
+  if (hints & MEMORY_HINT_ZEROED)
+    return memory_manager_mcalloc(memory_manager, 1, size);
+
+  return memory_manager_mmalloc(memory_manager, size);
+}
+
+int memory_manager_supports_hints(const memory_manager_t *memory_manager)
+{
+  if (!memory_manager)
+    memory_manager = &malloc_manager;
+
+  return memory_manager->mmalloc_hinted != NULL;
+}
+
 /* ---------------------------------------------------------------- */
 
 /* If "memory_manager" is NULL, return the default memory manager. */
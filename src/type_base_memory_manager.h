@@ -80,6 +80,9 @@ typedef size_t  (*manager_mfree_fun_t)   (const memory_manager_t *self, void   *
 typedef void   *(*manager_mrealloc_fun_t)(const memory_manager_t *self, void   *ptr,   size_t size);
 typedef void   *(*manager_mcalloc_fun_t) (const memory_manager_t *self, size_t  nmemb, size_t size);
 
+typedef void   *(*manager_mmalloc_aligned_fun_t)(const memory_manager_t *self, size_t alignment, size_t size);
+typedef void   *(*manager_mmalloc_hinted_fun_t) (const memory_manager_t *self, size_t size,      unsigned int hints);
+
 typedef void    (*manager_on_oom_fun_t)  (const memory_manager_t *self, size_t      size);
 typedef void    (*manager_on_err_fun_t)  (const memory_manager_t *self, const char *msg);
 
@@ -101,6 +104,11 @@ struct memory_manager_s
   manager_mrealloc_fun_t mrealloc;
   manager_mcalloc_fun_t  mcalloc;
 
+  /* Optional; see "memory_manager_mmalloc_aligned" and */
+  /* "memory_manager_mmalloc_hinted".                   */
+  manager_mmalloc_aligned_fun_t mmalloc_aligned;
+  manager_mmalloc_hinted_fun_t  mmalloc_hinted;
+
   manager_on_oom_fun_t on_oom;
   manager_on_err_fun_t on_err;
 
@@ -114,6 +122,9 @@ struct memory_manager_s
   , NULL                          \
   , NULL                          \
   , NULL                          \
+  , NULL                          \
+                                  \
+  , NULL                          \
   , NULL                          \
                                   \
   , memory_manager_default_on_oom \
@@ -174,6 +185,45 @@ void   *memory_manager_mcalloc (const memory_manager_t *memory_manager, size_t n
 void    memory_manager_on_oom  (const memory_manager_t *memory_manager, size_t      size);
 void    memory_manager_on_err  (const memory_manager_t *memory_manager, const char *msg);
 
+/* ---------------------------------------------------------------- */
+/* Aligned and hinted allocation.                                   */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Allocate "size" bytes aligned to "alignment", a power of two.
+ *
+ * Blocks are released with "memory_manager_mfree_aligned".  Managers without
+ * "mmalloc_aligned" over-allocate with "mmalloc" and record the original
+ * block just in front of the aligned one.
+ */
+void   *memory_manager_mmalloc_aligned(const memory_manager_t *memory_manager, size_t alignment, size_t size);
+size_t  memory_manager_mfree_aligned  (const memory_manager_t *memory_manager, void   *ptr);
+
+/* Hints for "memory_manager_mmalloc_hinted". */
+#define MEMORY_HINT_NONE       0x0u
+/* Back the block with huge pages where possible.  */
+#define MEMORY_HINT_HUGE_PAGES 0x1u
+/* Zero the block, as "mcalloc" does.              */
+#define MEMORY_HINT_ZEROED     0x2u
+/* The block will be accessed soon and often.      */
+#define MEMORY_HINT_HOT        0x4u
+/* The block will rarely be accessed.              */
+#define MEMORY_HINT_COLD       0x8u
+
+/*
+ * Allocate "size" bytes, passing placement hints to managers that implement
+ * "mmalloc_hinted".
+ *
+ * Hints never change the meaning of an allocation, only its placement, so
+ * blocks are released with "memory_manager_mfree" and resized with
+ * "memory_manager_mrealloc" as usual.  Other managers honor only
+ * "MEMORY_HINT_ZEROED", through "mcalloc".
+ */
+void   *memory_manager_mmalloc_hinted (const memory_manager_t *memory_manager, size_t size, unsigned int hints);
+
+/* Does the manager act on hints other than "MEMORY_HINT_ZEROED"? */
+int     memory_manager_supports_hints (const memory_manager_t *memory_manager);
+
 /* ---------------------------------------------------------------- */
 
 const memory_manager_t *require_memory_manager(const memory_manager_t *memory_manager);
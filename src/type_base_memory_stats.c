@@ -0,0 +1,943 @@
+/*
+ * opencurry: type_base_memory_stats.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* stdlib.h:
+ *   - qsort
+ */
+#include <stdlib.h>
+
+/* string.h:
+ *   - memcpy
+ *   - memset
+ */
+#include <string.h>
+
+#include "base.h"
+#include "type_base_prim.h"
+#include "type_base_memory_manager.h"
+#include "type_base_memory_tracker.h"
+#include "type_base_memory_stats.h"
+#include "type_base_hash_table.h"
+
+#include "bits.h"
+#include "util.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_getspecific
+ *   - pthread_key_create
+ *   - pthread_key_delete
+ *   - pthread_mutex_destroy
+ *   - pthread_mutex_init
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_unlock
+ *   - pthread_setspecific
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Blocks.                                                          */
+/* ---------------------------------------------------------------- */
+
+/* Precedes every allocation; the union keeps the payload aligned. */
+typedef union memory_stats_header_u memory_stats_header_t;
+union memory_stats_header_u
+{
+  struct
+  {
+    size_t      size;
+
+    const char *file;
+    int         line;
+  } info;
+
+  void        *align_ptr;
+  long         align_long;
+  long double  align_ldouble;
+};
+
+#define STATS_HEADER(ptr) \
+  (((memory_stats_header_t *) (ptr)) - 1)
+#define STATS_PAYLOAD(header) \
+  ((void *) (((memory_stats_header_t *) (header)) + 1))
+
+#if POSIX_PARALLEL
+#  define STATS_LOCK(stats)   pthread_mutex_lock  (&(stats)->lock)
+#  define STATS_UNLOCK(stats) pthread_mutex_unlock(&(stats)->lock)
+#else  /* #if POSIX_PARALLEL */
+#  define STATS_LOCK(stats)
+#  define STATS_UNLOCK(stats)
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Owned blocks.                                                    */
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+#  define OWNED_LOCK(owned)   pthread_mutex_lock  (&(owned)->lock)
+#  define OWNED_UNLOCK(owned) pthread_mutex_unlock(&(owned)->lock)
+#else  /* #if POSIX_PARALLEL */
+#  define OWNED_LOCK(owned)
+#  define OWNED_UNLOCK(owned)
+#endif /* #if POSIX_PARALLEL */
+
+static memory_stats_owned_t *memory_stats_owned(memory_stats_t *stats, const void *ptr)
+{
+  /* Not "hash_mix", which the shard's table indexes by. */
+  return &stats->owned[((size_t) ptr / sizeof(memory_stats_header_t)) % MEMORY_STATS_OWNED_SHARDS];
+}
+
+/* Record "ptr" as allocated by "stats"; returns 0 on success. */
+static int memory_stats_own(memory_stats_t *stats, const void *ptr)
+{
+  memory_stats_owned_t *owned = memory_stats_owned(stats, ptr);
+  void                **value;
+
+  OWNED_LOCK(owned);
+  {
+    value = hash_table_insert(&owned->blocks, ptr, NULL);
+  }
+  OWNED_UNLOCK(owned);
+
+  return value ? 0 : -1;
+}
+
+/* Whether "stats" allocated "ptr". */
+static int memory_stats_owns(memory_stats_t *stats, const void *ptr)
+{
+  memory_stats_owned_t *owned = memory_stats_owned(stats, ptr);
+  int                   found;
+
+  OWNED_LOCK(owned);
+  {
+    found = hash_table_contains(&owned->blocks, ptr);
+  }
+  OWNED_UNLOCK(owned);
+
+  return found;
+}
+
+/* Forget "ptr", returning whether "stats" allocated it. */
+static int memory_stats_disown(memory_stats_t *stats, const void *ptr)
+{
+  memory_stats_owned_t *owned = memory_stats_owned(stats, ptr);
+  int                   removed;
+
+  OWNED_LOCK(owned);
+  {
+    removed = hash_table_remove(&owned->blocks, ptr, NULL);
+  }
+  OWNED_UNLOCK(owned);
+
+  return removed;
+}
+
+/* ---------------------------------------------------------------- */
+/* Counters.                                                        */
+/* ---------------------------------------------------------------- */
+
+size_t memory_stats_histogram_bucket(size_t size)
+{
+  size_t bucket;
+
+  for (bucket = 0; size; ++bucket)
+    size >>= 1;
+
+  return bucket;
+}
+
+static void memory_stats_counters_clear(memory_stats_counters_t *counters)
+{
+  memory_stats_counters_t *next       = counters->next;
+  void                    *owner      = counters->owner;
+  unsigned long            generation = counters->generation;
+
+  memset(counters, 0, sizeof(*counters));
+
+  counters->next       = next;
+  counters->owner      = owner;
+  counters->generation = generation;
+}
+
+/*
+ * Find the entry for a call site, adding it if "add" is set and there is
+ * room.
+ *
+ * The table is open-addressed and kept at most 3/4 full.
+ */
+static memory_stats_site_t *memory_stats_site(memory_stats_counters_t *counters, const char *file, int line, int add)
+{
+  size_t hash;
+  size_t i;
+
+  hash = (size_t) file ^ ((size_t) line * 2654435761UL);
+  hash ^= hash >> 7;
+
+  for (i = 0; i < MEMORY_STATS_NUM_SITES; ++i)
+  {
+    memory_stats_site_t *site;
+
+    site = &counters->sites[(hash + i) % MEMORY_STATS_NUM_SITES];
+
+    if (site->file == file && site->line == line)
+      return site;
+
+    if (!site->file)
+    {
+      if (!add || counters->sites_num >= MEMORY_STATS_NUM_SITES / 4 * 3)
+        return NULL;
+
+      site->file = file;
+      site->line = line;
+      ++counters->sites_num;
+
+      return site;
+    }
+  }
+
+  return NULL;
+}
+
+static void memory_stats_count_alloc(memory_stats_counters_t *counters, size_t size, const char *file, int line)
+{
+  ++counters->allocs;
+  counters->total_bytes += size;
+  counters->live_bytes  += (long) size;
+  if (counters->live_bytes > counters->peak_bytes)
+    counters->peak_bytes = counters->live_bytes;
+
+  ++counters->histogram[memory_stats_histogram_bucket(size)];
+
+  if (file)
+  {
+    memory_stats_site_t *site = memory_stats_site(counters, file, line, 1);
+
+    if (!site)
+    {
+      ++counters->sites_dropped;
+    }
+    else
+    {
+      ++site->allocs;
+      site->total_bytes += size;
+      site->live_bytes  += (long) size;
+    }
+  }
+}
+
+static void memory_stats_count_free(memory_stats_counters_t *counters, size_t size, const char *file, int line)
+{
+  ++counters->frees;
+  counters->live_bytes -= (long) size;
+
+  if (file)
+  {
+    memory_stats_site_t *site = memory_stats_site(counters, file, line, 1);
+
+    if (site)
+    {
+      ++site->frees;
+      site->live_bytes -= (long) size;
+    }
+  }
+}
+
+/*
+ * Add "src"'s counts to "dest".
+ *
+ * With "live_only", "src" predates a reset, and only its live bytes count.
+ */
+static void memory_stats_counters_merge(memory_stats_counters_t *dest, const memory_stats_counters_t *src, int live_only)
+{
+  size_t i;
+
+  if (live_only)
+  {
+    dest->live_bytes += src->live_bytes;
+    dest->peak_bytes += src->live_bytes;
+
+    for (i = 0; i < MEMORY_STATS_NUM_SITES; ++i)
+    {
+      const memory_stats_site_t *src_site = &src->sites[i];
+      memory_stats_site_t       *dest_site;
+
+      if (!src_site->file)
+        continue;
+
+      dest_site = memory_stats_site(dest, src_site->file, src_site->line, 1);
+      if (dest_site)
+        dest_site->live_bytes += src_site->live_bytes;
+    }
+
+    return;
+  }
+
+  dest->allocs        += src->allocs;
+  dest->frees         += src->frees;
+  dest->reallocs      += src->reallocs;
+  dest->failures      += src->failures;
+
+  dest->live_bytes    += src->live_bytes;
+  dest->peak_bytes    += src->peak_bytes;
+  dest->total_bytes   += src->total_bytes;
+
+  for (i = 0; i < MEMORY_STATS_HISTOGRAM_SIZE; ++i)
+    dest->histogram[i] += src->histogram[i];
+
+  dest->sites_dropped += src->sites_dropped;
+
+  for (i = 0; i < MEMORY_STATS_NUM_SITES; ++i)
+  {
+    const memory_stats_site_t *src_site = &src->sites[i];
+    memory_stats_site_t       *dest_site;
+
+    if (!src_site->file)
+      continue;
+
+    dest_site = memory_stats_site(dest, src_site->file, src_site->line, 1);
+    if (!dest_site)
+    {
+      dest->sites_dropped += src_site->allocs;
+      continue;
+    }
+
+    dest_site->allocs      += src_site->allocs;
+    dest_site->frees       += src_site->frees;
+    dest_site->live_bytes  += src_site->live_bytes;
+    dest_site->total_bytes += src_site->total_bytes;
+  }
+}
+
+/* Zero every counter except live bytes, keeping the sites. */
+static void memory_stats_counters_reset(memory_stats_counters_t *counters)
+{
+  long   live_bytes;
+  size_t i;
+
+  memory_stats_site_t sites[MEMORY_STATS_NUM_SITES];
+  size_t              sites_num;
+
+  live_bytes = counters->live_bytes;
+  sites_num  = counters->sites_num;
+  memcpy(sites, counters->sites, sizeof(sites));
+
+  memory_stats_counters_clear(counters);
+
+  counters->live_bytes = live_bytes;
+  counters->peak_bytes = live_bytes;
+
+  /* Keep the sites, with only their live bytes. */
+  counters->sites_num = sites_num;
+  for (i = 0; i < MEMORY_STATS_NUM_SITES; ++i)
+  {
+    counters->sites[i].file       = sites[i].file;
+    counters->sites[i].line       = sites[i].line;
+    counters->sites[i].live_bytes = sites[i].live_bytes;
+  }
+}
+
+#if POSIX_PARALLEL
+/* Whether "counters" have not been reset since the last "memory_stats_reset". */
+static int memory_stats_counters_stale(memory_stats_t *stats, memory_stats_counters_t *counters)
+{
+  return ATOMIC_LOAD(&counters->generation) != ATOMIC_LOAD(&stats->generation);
+}
+
+/* Thread exit: fold the thread's counters into "retired". */
+static void memory_stats_local_destroy(void *local_raw)
+{
+  memory_stats_counters_t  *local = local_raw;
+  memory_stats_t           *stats;
+  memory_stats_counters_t **link;
+
+  if (!local)
+    return;
+
+  stats = local->owner;
+
+  STATS_LOCK(stats);
+  {
+    for (link = &stats->threads; *link; link = &(*link)->next)
+    {
+      if (*link == local)
+      {
+        *link = local->next;
+        break;
+      }
+    }
+
+    memory_stats_counters_merge(&stats->retired, local, memory_stats_counters_stale(stats, local));
+  }
+  STATS_UNLOCK(stats);
+
+  memory_manager_mfree(&stats->inner, local);
+}
+#endif /* #if POSIX_PARALLEL */
+
+/* The calling thread's counters, or NULL if they could not be allocated. */
+static memory_stats_counters_t *memory_stats_local(memory_stats_t *stats)
+{
+#if POSIX_PARALLEL
+  memory_stats_counters_t *local;
+
+  local = (memory_stats_counters_t *) pthread_getspecific(stats->local_key);
+  if (local)
+  {
+    /* Only this thread writes its counters, so it resets them itself. */
+    if (memory_stats_counters_stale(stats, local))
+    {
+      memory_stats_counters_reset(local);
+      ATOMIC_STORE(&local->generation, ATOMIC_LOAD(&stats->generation));
+    }
+
+    return local;
+  }
+
+  local = memory_manager_mmalloc(&stats->inner, sizeof(*local));
+  if (!local)
+    return NULL;
+
+  memset(local, 0, sizeof(*local));
+  local->owner      = stats;
+  local->generation = ATOMIC_LOAD(&stats->generation);
+
+  if (pthread_setspecific(stats->local_key, local) != 0)
+  {
+    memory_manager_mfree(&stats->inner, local);
+    return NULL;
+  }
+
+  STATS_LOCK(stats);
+  {
+    local->next    = stats->threads;
+    stats->threads = local;
+  }
+  STATS_UNLOCK(stats);
+
+  return local;
+#else  /* #if POSIX_PARALLEL */
+  return &stats->retired;
+#endif /* #if POSIX_PARALLEL */
+}
+
+/* ---------------------------------------------------------------- */
+/* memory_stats_t                                                   */
+/* ---------------------------------------------------------------- */
+
+memory_stats_t *memory_stats_init(memory_stats_t *stats, const memory_manager_t *inner)
+{
+  size_t i;
+
+  if (!stats)
+    return NULL;
+
+  /* Without functions, "inner" would allocate with "malloc_manager", but */
+  /* neither zero nor reallocate; use "malloc_manager" for all of it.     */
+  inner = require_memory_manager(inner);
+  if (!inner->mmalloc || !inner->mfree)
+    inner = &malloc_manager;
+
+  memory_manager_copy(&stats->inner, inner);
+
+  memset(&stats->retired, 0, sizeof(stats->retired));
+  stats->retired.owner = stats;
+
+  stats->generation  = 0;
+  stats->track_owned = 0;
+
+#if POSIX_PARALLEL
+  stats->threads = NULL;
+
+  if (pthread_mutex_init(&stats->lock, NULL) != 0)
+    return NULL;
+
+  if (pthread_key_create(&stats->local_key, memory_stats_local_destroy) != 0)
+  {
+    pthread_mutex_destroy(&stats->lock);
+    return NULL;
+  }
+#endif /* #if POSIX_PARALLEL */
+
+  for (i = 0; i < MEMORY_STATS_OWNED_SHARDS; ++i)
+  {
+    hash_table_init(&stats->owned[i].blocks, NULL, 0, &stats->inner);
+
+#if POSIX_PARALLEL
+    pthread_mutex_init(&stats->owned[i].lock, NULL);
+#endif /* #if POSIX_PARALLEL */
+  }
+
+  stats->initialized = 1;
+
+  return stats;
+}
+
+size_t memory_stats_deinit(memory_stats_t *stats)
+{
+  size_t num_freed;
+  size_t i;
+
+  if (!stats || !stats->initialized)
+    return 0;
+
+  num_freed = 0;
+
+  for (i = 0; i < MEMORY_STATS_OWNED_SHARDS; ++i)
+  {
+    num_freed += hash_table_deinit(&stats->owned[i].blocks);
+
+#if POSIX_PARALLEL
+    pthread_mutex_destroy(&stats->owned[i].lock);
+#endif /* #if POSIX_PARALLEL */
+  }
+
+#if POSIX_PARALLEL
+  pthread_key_delete(stats->local_key);
+
+  while (stats->threads)
+  {
+    memory_stats_counters_t *local = stats->threads;
+
+    stats->threads = local->next;
+
+    num_freed += memory_manager_mfree(&stats->inner, local);
+  }
+
+  pthread_mutex_destroy(&stats->lock);
+#endif /* #if POSIX_PARALLEL */
+
+  stats->initialized = 0;
+
+  return num_freed;
+}
+
+void memory_stats_reset(memory_stats_t *stats)
+{
+  if (!stats || !stats->initialized)
+    return;
+
+  STATS_LOCK(stats);
+  {
+    /* Only written under the lock, or by the only thread. */
+    memory_stats_counters_reset(&stats->retired);
+
+#if POSIX_PARALLEL
+    /* Other threads' counters are theirs to write; see "memory_stats_local". */
+    ATOMIC_STORE(&stats->generation, stats->generation + 1);
+#endif /* #if POSIX_PARALLEL */
+  }
+  STATS_UNLOCK(stats);
+}
+
+/* ---------------------------------------------------------------- */
+
+void *memory_stats_mmalloc(memory_stats_t *stats, size_t size, const char *file, int line)
+{
+  memory_stats_header_t   *header;
+  memory_stats_counters_t *local;
+
+#if ERROR_CHECKING
+  if (!stats)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  local = memory_stats_local(stats);
+
+  header = memory_manager_mmalloc(&stats->inner, sizeof(*header) + size);
+  if (!header)
+  {
+    if (local)
+      ++local->failures;
+
+    return NULL;
+  }
+
+  if (stats->track_owned && memory_stats_own(stats, STATS_PAYLOAD(header)) != 0)
+  {
+    memory_manager_mfree(&stats->inner, header);
+
+    if (local)
+      ++local->failures;
+
+    return NULL;
+  }
+
+  header->info.size = size;
+  header->info.file = file;
+  header->info.line = line;
+
+  if (local)
+    memory_stats_count_alloc(local, size, file, line);
+
+  return STATS_PAYLOAD(header);
+}
+
+size_t memory_stats_mfree(memory_stats_t *stats, void *ptr)
+{
+  memory_stats_header_t   *header;
+  memory_stats_counters_t *local;
+
+#if ERROR_CHECKING
+  if (!stats)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  /* As "free" does, NULL is a no-op. */
+  if (!ptr)
+    return 0;
+
+  /* Allocated before attaching. */
+  if (stats->track_owned && !memory_stats_disown(stats, ptr))
+    return memory_manager_mfree(&stats->inner, ptr);
+
+  header = STATS_HEADER(ptr);
+
+  local = memory_stats_local(stats);
+  if (local)
+    memory_stats_count_free(local, header->info.size, header->info.file, header->info.line);
+
+  return memory_manager_mfree(&stats->inner, header);
+}
+
+void *memory_stats_mrealloc(memory_stats_t *stats, void *ptr, size_t size, const char *file, int line)
+{
+  memory_stats_header_t   *header;
+  memory_stats_counters_t *local;
+  size_t                   old_size;
+  const char              *old_file;
+  int                      old_line;
+
+  if (!ptr)
+    return memory_stats_mmalloc(stats, size, file, line);
+
+#if ERROR_CHECKING
+  if (!stats)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  /* Allocated before attaching. */
+  if (stats->track_owned && !memory_stats_owns(stats, ptr))
+    return memory_manager_mrealloc(&stats->inner, ptr, size);
+
+  local = memory_stats_local(stats);
+
+  header   = STATS_HEADER(ptr);
+  old_size = header->info.size;
+  old_file = header->info.file;
+  old_line = header->info.line;
+
+  if (!stats->track_owned)
+  {
+    header = memory_manager_mrealloc(&stats->inner, header, sizeof(*header) + size);
+  }
+  else
+  {
+    /* Move the block by hand, so that recording its new address can fail */
+    /* before the old block is gone.                                      */
+    memory_stats_header_t *moved;
+
+    moved = memory_manager_mmalloc(&stats->inner, sizeof(*moved) + size);
+    if (moved && memory_stats_own(stats, STATS_PAYLOAD(moved)) != 0)
+    {
+      memory_manager_mfree(&stats->inner, moved);
+      moved = NULL;
+    }
+
+    if (moved)
+    {
+      memory_stats_disown(stats, ptr);
+      memcpy(moved, header, sizeof(*moved) + (old_size < size ? old_size : size));
+      memory_manager_mfree(&stats->inner, header);
+    }
+
+    header = moved;
+  }
+  if (!header)
+  {
+    if (local)
+      ++local->failures;
+
+    return NULL;
+  }
+
+  /* Without a new site, the block stays attributed to the old one. */
+  if (!file)
+  {
+    file = old_file;
+    line = old_line;
+  }
+
+  header->info.size = size;
+  header->info.file = file;
+  header->info.line = line;
+
+  if (local)
+  {
+    /* Count as a free of the old block and an allocation of the new one, */
+    /* without disturbing the allocation and free totals.                 */
+    memory_stats_count_free (local, old_size, old_file, old_line);
+    memory_stats_count_alloc(local, size,     file,     line);
+
+    --local->allocs;
+    --local->frees;
+    ++local->reallocs;
+  }
+
+  return STATS_PAYLOAD(header);
+}
+
+void *memory_stats_mcalloc(memory_stats_t *stats, size_t nmemb, size_t size, const char *file, int line)
+{
+  void *mem;
+
+  if (size > 0 && nmemb > ((size_t) (-1)) / size)
+    return NULL;
+
+  mem = memory_stats_mmalloc(stats, nmemb * size, file, line);
+  if (!mem)
+    return NULL;
+
+  memset(mem, 0, nmemb * size);
+
+  return mem;
+}
+
+/* ---------------------------------------------------------------- */
+
+/* Merge every thread's counters into "merged". */
+static void memory_stats_merge_all(memory_stats_t *stats, memory_stats_counters_t *merged)
+{
+  memset(merged, 0, sizeof(*merged));
+
+  STATS_LOCK(stats);
+  {
+#if POSIX_PARALLEL
+    memory_stats_counters_t *local;
+#endif /* #if POSIX_PARALLEL */
+
+    memory_stats_counters_merge(merged, &stats->retired, 0);
+
+#if POSIX_PARALLEL
+    for (local = stats->threads; local; local = local->next)
+      memory_stats_counters_merge(merged, local, memory_stats_counters_stale(stats, local));
+#endif /* #if POSIX_PARALLEL */
+  }
+  STATS_UNLOCK(stats);
+}
+
+memory_stats_snapshot_t *memory_stats_read(memory_stats_t *stats, memory_stats_snapshot_t *out)
+{
+  memory_stats_counters_t merged;
+  size_t                  i;
+
+  if (!stats || !stats->initialized || !out)
+    return NULL;
+
+  memory_stats_merge_all(stats, &merged);
+
+  out->allocs        = merged.allocs;
+  out->frees         = merged.frees;
+  out->reallocs      = merged.reallocs;
+  out->failures      = merged.failures;
+
+  out->live_bytes    = merged.live_bytes;
+  out->peak_bytes    = merged.peak_bytes;
+  out->total_bytes   = merged.total_bytes;
+
+  for (i = 0; i < MEMORY_STATS_HISTOGRAM_SIZE; ++i)
+    out->histogram[i] = merged.histogram[i];
+
+  out->sites_num     = merged.sites_num;
+  out->sites_dropped = merged.sites_dropped;
+
+  return out;
+}
+
+/* Largest live bytes first. */
+static int memory_stats_site_cmp(const void *a_raw, const void *b_raw)
+{
+  const memory_stats_site_t *a = a_raw;
+  const memory_stats_site_t *b = b_raw;
+
+  if (a->live_bytes > b->live_bytes)
+    return -1;
+  if (a->live_bytes < b->live_bytes)
+    return 1;
+
+  return cmp_ulong(b->total_bytes, a->total_bytes);
+}
+
+size_t memory_stats_read_sites(memory_stats_t *stats, memory_stats_site_t *out, size_t out_num)
+{
+  memory_stats_counters_t merged;
+  size_t                  num;
+  size_t                  i;
+
+  if (!stats || !stats->initialized || !out)
+    return 0;
+
+  memory_stats_merge_all(stats, &merged);
+
+  /* Compact the used entries to the front. */
+  num = 0;
+  for (i = 0; i < MEMORY_STATS_NUM_SITES; ++i)
+    if (merged.sites[i].file)
+      merged.sites[num++] = merged.sites[i];
+
+  qsort(merged.sites, num, sizeof(merged.sites[0]), memory_stats_site_cmp);
+
+  if (num > out_num)
+    num = out_num;
+
+  for (i = 0; i < num; ++i)
+    out[i] = merged.sites[i];
+
+  return num;
+}
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+static void   *memory_stats_manager_mmalloc (const memory_manager_t *self, size_t  size)
+  { return memory_stats_mmalloc (self->state, size, NULL, 0); }
+static size_t  memory_stats_manager_mfree   (const memory_manager_t *self, void   *ptr)
+  { return memory_stats_mfree   (self->state, ptr); }
+static void   *memory_stats_manager_mrealloc(const memory_manager_t *self, void   *ptr,   size_t size)
+  { return memory_stats_mrealloc(self->state, ptr,   size, NULL, 0); }
+static void   *memory_stats_manager_mcalloc (const memory_manager_t *self, size_t  nmemb, size_t size)
+  { return memory_stats_mcalloc (self->state, nmemb, size, NULL, 0); }
+
+memory_manager_t *memory_stats_manager_init(memory_manager_t *dest, memory_stats_t *stats)
+{
+  if (!stats || !stats->initialized)
+    return NULL;
+
+  dest =
+    memory_manager_init
+      ( dest
+
+      , memory_stats_manager_mmalloc
+      , memory_stats_manager_mfree
+      , memory_stats_manager_mrealloc
+      , memory_stats_manager_mcalloc
+      );
+  if (!dest)
+    return NULL;
+
+  dest->on_oom     = stats->inner.on_oom;
+  dest->on_err     = stats->inner.on_err;
+
+  dest->state      = (void *) stats;
+  dest->state_size = sizeof(*stats);
+
+  return dest;
+}
+
+memory_stats_t *memory_manager_stats(const memory_manager_t *memory_manager)
+{
+  if (!memory_manager || memory_manager->mmalloc != memory_stats_manager_mmalloc)
+    return NULL;
+
+  return (memory_stats_t *) memory_manager->state;
+}
+
+memory_tracker_t *memory_stats_attach_tracker(memory_stats_t *stats, memory_tracker_t *tracker)
+{
+  if (!stats || !tracker)
+    return NULL;
+
+  if (!memory_stats_init(stats, MEMORY_TRACKER_CMANAGER(tracker)))
+    return NULL;
+
+  /* Blocks allocated before now lack a stats header. */
+  stats->track_owned =
+    (  tracker->byte_allocations
+    || tracker->tval_allocations
+    || tracker->manual_allocations
+    || tracker->dependency_graph
+    );
+
+  if (!memory_stats_manager_init(&tracker->memory_manager, stats))
+    return NULL;
+
+  return tracker;
+}
+
+/* ---------------------------------------------------------------- */
+/* Call sites.                                                      */
+/* ---------------------------------------------------------------- */
+
+void *memory_manager_mmalloc_at(const memory_manager_t *memory_manager, size_t size, const char *file, int line)
+{
+  memory_stats_t *stats;
+  void           *mem;
+
+  stats = memory_manager_stats(memory_manager);
+  if (!stats)
+    return memory_manager_mmalloc(memory_manager, size);
+
+  mem = memory_stats_mmalloc(stats, size, file, line);
+  if (!mem)
+    memory_manager_on_oom(memory_manager, size);
+
+  return mem;
+}
+
+void *memory_manager_mrealloc_at(const memory_manager_t *memory_manager, void *ptr, size_t size, const char *file, int line)
+{
+  memory_stats_t *stats;
+
+  stats = memory_manager_stats(memory_manager);
+  if (!stats)
+    return memory_manager_mrealloc(memory_manager, ptr, size);
+
+  return memory_stats_mrealloc(stats, ptr, size, file, line);
+}
+
+void *memory_manager_mcalloc_at(const memory_manager_t *memory_manager, size_t nmemb, size_t size, const char *file, int line)
+{
+  memory_stats_t *stats;
+
+  stats = memory_manager_stats(memory_manager);
+  if (!stats)
+    return memory_manager_mcalloc(memory_manager, nmemb, size);
+
+  return memory_stats_mcalloc(stats, nmemb, size, file, line);
+}
@@ -0,0 +1,296 @@
+/*
+ * opencurry: type_base_memory_stats.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_memory_stats.h
+ * ------
+ *
+ * Statistics-collecting memory manager.
+ *
+ * A "memory_stats_t" wraps an inner memory manager, forwarding every request
+ * to it, while counting allocations, frees, live and peak bytes, and a log2
+ * histogram of requested sizes.  Allocations made through the
+ * "MEMORY_MANAGER_MMALLOC_SITE" family of macros are additionally attributed
+ * to their call site.
+ *
+ * Each allocation is preceded by a small header recording its size and call
+ * site, so the stats manager must only free what it allocated itself.  When
+ * it is attached to a memory tracker that has already allocated, such as
+ * "global_memory_tracker", it also records its own blocks in a set, and
+ * passes any other block to the inner manager as is; this costs a lock, one
+ * of "MEMORY_STATS_OWNED_SHARDS" chosen by address, and a hash table
+ * operation for each allocation and free.
+ *
+ * Under POSIX_PARALLEL, counters are kept per thread and merged on read, so
+ * counting costs no synchronization.  Reads made while other threads are
+ * allocating are approximate.
+ */
+
+#ifndef TYPE_BASE_MEMORY_STATS_H
+#define TYPE_BASE_MEMORY_STATS_H
+/* limits.h:
+ *   - CHAR_BIT
+ */
+#include <limits.h>
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_key_t
+ *   - pthread_mutex_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_memory_manager.h"
+#include "type_base_memory_tracker.h"
+#include "type_base_hash_table.h"
+
+/* ---------------------------------------------------------------- */
+/* Counters.                                                        */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Bucket 0 counts requests of 0 bytes; bucket "i" counts requests of
+ * [2^(i-1), 2^i) bytes.
+ */
+#define MEMORY_STATS_HISTOGRAM_SIZE (sizeof(size_t) * CHAR_BIT + 1)
+
+/* Maximum number of distinct call sites counted per thread. */
+#define MEMORY_STATS_NUM_SITES 256
+
+typedef struct memory_stats_site_s memory_stats_site_t;
+struct memory_stats_site_s
+{
+  /* NULL for an unused entry. */
+  const char    *file;
+  int            line;
+
+  unsigned long  allocs;
+  unsigned long  frees;
+
+  /* Signed: blocks may be freed by a different thread than allocated them. */
+  long           live_bytes;
+  unsigned long  total_bytes;
+};
+
+typedef struct memory_stats_counters_s memory_stats_counters_t;
+struct memory_stats_counters_s
+{
+  unsigned long allocs;
+  unsigned long frees;
+  unsigned long reallocs;
+  unsigned long failures;
+
+  long          live_bytes;
+  long          peak_bytes;
+  unsigned long total_bytes;
+
+  unsigned long histogram[MEMORY_STATS_HISTOGRAM_SIZE];
+
+  memory_stats_site_t sites[MEMORY_STATS_NUM_SITES];
+  size_t              sites_num;
+
+  /* Allocations whose site did not fit in "sites". */
+  unsigned long       sites_dropped;
+
+  /* Registry of per-thread counters. */
+  memory_stats_counters_t *next;
+  void                    *owner;
+
+  /* The "memory_stats_reset" these counts follow. */
+  unsigned long            generation;
+};
+
+/* A merged view of the counters. */
+typedef struct memory_stats_snapshot_s memory_stats_snapshot_t;
+struct memory_stats_snapshot_s
+{
+  unsigned long allocs;
+  unsigned long frees;
+  unsigned long reallocs;
+  unsigned long failures;
+
+  long          live_bytes;
+
+  /*
+   * Exact when blocks are freed by the thread that allocated them; otherwise
+   * an upper bound, the sum of per-thread peaks.
+   */
+  long          peak_bytes;
+  unsigned long total_bytes;
+
+  unsigned long histogram[MEMORY_STATS_HISTOGRAM_SIZE];
+
+  size_t        sites_num;
+  unsigned long sites_dropped;
+};
+
+/* ---------------------------------------------------------------- */
+/* memory_stats_t                                                   */
+/* ---------------------------------------------------------------- */
+
+/* Blocks allocated by a stats manager, by address; see "track_owned". */
+#define MEMORY_STATS_OWNED_SHARDS 16
+
+typedef struct memory_stats_owned_s memory_stats_owned_t;
+struct memory_stats_owned_s
+{
+  hash_table_t             blocks;
+
+#if POSIX_PARALLEL
+  pthread_mutex_t          lock;
+#endif /* #if POSIX_PARALLEL */
+};
+
+typedef struct memory_stats_s memory_stats_t;
+struct memory_stats_s
+{
+  memory_manager_t inner;
+
+  /* Counters of exited threads, or the only counters without POSIX_PARALLEL. */
+  memory_stats_counters_t  retired;
+
+#if POSIX_PARALLEL
+  memory_stats_counters_t *threads;
+
+  pthread_key_t            local_key;
+  pthread_mutex_t          lock;
+#endif /* #if POSIX_PARALLEL */
+
+  /* Incremented by "memory_stats_reset".  Each thread resets its own
+   * counters when it next counts; until then, reads treat them as reset.
+   */
+  unsigned long            generation;
+
+  /* Whether blocks not in "owned" were allocated by "inner" alone. */
+  int                      track_owned;
+  memory_stats_owned_t     owned[MEMORY_STATS_OWNED_SHARDS];
+
+  int initialized;
+};
+
+/* If "inner" is NULL, "default_memory_manager" is used. */
+memory_stats_t *memory_stats_init(memory_stats_t *stats, const memory_manager_t *inner);
+
+/*
+ * Release per-thread counters and the set of owned blocks, returning the
+ * number of blocks freed.
+ *
+ * Allocations still live are not freed; they remain valid allocations of the
+ * inner manager, offset by the stats header.
+ */
+size_t memory_stats_deinit(memory_stats_t *stats);
+
+/*
+ * Zero every counter except live bytes.
+ *
+ * Other threads' counters are not written: each thread resets its own the
+ * next time it counts, and reads meanwhile only include their live bytes.
+ */
+void memory_stats_reset(memory_stats_t *stats);
+
+/* ---------------------------------------------------------------- */
+
+void   *memory_stats_mmalloc (memory_stats_t *stats, size_t  size,                const char *file, int line);
+size_t  memory_stats_mfree   (memory_stats_t *stats, void   *ptr);
+void   *memory_stats_mrealloc(memory_stats_t *stats, void   *ptr,   size_t size,  const char *file, int line);
+void   *memory_stats_mcalloc (memory_stats_t *stats, size_t  nmemb, size_t size,  const char *file, int line);
+
+/* ---------------------------------------------------------------- */
+
+/* Merge every thread's counters. */
+memory_stats_snapshot_t *memory_stats_read(memory_stats_t *stats, memory_stats_snapshot_t *out);
+
+/*
+ * Merge every thread's call site counters into "out", ordered by live bytes,
+ * largest first.
+ *
+ * Returns the number of sites written, at most "out_num".
+ */
+size_t memory_stats_read_sites(memory_stats_t *stats, memory_stats_site_t *out, size_t out_num);
+
+/* "size" -> histogram bucket. */
+size_t memory_stats_histogram_bucket(size_t size);
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+memory_manager_t *memory_stats_manager_init(memory_manager_t *dest, memory_stats_t *stats);
+
+/* Is "memory_manager" a stats manager?  If so, return its stats. */
+memory_stats_t *memory_manager_stats(const memory_manager_t *memory_manager);
+
+/*
+ * Initialize "stats" and interpose it between "tracker" and its memory
+ * manager.
+ *
+ * If "tracker" has already allocated, "stats" tracks which blocks it owns,
+ * and blocks allocated before attaching are neither counted nor given a
+ * header.  Attach before other threads use "tracker".
+ */
+memory_tracker_t *memory_stats_attach_tracker(memory_stats_t *stats, memory_tracker_t *tracker);
+
+/* ---------------------------------------------------------------- */
+/* Call sites.                                                      */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Like "memory_manager_mmalloc" et al., but if "memory_manager" is a stats
+ * manager, attribute the allocation to "file" and "line".
+ */
+void *memory_manager_mmalloc_at (const memory_manager_t *memory_manager, size_t size,                const char *file, int line);
+void *memory_manager_mrealloc_at(const memory_manager_t *memory_manager, void  *ptr,   size_t size,  const char *file, int line);
+void *memory_manager_mcalloc_at (const memory_manager_t *memory_manager, size_t nmemb, size_t size,  const char *file, int line);
+
+#define MEMORY_MANAGER_MMALLOC_SITE( memory_manager, size) \
+  memory_manager_mmalloc_at ((memory_manager), (size), __FILE__, __LINE__)
+#define MEMORY_MANAGER_MREALLOC_SITE(memory_manager, ptr, size) \
+  memory_manager_mrealloc_at((memory_manager), (ptr), (size), __FILE__, __LINE__)
+#define MEMORY_MANAGER_MCALLOC_SITE( memory_manager, nmemb, size) \
+  memory_manager_mcalloc_at ((memory_manager), (nmemb), (size), __FILE__, __LINE__)
+
+#endif /* ifndef TYPE_BASE_MEMORY_STATS_H */
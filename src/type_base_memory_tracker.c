@@ -36,7 +36,40 @@
  */
 #include <stddef.h>
 
+/* limits.h:
+ *   - CHAR_BIT
+ */
+#include <limits.h>
+
+/* string.h:
+ *   - memcpy
+ *   - memset
+ */
+#include <string.h>
+
 #include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_cond_broadcast
+ *   - pthread_cond_signal
+ *   - pthread_cond_t
+ *   - pthread_cond_wait
+ *   - pthread_create
+ *   - pthread_getspecific
+ *   - pthread_join
+ *   - pthread_key_create
+ *   - pthread_key_t
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_t
+ *   - pthread_mutex_unlock
+ *   - pthread_once
+ *   - pthread_once_t
+ *   - pthread_setspecific
+ *   - pthread_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
 #include "type_base_prim.h"
 #include "type_base_memory_tracker.h"
 
@@ -44,6 +77,8 @@
 #include "type_base_tval.h"
 #include "type_base_memory_manager.h"
 #include "type_base_type.h"
+#include "type_base_epoch.h"
+#include "type_base_compare.h"
 
 #include "cpp.h"
 #include "util.h"
@@ -303,6 +338,12 @@ size_t alloc_dep_manual(size_t index)
 /* Memory and value allocation management.                          */
 /* ---------------------------------------------------------------- */
 
+static size_t memory_tracker_free_intrusive    (memory_tracker_t *tracker);
+static size_t memory_tracker_rollback_intrusive(memory_tracker_t *tracker, size_t serial);
+
+static void   dependency_graph_init  (dependency_graph_t *graph);
+static size_t dependency_graph_deinit(dependency_graph_t *graph, const memory_manager_t *manager);
+
 /* memory_tracker type. */
 
 const type_t *memory_tracker_type(void)
@@ -313,6 +354,8 @@ static size_t               memory_tracker_type_size       (const type_t *self,
 static const struct_info_t *memory_tracker_type_is_struct  (const type_t *self);
 static const tval          *memory_tracker_type_has_default(const type_t *self);
 
+static const struct type_registry_entry_s *memory_tracker_type_registry_entry = NULL;
+
 const type_t memory_tracker_type_def =
   { type_type
 
@@ -350,6 +393,10 @@ const type_t memory_tracker_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &memory_tracker_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -361,30 +408,104 @@ static size_t               memory_tracker_type_size       (const type_t *self,
   { return sizeof(memory_tracker_t); }
 
 DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(memory_tracker)
-static const struct_info_t *memory_tracker_type_is_struct  (const type_t *self)
-  {
-    STRUCT_INFO_BEGIN(memory_tracker);
-
-    /* typed_t type */
-    STRUCT_INFO_RADD(typed_type(), type);
+static field_info_t memory_tracker_fields[] =
+  { /* typed_t type */
+    STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, type,               typed_type_def)
 
     /* memory_manager_t memory_manager; */
-    STRUCT_INFO_RADD(memory_manager_type(), memory_manager);
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, memory_manager,     memory_manager_type_def)
 
     /* void *dynamic_container; */
-    STRUCT_INFO_RADD(objp_type(), dynamic_container);
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, dynamic_container,  objp_type_def)
 
     /* lookup_t *byte_allocations;   */
     /* lookup_t *tval_allocations;   */
     /* lookup_t *manual_allocations; */
     /* lookup_t *dependency_graph;   */
-    STRUCT_INFO_RADD(objp_type(), byte_allocations);
-    STRUCT_INFO_RADD(objp_type(), tval_allocations);
-    STRUCT_INFO_RADD(objp_type(), manual_allocations);
-    STRUCT_INFO_RADD(objp_type(), dependency_graph);
-
-    STRUCT_INFO_DONE();
-  }
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, byte_allocations,   objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, tval_allocations,   objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, manual_allocations, objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, dependency_graph,   objp_type_def)
+
+    /* int      intrusive;        */
+    /* void    *intrusive_list;   */
+    /* void   **intrusive_slots;  */
+    /* size_t   intrusive_num;    */
+    /* size_t   intrusive_size;   */
+    /* size_t   intrusive_serial; */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive,          int_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive_list,     objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive_slots,    objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive_num,      size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive_size,     size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, intrusive_serial,   size_type_def)
+
+    /* size_t                          checkpoints_num;    */
+    /* size_t                         *checkpoint_serials; */
+    /* size_t                          checkpoints_size;   */
+    /* size_t                          checkpoint_serial;  */
+    /* memory_tracker_journal_entry_t *journal;            */
+    /* size_t                          journal_num;        */
+    /* size_t                          journal_size;       */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, checkpoints_num,    size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, checkpoint_serials, objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, checkpoints_size,   size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, checkpoint_serial,  size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, journal,            objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, journal_num,        size_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, journal_size,       size_type_def)
+
+    /* void          *owner_thread;      */
+    /* void volatile *remote_frees;      */
+    /* void volatile *remote_byte_frees; */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, owner_thread,       objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, remote_frees,       objp_type_def)
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, remote_byte_frees,  objp_type_def)
+
+    /* int deferred; */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, deferred,           int_type_def)
+
+    /* int retire; */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, retire,             int_type_def)
+
+    /* size_t shares; */
+  , STATIC_FIELD_INFO(memory_tracker, memory_tracker_t, shares,             size_type_def)
+
+  , FIELD_INFO_TERMINATOR
+  };
+static struct_info_t memory_tracker_struct_info =
+  STATIC_STRUCT_INFO(memory_tracker, memory_tracker_fields);
+STATIC_FIELD_INFO_FIRST  (memory_tracker_t,                     type)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, type,               memory_manager)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, memory_manager,     dynamic_container)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, dynamic_container,  byte_allocations)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, byte_allocations,   tval_allocations)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, tval_allocations,   manual_allocations)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, manual_allocations, dependency_graph)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, dependency_graph,   intrusive)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive,          intrusive_list)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive_list,     intrusive_slots)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive_slots,    intrusive_num)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive_num,      intrusive_size)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive_size,     intrusive_serial)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, intrusive_serial,   checkpoints_num)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, checkpoints_num,    checkpoint_serials)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, checkpoint_serials, checkpoints_size)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, checkpoints_size,   checkpoint_serial)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, checkpoint_serial,  journal)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, journal,            journal_num)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, journal_num,        journal_size)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, journal_size,       owner_thread)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, owner_thread,       remote_frees)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, remote_frees,       remote_byte_frees)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, remote_byte_frees,  deferred)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, deferred,           retire)
+STATIC_FIELD_INFO_FOLLOWS(memory_tracker_t, retire,             shares)
+STATIC_FIELD_INFO_LAST   (memory_tracker_t,                     shares)
+
+/* Prebuilt, so describing trackers does no work at runtime. */
+static const struct_info_t *memory_tracker_type_is_struct  (const type_t *self)
+  { return &memory_tracker_struct_info; }
 
 static const tval          *memory_tracker_type_has_default(const type_t *self)
   { return type_has_default_value(self, &memory_tracker_defaults); }
@@ -414,642 +535,2285 @@ memory_tracker_t global_typed_dyn_memory_tracker =
 
 /* ---------------------------------------------------------------- */
 
-memory_tracker_t *memory_tracker_init(memory_tracker_t *dest, const memory_manager_t *memory_manager, void *dynamic_container)
-{
-  int dynamically_allocated;
+/*
+ * Per-thread memory trackers.
+ *
+ * A thread's trackers live in a record that is also the token stored in
+ * their "owner_thread" fields.  Records of exited threads are never freed,
+ * since blocks allocated from them may still be live; instead they are
+ * adopted by the next thread that asks for trackers, which then also drains
+ * what other threads handed back in the meantime.
+ *
+ * The typed tracker allocates from the record's heap, described below, so
+ * that a typed value's owner can be found from its address alone.
+ */
 
-  UNUSED(dynamically_allocated);
+#if POSIX_PARALLEL
+/*
+ * Per-thread heaps.
+ *
+ * A heap hands out blocks from spans of THREAD_HEAP_SPAN_SIZE bytes, each
+ * aligned to its size and headed by the record that owns it, so a block's
+ * span is found by masking the block's address.  "thread_heap_spans" records
+ * every live span, so that any thread can tell whether an arbitrary address
+ * is in one before reading a header; it only changes when a span is created
+ * or released, never per block.
+ *
+ * Small blocks are rounded up to a power of two, and each size class carves
+ * its blocks from spans of its own, which are kept for the life of the heap.
+ * A larger block gets a span of its own, released when the block is freed.
+ *
+ * Only the owning thread allocates or frees; see "byte_remote_free" for how
+ * other threads hand blocks back.
+ */
+#define THREAD_HEAP_SPAN_SHIFT   16
+#define THREAD_HEAP_SPAN_SIZE    (((size_t) 1) << THREAD_HEAP_SPAN_SHIFT)
 
-  memory_manager = require_memory_manager(memory_manager);
+/* Spans obtained at once for small blocks. */
+#define THREAD_HEAP_REGION_SPANS 16
 
-  if (!dest)
+/* Size classes: 16 bytes, doubling up to 16 KiB. */
+#define THREAD_HEAP_MIN_SHIFT    4
+#define THREAD_HEAP_CLASSES      11
+#define THREAD_HEAP_MAX_SMALL    (((size_t) 1) << (THREAD_HEAP_MIN_SHIFT + THREAD_HEAP_CLASSES - 1))
+
+/* Slots in "thread_heap_spans", and how far a lookup probes. */
+#define THREAD_HEAP_SPANS        (((size_t) 1) << 14)
+#define THREAD_HEAP_PROBES       64
+
+typedef struct thread_memory_trackers_s thread_memory_trackers_t;
+
+typedef union thread_heap_span_u thread_heap_span_t;
+union thread_heap_span_u
+{
+  struct
   {
-    dynamically_allocated = TRUE();
+    thread_memory_trackers_t *owner;
 
-    if (dynamic_container)
-    {
-      /* Error: Cannot dynamically allocate a memory           */
-      /* tracker with an existing "dynamic_container" present. */
-      return NULL;
-    }
+    /* Size of every block; for a large span, of its one block. */
+    size_t                    block_size;
 
-    dest = memory_manager_mmalloc(memory_manager, sizeof(*dest));
+    /* Size class, or THREAD_HEAP_CLASSES for a large span. */
+    size_t                    class_index;
+  } info;
 
-    if (!dest)
-    {
-      /* Error: failed to allocate memory! */
-      return NULL;
-    }
+  void        *align_ptr;
+  long         align_long;
+  long double  align_ldouble;
+};
 
-    dest->dynamic_container = dest;
-  }
-  else
-  {
-    dynamically_allocated = FALSE();
+#define THREAD_HEAP_SPAN(ptr) \
+  ((thread_heap_span_t *) ((size_t) (ptr) & ~(THREAD_HEAP_SPAN_SIZE - 1)))
 
-    dest->dynamic_container = dynamic_container;
-  }
+typedef struct thread_heap_class_s thread_heap_class_t;
+struct thread_heap_class_s
+{
+  /* Freed blocks, linked through their first word. */
+  void *free_list;
 
-  dest->type = memory_tracker_type;
+  /* The uncarved remainder of the newest span. */
+  char *carve;
+  char *carve_end;
+};
 
-  dest->memory_manager     = *memory_manager;
-  /* dest->dynamic_container */
-  dest->byte_allocations   = NULL;
-  dest->tval_allocations   = NULL;
-  dest->manual_allocations = NULL;
-  dest->dependency_graph   = NULL;
+typedef struct thread_heap_s thread_heap_t;
+struct thread_heap_s
+{
+  thread_heap_class_t classes[THREAD_HEAP_CLASSES];
 
-  dest = memory_tracker_require_containers(dest);
+  /* Spans of the newest region not yet given to a class. */
+  char *region;
+  char *region_end;
+};
 
-  if (!dest)
-  {
-    /* Error: failed to allocate memory for trackers. */
-    return NULL;
-  }
+struct thread_memory_trackers_s
+{
+  memory_tracker_t general;
+  memory_tracker_t typed_dyn;
 
-  /* Success! =) */
-  return dest;
+  thread_heap_t    heap;
+
+  /* Next record of an exited thread, awaiting adoption. */
+  thread_memory_trackers_t *next_abandoned;
+};
+
+/* Base addresses of live spans; NULL if never used. */
+static void * volatile thread_heap_spans[THREAD_HEAP_SPANS];
+
+/* Marks a slot whose span was released. */
+static char thread_heap_span_released;
+
+static size_t thread_heap_spans_slot(const void *span)
+{
+  return hash_mix(((size_t) span) >> THREAD_HEAP_SPAN_SHIFT) & (THREAD_HEAP_SPANS - 1);
 }
 
-size_t memory_tracker_free(memory_tracker_t *tracker)
+/* Returns 0 if no slot is free near the span's own. */
+static int thread_heap_spans_add(void *span)
 {
-  size_t num_freed;
+  size_t  slot;
+  size_t  probes;
+  void   *entry;
 
-  memory_manager_t  manager;
-  void             *dynamic_container;
+  slot = thread_heap_spans_slot(span);
 
-#if ERROR_CHECKING
-  if (!tracker)
-    return 0;
-#endif /* #if ERROR_CHECKING */
+  for (probes = 0; probes < THREAD_HEAP_PROBES; ++probes, slot = (slot + 1) & (THREAD_HEAP_SPANS - 1))
+  {
+    entry = ATOMIC_LOAD(&thread_heap_spans[slot]);
 
-  num_freed = 0;
+    if (entry && entry != (void *) &thread_heap_span_released)
+      continue;
 
-  memory_manager_copy(&manager, require_memory_manager(MEMORY_TRACKER_CMANAGER(tracker)));
-  dynamic_container = MEMORY_TRACKER_DYNAMIC_CONTAINER(tracker);
+    if (ATOMIC_CAS(&thread_heap_spans[slot], entry, span))
+      return 1;
+  }
 
-  /* ---------------------------------------------------------------- */
+  return 0;
+}
 
-  /* Free containers. */
-  num_freed += memory_tracker_free_containers(tracker);
+static void thread_heap_spans_remove(void *span)
+{
+  size_t slot;
+  size_t probes;
 
-  /* Cleanup memory_manager. */
-  num_freed += memory_manager_deinit(&tracker->memory_manager);
+  slot = thread_heap_spans_slot(span);
 
-  /* ---------------------------------------------------------------- */
+  for (probes = 0; probes < THREAD_HEAP_PROBES; ++probes, slot = (slot + 1) & (THREAD_HEAP_SPANS - 1))
+  {
+    if (ATOMIC_LOAD(&thread_heap_spans[slot]) == span)
+    {
+      ATOMIC_STORE(&thread_heap_spans[slot], (void *) &thread_heap_span_released);
+      return;
+    }
+  }
+}
 
-  tracker->dependency_graph   = NULL;
-  tracker->manual_allocations = NULL;
-  tracker->tval_allocations   = NULL;
-  tracker->byte_allocations   = NULL;
-  tracker->dynamic_container  = NULL;
-  /* tracker->memory_manager */
+/* The span holding "ptr", or NULL if "ptr" isn't in any heap. */
+static thread_heap_span_t *thread_heap_span_of(const void *ptr)
+{
+  thread_heap_span_t *span;
+  size_t              slot;
+  size_t              probes;
+  void               *entry;
 
-  tracker->type = NULL;
+  span = THREAD_HEAP_SPAN(ptr);
+  slot = thread_heap_spans_slot(span);
 
-  ++num_freed;
+  for (probes = 0; probes < THREAD_HEAP_PROBES; ++probes, slot = (slot + 1) & (THREAD_HEAP_SPANS - 1))
+  {
+    entry = ATOMIC_LOAD(&thread_heap_spans[slot]);
 
-  /* ---------------------------------------------------------------- */
+    if (!entry)
+      return NULL;
 
-  if (dynamic_container)
-  {
-    memory_manager_mfree(&manager, dynamic_container);
-      ++num_freed;
+    if (entry == (void *) span)
+      return span;
   }
 
-  return num_freed;
+  return NULL;
 }
 
-/* Special case: can dynamically allocate "dest" if "src" lacks a dynamic
- * container; then "dest"'s dynamic container refers to the newly allocated
- * "dest".
- *
- * N.B. Otherwise, "dest->dynamic_container" is copied from "src"!
- */
-memory_tracker_t *memory_tracker_copy(memory_tracker_t *dest, const memory_tracker_t *src)
+/* A fresh span, headed by "owner". */
+static thread_heap_span_t *thread_heap_span_new(thread_memory_trackers_t *owner, size_t class_index)
 {
-  int dynamically_allocated;
+  thread_heap_t      *heap;
+  thread_heap_span_t *span;
+  char               *region;
 
-  UNUSED(dynamically_allocated);
+  heap = &owner->heap;
 
-#if ERROR_CHECKING
-  if (!src)
+  if (heap->region == heap->region_end)
+  {
+    region = memory_manager_mmalloc_aligned(&malloc_manager, THREAD_HEAP_SPAN_SIZE, THREAD_HEAP_REGION_SPANS * THREAD_HEAP_SPAN_SIZE);
+    if (!region)
+      return NULL;
+
+    heap->region     = region;
+    heap->region_end = region + THREAD_HEAP_REGION_SPANS * THREAD_HEAP_SPAN_SIZE;
+  }
+
+  /* The header is written before the span is published. */
+  span = (thread_heap_span_t *) heap->region;
+
+  span->info.owner       = owner;
+  span->info.block_size  = ((size_t) 1) << (THREAD_HEAP_MIN_SHIFT + class_index);
+  span->info.class_index = class_index;
+
+  if (!thread_heap_spans_add(span))
     return NULL;
-#endif /* #if ERROR_CHECKING */
 
-  if (!dest)
+  heap->region += THREAD_HEAP_SPAN_SIZE;
+
+  return span;
+}
+
+static void *thread_heap_malloc(thread_memory_trackers_t *owner, size_t size)
+{
+  thread_heap_class_t *heap_class;
+  thread_heap_span_t  *span;
+  size_t               class_index;
+  void                *block;
+
+  if (size > THREAD_HEAP_MAX_SMALL)
   {
-    dynamically_allocated = TRUE();
+    if (size > ((size_t) (-1)) - THREAD_HEAP_SPAN_SIZE - sizeof(*span))
+      return NULL;
 
-    if (src->dynamic_container)
-    {
-      /* Error: Cannot dynamically allocate a memory             */
-      /* when "src" has an existing "dynamic_container" present. */
+    span = memory_manager_mmalloc_aligned(&malloc_manager, THREAD_HEAP_SPAN_SIZE, sizeof(*span) + size);
+    if (!span)
       return NULL;
-    }
 
-    dest = memory_manager_mmalloc(MEMORY_TRACKER_CMANAGER(src), sizeof(*dest));
+    span->info.owner       = owner;
+    span->info.block_size  = size;
+    span->info.class_index = THREAD_HEAP_CLASSES;
 
-    if (!dest)
+    if (!thread_heap_spans_add(span))
     {
-      /* Error: failed to allocate memory! */
+      memory_manager_mfree_aligned(&malloc_manager, span);
       return NULL;
     }
 
-    /* Special case: assign dest->dynamic_container. */
-
-    dest->dynamic_container = dest;
+    return (void *) (span + 1);
   }
-  else
+
+  for (class_index = 0; (((size_t) 1) << (THREAD_HEAP_MIN_SHIFT + class_index)) < size; ++class_index)
+    ;
+
+  heap_class = &owner->heap.classes[class_index];
+
+  if (heap_class->free_list)
   {
-    dynamically_allocated = FALSE();
+    block                 = heap_class->free_list;
+    heap_class->free_list = *(void **) block;
 
-    dest->dynamic_container = src->dynamic_container;
+    return block;
   }
 
-  dest->type = src->type;
+  if ((size_t) (heap_class->carve_end - heap_class->carve) < (((size_t) 1) << (THREAD_HEAP_MIN_SHIFT + class_index)))
+  {
+    span = thread_heap_span_new(owner, class_index);
+    if (!span)
+      return NULL;
 
-  memory_manager_copy(&dest->memory_manager, &src->memory_manager);
-  /* dest->dynamic_container */
-  dest->byte_allocations   = NULL;
-  dest->tval_allocations   = NULL;
-  dest->manual_allocations = NULL;
-  dest->dependency_graph   = NULL;
+    heap_class->carve     = (char *) (span + 1);
+    heap_class->carve_end = ((char *) span) + THREAD_HEAP_SPAN_SIZE;
+  }
 
-  return dest;
+  block              = heap_class->carve;
+  heap_class->carve += ((size_t) 1) << (THREAD_HEAP_MIN_SHIFT + class_index);
+
+  return block;
 }
 
-memory_tracker_t *memory_tracker_require_containers(memory_tracker_t *tracker)
+static size_t thread_heap_free(thread_memory_trackers_t *owner, void *ptr)
 {
-#if ERROR_CHECKING
-  if (!tracker)
-    return NULL;
-#endif /* #if ERROR_CHECKING */
+  thread_heap_span_t  *span;
+  thread_heap_class_t *heap_class;
 
-  if (!tracker->byte_allocations)
+  if (!ptr)
+    return 0;
+
+  span = THREAD_HEAP_SPAN(ptr);
+
+  if (span->info.class_index >= THREAD_HEAP_CLASSES)
   {
-    int is_duplicate = -1;
+    thread_heap_spans_remove(span);
+    memory_manager_mfree_aligned(&malloc_manager, span);
 
-    lookup_t     *lookup;
-    const size_t  value_size = sizeof(byte_allocation_t);
+    return 1;
+  }
 
-    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+  heap_class = &owner->heap.classes[span->info.class_index];
 
-    tracker->byte_allocations =
-      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->byte_allocations));
+  *(void **) ptr        = heap_class->free_list;
+  heap_class->free_list = ptr;
 
-    if (lookup)
-      lookup = lookup_init_empty(lookup, value_size);
+  return 1;
+}
 
-    if (lookup)
-      lookup = lookup_minsert
-        ( tracker->byte_allocations
-        , &lookup
-        , LOOKUP_NO_ADD_DUPLICATES
+static void *thread_heap_realloc(thread_memory_trackers_t *owner, void *ptr, size_t size)
+{
+  thread_heap_span_t *span;
+  void               *moved;
 
-        , cmp_byte_allocation
+  if (!ptr)
+    return thread_heap_malloc(owner, size);
 
-        , memory_manager
+  span = THREAD_HEAP_SPAN(ptr);
 
-        , NULL
-        , &is_duplicate
-        );
+  /* Shrinking a small block, or any block by less than half, keeps it. */
+  if (size <= span->info.block_size && (span->info.class_index < THREAD_HEAP_CLASSES || size > span->info.block_size / 2))
+    return ptr;
 
-    if (is_duplicate)
-      lookup = NULL;
+  moved = thread_heap_malloc(owner, size);
+  if (!moved)
+    return NULL;
 
-    if (!lookup)
-    {
-      /* Error: failed to initialize lookup container! */
+  memcpy(moved, ptr, size < span->info.block_size ? size : span->info.block_size);
+  thread_heap_free(owner, ptr);
 
-      if (tracker->byte_allocations)
-      {
-        lookup_deinit(tracker->byte_allocations, memory_manager);
-        memory_manager_mfree
-          ( memory_manager
-          , tracker->byte_allocations
-          );
-        tracker->byte_allocations = NULL;
-      }
+  return moved;
+}
 
-      return NULL;
-    }
+static void *thread_heap_manager_mmalloc(const memory_manager_t *self, size_t size)
+{
+  return thread_heap_malloc(self->state, size);
+}
 
-    tracker->byte_allocations = lookup;
-  }
+static size_t thread_heap_manager_mfree(const memory_manager_t *self, void *ptr)
+{
+  return thread_heap_free(self->state, ptr);
+}
 
-  if (!tracker->tval_allocations)
-  {
-    int is_duplicate = -1;
+static void *thread_heap_manager_mrealloc(const memory_manager_t *self, void *ptr, size_t size)
+{
+  return thread_heap_realloc(self->state, ptr, size);
+}
 
-    lookup_t     *lookup;
-    const size_t  value_size = sizeof(tval_allocation_t);
+static void *thread_heap_manager_mcalloc(const memory_manager_t *self, size_t nmemb, size_t size)
+{
+  void *block;
 
-    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+  if (size && nmemb > ((size_t) (-1)) / size)
+    return NULL;
 
-    tracker->tval_allocations =
-      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->tval_allocations));
+  block = thread_heap_malloc(self->state, nmemb * size);
+  if (block)
+    memset(block, 0, nmemb * size);
 
-    if (lookup)
-      lookup = lookup_init_empty(lookup, value_size);
+  return block;
+}
 
-    if (lookup)
-      if (!lookup_minsert
-            ( tracker->byte_allocations
-            , &lookup
-            , LOOKUP_NO_ADD_DUPLICATES
+static pthread_key_t   thread_memory_trackers_key;
+static pthread_once_t  thread_memory_trackers_once = PTHREAD_ONCE_INIT;
+static int             thread_memory_trackers_key_valid = 0;
+
+static pthread_mutex_t           abandoned_thread_memory_trackers_lock = PTHREAD_MUTEX_INITIALIZER;
+static thread_memory_trackers_t *abandoned_thread_memory_trackers      = NULL;
+
+/* Thread exit: free what was handed back, and leave the rest for adoption. */
+static void thread_memory_trackers_abandon(void *trackers_raw)
+{
+  thread_memory_trackers_t *trackers = trackers_raw;
+
+  if (!trackers)
+    return;
+
+  memory_tracker_drain(&trackers->general);
+  memory_tracker_drain(&trackers->typed_dyn);
+
+  pthread_mutex_lock(&abandoned_thread_memory_trackers_lock);
+  trackers->next_abandoned         = abandoned_thread_memory_trackers;
+  abandoned_thread_memory_trackers = trackers;
+  pthread_mutex_unlock(&abandoned_thread_memory_trackers_lock);
+}
+
+static void thread_memory_trackers_key_init(void)
+{
+  thread_memory_trackers_key_valid =
+    pthread_key_create(&thread_memory_trackers_key, thread_memory_trackers_abandon) == 0;
+}
+
+static thread_memory_trackers_t *thread_memory_trackers_new(void)
+{
+  thread_memory_trackers_t *trackers;
+  memory_manager_t          heap_manager;
+
+  trackers = memory_manager_mmalloc(&malloc_manager, sizeof(*trackers));
+  if (!trackers)
+    return NULL;
+
+  memset(&trackers->heap, 0, sizeof(trackers->heap));
+
+  if (!memory_tracker_init(&trackers->general, &malloc_manager, NULL))
+  {
+    memory_manager_mfree(&malloc_manager, trackers);
+    return NULL;
+  }
+
+  memory_manager_init
+    ( &heap_manager
+
+    , thread_heap_manager_mmalloc
+    , thread_heap_manager_mfree
+    , thread_heap_manager_mrealloc
+    , thread_heap_manager_mcalloc
+    );
+
+  heap_manager.state      = (void *) trackers;
+  heap_manager.state_size = sizeof(*trackers);
+
+  if (!memory_tracker_init(&trackers->typed_dyn, &heap_manager, NULL))
+  {
+    memory_tracker_free(&trackers->general);
+    memory_manager_mfree(&malloc_manager, trackers);
+    return NULL;
+  }
+
+  memory_tracker_set_intrusive(&trackers->general, TRUE());
+
+  trackers->general.owner_thread   = trackers;
+  trackers->typed_dyn.owner_thread = trackers;
+  trackers->next_abandoned         = NULL;
+
+  return trackers;
+}
+
+/* Get the calling thread's trackers, adopting or creating them on first use. */
+static thread_memory_trackers_t *thread_memory_trackers(void)
+{
+  thread_memory_trackers_t *trackers;
+
+  pthread_once(&thread_memory_trackers_once, thread_memory_trackers_key_init);
+  if (!thread_memory_trackers_key_valid)
+    return NULL;
+
+  trackers = pthread_getspecific(thread_memory_trackers_key);
+  if (trackers)
+    return trackers;
+
+  pthread_mutex_lock(&abandoned_thread_memory_trackers_lock);
+  trackers = abandoned_thread_memory_trackers;
+  if (trackers)
+    abandoned_thread_memory_trackers = trackers->next_abandoned;
+  pthread_mutex_unlock(&abandoned_thread_memory_trackers_lock);
+
+  if (trackers)
+    trackers->next_abandoned = NULL;
+  else
+    trackers = thread_memory_trackers_new();
+
+  if (!trackers)
+    return NULL;
+
+  if (pthread_setspecific(thread_memory_trackers_key, trackers) != 0)
+  {
+    thread_memory_trackers_abandon(trackers);
+    return NULL;
+  }
+
+  memory_tracker_drain(&trackers->general);
+  memory_tracker_drain(&trackers->typed_dyn);
+
+  return trackers;
+}
+
+/* Is the calling thread the owner of "tracker"? */
+static int memory_tracker_is_local(const memory_tracker_t *tracker)
+{
+  if (!tracker->owner_thread)
+    return 1;
+
+  if (!thread_memory_trackers_key_valid)
+    return 0;
+
+  return tracker->owner_thread == pthread_getspecific(thread_memory_trackers_key);
+}
+
+#endif /* #if POSIX_PARALLEL */
+
+memory_tracker_t *memory_tracker_owner(const void *ptr)
+{
+#if POSIX_PARALLEL
+  thread_heap_span_t *span;
+
+  if (!ptr)
+    return NULL;
+
+  span = thread_heap_span_of(ptr);
+  if (!span)
+    return NULL;
+
+  return &span->info.owner->typed_dyn;
+#else  /* #if POSIX_PARALLEL */
+  return NULL;
+#endif /* #if POSIX_PARALLEL */
+}
+
+memory_tracker_t *thread_memory_tracker(void)
+{
+#if POSIX_PARALLEL
+  thread_memory_trackers_t *trackers;
+
+  trackers = thread_memory_trackers();
+  if (!trackers)
+    return NULL;
+
+  return &trackers->general;
+#else  /* #if POSIX_PARALLEL */
+  return &global_memory_tracker;
+#endif /* #if POSIX_PARALLEL */
+}
+
+memory_tracker_t *thread_typed_dyn_memory_tracker(void)
+{
+#if POSIX_PARALLEL
+  thread_memory_trackers_t *trackers;
+
+  trackers = thread_memory_trackers();
+  if (!trackers)
+    return NULL;
+
+  if (ATOMIC_LOAD(&trackers->typed_dyn.remote_byte_frees))
+    memory_tracker_drain(&trackers->typed_dyn);
+
+  return &trackers->typed_dyn;
+#else  /* #if POSIX_PARALLEL */
+  return &global_typed_dyn_memory_tracker;
+#endif /* #if POSIX_PARALLEL */
+}
+
+/* ---------------------------------------------------------------- */
+
+memory_tracker_t *memory_tracker_init(memory_tracker_t *dest, const memory_manager_t *memory_manager, void *dynamic_container)
+{
+  int dynamically_allocated;
+
+  UNUSED(dynamically_allocated);
+
+  memory_manager = require_memory_manager(memory_manager);
+
+  if (!dest)
+  {
+    dynamically_allocated = TRUE();
+
+    if (dynamic_container)
+    {
+      /* Error: Cannot dynamically allocate a memory           */
+      /* tracker with an existing "dynamic_container" present. */
+      return NULL;
+    }
+
+    dest = memory_manager_mmalloc(memory_manager, sizeof(*dest));
+
+    if (!dest)
+    {
+      /* Error: failed to allocate memory! */
+      return NULL;
+    }
+
+    dest->dynamic_container = dest;
+  }
+  else
+  {
+    dynamically_allocated = FALSE();
+
+    dest->dynamic_container = dynamic_container;
+  }
+
+  dest->type = memory_tracker_type;
+
+  dest->memory_manager     = *memory_manager;
+  /* dest->dynamic_container */
+  dest->byte_allocations   = NULL;
+  dest->tval_allocations   = NULL;
+  dest->manual_allocations = NULL;
+  dest->dependency_graph   = NULL;
+
+  dest->intrusive          = 0;
+  dest->intrusive_list     = NULL;
+  dest->intrusive_slots    = NULL;
+  dest->intrusive_num      = 0;
+  dest->intrusive_size     = 0;
+  dest->intrusive_serial   = 0;
+
+  dest->checkpoints_num    = 0;
+  dest->checkpoint_serials = NULL;
+  dest->checkpoints_size   = 0;
+  dest->checkpoint_serial  = 0;
+  dest->journal            = NULL;
+  dest->journal_num        = 0;
+  dest->journal_size       = 0;
+
+  dest->owner_thread       = NULL;
+  dest->remote_frees       = NULL;
+  dest->remote_byte_frees  = NULL;
+
+  dest->deferred           = 0;
+  dest->retire             = 0;
+
+  dest->shares             = 0;
+
+  dest = memory_tracker_require_containers(dest);
+
+  if (!dest)
+  {
+    /* Error: failed to allocate memory for trackers. */
+    return NULL;
+  }
+
+  /* Success! =) */
+  return dest;
+}
+
+size_t memory_tracker_free(memory_tracker_t *tracker)
+{
+  size_t num_freed;
+
+  memory_manager_t  manager;
+  void             *dynamic_container;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (tracker->deferred)
+  {
+    num_freed = memory_tracker_defer(tracker);
+    if (num_freed)
+      return num_freed;
+  }
+
+  /* Take back what other threads handed back. */
+  num_freed = memory_tracker_drain(tracker);
+
+  memory_manager_copy(&manager, require_memory_manager(MEMORY_TRACKER_CMANAGER(tracker)));
+  dynamic_container = MEMORY_TRACKER_DYNAMIC_CONTAINER(tracker);
+
+  /* ---------------------------------------------------------------- */
+
+  /* Free intrusively tracked blocks. */
+  num_freed += memory_tracker_free_intrusive(tracker);
+
+  /* Free the checkpoint journal. */
+  if (tracker->checkpoint_serials)
+    num_freed += memory_manager_mfree(&manager, tracker->checkpoint_serials);
+  if (tracker->journal)
+    num_freed += memory_manager_mfree(&manager, tracker->journal);
+
+  tracker->checkpoints_num    = 0;
+  tracker->checkpoint_serials = NULL;
+  tracker->checkpoints_size   = 0;
+  tracker->journal            = NULL;
+  tracker->journal_num        = 0;
+  tracker->journal_size       = 0;
+
+  /* Free containers. */
+  num_freed += memory_tracker_free_containers(tracker);
+
+  /* Cleanup memory_manager. */
+  num_freed += memory_manager_deinit(&tracker->memory_manager);
+
+  /* ---------------------------------------------------------------- */
+
+  tracker->dependency_graph   = NULL;
+  tracker->manual_allocations = NULL;
+  tracker->tval_allocations   = NULL;
+  tracker->byte_allocations   = NULL;
+  tracker->dynamic_container  = NULL;
+  /* tracker->memory_manager */
+
+  tracker->type = NULL;
+
+  ++num_freed;
+
+  /* ---------------------------------------------------------------- */
+
+  if (dynamic_container)
+  {
+    memory_manager_mfree(&manager, dynamic_container);
+      ++num_freed;
+  }
+
+  return num_freed;
+}
+
+/* Special case: can dynamically allocate "dest" if "src" lacks a dynamic
+ * container; then "dest"'s dynamic container refers to the newly allocated
+ * "dest".
+ *
+ * N.B. Otherwise, "dest->dynamic_container" is copied from "src"!
+ */
+memory_tracker_t *memory_tracker_copy(memory_tracker_t *dest, const memory_tracker_t *src)
+{
+  int dynamically_allocated;
+
+  UNUSED(dynamically_allocated);
+
+#if ERROR_CHECKING
+  if (!src)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  if (!dest)
+  {
+    dynamically_allocated = TRUE();
+
+    if (src->dynamic_container)
+    {
+      /* Error: Cannot dynamically allocate a memory             */
+      /* when "src" has an existing "dynamic_container" present. */
+      return NULL;
+    }
+
+    dest = memory_manager_mmalloc(MEMORY_TRACKER_CMANAGER(src), sizeof(*dest));
+
+    if (!dest)
+    {
+      /* Error: failed to allocate memory! */
+      return NULL;
+    }
+
+    /* Special case: assign dest->dynamic_container. */
+
+    dest->dynamic_container = dest;
+  }
+  else
+  {
+    dynamically_allocated = FALSE();
+
+    dest->dynamic_container = src->dynamic_container;
+  }
+
+  dest->type = src->type;
+
+  memory_manager_copy(&dest->memory_manager, &src->memory_manager);
+  /* dest->dynamic_container */
+  dest->byte_allocations   = NULL;
+  dest->tval_allocations   = NULL;
+  dest->manual_allocations = NULL;
+  dest->dependency_graph   = NULL;
+
+  dest->intrusive          = src->intrusive;
+  dest->intrusive_list     = NULL;
+  dest->intrusive_slots    = NULL;
+  dest->intrusive_num      = 0;
+  dest->intrusive_size     = 0;
+  dest->intrusive_serial   = 0;
+
+  dest->checkpoints_num    = 0;
+  dest->checkpoint_serials = NULL;
+  dest->checkpoints_size   = 0;
+  dest->checkpoint_serial  = 0;
+  dest->journal            = NULL;
+  dest->journal_num        = 0;
+  dest->journal_size       = 0;
+
+  dest->owner_thread       = NULL;
+  dest->remote_frees       = NULL;
+  dest->remote_byte_frees  = NULL;
+
+  dest->deferred           = src->deferred;
+  dest->retire             = src->retire;
+
+  dest->shares             = 0;
+
+  return dest;
+}
+
+/*
+ * Sharing.
+ *
+ * "shares" is only changed by compare-and-swap.
+ */
+
+memory_tracker_t *memory_tracker_share(memory_tracker_t *tracker)
+{
+  size_t shares;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  do
+  {
+    shares = ATOMIC_LOAD(&tracker->shares);
+  } while (!ATOMIC_CAS(&tracker->shares, shares, shares + 1));
+
+  return tracker;
+}
+
+size_t memory_tracker_unshare(memory_tracker_t *tracker)
+{
+  size_t shares;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  do
+  {
+    shares = ATOMIC_LOAD(&tracker->shares);
+    if (!shares)
+      return 0;
+  } while (!ATOMIC_CAS(&tracker->shares, shares, shares - 1));
+
+  return shares;
+}
+
+int memory_tracker_is_shared(const memory_tracker_t *tracker)
+{
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  return ATOMIC_LOAD(&tracker->shares) != 0;
+}
+
+memory_tracker_t *memory_tracker_require_containers(memory_tracker_t *tracker)
+{
+#if ERROR_CHECKING
+  if (!tracker)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  if (!tracker->byte_allocations)
+  {
+    int is_duplicate = -1;
+
+    lookup_t     *lookup;
+    const size_t  value_size = sizeof(byte_allocation_t);
+
+    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+    tracker->byte_allocations =
+      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->byte_allocations));
+
+    if (lookup)
+      lookup = lookup_init_empty(lookup, value_size);
+
+    if (lookup)
+      lookup = lookup_minsert
+        ( tracker->byte_allocations
+        , &lookup
+        , LOOKUP_NO_ADD_DUPLICATES
+
+        , cmp_byte_allocation
+
+        , memory_manager
+
+        , NULL
+        , &is_duplicate
+        );
+
+    if (is_duplicate)
+      lookup = NULL;
+
+    if (!lookup)
+    {
+      /* Error: failed to initialize lookup container! */
+
+      if (tracker->byte_allocations)
+      {
+        lookup_deinit(tracker->byte_allocations, memory_manager);
+        memory_manager_mfree
+          ( memory_manager
+          , tracker->byte_allocations
+          );
+        tracker->byte_allocations = NULL;
+      }
+
+      return NULL;
+    }
+
+    tracker->byte_allocations = lookup;
+  }
+
+  if (!tracker->tval_allocations)
+  {
+    int is_duplicate = -1;
+
+    lookup_t     *lookup;
+    const size_t  value_size = sizeof(tval_allocation_t);
+
+    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+    tracker->tval_allocations =
+      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->tval_allocations));
+
+    if (lookup)
+      lookup = lookup_init_empty(lookup, value_size);
+
+    if (lookup)
+      if (!lookup_minsert
+            ( tracker->byte_allocations
+            , &lookup
+            , LOOKUP_NO_ADD_DUPLICATES
+
+            , cmp_byte_allocation
+
+            , memory_manager
+
+            , NULL
+            , &is_duplicate
+            )
+         )
+        lookup = NULL;
+
+    if (is_duplicate)
+      lookup = NULL;
+
+    if (!lookup)
+    {
+      /* Error: failed to initialize lookup container! */
+
+      lookup_deinit(tracker->byte_allocations, memory_manager);
+      memory_manager_mfree
+        ( memory_manager
+        , tracker->byte_allocations
+        );
+      tracker->byte_allocations = NULL;
+
+      if (tracker->tval_allocations)
+      {
+        lookup_deinit(tracker->tval_allocations, memory_manager);
+        memory_manager_mfree
+          ( memory_manager
+          , tracker->tval_allocations
+          );
+        tracker->tval_allocations = NULL;
+      }
+
+      return NULL;
+    }
+
+    tracker->tval_allocations = lookup;
+  }
+
+  if (!tracker->manual_allocations)
+  {
+    int is_duplicate = -1;
+
+    lookup_t     *lookup;
+    const size_t  value_size = sizeof(manual_allocation_t);
+
+    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+    tracker->manual_allocations =
+      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->manual_allocations));
+
+    if (lookup)
+      lookup = lookup_init_empty(lookup, value_size);
+
+    if (lookup)
+      if (!lookup_minsert
+            ( tracker->byte_allocations
+            , &lookup
+            , LOOKUP_NO_ADD_DUPLICATES
 
             , cmp_byte_allocation
 
-            , memory_manager
+            , memory_manager
+
+            , NULL
+            , &is_duplicate
+            )
+         )
+        lookup = NULL;
+
+    if (is_duplicate)
+      lookup = NULL;
+
+    if (!lookup)
+    {
+      /* Error: failed to initialize lookup container! */
+
+      lookup_deinit(tracker->byte_allocations, memory_manager);
+      memory_manager_mfree
+        ( memory_manager
+        , tracker->byte_allocations
+        );
+      tracker->byte_allocations = NULL;
+
+      lookup_deinit(tracker->tval_allocations, memory_manager);
+      memory_manager_mfree
+        ( memory_manager
+        , tracker->tval_allocations
+        );
+      tracker->tval_allocations = NULL;
+
+      if (tracker->manual_allocations)
+      {
+        lookup_deinit(tracker->manual_allocations, memory_manager);
+        memory_manager_mfree
+          ( memory_manager
+          , tracker->manual_allocations
+          );
+        tracker->manual_allocations = NULL;
+      }
+
+      return NULL;
+    }
+
+    tracker->manual_allocations = lookup;
+  }
+
+  if (!tracker->dependency_graph)
+  {
+    dependency_graph_t *graph;
+
+    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+    graph = memory_manager_mmalloc(memory_manager, sizeof(*graph));
+    if (!graph)
+    {
+      /* Error: failed to allocate the dependency graph! */
+      return NULL;
+    }
+
+    dependency_graph_init(graph);
+
+    tracker->dependency_graph = graph;
+  }
+
+  return tracker;
+}
+
+size_t memory_tracker_free_containers(memory_tracker_t *tracker)
+{
+  size_t num_freed;
+
+  const memory_manager_t *manager;
+
+  void *free_byte_allocations   = NULL;
+  void *free_tval_allocations   = NULL;
+  void *free_manual_allocations = NULL;
+
+  lookup_t            *lookup;
+  const bnode_t       *root;
+
+  byte_allocation_t    byte_value;
+  tval_allocation_t    tval_value;
+  manual_allocation_t  manual_value;
+
+  size_t               result_num;
+  byte_allocation_t    result_byte;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  num_freed = 0;
+
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+  /* ---------------------------------------------------------------- */
+  /* Free all non--container allocations.                             */
+
+  if (tracker->byte_allocations)
+  {
+    lookup = tracker->byte_allocations;
+
+    while(!LOOKUP_EMPTY(tracker->byte_allocations))
+    {
+      root       =
+        ( (LOOKUP_ROOT_CNODE(lookup)) );
+      byte_value = DEREF_PTR
+        ( (const byte_allocation_t *)
+          (LOOKUP_NODE_VALUE(lookup, root))
+        );
+
+      if      (byte_value == tracker->byte_allocations)
+      {
+        free_byte_allocations   = byte_value;
+      }
+      else if (byte_value == tracker->tval_allocations)
+      {
+        free_tval_allocations   = byte_value;
+      }
+      else if (byte_value == tracker->manual_allocations)
+      {
+        free_manual_allocations = byte_value;
+      }
+      else
+      {
+        /* Standard allocation.  Free it. */
+
+        result_num = free_byte_allocation(tracker, byte_value);
+        if (!result_num)
+        {
+          /* Error: failed to free a byte allocation! */
+#if ERROR_CHECKING
+          bug
+            ( "Error: memory_tracker_free_containers: line #"
+              CURRENT_LINE_STR
+              "failed to free a byte allocation!\n"
+            );
+#endif /* #if ERROR_CHECKING */
+          break;
+        }
+
+        num_freed += result_num;
+        continue;
+      }
+
+      /* Just remove the allocation container reference. */
+      /*                                                 */
+      /* We'll free the container once we're done        */
+      /* freeing all non-container allocations.          */
+
+      result_byte = untrack_byte_allocation(tracker, byte_value);
+      if (!result_byte)
+      {
+          /* Error: failed to untrack a container! */
+#if ERROR_CHECKING
+          bug
+            ( "Error: memory_tracker_free_containers: line #"
+              CURRENT_LINE_STR
+              "failed to untrack container!\n"
+            );
+#endif /* #if ERROR_CHECKING */
+          break;
+      }
+
+      continue;
+    }
+  }
+
+  if (tracker->tval_allocations)
+  {
+    lookup = tracker->tval_allocations;
+
+    while(!LOOKUP_EMPTY(tracker->tval_allocations))
+    {
+      root       =
+        ( (LOOKUP_ROOT_CNODE(lookup)) );
+      tval_value = DEREF_PTR
+        ( (const tval_allocation_t *)
+          (LOOKUP_NODE_VALUE(lookup, root))
+        );
+
+      result_num = free_tval_allocation(tracker, tval_value);
+      if (!result_num)
+      {
+        /* Error: failed to free a tval allocation! */
+#if ERROR_CHECKING
+        bug
+          ( "Error: memory_tracker_free_containers: line #"
+            CURRENT_LINE_STR
+            "failed to free a tval allocation!\n"
+          );
+#endif /* #if ERROR_CHECKING */
+        break;
+      }
+
+      num_freed += result_num;
+    }
+  }
+
+  if (tracker->manual_allocations)
+  {
+    lookup = tracker->manual_allocations;
+
+    while(!LOOKUP_EMPTY(tracker->manual_allocations))
+    {
+      root         =
+        ( (LOOKUP_ROOT_CNODE(lookup)) );
+      manual_value = DEREF_DEFAULT
+        ( (const manual_allocation_t *)
+          (LOOKUP_NODE_VALUE(lookup, root))
+        , manual_allocation_defaults
+        );
+
+      result_num = free_manual_allocation(tracker, manual_value);
+      if (!result_num)
+      {
+        /* Error: failed to free a manual allocation! */
+#if ERROR_CHECKING
+        bug
+          ( "Error: memory_tracker_free_containers: line #"
+            CURRENT_LINE_STR
+            "failed to free a manual allocation!\n"
+          );
+#endif /* #if ERROR_CHECKING */
+        break;
+      }
+
+      num_freed += result_num;
+    }
+  }
+
+  /* ---------------------------------------------------------------- */
+  /* Free containers.                                                 */
+
+  if ((lookup = tracker->byte_allocations))
+    num_freed += lookup_deinit(lookup, manager);
+  if ((lookup = tracker->tval_allocations))
+    num_freed += lookup_deinit(lookup, manager);
+  if ((lookup = tracker->manual_allocations))
+    num_freed += lookup_deinit(lookup, manager);
+
+  if (free_byte_allocations)
+    num_freed += memory_manager_mfree(manager, free_byte_allocations);
+  if (free_tval_allocations)
+    num_freed += memory_manager_mfree(manager, free_tval_allocations);
+  if (free_manual_allocations)
+    num_freed += memory_manager_mfree(manager, free_manual_allocations);
+
+  if (tracker->dependency_graph)
+  {
+    num_freed += dependency_graph_deinit(tracker->dependency_graph, manager);
+    num_freed += memory_manager_mfree(manager, tracker->dependency_graph);
+  }
+
+  /* ---------------------------------------------------------------- */
+  /* Unset containers.                                                */
+
+  tracker->byte_allocations   = NULL;
+  tracker->tval_allocations   = NULL;
+  tracker->manual_allocations = NULL;
+  tracker->dependency_graph   = NULL;
+
+  /* ---------------------------------------------------------------- */
+  /* Success!                                                         */
+
+  return num_freed;
+}
+
+/* ---------------------------------------------------------------- */
+/* Deferred reclamation.                                            */
+/* ---------------------------------------------------------------- */
+
+/*
+ * A tracker queued for the reclaimer.
+ *
+ * "tracker" is a detached copy of the original; "manager" is kept apart,
+ * since freeing "tracker" deinitializes its own.
+ */
+typedef struct reclaim_job_s reclaim_job_t;
+struct reclaim_job_s
+{
+  memory_tracker_t  tracker;
+  memory_manager_t  manager;
+
+  reclaim_job_t    *next;
+};
+
+/* Queue of jobs, oldest first. */
+static reclaim_job_t *reclaim_head = NULL;
+static reclaim_job_t *reclaim_tail = NULL;
+
+/* Jobs queued and freed so far; a flush waits for the latter to reach the */
+/* former.                                                                 */
+static size_t reclaim_queued_num = 0;
+static size_t reclaim_done_num   = 0;
+
+/* Blocks the reclaimer has released that no flush has reported yet. */
+static size_t reclaim_unreported_num = 0;
+
+#if POSIX_PARALLEL
+static pthread_mutex_t reclaim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signalled when jobs are queued, or the reclaimer should stop. */
+static pthread_cond_t  reclaim_queued_cond = PTHREAD_COND_INITIALIZER;
+
+/* Signalled when a batch has been freed. */
+static pthread_cond_t  reclaim_done_cond   = PTHREAD_COND_INITIALIZER;
+
+static pthread_t       reclaim_thread;
+static int             reclaim_running  = 0;
+static int             reclaim_stopping = 0;
+
+#define RECLAIM_LOCK()   pthread_mutex_lock(&reclaim_lock)
+#define RECLAIM_UNLOCK() pthread_mutex_unlock(&reclaim_lock)
+#else  /* #if POSIX_PARALLEL */
+#define RECLAIM_LOCK()   do {} while(0)
+#define RECLAIM_UNLOCK() do {} while(0)
+#endif /* #if POSIX_PARALLEL */
+
+/* Free a batch of jobs, linked through "next", in order. */
+static size_t reclaim_batch(reclaim_job_t *batch)
+{
+  size_t num_freed;
+
+  reclaim_job_t    *job;
+  reclaim_job_t    *next;
+  memory_manager_t  manager;
+
+  num_freed = 0;
+
+  for (job = batch; job; job = next)
+  {
+    next    = job->next;
+    manager = job->manager;
+
+    num_freed += memory_tracker_free(&job->tracker);
+    memory_manager_mfree(&manager, job);
+  }
+
+  return num_freed;
+}
+
+/* Take every queued job.  Must be called with "reclaim_lock" held. */
+static reclaim_job_t *reclaim_take(size_t *out_num)
+{
+  reclaim_job_t *batch;
+  reclaim_job_t *job;
+  size_t         num;
+
+  batch = reclaim_head;
+
+  reclaim_head = NULL;
+  reclaim_tail = NULL;
+
+  num = 0;
+  for (job = batch; job; job = job->next)
+    ++num;
+
+  *out_num = num;
+
+  return batch;
+}
+
+#if POSIX_PARALLEL
+static void *reclaim_thread_main(void *context)
+{
+  reclaim_job_t *batch;
+  size_t         batch_num;
+  size_t         num_freed;
+
+  RECLAIM_LOCK();
+
+  for (;;)
+  {
+    while (!reclaim_head && !reclaim_stopping)
+      pthread_cond_wait(&reclaim_queued_cond, &reclaim_lock);
+
+    if (!reclaim_head)
+      break;
+
+    batch = reclaim_take(&batch_num);
+
+    RECLAIM_UNLOCK();
+    {
+      num_freed = reclaim_batch(batch);
+    }
+    RECLAIM_LOCK();
+
+    reclaim_done_num       += batch_num;
+    reclaim_unreported_num += num_freed;
+
+    pthread_cond_broadcast(&reclaim_done_cond);
+  }
+
+  RECLAIM_UNLOCK();
+
+  return context;
+}
+
+/* Start the reclaimer if needed.  Must be called with "reclaim_lock" held. */
+static int reclaim_require_thread(void)
+{
+  if (reclaim_running)
+    return 1;
+
+  reclaim_stopping = 0;
+
+  if (pthread_create(&reclaim_thread, NULL, reclaim_thread_main, NULL) != 0)
+    return 0;
+
+  reclaim_running = 1;
+
+  return 1;
+}
+#else  /* #if POSIX_PARALLEL */
+/* Without a reclaimer thread, free every queued job on this one. */
+static void reclaim_run(void)
+{
+  reclaim_job_t *batch;
+  size_t         batch_num;
+
+  batch = reclaim_take(&batch_num);
+
+  reclaim_done_num       += batch_num;
+  reclaim_unreported_num += reclaim_batch(batch);
+}
+#endif /* #if POSIX_PARALLEL */
+
+size_t memory_tracker_defer(memory_tracker_t *tracker)
+{
+  reclaim_job_t          *job;
+  const memory_manager_t *manager;
+  int                     dynamic;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  manager = require_memory_manager(MEMORY_TRACKER_CMANAGER(tracker));
+
+  job = memory_manager_mmalloc(manager, sizeof(*job));
+  if (!job)
+    return 0;
+
+  memory_manager_copy(&job->manager, manager);
+
+  job->tracker              = *tracker;
+  job->tracker.deferred     = 0;
+  job->tracker.owner_thread = NULL;
+  job->next                 = NULL;
+
+  /* Once queued, "job", and "tracker" if dynamic, may be freed at any time. */
+  dynamic = tracker->dynamic_container != NULL;
+
+  RECLAIM_LOCK();
+  {
+#if POSIX_PARALLEL
+    if (!reclaim_require_thread())
+    {
+      RECLAIM_UNLOCK();
+      memory_manager_mfree(manager, job);
+      return 0;
+    }
+#endif /* #if POSIX_PARALLEL */
+
+    if (reclaim_tail)
+      reclaim_tail->next = job;
+    else
+      reclaim_head       = job;
+    reclaim_tail = job;
+
+    ++reclaim_queued_num;
+
+#if POSIX_PARALLEL
+    pthread_cond_signal(&reclaim_queued_cond);
+#endif /* #if POSIX_PARALLEL */
+  }
+  RECLAIM_UNLOCK();
+
+  /* ---------------------------------------------------------------- */
+  /* Leave "tracker" as "memory_tracker_free" would, unless the       */
+  /* reclaimer owns its memory.                                       */
+
+  if (dynamic)
+    return 1;
+
+  memory_manager_deinit(&tracker->memory_manager);
+
+  tracker->byte_allocations   = NULL;
+  tracker->tval_allocations   = NULL;
+  tracker->manual_allocations = NULL;
+  tracker->dependency_graph   = NULL;
+
+  tracker->intrusive_list     = NULL;
+  tracker->intrusive_slots    = NULL;
+  tracker->intrusive_num      = 0;
+  tracker->intrusive_size     = 0;
+
+  tracker->checkpoints_num    = 0;
+  tracker->checkpoint_serials = NULL;
+  tracker->checkpoints_size   = 0;
+  tracker->journal            = NULL;
+  tracker->journal_num        = 0;
+  tracker->journal_size       = 0;
+
+  tracker->owner_thread       = NULL;
+  tracker->remote_frees       = NULL;
+  tracker->remote_byte_frees  = NULL;
+
+  tracker->type = NULL;
+
+  return 1;
+}
+
+size_t memory_tracker_reclaim_flush(void)
+{
+  size_t num_freed;
+
+#if POSIX_PARALLEL
+  size_t queued_num;
+
+  RECLAIM_LOCK();
+  {
+    queued_num = reclaim_queued_num;
+
+    while (reclaim_running && reclaim_done_num < queued_num)
+      pthread_cond_wait(&reclaim_done_cond, &reclaim_lock);
+
+    num_freed = reclaim_unreported_num;
+    reclaim_unreported_num = 0;
+  }
+  RECLAIM_UNLOCK();
+#else  /* #if POSIX_PARALLEL */
+  reclaim_run();
+
+  num_freed = reclaim_unreported_num;
+  reclaim_unreported_num = 0;
+#endif /* #if POSIX_PARALLEL */
+
+  return num_freed;
+}
+
+size_t memory_tracker_reclaim_pending(void)
+{
+  size_t num;
+
+  RECLAIM_LOCK();
+  {
+    num = reclaim_queued_num - reclaim_done_num;
+  }
+  RECLAIM_UNLOCK();
+
+  return num;
+}
+
+void memory_tracker_reclaim_stop(void)
+{
+#if POSIX_PARALLEL
+  RECLAIM_LOCK();
+  {
+    if (!reclaim_running)
+    {
+      RECLAIM_UNLOCK();
+      return;
+    }
+
+    reclaim_stopping = 1;
+    pthread_cond_signal(&reclaim_queued_cond);
+  }
+  RECLAIM_UNLOCK();
+
+  /* The reclaimer empties the queue before it exits. */
+  pthread_join(reclaim_thread, NULL);
+
+  RECLAIM_LOCK();
+  {
+    reclaim_running  = 0;
+    reclaim_stopping = 0;
+
+    /* Jobs queued while it was exiting. */
+    if (reclaim_head)
+      reclaim_require_thread();
+
+    pthread_cond_broadcast(&reclaim_done_cond);
+  }
+  RECLAIM_UNLOCK();
+#else  /* #if POSIX_PARALLEL */
+  reclaim_run();
+#endif /* #if POSIX_PARALLEL */
+}
+
+/* ---------------------------------------------------------------- */
+/* Dependency graph.                                                */
+
+#define DEPENDENCY_GRAPH_MIN_EDGES 16
+#define TRACKER_MIN_BUFFER         16
+
+static void dependency_graph_init(dependency_graph_t *graph)
+{
+  graph->edges           = NULL;
+  graph->edges_num       = 0;
+  graph->edges_size      = 0;
+  graph->edges_len       = 0;
+  graph->edges_free      = DEPENDENCY_EDGE_NONE;
+
+  graph->parent_heads    = NULL;
+  graph->dependent_heads = NULL;
+  graph->heads_size      = 0;
+}
+
+static size_t dependency_graph_deinit(dependency_graph_t *graph, const memory_manager_t *manager)
+{
+  size_t num_freed = 0;
+
+  if (graph->edges)
+    num_freed += memory_manager_mfree(manager, graph->edges);
+  if (graph->parent_heads)
+    num_freed += memory_manager_mfree(manager, graph->parent_heads);
+  if (graph->dependent_heads)
+    num_freed += memory_manager_mfree(manager, graph->dependent_heads);
+
+  dependency_graph_init(graph);
+
+  return num_freed;
+}
+
+/*
+ * Grow "buf", holding "num" elements of "size" bytes, by doubling until it
+ * holds at least "min_num" elements.
+ *
+ * Returns NULL on failure, leaving "buf" intact.
+ */
+static void *tracker_grow_buffer(const memory_manager_t *manager, void *buf, size_t size, size_t num, size_t min_num, size_t *out_num)
+{
+  size_t  new_num;
+  void   *new_buf;
+
+  new_num = num ? num : TRACKER_MIN_BUFFER;
+  while (new_num < min_num)
+  {
+    if (new_num > ((size_t) (-1)) / 2)
+      return NULL;
+
+    new_num *= 2;
+  }
+
+  if (new_num > ((size_t) (-1)) / size)
+    return NULL;
+
+  if (!buf)
+    new_buf = memory_manager_mmalloc (manager,      new_num * size);
+  else
+    new_buf = memory_manager_mrealloc(manager, buf, new_num * size);
+
+  if (!new_buf)
+    return NULL;
+
+  *out_num = new_num;
+  return new_buf;
+}
+
+/* Ensure "ref" can index the heads. */
+static int dependency_graph_reserve_ref(dependency_graph_t *graph, size_t ref, const memory_manager_t *manager)
+{
+  size_t  old_size;
+  size_t  new_size;
+  size_t *heads;
+  size_t  i;
+
+  if (ref < graph->heads_size)
+    return 1;
+
+  if (ref == DEPENDENCY_EDGE_NONE)
+    return 0;
+
+  old_size = graph->heads_size;
+
+  heads = tracker_grow_buffer(manager, graph->parent_heads, sizeof(*heads), old_size, ref + 1, &new_size);
+  if (!heads)
+    return 0;
+  graph->parent_heads = heads;
+
+  heads = tracker_grow_buffer(manager, graph->dependent_heads, sizeof(*heads), old_size, ref + 1, &new_size);
+  if (!heads)
+    return 0;
+  graph->dependent_heads = heads;
+
+  for (i = old_size; i < new_size; ++i)
+  {
+    graph->parent_heads   [i] = DEPENDENCY_EDGE_NONE;
+    graph->dependent_heads[i] = DEPENDENCY_EDGE_NONE;
+  }
+
+  graph->heads_size = new_size;
+
+  return 1;
+}
+
+/* First edge with "ref" as its parent. */
+static size_t dependency_graph_parent_head(const dependency_graph_t *graph, size_t ref)
+{
+  if (ref >= graph->heads_size)
+    return DEPENDENCY_EDGE_NONE;
+
+  return graph->parent_heads[ref];
+}
+
+/* First edge with "ref" as its dependent. */
+static size_t dependency_graph_dependent_head(const dependency_graph_t *graph, size_t ref)
+{
+  if (ref >= graph->heads_size)
+    return DEPENDENCY_EDGE_NONE;
+
+  return graph->dependent_heads[ref];
+}
+
+static size_t dependency_graph_find(const dependency_graph_t *graph, allocation_dependency_t dependency)
+{
+  size_t edge;
+
+  for
+    ( edge = dependency_graph_parent_head(graph, dependency.parent)
+    ; edge != DEPENDENCY_EDGE_NONE
+    ; edge = graph->edges[edge].parent_next
+    )
+  {
+    if (graph->edges[edge].dependency.dependent == dependency.dependent)
+      return edge;
+  }
+
+  return DEPENDENCY_EDGE_NONE;
+}
+
+/* Returns the index of the new or existing edge, or DEPENDENCY_EDGE_NONE. */
+static size_t dependency_graph_add(dependency_graph_t *graph, allocation_dependency_t dependency, const memory_manager_t *manager)
+{
+  size_t             edge;
+  dependency_edge_t *edges;
+  size_t             edges_size;
+  dependency_edge_t *value;
+
+  edge = dependency_graph_find(graph, dependency);
+  if (edge != DEPENDENCY_EDGE_NONE)
+    return edge;
+
+  if (!dependency_graph_reserve_ref(graph, max_size(dependency.parent, dependency.dependent), manager))
+    return DEPENDENCY_EDGE_NONE;
+
+  if (graph->edges_free != DEPENDENCY_EDGE_NONE)
+  {
+    edge              = graph->edges_free;
+    graph->edges_free = graph->edges[edge].parent_next;
+  }
+  else
+  {
+    if (graph->edges_num >= graph->edges_size)
+    {
+      edges = tracker_grow_buffer(manager, graph->edges, sizeof(*edges), graph->edges_size, graph->edges_num + 1, &edges_size);
+      if (!edges)
+        return DEPENDENCY_EDGE_NONE;
+
+      graph->edges      = edges;
+      graph->edges_size = edges_size;
+    }
+
+    edge = graph->edges_num++;
+  }
+
+  value = &graph->edges[edge];
+
+  value->dependency     = dependency;
+  value->in_use         = 1;
+
+  value->parent_prev    = DEPENDENCY_EDGE_NONE;
+  value->parent_next    = graph->parent_heads[dependency.parent];
+  if (value->parent_next != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->parent_next].parent_prev = edge;
+  graph->parent_heads[dependency.parent] = edge;
+
+  value->dependent_prev = DEPENDENCY_EDGE_NONE;
+  value->dependent_next = graph->dependent_heads[dependency.dependent];
+  if (value->dependent_next != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->dependent_next].dependent_prev = edge;
+  graph->dependent_heads[dependency.dependent] = edge;
+
+  ++graph->edges_len;
+
+  return edge;
+}
+
+static void dependency_graph_remove(dependency_graph_t *graph, size_t edge)
+{
+  dependency_edge_t *value = &graph->edges[edge];
+
+  if (value->parent_prev != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->parent_prev].parent_next = value->parent_next;
+  else
+    graph->parent_heads[value->dependency.parent] = value->parent_next;
+
+  if (value->parent_next != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->parent_next].parent_prev = value->parent_prev;
+
+  if (value->dependent_prev != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->dependent_prev].dependent_next = value->dependent_next;
+  else
+    graph->dependent_heads[value->dependency.dependent] = value->dependent_next;
+
+  if (value->dependent_next != DEPENDENCY_EDGE_NONE)
+    graph->edges[value->dependent_next].dependent_prev = value->dependent_prev;
+
+  value->dependency  = null_allocation_dependency;
+  value->in_use      = 0;
+  value->parent_next = graph->edges_free;
+  graph->edges_free  = edge;
+
+  --graph->edges_len;
+}
+
+/* Remove every edge with "ref" as its parent, and, if "incoming" is set, as */
+/* its dependent.  Returns the number of edges removed.                     */
+static size_t dependency_graph_remove_ref(dependency_graph_t *graph, size_t ref, int incoming)
+{
+  size_t num_removed;
+  size_t edge;
+
+  num_removed = 0;
+
+  while ((edge = dependency_graph_parent_head(graph, ref)) != DEPENDENCY_EDGE_NONE)
+  {
+    dependency_graph_remove(graph, edge);
+    ++num_removed;
+  }
+
+  if (incoming)
+  {
+    while ((edge = dependency_graph_dependent_head(graph, ref)) != DEPENDENCY_EDGE_NONE)
+    {
+      dependency_graph_remove(graph, edge);
+      ++num_removed;
+    }
+  }
+
+  return num_removed;
+}
+
+/* ---------------------------------------------------------------- */
+
+/* A tracked allocation of any type. */
+typedef union resolved_allocation_u resolved_allocation_t;
+union resolved_allocation_u
+{
+  byte_allocation_t   byte;
+  tval_allocation_t   tval;
+  manual_allocation_t manual;
+};
+
+/* Obtain the allocation "ref" refers to.  Returns 0 when it isn't tracked. */
+static int resolve_allocation(memory_tracker_t *tracker, size_t ref, resolved_allocation_t *out)
+{
+  int index = (int) GET_ALLOC_DEP_INDEX(ref);
+
+  switch (GET_ALLOC_DEP_TYPE(ref))
+  {
+    default:
+      return 0;
 
-            , NULL
-            , &is_duplicate
-            )
-         )
-        lookup = NULL;
+    case a_t_byte:
+      out->byte   = get_byte_allocation  (tracker, index);
+      return out->byte != NULL;
 
-    if (is_duplicate)
-      lookup = NULL;
+    case a_t_tval:
+      out->tval   = get_tval_allocation  (tracker, index);
+      return out->tval != NULL;
 
-    if (!lookup)
-    {
-      /* Error: failed to initialize lookup container! */
+    case a_t_manual:
+      out->manual = get_manual_allocation(tracker, index);
+      return !is_manual_allocation_null(out->manual);
+  }
+}
 
-      lookup_deinit(tracker->byte_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->byte_allocations
-        );
-      tracker->byte_allocations = NULL;
+/* Free a block, or retire it when "tracker" retires what it frees. */
+static size_t tracker_release_bytes(memory_tracker_t *tracker, void *ptr)
+{
+  if (tracker->retire)
+    return epoch_retire_bytes(MEMORY_TRACKER_CMANAGER(tracker), ptr);
+  else
+    return memory_manager_mfree(MEMORY_TRACKER_CMANAGER(tracker), ptr);
+}
 
-      if (tracker->tval_allocations)
-      {
-        lookup_deinit(tracker->tval_allocations, memory_manager);
-        memory_manager_mfree
-          ( memory_manager
-          , tracker->tval_allocations
-          );
-        tracker->tval_allocations = NULL;
-      }
+/* Untrack and free an allocation, ignoring dependencies. */
+static size_t release_allocation(memory_tracker_t *tracker, size_t ref, resolved_allocation_t allocation)
+{
+  switch (GET_ALLOC_DEP_TYPE(ref))
+  {
+    default:
+      return 0;
 
-      return NULL;
-    }
+    case a_t_byte:
+      if (!untrack_byte_allocation(tracker, allocation.byte))
+        return 0;
+      return 1 + tracker_release_bytes(tracker, allocation.byte);
 
-    tracker->tval_allocations = lookup;
+    case a_t_tval:
+      if (!untrack_tval_allocation(tracker, allocation.tval))
+        return 0;
+      if (tracker->retire)
+        return 1 + epoch_retire_tval(allocation.tval);
+      return 1 + tval_free(allocation.tval);
+
+    case a_t_manual:
+      if (is_manual_allocation_null(untrack_manual_allocation(tracker, allocation.manual)))
+        return 0;
+      if (tracker->retire)
+        return 1 + epoch_retire(allocation.manual.cleanup, allocation.manual.context);
+      return 1 + allocation.manual.cleanup(allocation.manual.context);
   }
+}
 
-  if (!tracker->manual_allocations)
-  {
-    int is_duplicate = -1;
+#define VISITED_GET(visited, ref) \
+  ((visited)[(ref) / CHAR_BIT] &  (1U << ((ref) % CHAR_BIT)))
+#define VISITED_SET(visited, ref) \
+  ((visited)[(ref) / CHAR_BIT] |= (1U << ((ref) % CHAR_BIT)))
 
-    lookup_t     *lookup;
-    const size_t  value_size = sizeof(manual_allocation_t);
+/*
+ * Free every allocation reachable from "root" through the dependency graph,
+ * and "root" itself if "include_root" is set.
+ *
+ * The graph is walked breadth-first with an explicit worklist, and reached
+ * allocations are marked in a bitmap indexed by their packed reference, so
+ * each is freed once, stack use is bounded, and cycles terminate; the whole
+ * walk is O(V+E).  Every reached allocation is resolved before any is
+ * untracked, so the indices the edges refer to stay valid throughout.
+ *
+ * Returns the number of allocations untracked and edges removed, plus what
+ * freeing each allocation returned.
+ */
+static size_t free_allocation_graph(memory_tracker_t *tracker, size_t root, int include_root)
+{
+  size_t num_freed;
 
-    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+  dependency_graph_t     *graph;
+  const memory_manager_t *manager;
 
-    tracker->manual_allocations =
-      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->manual_allocations));
+  size_t                 *worklist;
+  size_t                  worklist_num;
+  size_t                  worklist_size;
+  size_t                 *new_worklist;
 
-    if (lookup)
-      lookup = lookup_init_empty(lookup, value_size);
+  resolved_allocation_t  *resolved;
+  unsigned char          *visited;
+  size_t                  visited_size;
 
-    if (lookup)
-      if (!lookup_minsert
-            ( tracker->byte_allocations
-            , &lookup
-            , LOOKUP_NO_ADD_DUPLICATES
+  resolved_allocation_t   allocation;
 
-            , cmp_byte_allocation
+  size_t                  i;
+  size_t                  edge;
+  size_t                  ref;
 
-            , memory_manager
+  graph   = tracker->dependency_graph;
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
 
-            , NULL
-            , &is_duplicate
-            )
-         )
-        lookup = NULL;
+  /* ---------------------------------------------------------------- */
+  /* Common case: no dependents.                                      */
 
-    if (is_duplicate)
-      lookup = NULL;
+  if (dependency_graph_parent_head(graph, root) == DEPENDENCY_EDGE_NONE)
+  {
+    if (!include_root)
+      return 0;
 
-    if (!lookup)
-    {
-      /* Error: failed to initialize lookup container! */
+    if (!resolve_allocation(tracker, root, &allocation))
+      return 0;
 
-      lookup_deinit(tracker->byte_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->byte_allocations
-        );
-      tracker->byte_allocations = NULL;
+    num_freed  = dependency_graph_remove_ref(graph, root, TRUE());
+    num_freed += release_allocation(tracker, root, allocation);
 
-      lookup_deinit(tracker->tval_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->tval_allocations
-        );
-      tracker->tval_allocations = NULL;
+    return num_freed;
+  }
 
-      if (tracker->manual_allocations)
+  /* ---------------------------------------------------------------- */
+  /* Collect reachable allocations.                                   */
+
+  /* Only refs with edges, all below "heads_size", are reached. */
+  visited_size = max_size(graph->heads_size, root + 1);
+
+  visited = memory_manager_mcalloc(manager, (visited_size + CHAR_BIT - 1) / CHAR_BIT, 1);
+  if (!visited)
+    return 0;
+
+  worklist_size = DEPENDENCY_GRAPH_MIN_EDGES;
+  worklist      = memory_manager_mmalloc(manager, worklist_size * sizeof(*worklist));
+  if (!worklist)
+  {
+    memory_manager_mfree(manager, visited);
+    return 0;
+  }
+
+  worklist[0]  = root;
+  worklist_num = 1;
+  VISITED_SET(visited, root);
+
+  for (i = 0; i < worklist_num; ++i)
+  {
+    for
+      ( edge = dependency_graph_parent_head(graph, worklist[i])
+      ; edge != DEPENDENCY_EDGE_NONE
+      ; edge = graph->edges[edge].parent_next
+      )
+    {
+      ref = graph->edges[edge].dependency.dependent;
+
+      if (VISITED_GET(visited, ref))
+        continue;
+      VISITED_SET(visited, ref);
+
+      if (worklist_num >= worklist_size)
       {
-        lookup_deinit(tracker->manual_allocations, memory_manager);
-        memory_manager_mfree
-          ( memory_manager
-          , tracker->manual_allocations
-          );
-        tracker->manual_allocations = NULL;
+        new_worklist = tracker_grow_buffer(manager, worklist, sizeof(*worklist), worklist_size, worklist_num + 1, &worklist_size);
+        if (!new_worklist)
+        {
+          memory_manager_mfree(manager, worklist);
+          memory_manager_mfree(manager, visited);
+          return 0;
+        }
+
+        worklist = new_worklist;
       }
 
-      return NULL;
+      worklist[worklist_num++] = ref;
     }
+  }
 
-    tracker->tval_allocations = lookup;
+  memory_manager_mfree(manager, visited);
+
+  /* ---------------------------------------------------------------- */
+  /* Resolve them.                                                    */
+
+  resolved = memory_manager_mmalloc(manager, worklist_num * sizeof(*resolved));
+  if (!resolved)
+  {
+    memory_manager_mfree(manager, worklist);
+    return 0;
   }
 
-  if (!tracker->dependency_graph)
+  for (i = 0; i < worklist_num; ++i)
   {
-    int is_duplicate = -1;
+    if (!resolve_allocation(tracker, worklist[i], &resolved[i]))
+      worklist[i] = DEPENDENCY_EDGE_NONE;
+  }
 
-    lookup_t     *lookup;
-    const size_t  value_size = sizeof(allocation_dependency_t);
+  /* ---------------------------------------------------------------- */
+  /* Remove their edges and free them.                                */
 
-    const memory_manager_t *memory_manager = MEMORY_TRACKER_CMANAGER(tracker);
+  num_freed = 0;
 
-    tracker->dependency_graph =
-      lookup = memory_manager_mmalloc(memory_manager, sizeof(*tracker->dependency_graph));
+  for (i = 0; i < worklist_num; ++i)
+  {
+    ref = worklist[i];
+    if (ref == DEPENDENCY_EDGE_NONE)
+      ref = (i == 0) ? root : DEPENDENCY_EDGE_NONE;
+    if (ref == DEPENDENCY_EDGE_NONE)
+      continue;
 
-    if (lookup)
-      lookup = lookup_init_empty(lookup, value_size);
+    num_freed += dependency_graph_remove_ref(graph, ref, include_root || i > 0);
+  }
 
-    if (lookup)
-      if (!lookup_minsert
-            ( tracker->byte_allocations
-            , &lookup
-            , LOOKUP_NO_ADD_DUPLICATES
+  for (i = include_root ? 0 : 1; i < worklist_num; ++i)
+  {
+    if (worklist[i] == DEPENDENCY_EDGE_NONE)
+      continue;
 
-            , cmp_byte_allocation
+    num_freed += release_allocation(tracker, worklist[i], resolved[i]);
+  }
 
-            , memory_manager
+  memory_manager_mfree(manager, resolved);
+  memory_manager_mfree(manager, worklist);
 
-            , NULL
-            , &is_duplicate
-            )
-         )
-        lookup = NULL;
+  return num_freed;
+}
 
-    if (is_duplicate)
-      lookup = NULL;
+/* ---------------------------------------------------------------- */
+/* Checkpoint journal.                                              */
 
-    if (!lookup)
-    {
-      /* Error: failed to initialize lookup container! */
+/* Ensure the journal has room for one more entry while checkpoints are active. */
+static int journal_reserve(memory_tracker_t *tracker)
+{
+  memory_tracker_journal_entry_t *journal;
+  size_t                          journal_size;
 
-      lookup_deinit(tracker->byte_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->byte_allocations
-        );
-      tracker->byte_allocations = NULL;
+  if (tracker->checkpoints_num <= 0)
+    return 1;
 
-      lookup_deinit(tracker->tval_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->tval_allocations
-        );
-      tracker->tval_allocations = NULL;
+  if (tracker->journal_num < tracker->journal_size)
+    return 1;
 
-      lookup_deinit(tracker->manual_allocations, memory_manager);
-      memory_manager_mfree
-        ( memory_manager
-        , tracker->manual_allocations
-        );
-      tracker->manual_allocations = NULL;
+  journal = tracker_grow_buffer(MEMORY_TRACKER_CMANAGER(tracker), tracker->journal, sizeof(*journal), tracker->journal_size, tracker->journal_num + 1, &journal_size);
+  if (!journal)
+    return 0;
 
-      if (tracker->dependency_graph)
-      {
-        lookup_deinit(tracker->dependency_graph, memory_manager);
-        memory_manager_mfree
-          ( memory_manager
-          , tracker->dependency_graph
-          );
-        tracker->dependency_graph = NULL;
-      }
+  tracker->journal      = journal;
+  tracker->journal_size = journal_size;
 
-      return NULL;
-    }
+  return 1;
+}
 
-    tracker->tval_allocations = lookup;
-  }
+/* Record a newly tracked allocation; space must have been reserved. */
+static void journal_append(memory_tracker_t *tracker, allocation_type_t type, resolved_allocation_t allocation)
+{
+  memory_tracker_journal_entry_t *entry;
 
-  return tracker;
+  if (tracker->checkpoints_num <= 0)
+    return;
+
+  entry = &tracker->journal[tracker->journal_num++];
+
+  entry->type = type;
+  switch (type)
+  {
+    default:
+      break;
+
+    case a_t_byte:
+      entry->allocation.byte   = allocation.byte;
+      break;
+
+    case a_t_tval:
+      entry->allocation.tval   = allocation.tval;
+      break;
+
+    case a_t_manual:
+      entry->allocation.manual = allocation.manual;
+      break;
+  }
 }
 
-size_t memory_tracker_free_containers(memory_tracker_t *tracker)
+static int journal_entry_is(const memory_tracker_journal_entry_t *entry, allocation_type_t type, resolved_allocation_t allocation)
 {
-  size_t num_freed;
+  if (entry->type != type)
+    return 0;
 
-  const memory_manager_t *manager;
+  switch (type)
+  {
+    default:
+      return 0;
 
-  void *free_byte_allocations   = NULL;
-  void *free_tval_allocations   = NULL;
-  void *free_manual_allocations = NULL;
-  void *free_dependency_graph   = NULL;
+    case a_t_byte:
+      return entry->allocation.byte == allocation.byte;
 
-  lookup_t            *lookup;
-  const bnode_t       *root;
+    case a_t_tval:
+      return entry->allocation.tval == allocation.tval;
 
-  byte_allocation_t    byte_value;
-  tval_allocation_t    tval_value;
-  manual_allocation_t  manual_value;
+    case a_t_manual:
+      return
+           entry->allocation.manual.cleanup == allocation.manual.cleanup
+        && entry->allocation.manual.context == allocation.manual.context
+        ;
+  }
+}
 
-  size_t               result_num;
-  byte_allocation_t    result_byte;
+/*
+ * After a "replace" method has untracked "src" and newly tracked, and so
+ * journaled, "dest", give "dest" "src"'s place in the journal: "dest" is
+ * journaled only if "src" was.
+ */
+static void journal_replace(memory_tracker_t *tracker, allocation_type_t src_type, resolved_allocation_t src, int have_src, int added_dest)
+{
+  memory_tracker_journal_entry_t dest_entry;
+  size_t                         i;
+
+  if (tracker->checkpoints_num <= 0 || !added_dest || tracker->journal_num <= 0)
+    return;
 
+  dest_entry = tracker->journal[--tracker->journal_num];
+
+  if (!have_src)
+    return;
+
+  for (i = tracker->journal_num; i > 0; --i)
+  {
+    if (journal_entry_is(&tracker->journal[i - 1], src_type, src))
+    {
+      tracker->journal[i - 1] = dest_entry;
+      return;
+    }
+  }
+}
+
+memory_tracker_checkpoint_t *memory_tracker_checkpoint(memory_tracker_t *tracker, memory_tracker_checkpoint_t *out_checkpoint)
+{
 #if ERROR_CHECKING
   if (!tracker)
-    return 0;
+    return NULL;
 #endif /* #if ERROR_CHECKING */
 
-  num_freed = 0;
+  if (!out_checkpoint)
+    return NULL;
+
+  if (tracker->checkpoints_num >= tracker->checkpoints_size)
+  {
+    size_t *serials;
+    size_t  serials_size;
+
+    serials = tracker_grow_buffer(MEMORY_TRACKER_CMANAGER(tracker), tracker->checkpoint_serials, sizeof(*serials), tracker->checkpoints_size, tracker->checkpoints_num + 1, &serials_size);
+    if (!serials)
+      return NULL;
+
+    tracker->checkpoint_serials = serials;
+    tracker->checkpoints_size   = serials_size;
+  }
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
+  tracker->checkpoint_serials[tracker->checkpoints_num++] = tracker->checkpoint_serial;
 
-  /* ---------------------------------------------------------------- */
-  /* Free all non--container allocations.                             */
+  out_checkpoint->depth            = tracker->checkpoints_num;
+  out_checkpoint->serial           = tracker->checkpoint_serial++;
+  out_checkpoint->journal_num      = tracker->journal_num;
+  out_checkpoint->intrusive_serial = tracker->intrusive_serial;
 
-  if (tracker->byte_allocations)
-  {
-    lookup = tracker->byte_allocations;
+  return out_checkpoint;
+}
 
-    while(!LOOKUP_EMPTY(tracker->byte_allocations))
-    {
-      root       =
-        ( (LOOKUP_ROOT_CNODE(lookup)) );
-      byte_value = DEREF_PTR
-        ( (const byte_allocation_t *)
-          (LOOKUP_NODE_VALUE(lookup, root))
-        );
+/* Whether "checkpoint" is still active, rather than ended, even if another */
+/* has since been taken at its depth.                                      */
+static int memory_tracker_checkpoint_is_active(const memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint)
+{
+  if (checkpoint->depth <= 0 || checkpoint->depth > tracker->checkpoints_num)
+    return 0;
 
-      if      (byte_value == tracker->byte_allocations)
-      {
-        free_byte_allocations   = byte_value;
-      }
-      else if (byte_value == tracker->tval_allocations)
-      {
-        free_tval_allocations   = byte_value;
-      }
-      else if (byte_value == tracker->manual_allocations)
-      {
-        free_manual_allocations = byte_value;
-      }
-      else if (byte_value == tracker->dependency_graph)
-      {
-        free_dependency_graph   = byte_value;
-      }
-      else
-      {
-        /* Standard allocation.  Free it. */
+  return tracker->checkpoint_serials[checkpoint->depth - 1] == checkpoint->serial;
+}
 
-        result_num = free_byte_allocation(tracker, byte_value);
-        if (!result_num)
-        {
-          /* Error: failed to free a byte allocation! */
-#if ERROR_CHECKING
-          bug
-            ( "Error: memory_tracker_free_containers: line #"
-              CURRENT_LINE_STR
-              "failed to free a byte allocation!\n"
-            );
-#endif /* #if ERROR_CHECKING */
-          break;
-        }
+/* End "checkpoint" and those taken after it. */
+static void memory_tracker_end_checkpoint(memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint)
+{
+  tracker->checkpoints_num = checkpoint->depth - 1;
 
-        num_freed += result_num;
-        continue;
-      }
+  /* Without an enclosing checkpoint, nothing needs the journal. */
+  if (tracker->checkpoints_num <= 0)
+    tracker->journal_num = 0;
+}
 
-      /* Just remove the allocation container reference. */
-      /*                                                 */
-      /* We'll free the container once we're done        */
-      /* freeing all non-container allocations.          */
+size_t memory_tracker_rollback(memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint)
+{
+  size_t num_freed;
+
+  memory_tracker_journal_entry_t entry;
 
-      result_byte = untrack_byte_allocation(tracker, byte_value);
-      if (!result_byte)
-      {
-          /* Error: failed to untrack a container! */
 #if ERROR_CHECKING
-          bug
-            ( "Error: memory_tracker_free_containers: line #"
-              CURRENT_LINE_STR
-              "failed to untrack container!\n"
-            );
+  if (!tracker)
+    return 0;
 #endif /* #if ERROR_CHECKING */
-          break;
-      }
-
-      continue;
-    }
-  }
 
-  if (tracker->tval_allocations)
-  {
-    lookup = tracker->tval_allocations;
+  if (!checkpoint)
+    return 0;
 
-    while(!LOOKUP_EMPTY(tracker->tval_allocations))
-    {
-      root       =
-        ( (LOOKUP_ROOT_CNODE(lookup)) );
-      tval_value = DEREF_PTR
-        ( (const tval_allocation_t *)
-          (LOOKUP_NODE_VALUE(lookup, root))
-        );
+  /* Already ended? */
+  if (!memory_tracker_checkpoint_is_active(tracker, checkpoint))
+    return 0;
 
-      result_num = free_tval_allocation(tracker, tval_value);
-      if (!result_num)
-      {
-        /* Error: failed to free a tval allocation! */
-#if ERROR_CHECKING
-        bug
-          ( "Error: memory_tracker_free_containers: line #"
-            CURRENT_LINE_STR
-            "failed to free a tval allocation!\n"
-          );
-#endif /* #if ERROR_CHECKING */
-        break;
-      }
+  num_freed = 0;
 
-      num_freed += result_num;
-    }
-  }
+  /* ---------------------------------------------------------------- */
+  /* Journaled allocations, newest first.                             */
 
-  if (tracker->manual_allocations)
+  while (tracker->journal_num > checkpoint->journal_num)
   {
-    lookup = tracker->manual_allocations;
+    entry = tracker->journal[--tracker->journal_num];
 
-    while(!LOOKUP_EMPTY(tracker->manual_allocations))
+    /* Entries of allocations since untracked are skipped. */
+    switch (entry.type)
     {
-      root         =
-        ( (LOOKUP_ROOT_CNODE(lookup)) );
-      manual_value = DEREF_DEFAULT
-        ( (const manual_allocation_t *)
-          (LOOKUP_NODE_VALUE(lookup, root))
-        , manual_allocation_defaults
-        );
+      default:
+        break;
 
-      result_num = free_manual_allocation(tracker, manual_value);
-      if (!result_num)
-      {
-        /* Error: failed to free a manual allocation! */
-#if ERROR_CHECKING
-        bug
-          ( "Error: memory_tracker_free_containers: line #"
-            CURRENT_LINE_STR
-            "failed to free a manual allocation!\n"
-          );
-#endif /* #if ERROR_CHECKING */
+      case a_t_byte:
+        num_freed += free_byte_allocation  (tracker, entry.allocation.byte);
         break;
-      }
 
-      num_freed += result_num;
+      case a_t_tval:
+        num_freed += free_tval_allocation  (tracker, entry.allocation.tval);
+        break;
+
+      case a_t_manual:
+        num_freed += free_manual_allocation(tracker, entry.allocation.manual);
+        break;
     }
   }
 
   /* ---------------------------------------------------------------- */
-  /* Free containers.                                                 */
-
-  if ((lookup = tracker->byte_allocations))
-    num_freed += lookup_deinit(lookup, manager);
-  if ((lookup = tracker->tval_allocations))
-    num_freed += lookup_deinit(lookup, manager);
-  if ((lookup = tracker->manual_allocations))
-    num_freed += lookup_deinit(lookup, manager);
-  if ((lookup = tracker->dependency_graph))
-    num_freed += lookup_deinit(lookup, manager);
+  /* Intrusively tracked blocks.                                      */
 
-  if (free_byte_allocations)
-    num_freed += memory_manager_mfree(manager, free_byte_allocations);
-  if (free_tval_allocations)
-    num_freed += memory_manager_mfree(manager, free_tval_allocations);
-  if (free_manual_allocations)
-    num_freed += memory_manager_mfree(manager, free_manual_allocations);
-  if (free_dependency_graph)
-    num_freed += memory_manager_mfree(manager, free_dependency_graph);
+  num_freed += memory_tracker_rollback_intrusive(tracker, checkpoint->intrusive_serial);
 
   /* ---------------------------------------------------------------- */
-  /* Unset containers.                                                */
-
-  tracker->byte_allocations   = NULL;
-  tracker->tval_allocations   = NULL;
-  tracker->manual_allocations = NULL;
-  tracker->dependency_graph   = NULL;
 
-  /* ---------------------------------------------------------------- */
-  /* Success!                                                         */
+  memory_tracker_end_checkpoint(tracker, checkpoint);
 
   return num_freed;
 }
 
+memory_tracker_t *memory_tracker_commit(memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint)
+{
+#if ERROR_CHECKING
+  if (!tracker)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  if (!checkpoint)
+    return NULL;
+
+  if (!memory_tracker_checkpoint_is_active(tracker, checkpoint))
+    return NULL;
+
+  memory_tracker_end_checkpoint(tracker, checkpoint);
+
+  return tracker;
+}
+
 /* ---------------------------------------------------------------- */
 /* byte_allocation tracking.                                        */
 
@@ -1060,7 +2824,6 @@ int track_byte_allocation(memory_tracker_t *tracker, byte_allocation_t allocatio
 
   lookup_t *lookup;
 
-  UNUSED(is_duplicate);
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1075,6 +2838,13 @@ int track_byte_allocation(memory_tracker_t *tracker, byte_allocation_t allocatio
   if (!allocation)
     return -4;
 
+  /* "track_mfree" assumes every block of an intrusive tracker has a header. */
+  if (tracker->intrusive)
+    return -7;
+
+  if (!journal_reserve(tracker))
+    return -6;
+
   lookup =
     lookup_minsert
       ( lookup
@@ -1092,6 +2862,14 @@ int track_byte_allocation(memory_tracker_t *tracker, byte_allocation_t allocatio
   if (!lookup)
     return -5;
 
+  if (!is_duplicate)
+  {
+    resolved_allocation_t resolved;
+
+    resolved.byte = allocation;
+    journal_append(tracker, a_t_byte, resolved);
+  }
+
   return (int) value_index;
 }
 
@@ -1236,12 +3014,7 @@ int tracked_byte_allocation(const memory_tracker_t *tracker, byte_allocation_t a
 
 size_t free_byte_allocation(memory_tracker_t *tracker, byte_allocation_t allocation)
 {
-  size_t num_freed;
-
-  size_t            result_num             = 0;
-  byte_allocation_t result_byte_allocation = NULL;
-
-  const memory_manager_t *manager;
+  int index;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1254,121 +3027,33 @@ size_t free_byte_allocation(memory_tracker_t *tracker, byte_allocation_t allocat
   if (!allocation)
     return 0;
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  /* ---------------------------------------------------------------- */
-  /* Untrack byte allocation.                                         */
-
-  result_byte_allocation = untrack_byte_allocation(tracker, allocation);
-  if (!result_byte_allocation)
-    return num_freed;
-  ++num_freed;
-
-  /* ---------------------------------------------------------------- */
-  /* Free dependencies.                                               */
-
-  num_freed += free_byte_allocation_dependencies(tracker, allocation);
-
-  /* ---------------------------------------------------------------- */
-  /* Free allocation.                                                 */
-
-  result_num = memory_manager_mfree(manager, allocation);
-  if (!result_num)
-  {
-    --num_freed;
-    result_num = track_byte_allocation(tracker, allocation);
-    if (!result_num)
-      return num_freed;
-
-    return num_freed;
-  }
-
-  num_freed += result_num;
-
-  /* ---------------------------------------------------------------- */
-  /* Done!                                                            */
+  index = tracked_byte_allocation(tracker, allocation);
+  if (index < 0)
+    return 0;
 
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_BYTE((size_t) index), TRUE());
 }
 
 size_t free_byte_allocation_dependencies(memory_tracker_t *tracker, byte_allocation_t allocation)
 {
-  size_t num_freed;
-
   int index;
 
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency = (const void * const) &value;
-
-  allocation_dependency_t key;
-
-  size_t result_num;
-  size_t subresult_num;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
 #if ERROR_CHECKING
   if (!tracker)
-    return 0;
-#endif /* #if ERROR_CHECKING */
-
-  if (!memory_tracker_require_containers(tracker))
-    return 0;
-
-  lookup = tracker->byte_allocations;
-
-  if (!allocation)
-    return 0;
-
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
-  index = tracked_byte_allocation(tracker, allocation);
-  if (index < 0)
-    return 0;
-
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  key = allocation_dependency_key(alloc_dep_byte((size_t) index));
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
-  {
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (!lookup)
-      return num_freed;
-#if ERROR_CHECKING
-    if (!result_num)
-      return num_freed;
-#endif /* #if ERROR_CHECKING */
-
-    subresult_num =
-      free_allocation
-        ( tracker
-        , GET_ALLOC_DEP_TYPE (dependency->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency->dependent)
-        );
-#if ERROR_CHECKING
-    if (!subresult_num)
-    {
-      /* Error: Couldn't free dependent! */
-      lookup_minsert(lookup, value, LOOKUP_ADD_DUPLICATES, cmp_allocation_dependency, manager, NULL, NULL);
-      return num_freed;
-    }
+    return 0;
 #endif /* #if ERROR_CHECKING */
 
-    num_freed += result_num;
-    num_freed += subresult_num;
-  }
+  if (!memory_tracker_require_containers(tracker))
+    return 0;
 
-  return num_freed;
+  if (!allocation)
+    return 0;
+
+  index = tracked_byte_allocation(tracker, allocation);
+  if (index < 0)
+    return 0;
+
+  return free_allocation_graph(tracker, ALLOC_DEP_BYTE((size_t) index), FALSE());
 }
 
 /* ---------------------------------------------------------------- */
@@ -1381,7 +3066,6 @@ int track_tval_allocation(memory_tracker_t *tracker, tval_allocation_t allocatio
 
   lookup_t *lookup;
 
-  UNUSED(is_duplicate);
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1396,6 +3080,9 @@ int track_tval_allocation(memory_tracker_t *tracker, tval_allocation_t allocatio
   if (!allocation)
     return -4;
 
+  if (!journal_reserve(tracker))
+    return -6;
+
   lookup =
     lookup_minsert
       ( lookup
@@ -1413,6 +3100,14 @@ int track_tval_allocation(memory_tracker_t *tracker, tval_allocation_t allocatio
   if (!lookup)
     return -5;
 
+  if (!is_duplicate)
+  {
+    resolved_allocation_t resolved;
+
+    resolved.tval = allocation;
+    journal_append(tracker, a_t_tval, resolved);
+  }
+
   return (int) value_index;
 }
 
@@ -1557,10 +3252,7 @@ int tracked_tval_allocation(const memory_tracker_t *tracker, tval_allocation_t a
 
 size_t free_tval_allocation(memory_tracker_t *tracker, tval_allocation_t allocation)
 {
-  size_t num_freed;
-
-  size_t            result_num             = 0;
-  tval_allocation_t result_tval_allocation = NULL;
+  int index;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1573,54 +3265,17 @@ size_t free_tval_allocation(memory_tracker_t *tracker, tval_allocation_t allocat
   if (!allocation)
     return 0;
 
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  /* ---------------------------------------------------------------- */
-  /* Untrack tval allocation.                                         */
-
-  result_tval_allocation = untrack_tval_allocation(tracker, allocation);
-  if (!result_tval_allocation)
-    return num_freed;
-  ++num_freed;
-
-  /* ---------------------------------------------------------------- */
-  /* Free dependencies.                                               */
-
-  num_freed += free_tval_allocation_dependencies(tracker, allocation);
-
-  /* ---------------------------------------------------------------- */
-  /* Free allocation.                                                 */
-
-  result_num = tval_free(allocation);
-
-  num_freed += result_num;
-
-  /* ---------------------------------------------------------------- */
-  /* Done!                                                            */
+  index = tracked_tval_allocation(tracker, allocation);
+  if (index < 0)
+    return 0;
 
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_TVAL((size_t) index), TRUE());
 }
 
 size_t free_tval_allocation_dependencies(memory_tracker_t *tracker, tval_allocation_t allocation)
 {
-  size_t num_freed;
-
   int index;
 
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency = (const void * const) &value;
-
-  allocation_dependency_t key;
-
-  size_t result_num;
-  size_t subresult_num;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
 #if ERROR_CHECKING
   if (!tracker)
     return 0;
@@ -1629,54 +3284,14 @@ size_t free_tval_allocation_dependencies(memory_tracker_t *tracker, tval_allocat
   if (!memory_tracker_require_containers(tracker))
     return 0;
 
-  lookup = tracker->tval_allocations;
-
   if (!allocation)
     return 0;
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
   index = tracked_tval_allocation(tracker, allocation);
   if (index < 0)
     return 0;
 
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  key = allocation_dependency_key(alloc_dep_tval((size_t) index));
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
-  {
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (!lookup)
-      return num_freed;
-#if ERROR_CHECKING
-    if (!result_num)
-      return num_freed;
-#endif /* #if ERROR_CHECKING */
-
-    subresult_num =
-      free_allocation
-        ( tracker
-        , GET_ALLOC_DEP_TYPE (dependency->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency->dependent)
-        );
-#if ERROR_CHECKING
-    if (!subresult_num)
-    {
-      /* Error: Couldn't free dependent! */
-      lookup_minsert(lookup, value, LOOKUP_ADD_DUPLICATES, cmp_allocation_dependency, manager, NULL, NULL);
-      return num_freed;
-    }
-#endif /* #if ERROR_CHECKING */
-
-    num_freed += result_num;
-    num_freed += subresult_num;
-  }
-
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_TVAL((size_t) index), FALSE());
 }
 
 /* ---------------------------------------------------------------- */
@@ -1689,7 +3304,6 @@ int track_manual_allocation(memory_tracker_t *tracker, manual_allocation_t alloc
 
   lookup_t *lookup;
 
-  UNUSED(is_duplicate);
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1704,6 +3318,9 @@ int track_manual_allocation(memory_tracker_t *tracker, manual_allocation_t alloc
   if (is_manual_allocation_null(allocation))
     return -4;
 
+  if (!journal_reserve(tracker))
+    return -6;
+
   lookup =
     lookup_minsert
       ( lookup
@@ -1721,6 +3338,14 @@ int track_manual_allocation(memory_tracker_t *tracker, manual_allocation_t alloc
   if (!lookup)
     return -5;
 
+  if (!is_duplicate)
+  {
+    resolved_allocation_t resolved;
+
+    resolved.manual = allocation;
+    journal_append(tracker, a_t_manual, resolved);
+  }
+
   return (int) value_index;
 }
 
@@ -1865,10 +3490,7 @@ int tracked_manual_allocation(const memory_tracker_t *tracker, manual_allocation
 
 size_t free_manual_allocation(memory_tracker_t *tracker, manual_allocation_t allocation)
 {
-  size_t num_freed;
-
-  size_t              result_num               = 0;
-  manual_allocation_t result_manual_allocation;
+  int index;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -1881,54 +3503,17 @@ size_t free_manual_allocation(memory_tracker_t *tracker, manual_allocation_t all
   if (is_manual_allocation_null(allocation))
     return 0;
 
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  /* ---------------------------------------------------------------- */
-  /* Untrack manual allocation.                                       */
-
-  result_manual_allocation = untrack_manual_allocation(tracker, allocation);
-  if (is_manual_allocation_null(result_manual_allocation))
-    return num_freed;
-  ++num_freed;
-
-  /* ---------------------------------------------------------------- */
-  /* Free dependencies.                                               */
-
-  num_freed += free_manual_allocation_dependencies(tracker, allocation);
-
-  /* ---------------------------------------------------------------- */
-  /* Free allocation.                                                 */
-
-  result_num = allocation.cleanup(allocation.context);
-
-  num_freed += result_num;
-
-  /* ---------------------------------------------------------------- */
-  /* Done!                                                            */
+  index = tracked_manual_allocation(tracker, allocation);
+  if (index < 0)
+    return 0;
 
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_MANUAL((size_t) index), TRUE());
 }
 
 size_t free_manual_allocation_dependencies(memory_tracker_t *tracker, manual_allocation_t allocation)
 {
-  size_t num_freed;
-
   int index;
 
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency = (const void * const) &value;
-
-  allocation_dependency_t key;
-
-  size_t result_num;
-  size_t subresult_num;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
 #if ERROR_CHECKING
   if (!tracker)
     return 0;
@@ -1937,54 +3522,14 @@ size_t free_manual_allocation_dependencies(memory_tracker_t *tracker, manual_all
   if (!memory_tracker_require_containers(tracker))
     return 0;
 
-  lookup = tracker->manual_allocations;
-
   if (is_manual_allocation_null(allocation))
     return 0;
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
   index = tracked_manual_allocation(tracker, allocation);
   if (index < 0)
     return 0;
 
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  key = allocation_dependency_key(alloc_dep_manual((size_t) index));
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
-  {
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (!lookup)
-      return num_freed;
-#if ERROR_CHECKING
-    if (!result_num)
-      return num_freed;
-#endif /* #if ERROR_CHECKING */
-
-    subresult_num =
-      free_allocation
-        ( tracker
-        , GET_ALLOC_DEP_TYPE (dependency->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency->dependent)
-        );
-#if ERROR_CHECKING
-    if (!subresult_num)
-    {
-      /* Error: Couldn't free dependent! */
-      lookup_minsert(lookup, value, LOOKUP_ADD_DUPLICATES, cmp_allocation_dependency, manager, NULL, NULL);
-      return num_freed;
-    }
-#endif /* #if ERROR_CHECKING */
-
-    num_freed += result_num;
-    num_freed += subresult_num;
-  }
-
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_MANUAL((size_t) index), FALSE());
 }
 
 /* ---------------------------------------------------------------- */
@@ -1998,6 +3543,9 @@ int replace_with_byte_allocation(memory_tracker_t *tracker, allocation_type_t sr
 
   int added_dest;
 
+  int                   have_src;
+  resolved_allocation_t src_value;
+
   const lookup_t *lookup;
 
 #if ERROR_CHECKING
@@ -2014,6 +3562,8 @@ int replace_with_byte_allocation(memory_tracker_t *tracker, allocation_type_t sr
   if (src_index < 0)
     return -8;
 
+  have_src = resolve_allocation(tracker, ALLOC_DEP_REF((size_t) src_type, (size_t) src_index), &src_value);
+
   dest_index = tracked_byte_allocation(tracker, dest_allocation);
   if (dest_index < 0)
   {
@@ -2206,6 +3756,8 @@ int replace_with_byte_allocation(memory_tracker_t *tracker, allocation_type_t sr
     return dest_index;
   }
 
+  journal_replace(tracker, src_type, src_value, have_src, added_dest);
+
   return dest_index;
 }
 
@@ -2218,6 +3770,9 @@ int replace_with_tval_allocation(memory_tracker_t *tracker, allocation_type_t sr
 
   int added_dest;
 
+  int                   have_src;
+  resolved_allocation_t src_value;
+
   const lookup_t *lookup;
 
 #if ERROR_CHECKING
@@ -2234,6 +3789,8 @@ int replace_with_tval_allocation(memory_tracker_t *tracker, allocation_type_t sr
   if (src_index < 0)
     return -8;
 
+  have_src = resolve_allocation(tracker, ALLOC_DEP_REF((size_t) src_type, (size_t) src_index), &src_value);
+
   dest_index = tracked_tval_allocation(tracker, dest_allocation);
   if (dest_index < 0)
   {
@@ -2426,6 +3983,8 @@ int replace_with_tval_allocation(memory_tracker_t *tracker, allocation_type_t sr
     return dest_index;
   }
 
+  journal_replace(tracker, src_type, src_value, have_src, added_dest);
+
   return dest_index;
 }
 
@@ -2438,6 +3997,9 @@ int replace_with_manual_allocation(memory_tracker_t *tracker, allocation_type_t
 
   int added_dest;
 
+  int                   have_src;
+  resolved_allocation_t src_value;
+
   const lookup_t *lookup;
 
 #if ERROR_CHECKING
@@ -2454,6 +4016,8 @@ int replace_with_manual_allocation(memory_tracker_t *tracker, allocation_type_t
   if (src_index < 0)
     return -8;
 
+  have_src = resolve_allocation(tracker, ALLOC_DEP_REF((size_t) src_type, (size_t) src_index), &src_value);
+
   dest_index = tracked_manual_allocation(tracker, dest_allocation);
   if (dest_index < 0)
   {
@@ -2646,6 +4210,8 @@ int replace_with_manual_allocation(memory_tracker_t *tracker, allocation_type_t
     return dest_index;
   }
 
+  journal_replace(tracker, src_type, src_value, have_src, added_dest);
+
   return dest_index;
 }
 
@@ -2653,12 +4219,7 @@ int replace_with_manual_allocation(memory_tracker_t *tracker, allocation_type_t
 
 int track_dependency(memory_tracker_t *tracker, allocation_dependency_t dependency)
 {
-  size_t value_index  = (size_t) -1;
-  int    is_duplicate =          -1;
-
-  lookup_t *lookup;
-
-  UNUSED(is_duplicate);
+  size_t edge;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -2668,210 +4229,108 @@ int track_dependency(memory_tracker_t *tracker, allocation_dependency_t dependen
   if (!memory_tracker_require_containers(tracker))
     return -3;
 
-  lookup = tracker->dependency_graph;
-
   if (is_allocation_dependency_null(dependency))
     return -4;
 
-  lookup =
-    lookup_minsert
-      ( lookup
-      , (void *) &dependency
-      , LOOKUP_NO_ADD_DUPLICATES
-
-      , cmp_allocation_dependency
-
-      , MEMORY_TRACKER_CMANAGER(tracker)
-
-      , &value_index
-      , &is_duplicate
-      );
-
-  if (!lookup)
+  edge = dependency_graph_add(tracker->dependency_graph, dependency, MEMORY_TRACKER_CMANAGER(tracker));
+  if (edge == DEPENDENCY_EDGE_NONE)
     return -5;
 
-  return (int) value_index;
+  return (int) edge;
 }
 
 allocation_dependency_t untrack_dependency(memory_tracker_t *tracker, allocation_dependency_t dependency)
 {
-  size_t num_deleted;
-
-  lookup_t *lookup;
+  size_t edge;
 
 #if ERROR_CHECKING
   if (!tracker)
     return null_allocation_dependency;
 #endif /* #if ERROR_CHECKING */
 
-  if (!memory_tracker_require_containers(tracker))
+  if (!tracker->dependency_graph)
     return null_allocation_dependency;
 
-  lookup = tracker->dependency_graph;
-
   if (is_allocation_dependency_null(dependency))
     return null_allocation_dependency;
 
-  lookup =
-    lookup_mdelete
-      ( lookup
-      , (void *) &dependency
-      , LOOKUP_UNLIMITED
-
-      , cmp_allocation_dependency
-
-      , MEMORY_TRACKER_CMANAGER(tracker)
-
-      , &num_deleted
-      );
-
-  if (!lookup)
+  edge = dependency_graph_find(tracker->dependency_graph, dependency);
+  if (edge == DEPENDENCY_EDGE_NONE)
     return null_allocation_dependency;
 
-  if (num_deleted <= 0)
-    return null_allocation_dependency;
+  dependency_graph_remove(tracker->dependency_graph, edge);
 
   return dependency;
 }
 
 allocation_dependency_t get_dependency(memory_tracker_t *tracker, int index)
 {
-  const allocation_dependency_t *value;
-
-  lookup_t *lookup;
+  const dependency_graph_t *graph;
 
 #if ERROR_CHECKING
   if (!tracker)
     return null_allocation_dependency;
 #endif /* #if ERROR_CHECKING */
 
-  if (!memory_tracker_require_containers(tracker))
-    return null_allocation_dependency;
+  graph = tracker->dependency_graph;
 
-  lookup = tracker->dependency_graph;
+  if (!graph)
+    return null_allocation_dependency;
 
   if (index < 0)
     return null_allocation_dependency;
-  if (index >= LOOKUP_CAPACITY(lookup))
-    return null_allocation_dependency;
-  if (!LOOKUP_GET_VALUE_IN_USE_BIT(lookup, (size_t) index))
+  if ((size_t) index >= graph->edges_num)
     return null_allocation_dependency;
-
-  value = LOOKUP_INDEX_VALUE(lookup, (size_t) index);
-  if (!value)
+  if (!graph->edges[index].in_use)
     return null_allocation_dependency;
 
-  return *value;
+  return graph->edges[index].dependency;
 }
 
 int tracked_dependency(const memory_tracker_t *tracker, allocation_dependency_t dependency)
 {
-  int         index;
-  const void *value;
-
-  const lookup_t *lookup;
+  size_t edge;
 
 #if ERROR_CHECKING
   if (!tracker)
     return UNTRACKED - 1;
 #endif /* #if ERROR_CHECKING */
 
-  lookup = tracker->dependency_graph;
-
-  if (!lookup)
+  if (!tracker->dependency_graph)
     return UNTRACKED - 2;
 
   if (is_allocation_dependency_null(dependency))
     return UNTRACKED - 3;
 
-  value =
-    lookup_retrieve
-      ( lookup
-      , (void *) &dependency
-
-      , cmp_allocation_dependency
-      );
-
-  if (!value)
+  edge = dependency_graph_find(tracker->dependency_graph, dependency);
+  if (edge == DEPENDENCY_EDGE_NONE)
     return UNTRACKED;
 
-  index = (int) LOOKUP_GET_VALUE_INDEX(lookup, value);
-
-  return index;
+  return (int) edge;
 }
 
 size_t free_dependency(memory_tracker_t *tracker, allocation_dependency_t dependency)
 {
-  size_t num_freed;
-
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency_value = (const void * const) &value;
-
-  allocation_dependency_t key;
-
-  size_t result_num;
-  size_t subresult_num;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
-#if ERROR_CHECKING
-  if (!tracker)
-    return 0;
-#endif /* #if ERROR_CHECKING */
-
-  if (!memory_tracker_require_containers(tracker))
-    return 0;
-
-  lookup = tracker->byte_allocations;
-
-  if (is_allocation_dependency_null(dependency))
-    return 0;
-
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  key = dependency;
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
-  {
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (!lookup)
-      return num_freed;
-#if ERROR_CHECKING
-    if (!result_num)
-      return num_freed;
-#endif /* #if ERROR_CHECKING */
-
-    subresult_num =
-      free_allocation
-        ( tracker
-        /*
-        , GET_ALLOC_DEP_TYPE (dependency->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency->dependent)
-        */
-        , GET_ALLOC_DEP_TYPE (dependency_value->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency_value->dependent)
-        );
-#if ERROR_CHECKING
-    if (!subresult_num)
-    {
-      /* Error: Couldn't free dependent! */
-      lookup_minsert(lookup, value, LOOKUP_ADD_DUPLICATES, cmp_allocation_dependency, manager, NULL, NULL);
-      return num_freed;
-    }
+  size_t edge;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
 #endif /* #if ERROR_CHECKING */
 
-    num_freed += result_num;
-    num_freed += subresult_num;
-  }
+  if (!memory_tracker_require_containers(tracker))
+    return 0;
 
-  return num_freed;
+  if (is_allocation_dependency_null(dependency))
+    return 0;
+
+  edge = dependency_graph_find(tracker->dependency_graph, dependency);
+  if (edge == DEPENDENCY_EDGE_NONE)
+    return 0;
+
+  dependency_graph_remove(tracker->dependency_graph, edge);
+
+  return 1 + free_allocation_graph(tracker, dependency.dependent, TRUE());
 }
 
 
@@ -2880,16 +4339,10 @@ allocation_dependency_t untrack_dependency_key(memory_tracker_t *tracker, alloca
   size_t num_dependencies;
 
   allocation_dependency_t first_dependency;
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency = (const void * const) &value;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
-  allocation_dependency_t key;
 
-  size_t result_num;
+  dependency_graph_t *graph;
+  size_t              parent;
+  size_t              edge;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -2899,64 +4352,33 @@ allocation_dependency_t untrack_dependency_key(memory_tracker_t *tracker, alloca
   num_dependencies = 0;
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
 
-  lookup = tracker->dependency_graph;
+  graph = tracker->dependency_graph;
 
-  if (!lookup)
+  if (!graph)
     return null_allocation_dependency;
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
   if (parent_type  < 0 || parent_type  >= a_t_end)
     return null_allocation_dependency;
 
-  if (parent_index < 0 || parent_index >= LOOKUP_CAPACITY(lookup))
+  if (parent_index < 0)
     return null_allocation_dependency;
 
-  key = allocation_depends_key(parent_type, parent_index);
+  parent = ALLOC_DEP_REF((size_t) parent_type, (size_t) parent_index);
 
   /* ---------------------------------------------------------------- */
 
-  num_dependencies = 0;
   first_dependency = null_allocation_dependency;
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
+  while ((edge = dependency_graph_parent_head(graph, parent)) != DEPENDENCY_EDGE_NONE)
   {
-    if (is_allocation_dependency_null(first_dependency))
-    {
-      first_dependency = *dependency;
-    }
+    if (num_dependencies <= 0)
+      first_dependency = graph->edges[edge].dependency;
 
-    if (out_dependencies)
-    {
-      if (num_dependencies < dependencies_num_max)
-      {
-        out_dependencies[num_dependencies] = *dependency;
-      }
-    }
+    if (out_dependencies && num_dependencies < dependencies_num_max)
+      out_dependencies[num_dependencies] = graph->edges[edge].dependency;
 
     ++num_dependencies;
 
-    /* ---------------------------------------------------------------- */
-
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (
-          !lookup
-#if ERROR_CHECKING
-       || !result_num
-#endif /* #if ERROR_CHECKING */
-       )
-    {
-      WRITE_OUTPUT(out_num_dependencies, num_dependencies);
-      return null_allocation_dependency;
-    }
-  }
-
-  /* ---------------------------------------------------------------- */
-
-  if (num_dependencies <= 0)
-  {
-    WRITE_OUTPUT(out_num_dependencies, num_dependencies);
-    return null_allocation_dependency;
+    dependency_graph_remove(graph, edge);
   }
 
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
@@ -2965,15 +4387,11 @@ allocation_dependency_t untrack_dependency_key(memory_tracker_t *tracker, alloca
 
 int tracked_dependency_key(const memory_tracker_t *tracker, allocation_type_t parent_type, int parent_index, int *out_dependency_indices, size_t dependency_indices_num_max, size_t *out_num_dependencies)
 {
-  size_t  num_dependencies;
-  int    *indices;
-  size_t  indices_num_max;
-
-  int     index;
-
-  const lookup_t *lookup;
+  size_t num_dependencies;
 
-  allocation_dependency_t key;
+  const dependency_graph_t *graph;
+  size_t                    edge;
+  size_t                    first;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -2983,70 +4401,37 @@ int tracked_dependency_key(const memory_tracker_t *tracker, allocation_type_t pa
   num_dependencies = 0;
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
 
-  lookup = tracker->dependency_graph;
+  graph = tracker->dependency_graph;
 
-  if (!lookup)
+  if (!graph)
     return UNTRACKED - 3;
 
   if (parent_type  < 0 || parent_type  >= a_t_end)
     return UNTRACKED - 4;
 
-  if (parent_index < 0 || parent_index >= LOOKUP_CAPACITY(lookup))
+  if (parent_index < 0)
     return UNTRACKED - 5;
 
-  key = allocation_depends_key(parent_type, parent_index);
+  first = dependency_graph_parent_head(graph, ALLOC_DEP_REF((size_t) parent_type, (size_t) parent_index));
 
-  if (!out_dependency_indices || dependency_indices_num_max <= 0)
+  for (edge = first; edge != DEPENDENCY_EDGE_NONE; edge = graph->edges[edge].parent_next)
   {
-    indices         = &index;
-    indices_num_max = 1;
-  }
-  else
-  {
-    indices         = out_dependency_indices;
-    indices_num_max = dependency_indices_num_max;
-  }
+    if (out_dependency_indices && num_dependencies < dependency_indices_num_max)
+      out_dependency_indices[num_dependencies] = (int) edge;
 
-  num_dependencies =
-    lookup_retrieve_multiple_from_int
-      ( lookup
-      , NULL
-      , (void *) &key
-
-      , cmp_allocation_dependency_key
-
-      , NULL
-        , 0
-      , indices
-        , indices_num_max
-      , NULL
-        , 0
-      );
+    ++num_dependencies;
+  }
 
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
 
-  if (num_dependencies <= 0)
+  if (first == DEPENDENCY_EDGE_NONE)
     return UNTRACKED;
 
-  return *indices;
+  return (int) first;
 }
 
 size_t free_dependency_key(memory_tracker_t *tracker, allocation_type_t parent_type, int parent_index)
 {
-  size_t num_freed;
-
-  const void *value;
-  const allocation_dependency_t *
-    const     dependency = (const void * const) &value;
-
-  allocation_dependency_t key;
-
-  size_t result_num;
-  size_t subresult_num;
-
-  lookup_t               *lookup;
-  const memory_manager_t *manager;
-
 #if ERROR_CHECKING
   if (!tracker)
     return 0;
@@ -3055,52 +4440,10 @@ size_t free_dependency_key(memory_tracker_t *tracker, allocation_type_t parent_t
   if (!memory_tracker_require_containers(tracker))
     return 0;
 
-  lookup = tracker->byte_allocations;
-
-  if (  parent_type  < 0 || parent_type  >= a_t_end
-     || parent_index < 0 || parent_index >= LOOKUP_CAPACITY(lookup)
-     )
+  if (parent_type < 0 || parent_type >= a_t_end || parent_index < 0)
     return 0;
 
-  manager = MEMORY_TRACKER_CMANAGER(tracker);
-
-  /* ---------------------------------------------------------------- */
-
-  num_freed = 0;
-
-  key = allocation_depends_key(parent_type, parent_index);
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
-  {
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
-    if (!lookup)
-      return num_freed;
-#if ERROR_CHECKING
-    if (!result_num)
-      return num_freed;
-#endif /* #if ERROR_CHECKING */
-
-    subresult_num =
-      free_allocation
-        ( tracker
-        , GET_ALLOC_DEP_TYPE (dependency->dependent)
-        , GET_ALLOC_DEP_INDEX(dependency->dependent)
-        );
-#if ERROR_CHECKING
-    if (!subresult_num)
-    {
-      /* Error: Couldn't free dependent! */
-      lookup_minsert(lookup, value, LOOKUP_ADD_DUPLICATES, cmp_allocation_dependency, manager, NULL, NULL);
-      return num_freed;
-    }
-#endif /* #if ERROR_CHECKING */
-
-    num_freed += result_num;
-    num_freed += subresult_num;
-  }
-
-  return num_freed;
+  return free_allocation_graph(tracker, ALLOC_DEP_REF((size_t) parent_type, (size_t) parent_index), FALSE());
 }
 
 
@@ -3132,24 +4475,22 @@ int dependency_replace_allocation(memory_tracker_t *tracker, allocation_type_t s
 {
   size_t num_replacements;
 
-  lookup_t               *lookup;
+  dependency_graph_t     *graph;
   const memory_manager_t *manager;
 
   size_t src_ref;
+  size_t dest_ref;
 
-  const allocation_dependency_t *value;
-        allocation_dependency_t  key;
-        allocation_dependency_t  replacement_value;
-
-  size_t result_num;
+  size_t                  edge;
+  allocation_dependency_t replacement_value;
 
 #if ERROR_CHECKING
   if (!tracker)
     return -32 - 7;
 #endif /* #if ERROR_CHECKING */
 
-  lookup = tracker->dependency_graph;
-  if (!lookup)
+  graph = tracker->dependency_graph;
+  if (!graph)
     return -32 - 4;
 
   if (!tracker_allocation_ccontainer(tracker, src_type,  (const int *) &src_index) )
@@ -3159,165 +4500,240 @@ int dependency_replace_allocation(memory_tracker_t *tracker, allocation_type_t s
 
   manager = MEMORY_TRACKER_CMANAGER(tracker);
 
-  src_ref = ALLOC_DEP_REF((size_t) src_type, (size_t) src_index);
+  src_ref  = ALLOC_DEP_REF((size_t) src_type,  (size_t) src_index);
+  dest_ref = ALLOC_DEP_REF((size_t) dest_type, (size_t) dest_index);
 
   /* ---------------------------------------------------------------- */
 
-  if
-    (  src_type  == dest_type
-    && src_index == dest_index
-    )
-  {
+  if (src_ref == dest_ref)
     return 0;
-  }
 
   num_replacements = 0;
 
   /* ---------------------------------------------------------------- */
   /* First, update all dependencies with "parent" as src.             */
 
-  key = allocation_dependency_key(src_ref);
-  if (is_allocation_dependency_null(key))
-    return -32 - 3;
-
-  while((value = lookup_retrieve(lookup, &key, cmp_allocation_dependency_key)))
+  while ((edge = dependency_graph_parent_head(graph, src_ref)) != DEPENDENCY_EDGE_NONE)
   {
     ++num_replacements;
 
-    /* ---------------------------------------------------------------- */
+    replacement_value = allocation_dependency(dest_ref, graph->edges[edge].dependency.dependent);
 
-    /* Set replacement value. */
-    replacement_value = allocation_dependency(src_ref, value->dependent);
+    dependency_graph_remove(graph, edge);
 
-    /* Remove old dependency. */
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
+    if (dependency_graph_add(graph, replacement_value, manager) == DEPENDENCY_EDGE_NONE)
+      return min_int(-128, -128 - 2 * num_replacements - 1);
+  }
 
-    if (
-          !lookup
-#if ERROR_CHECKING
-       || !result_num
-#endif /* #if ERROR_CHECKING */
-       )
-    {
-      int error_code = min_int(-128, -128 - 2 * num_replacements);
-      free_allocation(tracker, src_type,  src_index);
-      free_allocation(tracker, dest_type, dest_index);
-      free_allocation(tracker, GET_ALLOC_DEP_TYPE(replacement_value.dependent), GET_ALLOC_DEP_INDEX(replacement_value.dependent));
-      return error_code;
-    }
+  /* ---------------------------------------------------------------- */
+  /* Second, update all dependencies with "dependent" as src.         */
 
-    /* Insert new dependency. */
-    lookup =
-      lookup_minsert
-        ( lookup
-        , &replacement_value
-        , LOOKUP_NO_ADD_DUPLICATES
+  while ((edge = dependency_graph_dependent_head(graph, src_ref)) != DEPENDENCY_EDGE_NONE)
+  {
+    ++num_replacements;
 
-        , cmp_allocation_dependency
+    replacement_value = allocation_dependency(graph->edges[edge].dependency.parent, dest_ref);
 
-        , manager
+    dependency_graph_remove(graph, edge);
 
-        , NULL
-        , NULL
-        );
-    if (!lookup)
-    {
-      int error_code = min_int(-128, -128 - 2 * num_replacements - 1);
-      free_allocation(tracker, src_type,  src_index);
-      free_allocation(tracker, dest_type, dest_index);
-      free_allocation(tracker, GET_ALLOC_DEP_TYPE(replacement_value.dependent), GET_ALLOC_DEP_INDEX(replacement_value.dependent));
-      return error_code;
-    }
+    if (dependency_graph_add(graph, replacement_value, manager) == DEPENDENCY_EDGE_NONE)
+      return min_int(-128 - 64, -128 - 64 - 2 * num_replacements - 1);
   }
 
   /* ---------------------------------------------------------------- */
-  /* Second, update all dependencies with "dependent" as src.         */
 
-  key = allocation_dependency_value(src_ref);
-  if (is_allocation_dependency_null(key))
-    return -32 - 4;
+  return (int) num_replacements;
+}
+
+/* ---------------------------------------------------------------- */
+
+int untrack_allocation(memory_tracker_t *tracker, allocation_type_t type, int index)
+{
+  const lookup_t *lookup;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return -4;
+#endif /* #if ERROR_CHECKING */
+
+  if (!memory_tracker_require_containers(tracker))
+    return -3;
+
+  if (type < 0 || type >= a_t_end)
+    return -2;
 
-  while((value = lookup_get(lookup, &key, cmp_allocation_dependency_value)))
+  if (index < 0)
+    return -1;
+
+  switch (type)
   {
-    ++num_replacements;
+    default:
+      return -6;
+
+    case a_t_byte:
+      {
+        byte_allocation_t allocation;
+
+        lookup = tracker->byte_allocations;
+
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return -1;
+
+        allocation = get_byte_allocation(tracker, index);
+        if (!allocation)
+          return 0;
+
+        allocation = untrack_byte_allocation(tracker, allocation);
+        if (!allocation)
+          return -7;
+
+        return 1;
+      }; break;
+
+    case a_t_tval:
+      {
+        tval_allocation_t allocation;
+
+        lookup = tracker->tval_allocations;
+
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return -1;
+
+        allocation = get_tval_allocation(tracker, index);
+        if (!allocation)
+          return 0;
+
+        allocation = untrack_tval_allocation(tracker, allocation);
+        if (!allocation)
+          return -7;
+
+        return 1;
+      }; break;
+
+    case a_t_manual:
+      {
+        manual_allocation_t allocation;
+
+        lookup = tracker->manual_allocations;
+
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return -1;
+
+        allocation = get_manual_allocation(tracker, index);
+        if (is_manual_allocation_null(allocation))
+          return 0;
 
-    /* ---------------------------------------------------------------- */
+        allocation = untrack_manual_allocation(tracker, allocation);
+        if (is_manual_allocation_null(allocation))
+          return -7;
+
+        return 1;
+      }; break;
+  }
+
+  return -5;
+}
 
-    /* Set replacement value. */
-    replacement_value = allocation_dependency(value->parent, src_ref);
 
-    /* Remove old dependency. */
-    lookup =
-      lookup_mdelete(lookup, value, LOOKUP_UNLIMITED, cmp_allocation_dependency, manager, &result_num);
+int replace_with_existing_allocation(memory_tracker_t *tracker, allocation_type_t src_type, int src_index, allocation_type_t dest_type, int dest_index)
+{
+  const lookup_t *lookup;
 
-    if (
-          !lookup
 #if ERROR_CHECKING
-       || !result_num
+  if (!tracker)
+    return -32;
 #endif /* #if ERROR_CHECKING */
-       )
-    {
-      int error_code = min_int(-128 - 64, -128 - 64 - 2 * num_replacements);
-      free_allocation(tracker, src_type,  src_index);
-      free_allocation(tracker, dest_type, dest_index);
-      free_allocation(tracker, GET_ALLOC_DEP_TYPE(replacement_value.parent), GET_ALLOC_DEP_INDEX(replacement_value.parent));
-      return error_code;
-    }
 
-    /* Insert new dependency. */
-    lookup =
-      lookup_minsert
-        ( lookup
-        , &replacement_value
-        , LOOKUP_NO_ADD_DUPLICATES
+  if (!memory_tracker_require_containers(tracker))
+    return -31;
+
+  if (dest_type < 0 || dest_type >= a_t_end)
+    return -30;
+
+  if (dest_index < 0)
+    return -9;
+
+  switch (dest_type)
+  {
+    default:
+      return -33;
+
+    case a_t_byte:
+      {
+        byte_allocation_t dest_allocation;
+
+        lookup = tracker->byte_allocations;
+
+        if (dest_index >= LOOKUP_CAPACITY(lookup))
+          return -29;
+
+        dest_allocation = get_byte_allocation(tracker, dest_index);
+        if (!dest_allocation)
+          return -2;
+
+        return replace_with_byte_allocation(tracker, src_type, src_index, dest_allocation);
+      }; break;
+
+    case a_t_tval:
+      {
+        tval_allocation_t dest_allocation;
+
+        lookup = tracker->tval_allocations;
+
+        if (dest_index >= LOOKUP_CAPACITY(lookup))
+          return -29;
+
+        dest_allocation = get_tval_allocation(tracker, dest_index);
+        if (!dest_allocation)
+          return -2;
+
+        return replace_with_tval_allocation(tracker, src_type, src_index, dest_allocation);
+      }; break;
+
+    case a_t_manual:
+      {
+        manual_allocation_t dest_allocation;
+
+        lookup = tracker->manual_allocations;
 
-        , cmp_allocation_dependency
+        if (dest_index >= LOOKUP_CAPACITY(lookup))
+          return -29;
 
-        , manager
+        dest_allocation = get_manual_allocation(tracker, dest_index);
+        if (is_manual_allocation_null(dest_allocation))
+          return -2;
 
-        , NULL
-        , NULL
-        );
-    if (!lookup)
-    {
-      int error_code = min_int(-128 - 64, -128 - 64 - 2 * num_replacements - 1);
-      free_allocation(tracker, src_type,  src_index);
-      free_allocation(tracker, dest_type, dest_index);
-      free_allocation(tracker, GET_ALLOC_DEP_TYPE(replacement_value.parent), GET_ALLOC_DEP_INDEX(replacement_value.parent));
-      return error_code;
-    }
+        return replace_with_manual_allocation(tracker, src_type, src_index, dest_allocation);
+      }; break;
   }
 
-  /* ---------------------------------------------------------------- */
-
-  return (int) num_replacements;
+  return -34;
 }
 
-/* ---------------------------------------------------------------- */
 
-int untrack_allocation(memory_tracker_t *tracker, allocation_type_t type, int index)
+/* Returns number of freed allocations. */
+size_t free_allocation(memory_tracker_t *tracker, allocation_type_t type, int index)
 {
   const lookup_t *lookup;
 
 #if ERROR_CHECKING
   if (!tracker)
-    return -4;
+    return 0;
 #endif /* #if ERROR_CHECKING */
 
   if (!memory_tracker_require_containers(tracker))
-    return -3;
+    return 0;
 
   if (type < 0 || type >= a_t_end)
-    return -2;
+    return 0;
 
   if (index < 0)
-    return -1;
+    return 0;
 
   switch (type)
   {
     default:
-      return -6;
+      return 0;
 
     case a_t_byte:
       {
@@ -3326,17 +4742,13 @@ int untrack_allocation(memory_tracker_t *tracker, allocation_type_t type, int in
         lookup = tracker->byte_allocations;
 
         if (index >= LOOKUP_CAPACITY(lookup))
-          return -1;
+          return 0;
 
         allocation = get_byte_allocation(tracker, index);
         if (!allocation)
           return 0;
 
-        allocation = untrack_byte_allocation(tracker, allocation);
-        if (!allocation)
-          return -7;
-
-        return 1;
+        return free_byte_allocation(tracker, allocation);
       }; break;
 
     case a_t_tval:
@@ -3346,17 +4758,13 @@ int untrack_allocation(memory_tracker_t *tracker, allocation_type_t type, int in
         lookup = tracker->tval_allocations;
 
         if (index >= LOOKUP_CAPACITY(lookup))
-          return -1;
+          return 0;
 
         allocation = get_tval_allocation(tracker, index);
         if (!allocation)
           return 0;
 
-        allocation = untrack_tval_allocation(tracker, allocation);
-        if (!allocation)
-          return -7;
-
-        return 1;
+        return free_tval_allocation(tracker, allocation);
       }; break;
 
     case a_t_manual:
@@ -3372,260 +4780,568 @@ int untrack_allocation(memory_tracker_t *tracker, allocation_type_t type, int in
         if (is_manual_allocation_null(allocation))
           return 0;
 
-        allocation = untrack_manual_allocation(tracker, allocation);
-        if (is_manual_allocation_null(allocation))
-          return -7;
-
-        return 1;
+        return free_manual_allocation(tracker, allocation);
       }; break;
   }
 
-  return -5;
+  return 0;
 }
 
-
-int replace_with_existing_allocation(memory_tracker_t *tracker, allocation_type_t src_type, int src_index, allocation_type_t dest_type, int dest_index)
+size_t free_allocation_dependencies(memory_tracker_t *tracker, allocation_type_t type, int index)
 {
   const lookup_t *lookup;
 
 #if ERROR_CHECKING
   if (!tracker)
-    return -32;
+    return 0;
 #endif /* #if ERROR_CHECKING */
 
   if (!memory_tracker_require_containers(tracker))
-    return -31;
+    return 0;
 
-  if (dest_type < 0 || dest_type >= a_t_end)
-    return -30;
+  if (type < 0 || type >= a_t_end)
+    return 0;
 
-  if (dest_index < 0)
-    return -9;
+  if (index < 0)
+    return 0;
 
-  switch (dest_type)
+  switch (type)
   {
     default:
-      return -33;
+      return 0;
 
     case a_t_byte:
       {
-        byte_allocation_t dest_allocation;
+        byte_allocation_t allocation;
 
         lookup = tracker->byte_allocations;
 
-        if (dest_index >= LOOKUP_CAPACITY(lookup))
-          return -29;
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return 0;
 
-        dest_allocation = get_byte_allocation(tracker, dest_index);
-        if (!dest_allocation)
-          return -2;
+        allocation = get_byte_allocation(tracker, index);
+        if (!allocation)
+          return 0;
 
-        return replace_with_byte_allocation(tracker, src_type, src_index, dest_allocation);
+        return free_byte_allocation_dependencies(tracker, allocation);
       }; break;
 
     case a_t_tval:
       {
-        tval_allocation_t dest_allocation;
+        tval_allocation_t allocation;
 
         lookup = tracker->tval_allocations;
 
-        if (dest_index >= LOOKUP_CAPACITY(lookup))
-          return -29;
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return 0;
 
-        dest_allocation = get_tval_allocation(tracker, dest_index);
-        if (!dest_allocation)
-          return -2;
+        allocation = get_tval_allocation(tracker, index);
+        if (!allocation)
+          return 0;
 
-        return replace_with_tval_allocation(tracker, src_type, src_index, dest_allocation);
+        return free_tval_allocation_dependencies(tracker, allocation);
       }; break;
 
     case a_t_manual:
       {
-        manual_allocation_t dest_allocation;
+        manual_allocation_t allocation;
+
+        lookup = tracker->manual_allocations;
+
+        if (index >= LOOKUP_CAPACITY(lookup))
+          return -1;
+
+        allocation = get_manual_allocation(tracker, index);
+        if (is_manual_allocation_null(allocation))
+          return 0;
+
+        return free_manual_allocation_dependencies(tracker, allocation);
+      }; break;
+  }
+
+  return 0;
+}
+
+/* ---------------------------------------------------------------- */
+
+memory_manager_t *memory_tracker_manager(memory_tracker_t *tracker)
+{
+  return MEMORY_TRACKER_MANAGER(tracker);
+}
+
+const memory_manager_t *memory_tracker_cmanager(const memory_tracker_t *tracker)
+{
+  return MEMORY_TRACKER_CMANAGER(tracker);
+}
+
+void *memory_tracker_dynamic_container(const memory_tracker_t *tracker)
+{
+  return MEMORY_TRACKER_DYNAMIC_CONTAINER(tracker);
+}
+
+/* ---------------------------------------------------------------- */
+/* Intrusive mode.                                                  */
+/* ---------------------------------------------------------------- */
+
+/*
+ * In intrusive mode, every block handed out by "track_mmalloc" and friends is
+ * preceded by a header recording the block's owner and slot, and linking it
+ * into the tracker's list of live blocks.
+ *
+ * The union keeps the payload suitably aligned for any object.
+ */
+typedef union intrusive_header_u intrusive_header_t;
+union intrusive_header_u
+{
+  struct
+  {
+    const memory_tracker_t *owner;
+    size_t                  index;
+    size_t                  serial;
+
+    intrusive_header_t     *prev;
+    intrusive_header_t     *next;
+
+    /* Link in the owner's "remote_frees" list. */
+    void                   *remote_next;
+  } info;
+
+  void        *align_ptr;
+  long         align_long;
+  long double  align_ldouble;
+};
+
+#define INTRUSIVE_HEADER(ptr) \
+  (((intrusive_header_t *) (ptr)) - 1)
+#define INTRUSIVE_PAYLOAD(header) \
+  ((void *) (((intrusive_header_t *) (header)) + 1))
+
+/* Initial capacity of the slot table. */
+#define INTRUSIVE_MIN_SLOTS 16
+
+/* Number of "byte_allocations" other than the tracker's own containers. */
+static size_t explicit_byte_allocations_num(const memory_tracker_t *tracker)
+{
+  size_t num;
+
+  if (!tracker->byte_allocations)
+    return 0;
+
+  num = lookup_len(tracker->byte_allocations);
+
+  if (tracked_byte_allocation(tracker, tracker->byte_allocations)   >= 0)
+    --num;
+  if (tracker->tval_allocations   && tracked_byte_allocation(tracker, tracker->tval_allocations)   >= 0)
+    --num;
+  if (tracker->manual_allocations && tracked_byte_allocation(tracker, tracker->manual_allocations) >= 0)
+    --num;
+
+  return num;
+}
+
+memory_tracker_t *memory_tracker_set_intrusive(memory_tracker_t *tracker, int intrusive)
+{
+#if ERROR_CHECKING
+  if (!tracker)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  if (tracker->intrusive_num > 0)
+    return NULL;
+
+  /* Blocks without a header cannot be told apart from those with one. */
+  if (intrusive && explicit_byte_allocations_num(tracker) > 0)
+    return NULL;
+
+  tracker->intrusive = intrusive;
+
+  return tracker;
+}
+
+size_t memory_tracker_intrusive_num(const memory_tracker_t *tracker)
+{
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  return tracker->intrusive_num;
+}
+
+/*
+ * Returns the header of "ptr" if "tracker" owns it, and NULL otherwise.
+ *
+ * The header is read before anything is known about "ptr", so callers that
+ * may be handed other blocks rule out "byte_allocations" first.
+ */
+static intrusive_header_t *intrusive_verify(const memory_tracker_t *tracker, const void *ptr)
+{
+  intrusive_header_t *header;
+
+  if (!ptr)
+    return NULL;
+
+  header = INTRUSIVE_HEADER((void *) ptr);
+
+  if (header->info.owner != tracker)
+    return NULL;
+
+  if (header->info.index >= tracker->intrusive_num)
+    return NULL;
+
+  if (tracker->intrusive_slots[header->info.index] != header)
+    return NULL;
+
+  return header;
+}
+
+/* Ensure there is room for one more slot. */
+static int intrusive_reserve(memory_tracker_t *tracker)
+{
+  size_t   size;
+  void   **slots;
+
+  const memory_manager_t *manager;
+
+  if (tracker->intrusive_num < tracker->intrusive_size)
+    return 1;
+
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
+
+  size = tracker->intrusive_size ? 2 * tracker->intrusive_size : INTRUSIVE_MIN_SLOTS;
+  if (size < tracker->intrusive_size || size > ((size_t) (-1)) / sizeof(*slots))
+    return 0;
+
+  if (!tracker->intrusive_slots)
+    slots = memory_manager_mmalloc (manager, size * sizeof(*slots));
+  else
+    slots = memory_manager_mrealloc(manager, tracker->intrusive_slots, size * sizeof(*slots));
+
+  if (!slots)
+    return 0;
+
+  tracker->intrusive_slots = slots;
+  tracker->intrusive_size  = size;
+
+  return 1;
+}
+
+/* Assign a slot to a fresh header and push it onto the list. */
+static void *intrusive_link(memory_tracker_t *tracker, intrusive_header_t *header)
+{
+  intrusive_header_t *head = tracker->intrusive_list;
+
+  header->info.owner  = tracker;
+  header->info.index  = tracker->intrusive_num++;
+  header->info.serial = tracker->intrusive_serial++;
+  header->info.prev   = NULL;
+  header->info.next   = head;
+
+  header->info.remote_next = NULL;
+
+  if (head)
+    head->info.prev = header;
+
+  tracker->intrusive_list                      = header;
+  tracker->intrusive_slots[header->info.index] = header;
+
+  return INTRUSIVE_PAYLOAD(header);
+}
+
+/* Update the references to a header that was moved by "mrealloc". */
+static void *intrusive_relink(memory_tracker_t *tracker, intrusive_header_t *header)
+{
+  if (header->info.prev)
+    header->info.prev->info.next = header;
+  else
+    tracker->intrusive_list      = header;
+
+  if (header->info.next)
+    header->info.next->info.prev = header;
+
+  tracker->intrusive_slots[header->info.index] = header;
+
+  return INTRUSIVE_PAYLOAD(header);
+}
+
+/*
+ * Release a header's slot and remove it from the list.
+ *
+ * The last slot is moved into the vacated one, keeping the table dense.
+ */
+static void intrusive_unlink(memory_tracker_t *tracker, intrusive_header_t *header)
+{
+  size_t              last;
+  intrusive_header_t *moved;
+
+  last = --tracker->intrusive_num;
+
+  if (header->info.index != last)
+  {
+    moved = tracker->intrusive_slots[last];
+
+    moved->info.index                            = header->info.index;
+    tracker->intrusive_slots[header->info.index] = moved;
+  }
+
+  tracker->intrusive_slots[last] = NULL;
+
+  if (header->info.prev)
+    header->info.prev->info.next = header->info.next;
+  else
+    tracker->intrusive_list      = header->info.next;
+
+  if (header->info.next)
+    header->info.next->info.prev = header->info.prev;
+
+  header->info.owner = NULL;
+}
+
+static void *intrusive_malloc(memory_tracker_t *tracker, size_t size, int zero, int *out_index)
+{
+  intrusive_header_t *header;
+
+  const memory_manager_t *manager;
+
+  if (ATOMIC_LOAD(&tracker->remote_frees) || ATOMIC_LOAD(&tracker->remote_byte_frees))
+    memory_tracker_drain(tracker);
 
-        lookup = tracker->manual_allocations;
+  if (size > ((size_t) (-1)) - sizeof(intrusive_header_t))
+  {
+    WRITE_OUTPUT(out_index, -64 - 2);
+    return NULL;
+  }
 
-        if (dest_index >= LOOKUP_CAPACITY(lookup))
-          return -29;
+  if (!intrusive_reserve(tracker))
+  {
+    WRITE_OUTPUT(out_index, -64 - 5);
+    return NULL;
+  }
 
-        dest_allocation = get_manual_allocation(tracker, dest_index);
-        if (is_manual_allocation_null(dest_allocation))
-          return -2;
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
 
-        return replace_with_manual_allocation(tracker, src_type, src_index, dest_allocation);
-      }; break;
+  if (zero)
+    header = memory_manager_mcalloc(manager, 1, sizeof(*header) + size);
+  else
+    header = memory_manager_mmalloc(manager,    sizeof(*header) + size);
+
+  if (!header)
+  {
+    WRITE_OUTPUT(out_index, -64 - 2);
+    return NULL;
   }
 
-  return -34;
+  WRITE_OUTPUT(out_index, (int) tracker->intrusive_num);
+  return intrusive_link(tracker, header);
 }
 
-
-/* Returns number of freed allocations. */
-size_t free_allocation(memory_tracker_t *tracker, allocation_type_t type, int index)
+static void *intrusive_realloc(memory_tracker_t *tracker, void *ptr, size_t size, int *out_index)
 {
-  const lookup_t *lookup;
+  intrusive_header_t *header;
 
-#if ERROR_CHECKING
-  if (!tracker)
-    return 0;
-#endif /* #if ERROR_CHECKING */
+  const memory_manager_t *manager;
 
-  if (!memory_tracker_require_containers(tracker))
-    return 0;
+  header = intrusive_verify(tracker, ptr);
+  if (!header)
+  {
+    WRITE_OUTPUT(out_index, -64 - 3);
+    return NULL;
+  }
 
-  if (type < 0 || type >= a_t_end)
-    return 0;
+  if (size > ((size_t) (-1)) - sizeof(intrusive_header_t))
+  {
+    WRITE_OUTPUT(out_index, -64 - 2);
+    return NULL;
+  }
 
-  if (index < 0)
-    return 0;
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
 
-  switch (type)
+  header = memory_manager_mrealloc(manager, header, sizeof(*header) + size);
+  if (!header)
   {
-    default:
-      return 0;
+    WRITE_OUTPUT(out_index, -64 - 2);
+    return NULL;
+  }
 
-    case a_t_byte:
-      {
-        byte_allocation_t allocation;
+  WRITE_OUTPUT(out_index, (int) header->info.index);
+  return intrusive_relink(tracker, header);
+}
 
-        lookup = tracker->byte_allocations;
+static size_t intrusive_free(memory_tracker_t *tracker, void *ptr)
+{
+  intrusive_header_t *header;
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return 0;
+  header = intrusive_verify(tracker, ptr);
+  if (!header)
+    return 0;
 
-        allocation = get_byte_allocation(tracker, index);
-        if (!allocation)
-          return 0;
+  intrusive_unlink(tracker, header);
 
-        return free_byte_allocation(tracker, allocation);
-      }; break;
+  tracker_release_bytes(tracker, header);
 
-    case a_t_tval:
-      {
-        tval_allocation_t allocation;
+  /* Untracked and freed, as with "free_byte_allocation". */
+  return 2;
+}
 
-        lookup = tracker->tval_allocations;
+/* ---------------------------------------------------------------- */
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return 0;
+/*
+ * Handing blocks back to their owner.
+ *
+ * The "remote_frees" and "remote_byte_frees" lists are stacks that any thread
+ * may push onto, and that only the owner pops, always taking the whole stack
+ * at once, so a compare-and-swap per push suffices.  Each is linked through
+ * the freed blocks themselves, so handing a block back never allocates.
+ */
 
-        allocation = get_tval_allocation(tracker, index);
-        if (!allocation)
-          return 0;
+/* Take a whole stack, leaving it empty. */
+static void *remote_frees_take(void * volatile *list)
+{
+  void *head;
 
-        return free_tval_allocation(tracker, allocation);
-      }; break;
+  do
+  {
+    head = ATOMIC_LOAD(list);
+  } while (head && !ATOMIC_CAS(list, head, NULL));
 
-    case a_t_manual:
-      {
-        manual_allocation_t allocation;
+  return head;
+}
 
-        lookup = tracker->manual_allocations;
+#if POSIX_PARALLEL
+/* Push "node", whose link is "*next", onto a stack. */
+static void remote_frees_push(void * volatile *list, void *node, void **next)
+{
+  void *head;
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return -1;
+  do
+  {
+    head  = ATOMIC_LOAD(list);
+    *next = head;
+  } while (!ATOMIC_CAS(list, head, node));
+}
 
-        allocation = get_manual_allocation(tracker, index);
-        if (is_manual_allocation_null(allocation))
-          return 0;
+/* Push a block onto its owner's "remote_frees" list. */
+static size_t intrusive_remote_free(memory_tracker_t *owner, intrusive_header_t *header)
+{
+  remote_frees_push(&owner->remote_frees, header, &header->info.remote_next);
 
-        return free_manual_allocation(tracker, allocation);
-      }; break;
-  }
+  /* Freed on the owner's behalf. */
+  return 2;
+}
 
-  return 0;
+/*
+ * Push a block from another thread's heap onto its owner's
+ * "remote_byte_frees" list.  Returns 0 if "ptr" has no such owner.
+ *
+ * Every heap block has room for a pointer, and its contents are no longer
+ * needed, so its first word links it into the list.
+ */
+static size_t byte_remote_free(memory_tracker_t *tracker, void *ptr)
+{
+  memory_tracker_t *owner;
+
+  owner = memory_tracker_owner(ptr);
+  if (!owner || owner == tracker || memory_tracker_is_local(owner))
+    return 0;
+
+  remote_frees_push(&owner->remote_byte_frees, ptr, (void **) ptr);
+
+  /* Freed on the owner's behalf. */
+  return 2;
 }
+#endif /* #if POSIX_PARALLEL */
 
-size_t free_allocation_dependencies(memory_tracker_t *tracker, allocation_type_t type, int index)
+size_t memory_tracker_drain(memory_tracker_t *tracker)
 {
-  const lookup_t *lookup;
+  size_t num_freed;
+
+  intrusive_header_t *header;
+  void               *block;
+  void               *next;
 
 #if ERROR_CHECKING
   if (!tracker)
     return 0;
 #endif /* #if ERROR_CHECKING */
 
-  if (!memory_tracker_require_containers(tracker))
-    return 0;
+  num_freed = 0;
 
-  if (type < 0 || type >= a_t_end)
-    return 0;
+  if (ATOMIC_LOAD(&tracker->remote_frees))
+  {
+    for (header = remote_frees_take(&tracker->remote_frees); header; header = next)
+    {
+      next = header->info.remote_next;
 
-  if (index < 0)
-    return 0;
+      num_freed += intrusive_free(tracker, INTRUSIVE_PAYLOAD(header));
+    }
+  }
 
-  switch (type)
+  if (ATOMIC_LOAD(&tracker->remote_byte_frees))
   {
-    default:
-      return 0;
-
-    case a_t_byte:
-      {
-        byte_allocation_t allocation;
+    for (block = remote_frees_take(&tracker->remote_byte_frees); block; block = next)
+    {
+      next = *(void **) block;
 
-        lookup = tracker->byte_allocations;
+      num_freed += free_byte_allocation(tracker, block);
+    }
+  }
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return 0;
+  return num_freed;
+}
 
-        allocation = get_byte_allocation(tracker, index);
-        if (!allocation)
-          return 0;
+/* ---------------------------------------------------------------- */
 
-        return free_byte_allocation_dependencies(tracker, allocation);
-      }; break;
+/* Free intrusively tracked blocks with serials from "serial" on. */
+static size_t memory_tracker_rollback_intrusive(memory_tracker_t *tracker, size_t serial)
+{
+  size_t num_freed;
 
-    case a_t_tval:
-      {
-        tval_allocation_t allocation;
+  intrusive_header_t *header;
 
-        lookup = tracker->tval_allocations;
+  num_freed = 0;
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return 0;
+  while ((header = tracker->intrusive_list) && header->info.serial >= serial)
+    num_freed += intrusive_free(tracker, INTRUSIVE_PAYLOAD(header));
 
-        allocation = get_tval_allocation(tracker, index);
-        if (!allocation)
-          return 0;
+  return num_freed;
+}
 
-        return free_tval_allocation_dependencies(tracker, allocation);
-      }; break;
+/* Free every intrusively tracked block with a walk over the list. */
+static size_t memory_tracker_free_intrusive(memory_tracker_t *tracker)
+{
+  size_t num_freed;
 
-    case a_t_manual:
-      {
-        manual_allocation_t allocation;
+  intrusive_header_t *header;
+  intrusive_header_t *next;
 
-        lookup = tracker->manual_allocations;
+  const memory_manager_t *manager;
 
-        if (index >= LOOKUP_CAPACITY(lookup))
-          return -1;
+  num_freed = 0;
 
-        allocation = get_manual_allocation(tracker, index);
-        if (is_manual_allocation_null(allocation))
-          return 0;
+  manager = MEMORY_TRACKER_CMANAGER(tracker);
 
-        return free_manual_allocation_dependencies(tracker, allocation);
-      }; break;
-  }
+  for (header = tracker->intrusive_list; header; header = next)
+  {
+    next = header->info.next;
 
-  return 0;
-}
+    header->info.owner = NULL;
+    tracker_release_bytes(tracker, header);
 
-/* ---------------------------------------------------------------- */
+    ++num_freed;
+  }
 
-memory_manager_t *memory_tracker_manager(memory_tracker_t *tracker)
-{
-  return MEMORY_TRACKER_MANAGER(tracker);
-}
+  if (tracker->intrusive_slots)
+  {
+    memory_manager_mfree(manager, tracker->intrusive_slots);
+    ++num_freed;
+  }
 
-const memory_manager_t *memory_tracker_cmanager(const memory_tracker_t *tracker)
-{
-  return MEMORY_TRACKER_CMANAGER(tracker);
-}
+  tracker->intrusive_list  = NULL;
+  tracker->intrusive_slots = NULL;
+  tracker->intrusive_num   = 0;
+  tracker->intrusive_size  = 0;
 
-void *memory_tracker_dynamic_container(const memory_tracker_t *tracker)
-{
-  return MEMORY_TRACKER_DYNAMIC_CONTAINER(tracker);
+  return num_freed;
 }
 
 /* ---------------------------------------------------------------- */
@@ -3644,6 +5360,9 @@ void *track_mmalloc(memory_tracker_t *tracker, size_t size, int *out_index)
 
   WRITE_OUTPUT(out_index, -64 - 4);
 
+  if (tracker->intrusive)
+    return intrusive_malloc(tracker, size, FALSE(), out_index);
+
   if (!memory_tracker_require_containers(tracker))
     return NULL;
 
@@ -3681,6 +5400,17 @@ void *track_mcalloc(memory_tracker_t *tracker, size_t nmemb, size_t size, int *o
 
   WRITE_OUTPUT(out_index, -64 - 4);
 
+  if (tracker->intrusive)
+  {
+    if (size && nmemb > ((size_t) (-1)) / size)
+    {
+      WRITE_OUTPUT(out_index, -64 - 2);
+      return NULL;
+    }
+
+    return intrusive_malloc(tracker, nmemb * size, TRUE(), out_index);
+  }
+
   if (!memory_tracker_require_containers(tracker))
     return NULL;
 
@@ -3722,6 +5452,9 @@ void *track_mrealloc(memory_tracker_t *tracker, void *ptr, size_t size, int *out
   if (!ptr)
     return NULL;
 
+  if (tracker->intrusive)
+    return intrusive_realloc(tracker, ptr, size, out_index);
+
   if (!memory_tracker_require_containers(tracker))
     return NULL;
 
@@ -3764,9 +5497,67 @@ void *track_mrealloc(memory_tracker_t *tracker, void *ptr, size_t size, int *out
 
 size_t track_mfree(memory_tracker_t *tracker, void *ptr)
 {
+#if ERROR_CHECKING
+  if (!tracker)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  if (tracker->intrusive)
+  {
+#if POSIX_PARALLEL
+    if (ptr)
+    {
+      memory_tracker_t *owner;
+
+      /* The owner never changes while the block is live. */
+      owner = (memory_tracker_t *) INTRUSIVE_HEADER(ptr)->info.owner;
+
+      if (owner && owner->owner_thread && !memory_tracker_is_local(owner))
+        return intrusive_remote_free(owner, INTRUSIVE_HEADER(ptr));
+    }
+#endif /* #if POSIX_PARALLEL */
+
+    return intrusive_free(tracker, ptr);
+  }
+
+#if POSIX_PARALLEL
+  if (tracker->owner_thread && ptr)
+  {
+    size_t num_freed;
+
+    num_freed = free_byte_allocation(tracker, ptr);
+    if (!num_freed)
+      num_freed = byte_remote_free(tracker, ptr);
+
+    return num_freed;
+  }
+#endif /* #if POSIX_PARALLEL */
+
   return free_byte_allocation(tracker, ptr);
 }
 
+int tracked_mmalloc(const memory_tracker_t *tracker, const void *ptr)
+{
+  int index;
+
+  const intrusive_header_t *header;
+
+#if ERROR_CHECKING
+  if (!tracker)
+    return UNTRACKED;
+#endif /* #if ERROR_CHECKING */
+
+  index = tracked_byte_allocation(tracker, (byte_allocation_t) ptr);
+  if (index >= 0 || !tracker->intrusive)
+    return index;
+
+  header = intrusive_verify(tracker, ptr);
+  if (!header)
+    return UNTRACKED;
+
+  return (int) header->info.index;
+}
+
 /* ---------------------------------------------------------------- */
 
 tval *track_tval_init(memory_tracker_t *tracker, const type_t *type, tval *cons, int *out_index)
@@ -3822,15 +5613,11 @@ size_t track_manual_free(memory_tracker_t *tracker, manual_allocation_t cleanup)
 
 int tracked_dependency_key_size(const memory_tracker_t *tracker, allocation_type_t parent_type, int parent_index, size_t *out_dependency_indices, size_t dependency_indices_num_max, size_t *out_num_dependencies)
 {
-  size_t  num_dependencies;
-  size_t *indices;
-  size_t  indices_num_max;
-
-  size_t  index;
-
-  const lookup_t *lookup;
+  size_t num_dependencies;
 
-  allocation_dependency_t key;
+  const dependency_graph_t *graph;
+  size_t                    edge;
+  size_t                    first;
 
 #if ERROR_CHECKING
   if (!tracker)
@@ -3840,51 +5627,33 @@ int tracked_dependency_key_size(const memory_tracker_t *tracker, allocation_type
   num_dependencies = 0;
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
 
-  lookup = tracker->dependency_graph;
+  graph = tracker->dependency_graph;
 
-  if (!lookup)
+  if (!graph)
     return UNTRACKED - 3;
 
   if (parent_type  < 0 || parent_type  >= a_t_end)
     return UNTRACKED - 4;
 
-  if (parent_index < 0 || parent_index >= LOOKUP_CAPACITY(lookup))
+  if (parent_index < 0)
     return UNTRACKED - 5;
 
-  key = allocation_depends_key(parent_type, parent_index);
+  first = dependency_graph_parent_head(graph, ALLOC_DEP_REF((size_t) parent_type, (size_t) parent_index));
 
-  if (!out_dependency_indices || dependency_indices_num_max <= 0)
-  {
-    indices         = &index;
-    indices_num_max = 1;
-  }
-  else
+  for (edge = first; edge != DEPENDENCY_EDGE_NONE; edge = graph->edges[edge].parent_next)
   {
-    indices         = out_dependency_indices;
-    indices_num_max = dependency_indices_num_max;
-  }
-
-  num_dependencies =
-    lookup_retrieve_multiple
-      ( lookup
-      , (void *) &key
+    if (out_dependency_indices && num_dependencies < dependency_indices_num_max)
+      out_dependency_indices[num_dependencies] = (size_t) edge;
 
-      , cmp_allocation_dependency_key
-
-      , NULL
-        , 0
-      , indices
-        , indices_num_max
-      , NULL
-        , 0
-      );
+    ++num_dependencies;
+  }
 
   WRITE_OUTPUT(out_num_dependencies, num_dependencies);
 
-  if (num_dependencies <= 0)
+  if (first == DEPENDENCY_EDGE_NONE)
     return UNTRACKED;
 
-  return *indices;
+  return (int) first;
 }
 
 /* ---------------------------------------------------------------- */
@@ -120,6 +120,91 @@ struct allocation_dependency_s
   size_t dependent;
 };
 
+/*
+ * dependency_graph_t:
+ *
+ * Every tracked allocation_dependency_t, as an adjacency index.
+ *
+ * Each edge is linked both into the list of edges sharing its parent and into
+ * the list of edges sharing its dependent.  "parent_heads" and
+ * "dependent_heads" are indexed by the packed "parent" or "dependent" value
+ * (see "ALLOC_DEP_REF"), and hold the first edge of each list, so that the
+ * dependents of an allocation are found without a search.
+ *
+ * Edge indices are stable while an edge is tracked; removed edges are reused.
+ */
+#define DEPENDENCY_EDGE_NONE ((size_t) (-1))
+
+typedef struct dependency_edge_s dependency_edge_t;
+struct dependency_edge_s
+{
+  allocation_dependency_t dependency;
+
+  /* DEPENDENCY_EDGE_NONE at either end. */
+  size_t parent_prev;
+  size_t parent_next;
+  size_t dependent_prev;
+  size_t dependent_next;
+
+  /* Unused edges are chained through "parent_next". */
+  int in_use;
+};
+
+typedef struct dependency_graph_s dependency_graph_t;
+struct dependency_graph_s
+{
+  dependency_edge_t *edges;
+  size_t             edges_num;
+  size_t             edges_size;
+  size_t             edges_len;
+  size_t             edges_free;
+
+  size_t            *parent_heads;
+  size_t            *dependent_heads;
+  size_t             heads_size;
+};
+
+/*
+ * memory_tracker_journal_entry_t:
+ *
+ * An allocation tracked while a checkpoint was active, in the order the
+ * allocations were tracked.
+ */
+typedef struct memory_tracker_journal_entry_s memory_tracker_journal_entry_t;
+struct memory_tracker_journal_entry_s
+{
+  allocation_type_t type;
+
+  union
+  {
+    byte_allocation_t   byte;
+    tval_allocation_t   tval;
+    manual_allocation_t manual;
+  } allocation;
+};
+
+/*
+ * memory_tracker_checkpoint_t:
+ *
+ * A watermark in a memory tracker's allocations, returned by
+ * "memory_tracker_checkpoint".
+ */
+typedef struct memory_tracker_checkpoint_s memory_tracker_checkpoint_t;
+struct memory_tracker_checkpoint_s
+{
+  /* Nesting depth, from 1. */
+  size_t depth;
+
+  /* Tells apart checkpoints taken at the same depth. */
+  size_t serial;
+
+  /* Journal length when the checkpoint was taken. */
+  size_t journal_num;
+
+  /* Next intrusive serial when the checkpoint was taken. */
+  size_t intrusive_serial;
+};
+
 /* ---------------------------------------------------------------- */
 
 extern const manual_allocation_t null_manual_allocation;
@@ -215,7 +300,103 @@ struct memory_tracker_s
   lookup_t *manual_allocations;
 
   /* allocation_dependency_t */
-  lookup_t *dependency_graph;
+  dependency_graph_t *dependency_graph;
+
+  /* ---------------------------------------------------------------- */
+
+  /* Intrusive mode. */
+
+  /* When set, "track_mmalloc" and friends prefix each   */
+  /* block with a small header holding the block's slot  */
+  /* index and links in a doubly-linked list of every    */
+  /* such block, instead of recording the block in       */
+  /* "byte_allocations".  Untracking and freeing them    */
+  /* then involves no search.                            */
+  /*                                                     */
+  /* "track_mrealloc" and "track_mfree" then assume the  */
+  /* header is there, so an intrusive tracker refuses    */
+  /* "track_byte_allocation", and a tracker with such    */
+  /* allocations cannot be made intrusive.               */
+  /*                                                     */
+  /* Freeing a block moves the last slot into the freed  */
+  /* one, so an intrusive block's index is only valid    */
+  /* until the next free, and cannot be used in          */
+  /* "ALLOC_DEP_REF" dependencies.                       */
+  int intrusive;
+
+  /* Most recently allocated header, or NULL. */
+  void *intrusive_list;
+
+  /* Header pointers, indexed by slot. */
+  void   **intrusive_slots;
+  size_t   intrusive_num;
+  size_t   intrusive_size;
+
+  /* Each intrusive header records the next serial number; */
+  /* the list is ordered by it, newest first.              */
+  size_t   intrusive_serial;
+
+  /* ---------------------------------------------------------------- */
+
+  /* Checkpoints. */
+
+  /* Number of active checkpoints. */
+  size_t checkpoints_num;
+
+  /* The serial number of each active checkpoint, outermost first, and of */
+  /* the next one.                                                        */
+  size_t *checkpoint_serials;
+  size_t  checkpoints_size;
+  size_t  checkpoint_serial;
+
+  /* Allocations tracked while a checkpoint is active. */
+  memory_tracker_journal_entry_t *journal;
+  size_t                          journal_num;
+  size_t                          journal_size;
+
+  /* ---------------------------------------------------------------- */
+
+  /* Thread ownership. */
+
+  /* NULL for trackers shared under external            */
+  /* synchronization; otherwise, an opaque token of the  */
+  /* thread that owns this tracker, as with the trackers */
+  /* returned by "thread_memory_tracker".                */
+  void *owner_thread;
+
+  /* Intrusive blocks that other threads freed, linked   */
+  /* through their headers.  Other threads push onto it  */
+  /* without locking; the owner drains it.               */
+  void * volatile remote_frees;
+
+  /* Likewise, byte allocations that other threads       */
+  /* freed, linked through their first words.            */
+  void * volatile remote_byte_frees;
+
+  /* ---------------------------------------------------------------- */
+
+  /* Deferred reclamation. */
+
+  /* When set, "memory_tracker_free" hands the tracker's */
+  /* allocations to the background reclaimer instead of  */
+  /* freeing them itself; see "memory_tracker_defer".    */
+  int deferred;
+
+  /* When set, the free methods, and "track_mfree",      */
+  /* retire the blocks, values, and manual allocations   */
+  /* they would free, for epoch-based reclamation; see   */
+  /* "type_base_epoch.h".  Blocks moved by               */
+  /* "track_mrealloc" are still released immediately.    */
+  int retire;
+
+  /* ---------------------------------------------------------------- */
+
+  /* Sharing. */
+
+  /* Number of owners, beyond the first, of the value    */
+  /* containing this tracker; see                        */
+  /* "memory_tracker_share".                             */
+  volatile size_t shares;
 };
 
 #define MEMORY_TRACKER_DEFAULTS                      \
@@ -229,6 +410,30 @@ struct memory_tracker_s
   , /* tval_allocations   */ NULL                    \
   , /* manual_allocations */ NULL                    \
   , /* dependency_graph   */ NULL                    \
+                                                     \
+  , /* intrusive          */ 0                       \
+  , /* intrusive_list     */ NULL                    \
+  , /* intrusive_slots    */ NULL                    \
+  , /* intrusive_num      */ 0                       \
+  , /* intrusive_size     */ 0                       \
+  , /* intrusive_serial   */ 0                       \
+                                                     \
+  , /* checkpoints_num    */ 0                       \
+  , /* checkpoint_serials */ NULL                    \
+  , /* checkpoints_size   */ 0                       \
+  , /* checkpoint_serial  */ 0                       \
+  , /* journal            */ NULL                    \
+  , /* journal_num        */ 0                       \
+  , /* journal_size       */ 0                       \
+                                                     \
+  , /* owner_thread       */ NULL                    \
+  , /* remote_frees       */ NULL                    \
+  , /* remote_byte_frees  */ NULL                    \
+                                                     \
+  , /* deferred           */ 0                       \
+  , /* retire             */ 0                       \
+                                                     \
+  , /* shares             */ 0                       \
   }
 
 /* ---------------------------------------------------------------- */
@@ -247,6 +452,42 @@ extern memory_tracker_t global_memory_tracker;
 /* for types to use as a default.                               */
 extern memory_tracker_t global_typed_dyn_memory_tracker;
 
+/*
+ * Per-thread memory trackers.
+ *
+ * With POSIX_PARALLEL, each thread lazily gets its own pair of trackers, so
+ * tracking never contends with, or races against, other threads.  The
+ * general tracker is in intrusive mode: a block that "track_mfree" is asked
+ * to free on a thread other than its owner's is pushed, without locking,
+ * onto the owner's "remote_frees" list, and the owner frees it on its next
+ * allocation, or in "memory_tracker_drain".
+ *
+ * The typed tracker's memory manager allocates from a heap of the thread's
+ * own, in spans of memory headed by their owner, and types that track values
+ * in it allocate them there too.  "track_mfree" through a thread's typed
+ * tracker, as "type_free" does, then finds the owner of another thread's
+ * block from its address, and hands it back in the same way, on the owner's
+ * "remote_byte_frees" list; the typed tracker drains it whenever
+ * "thread_typed_dyn_memory_tracker" returns it.  Blocks are only ever freed
+ * into the heap by its owner.
+ *
+ * When a thread exits, its trackers are kept, together with anything still
+ * allocated from them, and handed to the next thread that needs trackers.
+ *
+ * Without POSIX_PARALLEL, these return "global_memory_tracker" and
+ * "global_typed_dyn_memory_tracker".
+ */
+memory_tracker_t *thread_memory_tracker          (void);
+memory_tracker_t *thread_typed_dyn_memory_tracker(void);
+
+/*
+ * The per-thread typed tracker from whose heap the block at "ptr" came, or
+ * NULL.
+ *
+ * This takes no lock, and is safe for any address.
+ */
+memory_tracker_t *memory_tracker_owner(const void *ptr);
+
 /* ---------------------------------------------------------------- */
 
 memory_tracker_t *memory_tracker_init(memory_tracker_t *dest, const memory_manager_t *memory_manager, void *dynamic_container);
@@ -257,6 +498,103 @@ memory_tracker_t *memory_tracker_copy(memory_tracker_t *dest, const memory_track
 memory_tracker_t *memory_tracker_require_containers(memory_tracker_t *tracker);
 size_t            memory_tracker_free_containers   (memory_tracker_t *tracker);
 
+/*
+ * Enable or disable intrusive mode.
+ *
+ * Fails, returning NULL, while any intrusively tracked block is still live,
+ * or when enabling it on a tracker with "byte_allocations".
+ */
+memory_tracker_t *memory_tracker_set_intrusive(memory_tracker_t *tracker, int intrusive);
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Sharing.
+ *
+ * A value that contains a memory tracker can have several owners, such as the
+ * references that "type_has_shared_ref_dup" copies instead of copying the
+ * value; the tracker counts them in "shares".
+ *
+ * "memory_tracker_share" adds an owner.  "memory_tracker_unshare" removes
+ * one and returns how many owners there were beyond the first; when it
+ * returns 0, nothing changes, since the caller is the only owner and should
+ * free the value itself.
+ *
+ * These are safe to call from several threads at once.
+ */
+memory_tracker_t *memory_tracker_share    (memory_tracker_t *tracker);
+size_t            memory_tracker_unshare  (memory_tracker_t *tracker);
+int               memory_tracker_is_shared(const memory_tracker_t *tracker);
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Deferred reclamation.
+ *
+ * "memory_tracker_defer" detaches every allocation "tracker" holds, together
+ * with its containers, and queues them for the reclaimer, leaving "tracker"
+ * as "memory_tracker_free" would; a dynamically allocated tracker is itself
+ * freed by the reclaimer.  Returns 1 once queued, and 0 without queueing
+ * anything on failure.  Trackers with "deferred" set are deferred by
+ * "memory_tracker_free" too, which then returns what this returns, or frees
+ * the tracker itself if queueing fails.
+ *
+ * With POSIX_PARALLEL, the reclaimer is a background thread, started on first
+ * use, that takes every queued tracker at once and frees the batch in queue
+ * order, each in dependency order as "memory_tracker_free" would.  Without
+ * POSIX_PARALLEL, queued trackers are freed by the next
+ * "memory_tracker_reclaim_flush".
+ *
+ * Allocations are freed on the reclaimer's thread, so the tracker's memory
+ * manager, and the types of its tracked values, must allow that; values
+ * freed through the per-thread trackers must not be deferred.
+ *
+ * "memory_tracker_reclaim_flush" waits until every tracker queued before it
+ * was called is freed, and returns the number of blocks released, as
+ * "memory_tracker_free" counts them, by every tracker the reclaimer has
+ * freed since the previous flush, including those it freed before this one
+ * was called.  Each tracker's count is reported by exactly one flush.
+ *
+ * "memory_tracker_reclaim_stop" flushes and then stops the reclaimer thread;
+ * it is restarted when next needed.
+ */
+size_t memory_tracker_defer            (memory_tracker_t *tracker);
+size_t memory_tracker_reclaim_flush    (void);
+size_t memory_tracker_reclaim_pending  (void);
+void   memory_tracker_reclaim_stop     (void);
+
+/* ---------------------------------------------------------------- */
+
+/*
+ * Checkpoints.
+ *
+ * "memory_tracker_checkpoint" records a watermark; every allocation tracked
+ * afterward is journaled until the checkpoint ends.  Returns NULL if there
+ * is no room to record it.
+ *
+ * "memory_tracker_rollback" frees, newest first, every allocation tracked
+ * after the watermark that is still tracked, together with its dependents,
+ * and ends the checkpoint.  Intrusively tracked blocks are freed in a second
+ * sweep down the intrusive list.  Returns the number of allocations freed,
+ * as the other free methods do.
+ *
+ * "memory_tracker_commit" ends the checkpoint, keeping its allocations.
+ *
+ * Checkpoints nest; ending one also ends any taken after it.  An allocation
+ * moved by a "replace" method keeps its place relative to checkpoints.
+ * Rolling back or committing a checkpoint that has already ended does
+ * nothing, and returns 0 or NULL respectively.
+ *
+ * The journal gets an entry for every allocation tracked while any
+ * checkpoint is active, and keeps it, even once the allocation is freed,
+ * until the outermost checkpoint ends.  A checkpoint held across many
+ * allocations and frees costs memory in proportion to all of them, not just
+ * to those still live.
+ */
+memory_tracker_checkpoint_t *memory_tracker_checkpoint(memory_tracker_t *tracker, memory_tracker_checkpoint_t *out_checkpoint);
+size_t                       memory_tracker_rollback  (memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint);
+memory_tracker_t            *memory_tracker_commit    (memory_tracker_t *tracker, const memory_tracker_checkpoint_t *checkpoint);
+
 /* ---------------------------------------------------------------- */
 
 /*   track methods: returns index >= 0 on success.  Duplicates are nops.    */
@@ -270,7 +608,8 @@ size_t            memory_tracker_free_containers   (memory_tracker_t *tracker);
 
 /* untrack methods ignore dependencies! */
 
-/* TODO: free_dependencies: handle loops! */
+/* free methods free every transitive dependent exactly once, iteratively, */
+/* so cyclic dependencies are safe.                                        */
 
 #define UNTRACKED -1
 
@@ -358,6 +697,31 @@ void   *track_mcalloc  (memory_tracker_t *tracker, size_t nmemb, size_t size, in
 void   *track_mrealloc (memory_tracker_t *tracker, void   *ptr,  size_t size, int *out_index);
 size_t  track_mfree    (memory_tracker_t *tracker, void   *ptr);
 
+/*
+ * Returns the index of a block returned by "track_mmalloc" and friends, or
+ * UNTRACKED.
+ *
+ * "byte_allocations" is searched first.  After that, in intrusive mode, the
+ * header in front of "ptr" is checked against its owner and its slot, so
+ * "ptr" must have been returned by "track_mmalloc" and friends, though
+ * possibly by another tracker, or be tracked in "byte_allocations".
+ *
+ * "track_mrealloc" and "track_mfree" do no such search: on an intrusive
+ * tracker, "ptr" must have been returned by "track_mmalloc" and friends.
+ */
+int     tracked_mmalloc(const memory_tracker_t *tracker, const void *ptr);
+
+/* Number of live intrusively tracked blocks. */
+size_t  memory_tracker_intrusive_num(const memory_tracker_t *tracker);
+
+/*
+ * Free the blocks other threads handed back to "tracker".
+ *
+ * Must be called on the owning thread.  Returns the number of allocations
+ * freed.
+ */
+size_t  memory_tracker_drain(memory_tracker_t *tracker);
+
 /* ---------------------------------------------------------------- */
 
 tval   *track_tval_init(memory_tracker_t *tracker, const type_t *type, tval *cons, int *out_index);
@@ -0,0 +1,455 @@
+/*
+ * opencurry: type_base_mmap_manager.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* "MAP_ANONYMOUS" and "madvise" are not declared in strict C89 mode. */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+#endif /* #ifndef _DEFAULT_SOURCE */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* string.h:
+ *   - memcpy
+ *   - memset
+ */
+#include <string.h>
+
+#include "base.h"
+#include "type_base_prim.h"
+#include "type_base_memory_manager.h"
+#include "type_base_mmap_manager.h"
+
+#include "util.h"
+
+#if POSIX_MMAP
+/* sys/mman.h:
+ *   - MADV_COLD
+ *   - MADV_HUGEPAGE
+ *   - MADV_WILLNEED
+ *   - MAP_ANONYMOUS
+ *   - MAP_FAILED
+ *   - MAP_PRIVATE
+ *   - PROT_READ
+ *   - PROT_WRITE
+ *   - madvise
+ *   - mmap
+ *   - munmap
+ */
+#include <sys/mman.h>
+
+/* unistd.h:
+ *   - _SC_PAGESIZE
+ *   - sysconf
+ */
+#include <unistd.h>
+#endif /* #if POSIX_MMAP */
+
+/* ---------------------------------------------------------------- */
+/* Blocks.                                                          */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Every block is preceded by a header recording where its memory came from,
+ * since "mfree" is not told.
+ *
+ * "length" is the size of the mapping starting at "base", or 0 when "base"
+ * was obtained from the inner manager.
+ */
+typedef union mmap_header_u mmap_header_t;
+union mmap_header_u
+{
+  struct
+  {
+    void         *base;
+    size_t        length;
+    size_t        size;
+    unsigned int  hints;
+  } info;
+
+  unsigned char padding[MMAP_MANAGER_HEADER_SIZE];
+};
+
+#define BLOCK_HEADER(ptr) \
+  ((mmap_header_t *) (((unsigned char *) (ptr)) - MMAP_MANAGER_HEADER_SIZE))
+
+/* Round "n" up to a multiple of "alignment", a power of two. */
+#define ALIGN_UP(n, alignment) \
+  (((n) + ((alignment) - 1)) & ~((alignment) - 1))
+
+/* ---------------------------------------------------------------- */
+/* mmap_config_t                                                    */
+/* ---------------------------------------------------------------- */
+
+mmap_config_t global_mmap_config = MMAP_CONFIG_DEFAULTS;
+
+mmap_config_t *mmap_config_init(mmap_config_t *config, const memory_manager_t *inner)
+{
+  if (!config)
+    return NULL;
+
+  config->inner          = inner;
+  config->threshold      = MMAP_DEFAULT_THRESHOLD;
+  config->huge_page_size = MMAP_DEFAULT_HUGE_PAGE_SIZE;
+
+  return config;
+}
+
+static const mmap_config_t *require_mmap_config(const mmap_config_t *config)
+{
+  if (!config)
+    return &global_mmap_config;
+  else
+    return config;
+}
+
+/* ---------------------------------------------------------------- */
+/* Mapping.                                                         */
+/* ---------------------------------------------------------------- */
+
+#if POSIX_MMAP
+static size_t page_size(void)
+{
+  long size;
+
+  size = sysconf(_SC_PAGESIZE);
+  if (size <= 0)
+    return 4096;
+
+  return (size_t) size;
+}
+
+static void advise(void *base, size_t length, unsigned int hints)
+{
+#ifdef MADV_HUGEPAGE
+  if (hints & MEMORY_HINT_HUGE_PAGES)
+    madvise(base, length, MADV_HUGEPAGE);
+#endif /* #ifdef MADV_HUGEPAGE */
+
+#ifdef MADV_WILLNEED
+  if (hints & MEMORY_HINT_HOT)
+    madvise(base, length, MADV_WILLNEED);
+#endif /* #ifdef MADV_WILLNEED */
+
+#ifdef MADV_COLD
+  if (hints & MEMORY_HINT_COLD)
+    madvise(base, length, MADV_COLD);
+#endif /* #ifdef MADV_COLD */
+}
+
+/*
+ * Map at least "length" bytes, starting at a multiple of "alignment", a
+ * power of two no smaller than the page size.
+ *
+ * Returns NULL on failure; "*out_length" receives the mapped length.
+ */
+static void *map_pages(size_t length, size_t alignment, size_t *out_length)
+{
+  unsigned char *raw;
+  unsigned char *base;
+  size_t         raw_length;
+  size_t         head;
+  size_t         tail;
+
+  length = ALIGN_UP(length, alignment);
+  if (!length)
+    return NULL;
+
+  /* Map enough extra to align, then trim the excess on both sides. */
+  raw_length = length + alignment - page_size();
+  if (raw_length < length)
+    return NULL;
+
+  raw = mmap(NULL, raw_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == (unsigned char *) MAP_FAILED)
+    return NULL;
+
+  base = (unsigned char *) ALIGN_UP((size_t) raw, alignment);
+  head = (size_t) (base - raw);
+  tail = raw_length - head - length;
+
+  if (head)
+    munmap(raw, head);
+  if (tail)
+    munmap(base + length, tail);
+
+  *out_length = length;
+
+  return base;
+}
+#endif /* #if POSIX_MMAP */
+
+/* ---------------------------------------------------------------- */
+/* Allocation.                                                      */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Allocate "size" bytes with the given hints.
+ *
+ * An "alignment" of 0 places the payload right after the header.
+ */
+static void *mmap_allocate(const mmap_config_t *config, size_t alignment, size_t size, unsigned int hints)
+{
+  mmap_header_t *header;
+  unsigned char *base;
+  unsigned char *payload;
+  size_t         length;
+  size_t         need;
+
+  config = require_mmap_config(config);
+
+  if (alignment < MMAP_MANAGER_HEADER_SIZE)
+    alignment = 0;
+
+  /* Header, worst-case alignment padding, and payload. */
+  need = MMAP_MANAGER_HEADER_SIZE + (alignment ? alignment - 1 : 0);
+  if (size > ((size_t) (-1)) - need - config->huge_page_size)
+    return NULL;
+  need += size;
+
+#if POSIX_MMAP
+  if (size >= config->threshold || (hints & MEMORY_HINT_HUGE_PAGES))
+  {
+    size_t map_alignment;
+
+    if ((hints & MEMORY_HINT_HUGE_PAGES) && config->huge_page_size > page_size())
+      map_alignment = config->huge_page_size;
+    else
+      map_alignment = page_size();
+
+    base = map_pages(need, map_alignment, &length);
+    if (!base)
+      return NULL;
+
+    advise(base, length, hints);
+
+    /* Fresh mappings are already zeroed. */
+    hints &= ~MEMORY_HINT_ZEROED;
+  }
+  else
+#endif /* #if POSIX_MMAP */
+  {
+    if (hints & MEMORY_HINT_ZEROED)
+    {
+      base = memory_manager_mcalloc(config->inner, 1, need);
+      hints &= ~MEMORY_HINT_ZEROED;
+    }
+    else
+    {
+      base = memory_manager_mmalloc(config->inner, need);
+    }
+
+    if (!base)
+      return NULL;
+
+    length = 0;
+  }
+
+  payload = base + MMAP_MANAGER_HEADER_SIZE;
+  if (alignment)
+    payload = (unsigned char *) ALIGN_UP((size_t) payload, alignment);
+
+  header = BLOCK_HEADER(payload);
+  header->info.base   = base;
+  header->info.length = length;
+  header->info.size   = size;
+  header->info.hints  = hints;
+
+  return payload;
+}
+
+void *mmap_malloc(const mmap_config_t *config, size_t size)
+{
+  return mmap_allocate(config, 0, size, MEMORY_HINT_NONE);
+}
+
+size_t mmap_free(const mmap_config_t *config, void *ptr)
+{
+  mmap_header_t *header;
+
+  if (!ptr)
+    return 0;
+
+  config = require_mmap_config(config);
+
+  header = BLOCK_HEADER(ptr);
+
+#if POSIX_MMAP
+  if (header->info.length)
+  {
+    munmap(header->info.base, header->info.length);
+    return 1;
+  }
+#endif /* #if POSIX_MMAP */
+
+  return memory_manager_mfree(config->inner, header->info.base);
+}
+
+void *mmap_realloc(const mmap_config_t *config, void *ptr, size_t size)
+{
+  mmap_header_t *header;
+  void          *resized;
+  size_t         capacity;
+
+  if (!ptr)
+    return mmap_malloc(config, size);
+
+  config = require_mmap_config(config);
+
+  header = BLOCK_HEADER(ptr);
+
+  /* Room left in the block itself. */
+  if (header->info.length)
+    capacity = header->info.length - (size_t) (((unsigned char *) ptr) - ((unsigned char *) header->info.base));
+  else
+    capacity = header->info.size;
+
+  if (size <= capacity)
+  {
+    header->info.size = size;
+    return ptr;
+  }
+
+  resized = mmap_allocate(config, 0, size, header->info.hints);
+  if (!resized)
+    return NULL;
+
+  memcpy(resized, ptr, header->info.size);
+  mmap_free(config, ptr);
+
+  return resized;
+}
+
+void *mmap_calloc(const mmap_config_t *config, size_t nmemb, size_t size)
+{
+  if (size > 0 && nmemb > ((size_t) (-1)) / size)
+    return NULL;
+
+  return mmap_allocate(config, 0, nmemb * size, MEMORY_HINT_ZEROED);
+}
+
+void *mmap_malloc_aligned(const mmap_config_t *config, size_t alignment, size_t size)
+{
+  if (!alignment || (alignment & (alignment - 1)))
+    return NULL;
+
+  return mmap_allocate(config, alignment, size, MEMORY_HINT_NONE);
+}
+
+void *mmap_malloc_hinted(const mmap_config_t *config, size_t size, unsigned int hints)
+{
+  return mmap_allocate(config, 0, size, hints);
+}
+
+int mmap_is_mapped(const void *ptr)
+{
+  if (!ptr)
+    return 0;
+
+  return BLOCK_HEADER(ptr)->info.length != 0;
+}
+
+unsigned int mmap_hints(const void *ptr)
+{
+  if (!ptr)
+    return MEMORY_HINT_NONE;
+
+  return BLOCK_HEADER(ptr)->info.hints;
+}
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+static void   *mmap_manager_mmalloc        (const memory_manager_t *self, size_t  size);
+static size_t  mmap_manager_mfree          (const memory_manager_t *self, void   *ptr);
+static void   *mmap_manager_mrealloc       (const memory_manager_t *self, void   *ptr,       size_t size);
+static void   *mmap_manager_mcalloc        (const memory_manager_t *self, size_t  nmemb,     size_t size);
+static void   *mmap_manager_mmalloc_aligned(const memory_manager_t *self, size_t  alignment, size_t size);
+static void   *mmap_manager_mmalloc_hinted (const memory_manager_t *self, size_t  size,      unsigned int hints);
+
+const memory_manager_t mmap_manager =
+  { memory_manager_type
+
+  , mmap_manager_mmalloc
+  , mmap_manager_mfree
+  , mmap_manager_mrealloc
+  , mmap_manager_mcalloc
+
+  , mmap_manager_mmalloc_aligned
+  , mmap_manager_mmalloc_hinted
+
+  , memory_manager_default_on_oom
+  , memory_manager_default_on_err
+
+  , NULL
+  , 0
+  };
+
+static void   *mmap_manager_mmalloc        (const memory_manager_t *self, size_t  size)
+  { return mmap_malloc        (self->state, size); }
+static size_t  mmap_manager_mfree          (const memory_manager_t *self, void   *ptr)
+  { return mmap_free          (self->state, ptr); }
+static void   *mmap_manager_mrealloc       (const memory_manager_t *self, void   *ptr,       size_t size)
+  { return mmap_realloc       (self->state, ptr,       size); }
+static void   *mmap_manager_mcalloc        (const memory_manager_t *self, size_t  nmemb,     size_t size)
+  { return mmap_calloc        (self->state, nmemb,     size); }
+static void   *mmap_manager_mmalloc_aligned(const memory_manager_t *self, size_t  alignment, size_t size)
+  { return mmap_malloc_aligned(self->state, alignment, size); }
+static void   *mmap_manager_mmalloc_hinted (const memory_manager_t *self, size_t  size,      unsigned int hints)
+  { return mmap_malloc_hinted (self->state, size,      hints); }
+
+memory_manager_t *mmap_manager_init(memory_manager_t *dest, const mmap_config_t *config)
+{
+  dest =
+    memory_manager_init
+      ( dest
+
+      , mmap_manager_mmalloc
+      , mmap_manager_mfree
+      , mmap_manager_mrealloc
+      , mmap_manager_mcalloc
+      );
+  if (!dest)
+    return NULL;
+
+  dest->mmalloc_aligned = mmap_manager_mmalloc_aligned;
+  dest->mmalloc_hinted  = mmap_manager_mmalloc_hinted;
+
+  dest->state      = (void *) require_mmap_config(config);
+  dest->state_size = sizeof(mmap_config_t);
+
+  return dest;
+}
@@ -0,0 +1,134 @@
+/*
+ * opencurry: type_base_mmap_manager.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_mmap_manager.h
+ * ------
+ *
+ * Page-mapping memory manager.
+ *
+ * Requests of at least "threshold" bytes, and every request hinted with
+ * "MEMORY_HINT_HUGE_PAGES", are served by mapping anonymous pages directly,
+ * so they can be advised individually: huge-page requests are aligned to
+ * "huge_page_size" and marked "MADV_HUGEPAGE", and "MEMORY_HINT_HOT" and
+ * "MEMORY_HINT_COLD" map to "MADV_WILLNEED" and "MADV_COLD" where the
+ * platform defines them.  Smaller requests are forwarded to the inner
+ * memory manager.
+ *
+ * Without POSIX_MMAP, every request is forwarded to the inner manager and
+ * hints other than "MEMORY_HINT_ZEROED" are ignored.
+ */
+
+#ifndef TYPE_BASE_MMAP_MANAGER_H
+#define TYPE_BASE_MMAP_MANAGER_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_memory_manager.h"
+
+/* ---------------------------------------------------------------- */
+/* mmap_config_t                                                    */
+/* ---------------------------------------------------------------- */
+
+/* Every block is preceded by a header of this size. */
+#define MMAP_MANAGER_HEADER_SIZE       64
+
+#define MMAP_DEFAULT_THRESHOLD         ((size_t) (256 * 1024))
+#define MMAP_DEFAULT_HUGE_PAGE_SIZE    ((size_t) (2 * 1024 * 1024))
+
+typedef struct mmap_config_s mmap_config_t;
+struct mmap_config_s
+{
+  /* Where requests below "threshold" go. */
+  const memory_manager_t *inner;
+
+  /* Smallest request that is mapped directly. */
+  size_t threshold;
+
+  /* Alignment and granularity of huge-page requests; a power of two. */
+  size_t huge_page_size;
+};
+
+#define MMAP_CONFIG_DEFAULTS        \
+  { NULL                            \
+  , MMAP_DEFAULT_THRESHOLD          \
+  , MMAP_DEFAULT_HUGE_PAGE_SIZE     \
+  }
+
+/* Configuration of "mmap_manager"; may be adjusted before first use. */
+extern mmap_config_t global_mmap_config;
+
+/* If "inner" is NULL, "default_memory_manager" is used. */
+mmap_config_t *mmap_config_init(mmap_config_t *config, const memory_manager_t *inner);
+
+/* ---------------------------------------------------------------- */
+
+void   *mmap_malloc        (const mmap_config_t *config, size_t  size);
+size_t  mmap_free          (const mmap_config_t *config, void   *ptr);
+void   *mmap_realloc       (const mmap_config_t *config, void   *ptr,       size_t size);
+void   *mmap_calloc        (const mmap_config_t *config, size_t  nmemb,     size_t size);
+void   *mmap_malloc_aligned(const mmap_config_t *config, size_t  alignment, size_t size);
+void   *mmap_malloc_hinted (const mmap_config_t *config, size_t  size,      unsigned int hints);
+
+/* Was the block obtained by mapping pages, rather than from "inner"? */
+int     mmap_is_mapped     (const void *ptr);
+
+/* The hints a block was allocated with. */
+unsigned int mmap_hints    (const void *ptr);
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Allocates according to "global_mmap_config".
+ *
+ * Implements "mmalloc_aligned" and "mmalloc_hinted"; blocks from either are
+ * released with "memory_manager_mfree".
+ */
+extern const memory_manager_t mmap_manager;
+
+/* If "config" is NULL, "global_mmap_config" is used. */
+memory_manager_t *mmap_manager_init(memory_manager_t *dest, const mmap_config_t *config);
+
+#endif /* ifndef TYPE_BASE_MMAP_MANAGER_H */
@@ -0,0 +1,524 @@
+/*
+ * opencurry: type_base_registry.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* string.h:
+ *   - memcpy
+ *   - strcmp
+ *   - strlen
+ */
+#include <string.h>
+
+#include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - PTHREAD_MUTEX_INITIALIZER
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_t
+ *   - pthread_mutex_unlock
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+#include "type_base_prim.h"
+#include "type_base_compare.h"
+#include "type_base_memory_manager.h"
+#include "type_base_hash_table.h"
+#include "type_base_registry.h"
+
+#include "type_base.h"
+
+#include "bits.h"
+#include "util.h"
+
+/* ---------------------------------------------------------------- */
+/* type_registry_entry_t type.                                      */
+/* ---------------------------------------------------------------- */
+
+const type_t *type_registry_entry_type(void)
+  { return &type_registry_entry_type_def; }
+
+static const char          *type_registry_entry_type_name       (const type_t *self);
+static size_t               type_registry_entry_type_size       (const type_t *self, const tval *val);
+static const struct_info_t *type_registry_entry_type_is_struct  (const type_t *self);
+static const tval          *type_registry_entry_type_has_default(const type_t *self);
+static int                  type_registry_entry_type_cmp        (const type_t *self, const tval *check, const tval *baseline, int deep, ref_traversal_t *vals);
+static size_t               type_registry_entry_type_hash       (const type_t *self, const tval *val, int deep, ref_traversal_t *vals);
+
+static const struct type_registry_entry_s *type_registry_entry_type_registry_entry = NULL;
+
+const type_t type_registry_entry_type_def =
+  { type_type
+
+    /* @: Required.           */
+
+  , /* memory                 */ MEMORY_TRACKER_DEFAULTS
+  , /* is_self_mutable        */ NULL
+  , /* @indirect              */ type_registry_entry_type
+
+  , /* self                   */ NULL
+  , /* container              */ NULL
+
+  , /* typed                  */ NULL
+
+  , /* @name                  */ type_registry_entry_type_name
+  , /* info                   */ NULL
+  , /* @size                  */ type_registry_entry_type_size
+  , /* @is_struct             */ type_registry_entry_type_is_struct
+  , /* is_mutable             */ NULL
+  , /* is_subtype             */ NULL
+  , /* is_supertype           */ NULL
+
+  , /* cons_type              */ NULL
+  , /* init                   */ NULL
+  , /* free                   */ NULL
+  , /* has_default            */ type_registry_entry_type_has_default
+  , /* mem                    */ NULL
+  , /* mem_init               */ NULL
+  , /* mem_is_dyn             */ NULL
+  , /* mem_free               */ NULL
+  , /* default_memory_manager */ NULL
+
+  , /* dup                    */ NULL
+
+  , /* user                   */ NULL
+  , /* cuser                  */ NULL
+  , /* cmp                    */ type_registry_entry_type_cmp
+  , /* hash                   */ type_registry_entry_type_hash
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &type_registry_entry_type_registry_entry
+
+  , /* parity                 */ ""
+  };
+
+static const char          *type_registry_entry_type_name       (const type_t *self)
+  { return "type_registry_entry_t"; }
+
+static size_t               type_registry_entry_type_size       (const type_t *self, const tval *val)
+  { return sizeof(type_registry_entry_t); }
+
+/* The name is owned by the registry, so a field-by-field copy would share it. */
+static const struct_info_t *type_registry_entry_type_is_struct  (const type_t *self)
+  { return type_is_not_struct(self); }
+
+static const tval          *type_registry_entry_type_has_default(const type_t *self)
+  { return type_has_default_value(self, &type_registry_entry_defaults); }
+
+static int                  type_registry_entry_type_cmp        (const type_t *self, const tval *check, const tval *baseline, int deep, ref_traversal_t *vals)
+{
+  const type_registry_entry_t *check_entry    = (const type_registry_entry_t *) check;
+  const type_registry_entry_t *baseline_entry = (const type_registry_entry_t *) baseline;
+
+  return SIGN(strcmp(check_entry->name, baseline_entry->name));
+}
+
+static size_t               type_registry_entry_type_hash       (const type_t *self, const tval *val, int deep, ref_traversal_t *vals)
+{
+  const type_registry_entry_t *entry = (const type_registry_entry_t *) val;
+
+  return hash_mem(entry->name, strlen(entry->name));
+}
+
+/* ---------------------------------------------------------------- */
+
+const type_registry_entry_t type_registry_entry_defaults =
+  TYPE_REGISTRY_ENTRY_DEFAULTS;
+
+/* ---------------------------------------------------------------- */
+/* Registry.                                                        */
+/* ---------------------------------------------------------------- */
+
+#if POSIX_PARALLEL
+static pthread_mutex_t type_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* #if POSIX_PARALLEL */
+
+/* Entries by name. */
+static hash_table_t type_registry_names =
+  { hash_table_type
+
+  , /* key_type       */ &type_registry_entry_type_def
+  , /* deep           */ 0
+
+  , /* memory_manager */ NULL
+
+  , /* entries        */ NULL
+  , /* size           */ 0
+  , /* num            */ 0
+  , /* removed        */ 0
+  };
+
+/* Entries by registered type's address. */
+static hash_table_t type_registry_types = HASH_TABLE_DEFAULTS;
+
+/* Entries by id - 1. */
+static type_registry_entry_t **type_registry_ids      = NULL;
+static size_t                  type_registry_ids_num  = 0;
+static size_t                  type_registry_ids_size = 0;
+
+/* Registered first, in this order, by "type_registry_require". */
+static const typed_t type_registry_builtins[] =
+  { type_type
+  , typed_type
+  , universal_type
+  , memory_manager_type
+  , memory_tracker_type
+  , hash_table_type
+  , type_registry_entry_type
+
+  , ordering_type
+  , ordering_relation_type
+  , comparer_type
+  , callback_compare_type
+  , callback_compare_inverted_type
+  , bnode_type
+  , lookup_type
+
+  , ref_traversal_type
+  , field_info_type
+  , struct_info_type
+  , template_cons_type
+
+  , void_type
+  , objp_type
+  , funp_type
+  , genp_type
+  , genpm_type
+  , genpc_type
+
+  , char_type
+  , schar_type
+  , uchar_type
+  , short_type
+  , ushort_type
+  , int_type
+  , uint_type
+  , long_type
+  , ulong_type
+  , float_type
+  , double_type
+  , ldouble_type
+
+  , enum_type
+  , array_type
+  , union_type
+
+  , div_type
+  , ldiv_type
+  , jmp_buf_type
+  , sig_atomic_type
+  , va_list_type
+  , size_type
+  , ptrdiff_type
+  , file_type
+  , fpos_type
+  , tm_type
+  , time_type
+  , clock_type
+  };
+
+static int type_registry_initialized = 0;
+
+static void type_registry_lock_acquire(void)
+{
+#if POSIX_PARALLEL
+  pthread_mutex_lock(&type_registry_lock);
+#endif /* #if POSIX_PARALLEL */
+}
+
+static void type_registry_lock_release(void)
+{
+#if POSIX_PARALLEL
+  pthread_mutex_unlock(&type_registry_lock);
+#endif /* #if POSIX_PARALLEL */
+}
+
+/* With the lock held. */
+static const type_registry_entry_t *type_registry_find(const type_t *type)
+{
+  void **entry;
+
+  entry = hash_table_find(&type_registry_types, (const tval *) type);
+  if (!entry)
+    return NULL;
+
+  return *entry;
+}
+
+/* With the lock held.  The new entry, or NULL on failure. */
+static type_registry_entry_t *type_registry_add(const type_t *type, const char *name)
+{
+  type_registry_entry_t *entry;
+  size_t                 name_size;
+
+  if (type_registry_ids_num >= type_registry_ids_size)
+  {
+    type_registry_entry_t **ids;
+    size_t                  ids_size;
+
+    ids_size = type_registry_ids_size >= 1 ? 2 * type_registry_ids_size : HASH_TABLE_MIN_SIZE;
+
+    ids = memory_manager_mrealloc(default_memory_manager, type_registry_ids, ids_size * sizeof(*ids));
+    if (!ids)
+      return NULL;
+
+    type_registry_ids      = ids;
+    type_registry_ids_size = ids_size;
+  }
+
+  if (hash_table_reserve(&type_registry_names, hash_table_num(&type_registry_names) + 1))
+    return NULL;
+  if (hash_table_reserve(&type_registry_types, hash_table_num(&type_registry_types) + 1))
+    return NULL;
+
+  /* The entry and its interned name, together. */
+  name_size = strlen(name) + 1;
+
+  entry = memory_manager_mmalloc(default_memory_manager, sizeof(*entry) + name_size);
+  if (!entry)
+    return NULL;
+
+  memcpy(entry + 1, name, name_size);
+
+  *entry            = type_registry_entry_defaults;
+  entry->registered = type;
+  entry->id         = type_registry_ids_num + 1;
+  entry->name       = (const char *) (entry + 1);
+
+  /* Room was reserved, so these can't fail. */
+  hash_table_put(&type_registry_names, (const tval *) entry, entry);
+  hash_table_put(&type_registry_types, (const tval *) type,  entry);
+
+  type_registry_ids[type_registry_ids_num++] = entry;
+
+  if (type->registry_entry)
+    ATOMIC_STORE(type->registry_entry, entry);
+
+  return entry;
+}
+
+/* With the lock held.  See "type_register". */
+static size_t type_registry_register(const type_t *type, int *out_is_new)
+{
+  const type_registry_entry_t *entry;
+  type_registry_entry_t        key;
+  const char                  *name;
+
+  entry = type_registry_find(type);
+  if (entry)
+    return entry->id;
+
+  name = type_name(type);
+  if (!name)
+    return TYPE_REGISTRY_NO_ID;
+
+  key      = type_registry_entry_defaults;
+  key.name = name;
+
+  if (hash_table_find(&type_registry_names, (const tval *) &key))
+    return TYPE_REGISTRY_NO_ID;
+
+  entry = type_registry_add(type, name);
+  if (!entry)
+    return TYPE_REGISTRY_NO_ID;
+
+  *out_is_new = 1;
+  return entry->id;
+}
+
+/* Register the builtin types before any other, once. */
+static void type_registry_require(void)
+{
+  size_t i;
+  int    is_new;
+
+  if (ATOMIC_LOAD(&type_registry_initialized))
+    return;
+
+  is_new = 0;
+
+  type_registry_lock_acquire();
+  {
+    if (!type_registry_initialized)
+    {
+      for (i = 0; i < ARRAY_NUM(type_registry_builtins); ++i)
+        type_registry_register(type_registry_builtins[i](), &is_new);
+
+      ATOMIC_STORE(&type_registry_initialized, 1);
+    }
+  }
+  type_registry_lock_release();
+
+  if (is_new)
+    type_subtype_memo_invalidate();
+}
+
+size_t type_register(const type_t *type)
+{
+  size_t id;
+  int    is_new;
+
+  if (!type)
+    return TYPE_REGISTRY_NO_ID;
+
+  type_registry_require();
+
+  is_new = 0;
+
+  type_registry_lock_acquire();
+  {
+    id = type_registry_register(type, &is_new);
+  }
+  type_registry_lock_release();
+
+  /* A new type may answer queries that were memoized without it. */
+  if (is_new)
+    type_subtype_memo_invalidate();
+
+  return id;
+}
+
+size_t type_registry_id(const type_t *type)
+{
+  const type_registry_entry_t *entry;
+  size_t                       id;
+
+  if (!type)
+    return TYPE_REGISTRY_NO_ID;
+
+  /* Cached once registered, which the builtins are.  A copy of a type
+   * shares the original's cache, so check whose entry it is.
+   */
+  if (type->registry_entry)
+  {
+    entry = ATOMIC_LOAD(type->registry_entry);
+    if (!entry)
+    {
+      type_registry_require();
+      entry = ATOMIC_LOAD(type->registry_entry);
+    }
+
+    if (entry && entry->registered == type)
+      return entry->id;
+  }
+
+  type_registry_require();
+
+  type_registry_lock_acquire();
+  {
+    entry = type_registry_find(type);
+    id    = entry ? entry->id : TYPE_REGISTRY_NO_ID;
+  }
+  type_registry_lock_release();
+
+  return id;
+}
+
+const char *type_registry_name(const type_t *type)
+{
+  const type_registry_entry_t *entry;
+  const char                  *name;
+
+  type_registry_require();
+
+  type_registry_lock_acquire();
+  {
+    entry = type_registry_find(type);
+    name  = entry ? entry->name : NULL;
+  }
+  type_registry_lock_release();
+
+  return name;
+}
+
+const type_t *type_registry_by_id(size_t id)
+{
+  const type_t *type;
+
+  type_registry_require();
+
+  type_registry_lock_acquire();
+  {
+    if (id >= 1 && id <= type_registry_ids_num)
+      type = type_registry_ids[id - 1]->registered;
+    else
+      type = NULL;
+  }
+  type_registry_lock_release();
+
+  return type;
+}
+
+const type_t *type_registry_by_name(const char *name)
+{
+  type_registry_entry_t   key;
+  void                  **entry;
+  const type_t           *type;
+
+  if (!name)
+    return NULL;
+
+  key      = type_registry_entry_defaults;
+  key.name = name;
+
+  type_registry_require();
+
+  type_registry_lock_acquire();
+  {
+    entry = hash_table_find(&type_registry_names, (const tval *) &key);
+    type  = entry ? ((const type_registry_entry_t *) *entry)->registered : NULL;
+  }
+  type_registry_lock_release();
+
+  return type;
+}
+
+size_t type_registry_num(void)
+{
+  size_t num;
+
+  type_registry_require();
+
+  type_registry_lock_acquire();
+  {
+    num = type_registry_ids_num;
+  }
+  type_registry_lock_release();
+
+  return num;
+}
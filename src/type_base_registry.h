@@ -0,0 +1,132 @@
+/*
+ * opencurry: type_base_registry.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_registry.h
+ * ------
+ *
+ * A global registry of types.
+ *
+ * Registering a type interns its name and assigns it a dense id: the first
+ * type registered is 1, the next 2, and so on, so per-type tables can be
+ * indexed by id.  Types can then be found by name or id in constant time,
+ * rather than only through their "typed_t" accessors.
+ *
+ * The builtin types are registered before any other, on first use of the
+ * registry.  A type whose "registry_entry" is set caches its entry there, so
+ * its id is read without locking.
+ *
+ * Types are registered for the life of the process.  The registry is
+ * synchronized.
+ */
+
+#ifndef TYPE_BASE_REGISTRY_H
+#define TYPE_BASE_REGISTRY_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_tval.h"
+
+/* ---------------------------------------------------------------- */
+/* type_registry_entry_t                                            */
+/* ---------------------------------------------------------------- */
+
+/* Entries are equal when their names are. */
+const type_t *type_registry_entry_type(void);
+extern const type_t type_registry_entry_type_def;
+typedef struct type_registry_entry_s type_registry_entry_t;
+struct type_registry_entry_s
+{
+  typed_t type;
+
+  const type_t *registered;
+  size_t        id;
+
+  /* Interned; owned by the registry. */
+  const char   *name;
+};
+
+#define TYPE_REGISTRY_ENTRY_DEFAULTS      \
+  { type_registry_entry_type              \
+                                          \
+  , /* registered */ NULL                 \
+  , /* id         */ 0                    \
+                                          \
+  , /* name       */ NULL                 \
+  }
+extern const type_registry_entry_t type_registry_entry_defaults;
+
+/* ---------------------------------------------------------------- */
+/* Registry.                                                        */
+/* ---------------------------------------------------------------- */
+
+/* No type has id 0. */
+#define TYPE_REGISTRY_NO_ID ((size_t) 0)
+
+/*
+ * Register "type", returning its id.  Registering a type again returns the
+ * same id.
+ *
+ * Returns "TYPE_REGISTRY_NO_ID" if "type" has no name, if another type is
+ * registered with the same name, or if memory could not be allocated.
+ *
+ * Registering a new type invalidates memoized subtype queries.
+ */
+size_t type_register(const type_t *type);
+
+/* The id of a registered type, or "TYPE_REGISTRY_NO_ID".  Doesn't lock once
+ * a type with a "registry_entry" is registered.
+ */
+size_t type_registry_id(const type_t *type);
+
+/* The interned name of a registered type, or NULL. */
+const char *type_registry_name(const type_t *type);
+
+/* The registered type with this id or name, or NULL. */
+const type_t *type_registry_by_id  (size_t id);
+const type_t *type_registry_by_name(const char *name);
+
+/* The number of registered types, which is also the greatest id. */
+size_t type_registry_num(void);
+
+#endif /* ifndef TYPE_BASE_REGISTRY_H */
@@ -0,0 +1,806 @@
+/*
+ * opencurry: type_base_serialize.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* string.h:
+ *   - memcmp
+ *   - memcpy
+ *   - memset
+ */
+#include <string.h>
+
+#include "base.h"
+#include "type_base_prim.h"
+#include "type_base_memory_manager.h"
+#include "type_base_serialize.h"
+
+#include "type_base.h"
+
+#include "util.h"
+
+/* ---------------------------------------------------------------- */
+/* Value queues.                                                    */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Both directions visit values breadth-first from the root, each once, so
+ * a reader lays the image out exactly as its writer did and can reject
+ * any image that differs, e.g. with overlapping values.
+ */
+
+#define TYPE_SERIAL_VALS_TAG  0
+
+/* Values are queued in chunks, so memoized references to them stay put. */
+#define TYPE_SERIAL_CHUNK_NUM 64
+
+typedef struct type_serial_value_s type_serial_value_t;
+struct type_serial_value_s
+{
+  const type_t *type;
+  const tval   *val;
+  size_t        offset;
+  size_t        size;
+};
+
+typedef struct type_serial_chunk_s type_serial_chunk_t;
+struct type_serial_chunk_s
+{
+  type_serial_chunk_t *next;
+  size_t               num;
+  type_serial_value_t  values[TYPE_SERIAL_CHUNK_NUM];
+};
+
+typedef struct type_serial_queue_s type_serial_queue_t;
+struct type_serial_queue_s
+{
+  const memory_manager_t *memory_manager;
+
+  /* Values already queued, memoized to their "type_serial_value_t". */
+  ref_traversal_t         vals;
+
+  type_serial_chunk_t    *first;
+  type_serial_chunk_t    *last;
+
+  /* Offset after the last value queued. */
+  size_t                  end;
+};
+
+/* Round "offset" up to TYPE_SERIAL_ALIGNMENT, or 0 on overflow. */
+static size_t type_serial_align(size_t offset)
+{
+  size_t aligned;
+
+  aligned = offset + (TYPE_SERIAL_ALIGNMENT - 1);
+  if (aligned < offset)
+    return 0;
+
+  return aligned - aligned % TYPE_SERIAL_ALIGNMENT;
+}
+
+#define TYPE_SERIAL_ROOT (type_serial_align(sizeof(type_serial_header_t)))
+
+static void type_serial_queue_init(type_serial_queue_t *queue, const memory_manager_t *memory_manager)
+{
+  queue->memory_manager = memory_manager;
+
+  ref_traversal_init_with_memory_manager(&queue->vals, memory_manager);
+
+  queue->first = NULL;
+  queue->last  = NULL;
+  queue->end   = TYPE_SERIAL_ROOT;
+}
+
+static void type_serial_queue_deinit(type_serial_queue_t *queue)
+{
+  type_serial_chunk_t *chunk;
+  type_serial_chunk_t *next;
+
+  for (chunk = queue->first; chunk; chunk = next)
+  {
+    next = chunk->next;
+    memory_manager_mfree(queue->memory_manager, chunk);
+  }
+
+  queue->first = NULL;
+  queue->last  = NULL;
+
+  ref_traversal_clear(&queue->vals);
+}
+
+static const type_serial_value_t *type_serial_queued(const type_serial_queue_t *queue, const tval *val)
+{
+  return ref_traversal_tagged_memoized(&queue->vals, TYPE_SERIAL_VALS_TAG, (void *) val);
+}
+
+/* Queue "val" at the end of the image.  NULL on failure. */
+static const type_serial_value_t *type_serial_queue_push(type_serial_queue_t *queue, const type_t *type, const tval *val, size_t size)
+{
+  type_serial_chunk_t *chunk;
+  type_serial_value_t *value;
+  size_t               end;
+
+  if (size <= 0)
+    return NULL;
+
+  end = type_serial_align(queue->end + size);
+  if (end <= queue->end)
+    return NULL;
+
+  chunk = queue->last;
+  if (!chunk || chunk->num >= TYPE_SERIAL_CHUNK_NUM)
+  {
+    chunk = memory_manager_mmalloc(queue->memory_manager, sizeof(*chunk));
+    if (!chunk)
+      return NULL;
+
+    chunk->next = NULL;
+    chunk->num  = 0;
+
+    if (queue->last)
+      queue->last->next = chunk;
+    else
+      queue->first      = chunk;
+    queue->last = chunk;
+  }
+
+  value = &chunk->values[chunk->num];
+
+  value->type   = type;
+  value->val    = val;
+  value->offset = queue->end;
+  value->size   = size;
+
+  if (!ref_traversal_tagged_memoize(&queue->vals, TYPE_SERIAL_VALS_TAG, (void *) val, value))
+    return NULL;
+
+  ++chunk->num;
+  queue->end = end;
+
+  return value;
+}
+
+/*
+ * Visit the fields of a value that aren't stored as they are: metadata,
+ * and "is_recursible_ref" fields, which may be references.  The plan
+ * already lists exactly these; without one, look at every field.
+ */
+typedef struct type_serial_fields_s type_serial_fields_t;
+struct type_serial_fields_s
+{
+  const struct_info_t      *struct_info;
+  const struct_info_plan_t *plan;
+
+  size_t                    index;
+  size_t                    num;
+};
+
+static void type_serial_fields_begin(type_serial_fields_t *fields, const type_t *type)
+{
+  fields->struct_info = type_is_struct(type);
+  fields->plan        = struct_info_plan(fields->struct_info);
+  fields->index       = 0;
+
+  if (fields->plan)
+    fields->num = fields->plan->steps_num;
+  else
+    fields->num = struct_info_num_fields(fields->struct_info);
+}
+
+static const field_info_t *type_serial_fields_next(type_serial_fields_t *fields)
+{
+  const field_info_t *field_info;
+
+  while (fields->index < fields->num)
+  {
+    if (fields->plan)
+      field_info = fields->plan->steps[fields->index].field_info;
+    else
+      field_info = struct_info_index_field(fields->struct_info, fields->index);
+
+    ++fields->index;
+
+    if (field_info && (field_info->is_metadata || field_info->is_recursible_ref))
+      return field_info;
+  }
+
+  return NULL;
+}
+
+/*
+ * The type referenced by a field, or NULL if the field is stored as it is.
+ *
+ * References must be data pointers.
+ */
+static const type_t *type_serial_field_ref_type(const field_info_t *field_info, int *out_invalid)
+{
+  const type_t *ref_type;
+
+  *out_invalid = 0;
+
+  if (field_info->is_metadata || !field_info->is_recursible_ref)
+    return NULL;
+
+  ref_type = type_deref(field_info->field_type, NULL, NULL);
+  if (ref_type && field_info->field_size != sizeof(void *))
+    *out_invalid = 1;
+
+  return ref_type;
+}
+
+/*
+ * Fields stored as they are that hold structs of their own, whose fields
+ * are then visited too: everything "type_serial_fields_next" skips, except
+ * references.
+ */
+static const struct_info_t *type_serial_field_embedded(const field_info_t *field_info)
+{
+  if (field_info->is_metadata || field_info->is_recursible_ref)
+    return NULL;
+
+  return type_is_struct(field_info->field_type);
+}
+
+/* Is every byte of "mem" zero? */
+static int type_serial_is_zero(const void *mem, size_t size)
+{
+  const unsigned char *bytes = mem;
+  size_t               i;
+
+  for (i = 0; i < size; ++i)
+    if (bytes[i])
+      return 0;
+
+  return 1;
+}
+
+/*
+ * Can "val" be read by another process?
+ *
+ * Function pointers can't be: unlike the "type" fields of typed values,
+ * there is nothing to restore them from.  Only NULL ones are accepted,
+ * including in embedded structs.  Each struct is at most as deep as its
+ * declaration, so the recursion is bounded.
+ */
+static int type_serial_is_portable(const struct_info_t *struct_info, const tval *val)
+{
+  const field_info_t  *field_info;
+  const struct_info_t *embedded;
+  size_t               num;
+  size_t               i;
+
+  num = struct_info_num_fields(struct_info);
+  for (i = 0; i < num; ++i)
+  {
+    field_info = struct_info_index_field(struct_info, i);
+    if (!field_info)
+      continue;
+
+    if (field_info->field_type == funp_type())
+    {
+      if (!type_serial_is_zero(field_info_cref(field_info, val), field_info->field_size))
+        return 0;
+
+      continue;
+    }
+
+    embedded = type_serial_field_embedded(field_info);
+    if (embedded && !type_serial_is_portable(embedded, field_info_cref(field_info, val)))
+      return 0;
+  }
+
+  return 1;
+}
+
+/*
+ * Give every typed value embedded in "val", itself of type "type", this
+ * process's type: each "typed_t" field is set to the type of the struct
+ * it is declared in.
+ */
+static void type_serial_restamp(const type_t *type, const struct_info_t *struct_info, tval *val)
+{
+  const field_info_t  *field_info;
+  const struct_info_t *embedded;
+  size_t               num;
+  size_t               i;
+
+  num = struct_info_num_fields(struct_info);
+  for (i = 0; i < num; ++i)
+  {
+    field_info = struct_info_index_field(struct_info, i);
+    if (!field_info)
+      continue;
+
+    if (field_info->field_type == typed_type() && field_info->field_size == sizeof(typed_t))
+    {
+      memcpy(field_info_ref(field_info, val), &type->indirect, sizeof(typed_t));
+      continue;
+    }
+
+    embedded = type_serial_field_embedded(field_info);
+    if (embedded)
+      type_serial_restamp(field_info->field_type, embedded, field_info_ref(field_info, val));
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/* Headers.                                                         */
+/* ---------------------------------------------------------------- */
+
+static int type_serial_header_is_valid(const type_serial_header_t *header, size_t size)
+{
+  return
+    (  memcmp(header->magic, TYPE_SERIAL_MAGIC, sizeof(header->magic)) == 0
+    && header->version    == TYPE_SERIAL_VERSION
+    && header->byte_order == TYPE_SERIAL_BYTE_ORDER
+    && header->size_size  == sizeof(size_t)
+    && header->ptr_size   == sizeof(void *)
+    && header->alignment  == TYPE_SERIAL_ALIGNMENT
+    && header->root       == TYPE_SERIAL_ROOT
+    && header->size       >  header->root
+    && header->size       <= size
+    );
+}
+
+const type_serial_header_t *type_serial_header(const void *buf, size_t size)
+{
+  const type_serial_header_t *header;
+
+  if (!buf || size < sizeof(type_serial_header_t))
+    return NULL;
+
+  if ((size_t) buf % TYPE_SERIAL_ALIGNMENT != 0)
+    return NULL;
+
+  header = (const type_serial_header_t *) buf;
+  if (!type_serial_header_is_valid(header, size))
+    return NULL;
+
+  return header;
+}
+
+/* ---------------------------------------------------------------- */
+/* Writing.                                                         */
+/* ---------------------------------------------------------------- */
+
+/* Queue every value reachable from the root.  0 on success. */
+static int type_serial_layout(type_serial_queue_t *queue, const type_t *type, const tval *val)
+{
+  type_serial_chunk_t *chunk;
+  size_t               i;
+
+  if (!type_serial_queue_push(queue, type, val, type_size(type, val)))
+    return -1;
+
+  /* The queue grows while we walk it. */
+  for (chunk = queue->first; chunk; chunk = chunk->next)
+  {
+    for (i = 0; i < chunk->num; ++i)
+    {
+      const type_serial_value_t *value;
+      type_serial_fields_t       fields;
+      const field_info_t        *field_info;
+
+      value = &chunk->values[i];
+
+      if (!type_serial_is_portable(type_is_struct(value->type), value->val))
+        return -4;
+
+      type_serial_fields_begin(&fields, value->type);
+      while ((field_info = type_serial_fields_next(&fields)))
+      {
+        const type_t       *ref_type;
+        const tval         *ref;
+        int                 invalid;
+
+        ref_type = type_serial_field_ref_type(field_info, &invalid);
+        if (invalid)
+          return -2;
+        if (!ref_type)
+          continue;
+
+        type_deref(field_info->field_type, field_info_cref(field_info, value->val), &ref);
+        if (!ref || type_serial_queued(queue, ref))
+          continue;
+
+        if (!type_serial_queue_push(queue, ref_type, ref, type_size(ref_type, ref)))
+          return -3;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* Write the image of the values "type_serial_layout" queued. */
+static void type_serial_write(const type_serial_queue_t *queue, char *image)
+{
+  type_serial_header_t       header;
+  const type_serial_chunk_t *chunk;
+  size_t                     i;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TYPE_SERIAL_MAGIC, sizeof(header.magic));
+
+  header.version    = TYPE_SERIAL_VERSION;
+  header.byte_order = TYPE_SERIAL_BYTE_ORDER;
+  header.size_size  = (unsigned char) sizeof(size_t);
+  header.ptr_size   = (unsigned char) sizeof(void *);
+  header.alignment  = (unsigned char) TYPE_SERIAL_ALIGNMENT;
+  header.size       = queue->end;
+  header.root       = queue->first->values[0].offset;
+  header.root_size  = queue->first->values[0].size;
+
+  memset(image, 0, TYPE_SERIAL_ROOT);
+  memcpy(image, &header, sizeof(header));
+
+  for (chunk = queue->first; chunk; chunk = chunk->next)
+  {
+    for (i = 0; i < chunk->num; ++i)
+    {
+      const type_serial_value_t *value;
+      type_serial_fields_t       fields;
+      const field_info_t        *field_info;
+      char                      *dest;
+      size_t                     end;
+
+      value = &chunk->values[i];
+      dest  = image + value->offset;
+
+      memcpy(dest, value->val, value->size);
+
+      /* Zero the padding up to the next value. */
+      end = type_serial_align(value->offset + value->size);
+      memset(dest + value->size, 0, end - value->offset - value->size);
+
+      type_serial_fields_begin(&fields, value->type);
+      while ((field_info = type_serial_fields_next(&fields)))
+      {
+        const tval                *ref;
+        const type_serial_value_t *ref_value;
+        size_t                     ref_offset;
+        int                        invalid;
+
+        if (field_info->is_metadata)
+        {
+          memset(field_info_ref(field_info, dest), 0, field_info->field_size);
+          continue;
+        }
+
+        if (!type_serial_field_ref_type(field_info, &invalid))
+          continue;
+
+        type_deref(field_info->field_type, field_info_cref(field_info, value->val), &ref);
+
+        ref_value  = ref ? type_serial_queued(queue, ref) : NULL;
+        ref_offset = ref_value ? ref_value->offset : 0;
+
+        memset(field_info_ref(field_info, dest), 0, field_info->field_size);
+        memcpy(field_info_ref(field_info, dest), &ref_offset, sizeof(ref_offset));
+      }
+    }
+  }
+}
+
+size_t type_serialize(const type_t *type, const tval *val, void *out_buf, size_t buf_size, const memory_manager_t *memory_manager)
+{
+  type_serial_queue_t queue;
+  size_t              size;
+
+  if (!type || !val)
+    return 0;
+
+  memory_manager = require_memory_manager(memory_manager);
+
+  type_serial_queue_init(&queue, memory_manager);
+
+  if (type_serial_layout(&queue, type, val) != 0)
+  {
+    size = 0;
+  }
+  else
+  {
+    size = queue.end;
+
+    if (out_buf && buf_size >= size)
+      type_serial_write(&queue, out_buf);
+  }
+
+  type_serial_queue_deinit(&queue);
+
+  return size;
+}
+
+void *type_serialize_alloc(const type_t *type, const tval *val, const memory_manager_t *memory_manager, size_t *out_size)
+{
+  type_serial_queue_t  queue;
+  void                *image;
+
+  image = NULL;
+  if (out_size)
+    *out_size = 0;
+
+  if (!type || !val)
+    return NULL;
+
+  memory_manager = require_memory_manager(memory_manager);
+
+  type_serial_queue_init(&queue, memory_manager);
+
+  if (type_serial_layout(&queue, type, val) == 0)
+  {
+    image = memory_manager_mmalloc(memory_manager, queue.end);
+    if (image)
+    {
+      type_serial_write(&queue, image);
+
+      if (out_size)
+        *out_size = queue.end;
+    }
+  }
+
+  type_serial_queue_deinit(&queue);
+
+  return image;
+}
+
+/* ---------------------------------------------------------------- */
+/* Reading.                                                         */
+/* ---------------------------------------------------------------- */
+
+/* Queue the value at "offset", which must be where the writer put it. */
+static const type_serial_value_t *type_serial_read_value(type_serial_queue_t *queue, const char *image, size_t image_size, const type_t *type, size_t offset)
+{
+  const type_serial_value_t *value;
+  const tval                *val;
+  size_t                     size;
+
+  if (offset < TYPE_SERIAL_ROOT || offset >= image_size)
+    return NULL;
+
+  val = image + offset;
+
+  value = type_serial_queued(queue, val);
+  if (value)
+  {
+    /* The same value read as two different types. */
+    if (value->type != type)
+      return NULL;
+
+    return value;
+  }
+
+  if (offset != queue->end)
+    return NULL;
+
+  size = type_size(type, val);
+  if (size > image_size - offset)
+    return NULL;
+
+  return type_serial_queue_push(queue, type, val, size);
+}
+
+/* Check every value reachable from the root, without writing to the image.  0 on success. */
+static int type_serial_read_layout(type_serial_queue_t *queue, const char *image, size_t image_size, const type_t *type, size_t root_size)
+{
+  const type_serial_value_t *root;
+  type_serial_chunk_t       *chunk;
+  size_t                     i;
+
+  root = type_serial_read_value(queue, image, image_size, type, TYPE_SERIAL_ROOT);
+  if (!root || root->size != root_size)
+    return -1;
+
+  for (chunk = queue->first; chunk; chunk = chunk->next)
+  {
+    for (i = 0; i < chunk->num; ++i)
+    {
+      const type_serial_value_t *value;
+      type_serial_fields_t       fields;
+      const field_info_t        *field_info;
+
+      value = &chunk->values[i];
+
+      if (!type_serial_is_portable(type_is_struct(value->type), value->val))
+        return -5;
+
+      type_serial_fields_begin(&fields, value->type);
+      while ((field_info = type_serial_fields_next(&fields)))
+      {
+        const type_t       *ref_type;
+        size_t              ref_offset;
+        int                 invalid;
+
+        ref_type = type_serial_field_ref_type(field_info, &invalid);
+        if (invalid)
+          return -2;
+        if (!ref_type)
+          continue;
+
+        memcpy(&ref_offset, field_info_cref(field_info, value->val), sizeof(ref_offset));
+        if (ref_offset == 0)
+          continue;
+
+        if (!type_serial_read_value(queue, image, image_size, ref_type, ref_offset))
+          return -3;
+      }
+    }
+  }
+
+  /* Nothing but the values the root reaches. */
+  if (queue->end != image_size)
+    return -4;
+
+  return 0;
+}
+
+static void type_serial_field_default(const field_info_t *field_info, void *field)
+{
+  size_t (*default_value)(const field_info_t *self, void *dest_mem);
+
+  default_value = field_info->default_value;
+  if (!default_value)
+  {
+    default_value = field_info_defaults.default_value;
+    if (!default_value)
+      default_value = default_value_zero;
+  }
+
+  default_value(field_info, field);
+}
+
+/* Turn the values "type_serial_read_layout" checked into values. */
+static void type_serial_read_patch(const type_serial_queue_t *queue, char *image)
+{
+  const type_serial_chunk_t *chunk;
+  size_t                     i;
+
+  for (chunk = queue->first; chunk; chunk = chunk->next)
+  {
+    for (i = 0; i < chunk->num; ++i)
+    {
+      const type_serial_value_t *value;
+      type_serial_fields_t       fields;
+      const field_info_t        *field_info;
+      char                      *val;
+
+      value = &chunk->values[i];
+      val   = image + value->offset;
+
+      /* Typed values, and those embedded in them, get this process's types. */
+      if (type_typed(value->type) && value->size >= sizeof(typed_t))
+        memcpy(val, &value->type->indirect, sizeof(typed_t));
+      type_serial_restamp(value->type, type_is_struct(value->type), val);
+
+      type_serial_fields_begin(&fields, value->type);
+      while ((field_info = type_serial_fields_next(&fields)))
+      {
+        size_t              ref_offset;
+        void               *ref;
+        int                 invalid;
+
+        if (field_info->is_metadata)
+        {
+          type_serial_field_default(field_info, field_info_ref(field_info, val));
+          continue;
+        }
+
+        if (!type_serial_field_ref_type(field_info, &invalid))
+          continue;
+
+        memcpy(&ref_offset, field_info_cref(field_info, val), sizeof(ref_offset));
+
+        if (ref_offset == 0)
+          ref = NULL;
+        else
+          ref = image + ref_offset;
+
+        memcpy(field_info_ref(field_info, val), &ref, sizeof(ref));
+      }
+    }
+  }
+}
+
+tval *type_deserialize_in_place(const type_t *type, void *buf, size_t size, const memory_manager_t *memory_manager)
+{
+  const type_serial_header_t *header;
+  type_serial_queue_t         queue;
+  tval                       *root;
+
+  if (!type)
+    return NULL;
+
+  header = type_serial_header(buf, size);
+  if (!header)
+    return NULL;
+
+  memory_manager = require_memory_manager(memory_manager);
+
+  type_serial_queue_init(&queue, memory_manager);
+
+  if (type_serial_read_layout(&queue, buf, header->size, type, header->root_size) != 0)
+  {
+    root = NULL;
+  }
+  else
+  {
+    type_serial_read_patch(&queue, buf);
+
+    root = (char *) buf + TYPE_SERIAL_ROOT;
+  }
+
+  type_serial_queue_deinit(&queue);
+
+  return root;
+}
+
+tval *type_deserialize(const type_t *type, const void *buf, size_t size, const memory_manager_t *memory_manager, void **out_image)
+{
+  type_serial_header_t  header;
+  void                 *image;
+  tval                 *root;
+
+  if (!out_image)
+    return NULL;
+
+  *out_image = NULL;
+
+  if (!type || !buf || size < sizeof(header))
+    return NULL;
+
+  memcpy(&header, buf, sizeof(header));
+  if (!type_serial_header_is_valid(&header, size))
+    return NULL;
+
+  memory_manager = require_memory_manager(memory_manager);
+
+  image = memory_manager_mmalloc(memory_manager, header.size);
+  if (!image)
+    return NULL;
+
+  memcpy(image, buf, header.size);
+
+  root = type_deserialize_in_place(type, image, header.size, memory_manager);
+  if (!root)
+  {
+    memory_manager_mfree(memory_manager, image);
+    return NULL;
+  }
+
+  *out_image = image;
+
+  return root;
+}
@@ -0,0 +1,183 @@
+/*
+ * opencurry: type_base_serialize.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_serialize.h
+ * ------
+ *
+ * Binary images of "tval"s, driven by their types.
+ *
+ * "type_serialize" writes a value and everything it references through
+ * "is_recursible_ref" fields into one contiguous, versioned image:
+ *
+ *   - a "type_serial_header_t",
+ *   - then each value, once, at an aligned offset, in the order first
+ *     reached from the root, which comes first.
+ *
+ * Values are written as they are laid out in memory, except that
+ * references, whose field types "deref" to another type, are replaced
+ * with the offset of the referenced value in the image, or 0 for NULL.
+ * Values referenced more than once, including through cycles, are written
+ * once.  Metadata fields are zeroed.  Values holding function pointers,
+ * other than NULL ones, can't be written or read, e.g. "memory_manager_t"s
+ * and the structs that embed them.
+ *
+ * None of the builtin types "deref" yet: references are only followed for
+ * field types that define it, and builtin values are written as flat
+ * images.
+ *
+ * Reading an image back only patches it: offsets become pointers into the
+ * image, the "type" fields of typed values, including those of typed
+ * structs embedded in other values, are set to the reader's types, and
+ * metadata fields are reset to their defaults.  "type_deserialize"
+ * does this on a fresh copy, and "type_deserialize_in_place" does it over
+ * the image itself, e.g. a private writable mapping of a file, with no
+ * copying at all.
+ *
+ * Images can only be read by builds with the same representation of the
+ * values' types: the header records the format version, byte order, and
+ * word sizes, and readers reject images that differ.  Pointers held in
+ * plain fields are copied as they are, and are only meaningful to the
+ * process that wrote them.
+ */
+
+#ifndef TYPE_BASE_SERIALIZE_H
+#define TYPE_BASE_SERIALIZE_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_tval.h"
+#include "type_base_memory_manager.h"
+
+/* ---------------------------------------------------------------- */
+/* Images.                                                          */
+/* ---------------------------------------------------------------- */
+
+/* Bumped whenever the layout of images changes. */
+#define TYPE_SERIAL_VERSION    1
+
+#define TYPE_SERIAL_MAGIC      "otv"
+#define TYPE_SERIAL_BYTE_ORDER 0x01020304UL
+
+/* Values in an image are aligned for any type. */
+typedef union type_serial_align_u type_serial_align_t;
+union type_serial_align_u
+{
+  void        *align_ptr;
+  size_t       align_size;
+  long         align_long;
+  long double  align_ldouble;
+};
+
+#define TYPE_SERIAL_ALIGNMENT (sizeof(type_serial_align_t))
+
+typedef struct type_serial_header_s type_serial_header_t;
+struct type_serial_header_s
+{
+  /* TYPE_SERIAL_MAGIC. */
+  char          magic[4];
+
+  /* TYPE_SERIAL_VERSION. */
+  unsigned long version;
+
+  /* TYPE_SERIAL_BYTE_ORDER, in the writer's byte order. */
+  unsigned long byte_order;
+
+  unsigned char size_size;
+  unsigned char ptr_size;
+  unsigned char alignment;
+
+  /* Size of the whole image, including this header. */
+  size_t        size;
+
+  /* Offset and size of the root value. */
+  size_t        root;
+  size_t        root_size;
+};
+
+/* The header of "buf" if it holds an image this build can read, otherwise NULL. */
+const type_serial_header_t *type_serial_header(const void *buf, size_t size);
+
+/* ---------------------------------------------------------------- */
+/* Writing.                                                         */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Write the image of "val" to "out_buf", returning its size, or 0 on
+ * failure.
+ *
+ * Like "snprintf", nothing is written if the image needs more than
+ * "buf_size" bytes, so that a first call with a NULL "out_buf" can size
+ * the buffer.
+ *
+ * "memory_manager", or "default_memory_manager" if NULL, is used only for
+ * bookkeeping while writing.
+ */
+size_t type_serialize(const type_t *type, const tval *val, void *out_buf, size_t buf_size, const memory_manager_t *memory_manager);
+
+/* Allocate and write the image of "val"; free it with "memory_manager_mfree". */
+void *type_serialize_alloc(const type_t *type, const tval *val, const memory_manager_t *memory_manager, size_t *out_size);
+
+/* ---------------------------------------------------------------- */
+/* Reading.                                                         */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Read the image in "buf", which must be aligned to TYPE_SERIAL_ALIGNMENT,
+ * turning it into the root value, of type "type", and the values it
+ * references, all inside "buf".  Returns the root, or NULL if "buf" isn't
+ * a valid image of "type".
+ *
+ * "buf" must outlive the values; "memory_manager" is as for
+ * "type_serialize".
+ */
+tval *type_deserialize_in_place(const type_t *type, void *buf, size_t size, const memory_manager_t *memory_manager);
+
+/*
+ * Read a copy of the image in "buf", which needn't be aligned, allocated
+ * with "memory_manager".  "out_image" is set to the copy, to be freed with
+ * "memory_manager_mfree".
+ */
+tval *type_deserialize(const type_t *type, const void *buf, size_t size, const memory_manager_t *memory_manager, void **out_image);
+
+#endif /* ifndef TYPE_BASE_SERIALIZE_H */
@@ -0,0 +1,737 @@
+/*
+ * opencurry: type_base_thread_cache.c
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+/* string.h:
+ *   - memcpy
+ *   - memmove
+ *   - memset
+ */
+#include <string.h>
+
+#include "base.h"
+#include "type_base_prim.h"
+#include "type_base_memory_manager.h"
+#include "type_base_thread_cache.h"
+
+#include "util.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_getspecific
+ *   - pthread_key_create
+ *   - pthread_key_delete
+ *   - pthread_mutex_destroy
+ *   - pthread_mutex_init
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_unlock
+ *   - pthread_once
+ *   - pthread_once_t
+ *   - pthread_setspecific
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Blocks.                                                          */
+/* ---------------------------------------------------------------- */
+
+/*
+ * Every block handed out is preceded by a header recording its size class,
+ * since "mfree" is not told the size of what it frees.
+ *
+ * The union keeps the payload suitably aligned for any object.
+ */
+typedef union thread_cache_header_u thread_cache_header_t;
+union thread_cache_header_u
+{
+  struct
+  {
+    size_t size_class;
+
+    /* Only meaningful for THREAD_CACHE_LARGE_CLASS. */
+    size_t size;
+  } info;
+
+  void        *align_ptr;
+  long         align_long;
+  long double  align_ldouble;
+};
+
+#define BLOCK_HEADER(ptr) \
+  (((thread_cache_header_t *) (ptr)) - 1)
+#define BLOCK_PAYLOAD(header) \
+  ((void *) (((thread_cache_header_t *) (header)) + 1))
+
+/* Free blocks are linked through the first word of their payload. */
+#define BLOCK_NEXT(ptr) \
+  (*((void **) (ptr)))
+
+#define BLOCK_STRIDE(size_class) \
+  (sizeof(thread_cache_header_t) + THREAD_CACHE_CLASS_SIZE(size_class))
+
+/* ---------------------------------------------------------------- */
+/* Magazines.                                                       */
+/* ---------------------------------------------------------------- */
+
+typedef struct thread_cache_magazine_s thread_cache_magazine_t;
+struct thread_cache_magazine_s
+{
+  size_t  num;
+  void   *blocks[THREAD_CACHE_MAGAZINE_SIZE];
+};
+
+typedef struct thread_cache_local_s thread_cache_local_t;
+struct thread_cache_local_s
+{
+  thread_cache_t          *owner;
+  thread_cache_magazine_t  magazines[THREAD_CACHE_NUM_CLASSES];
+};
+
+#if POSIX_PARALLEL
+#  define CENTRAL_LOCK(central)   pthread_mutex_lock  (&(central)->lock)
+#  define CENTRAL_UNLOCK(central) pthread_mutex_unlock(&(central)->lock)
+#else  /* #if POSIX_PARALLEL */
+#  define CENTRAL_LOCK(central)
+#  define CENTRAL_UNLOCK(central)
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+
+size_t thread_cache_size_class(size_t size)
+{
+  size_t size_class;
+  size_t class_size;
+
+  if (size > THREAD_CACHE_MAX_CLASS_SIZE)
+    return THREAD_CACHE_LARGE_CLASS;
+
+  for
+    ( size_class = 0, class_size = THREAD_CACHE_CLASS_SIZE(0)
+    ; class_size < size
+    ; ++size_class, class_size <<= 1
+    )
+    ;
+
+  return size_class;
+}
+
+/* ---------------------------------------------------------------- */
+
+/* Move the oldest "num" blocks of "magazine" to the central pool. */
+static size_t thread_cache_release
+  ( thread_cache_t          *thread_cache
+  , size_t                   size_class
+  , thread_cache_magazine_t *magazine
+  , size_t                   num
+  )
+{
+  thread_cache_central_t *central;
+  size_t                  i;
+
+  if (num > magazine->num)
+    num = magazine->num;
+  if (num <= 0)
+    return 0;
+
+  /* Chain the blocks together outside of the lock. */
+  for (i = 0; i + 1 < num; ++i)
+    BLOCK_NEXT(magazine->blocks[i]) = magazine->blocks[i + 1];
+
+  central = &thread_cache->central[size_class];
+
+  CENTRAL_LOCK(central);
+  {
+    BLOCK_NEXT(magazine->blocks[num - 1]) = central->free_list;
+    central->free_list                    = magazine->blocks[0];
+    central->free_num                    += num;
+  }
+  CENTRAL_UNLOCK(central);
+
+  magazine->num -= num;
+  memmove
+    ( (void *) &magazine->blocks[0]
+    , (const void *) &magazine->blocks[num]
+    , magazine->num * sizeof(magazine->blocks[0])
+    );
+
+  return num;
+}
+
+/*
+ * Allocate a new chunk of "THREAD_CACHE_BATCH_SIZE" blocks and place them in
+ * "magazine".
+ *
+ * The caller holds the central lock.
+ */
+static size_t thread_cache_carve_chunk
+  ( thread_cache_t          *thread_cache
+  , size_t                   size_class
+  , thread_cache_magazine_t *magazine
+  )
+{
+  thread_cache_central_t *central;
+  thread_cache_header_t  *chunk;
+  unsigned char          *blocks;
+  size_t                  stride;
+  size_t                  i;
+
+  central = &thread_cache->central[size_class];
+  stride  = BLOCK_STRIDE(size_class);
+
+  chunk = memory_manager_mmalloc
+    ( thread_cache->inner
+    , sizeof(thread_cache_header_t) + THREAD_CACHE_BATCH_SIZE * stride
+    );
+  if (!chunk)
+    return 0;
+
+  chunk->align_ptr = central->chunks;
+  central->chunks  = (void *) chunk;
+  ++central->chunks_num;
+
+  /* Push in reverse so that the magazine hands out ascending addresses. */
+  blocks = (unsigned char *) BLOCK_PAYLOAD(chunk);
+  for (i = THREAD_CACHE_BATCH_SIZE; i > 0; --i)
+  {
+    thread_cache_header_t *header;
+
+    header = (thread_cache_header_t *) (blocks + (i - 1) * stride);
+    header->info.size_class = size_class;
+    header->info.size       = 0;
+
+    magazine->blocks[magazine->num++] = BLOCK_PAYLOAD(header);
+  }
+
+  return THREAD_CACHE_BATCH_SIZE;
+}
+
+/* Fill an empty "magazine" from the central pool, or from a new chunk. */
+static size_t thread_cache_refill
+  ( thread_cache_t          *thread_cache
+  , size_t                   size_class
+  , thread_cache_magazine_t *magazine
+  )
+{
+  thread_cache_central_t *central;
+  size_t                  num;
+
+  central = &thread_cache->central[size_class];
+  num     = 0;
+
+  CENTRAL_LOCK(central);
+  {
+    while (central->free_list && num < THREAD_CACHE_BATCH_SIZE)
+    {
+      void *block;
+
+      block              = central->free_list;
+      central->free_list = BLOCK_NEXT(block);
+
+      magazine->blocks[magazine->num++] = block;
+      ++num;
+    }
+    central->free_num -= num;
+
+    if (num <= 0)
+      num = thread_cache_carve_chunk(thread_cache, size_class, magazine);
+  }
+  CENTRAL_UNLOCK(central);
+
+  return num;
+}
+
+/* Return all of a thread's magazines to the central pool. */
+static size_t thread_cache_local_release_all(thread_cache_t *thread_cache, thread_cache_local_t *local)
+{
+  size_t num;
+  size_t size_class;
+
+  num = 0;
+  for (size_class = 0; size_class < THREAD_CACHE_NUM_CLASSES; ++size_class)
+  {
+    thread_cache_magazine_t *magazine;
+
+    magazine = &local->magazines[size_class];
+
+    num += thread_cache_release(thread_cache, size_class, magazine, magazine->num);
+  }
+
+  return num;
+}
+
+#if POSIX_PARALLEL
+/* Thread exit: hand the thread's blocks back before its magazines go away. */
+static void thread_cache_local_destroy(void *local_raw)
+{
+  thread_cache_local_t *local = local_raw;
+  thread_cache_t       *owner;
+
+  if (!local)
+    return;
+
+  owner = local->owner;
+
+  thread_cache_local_release_all(owner, local);
+  memory_manager_mfree(owner->inner, local);
+}
+#endif /* #if POSIX_PARALLEL */
+
+static thread_cache_local_t *thread_cache_peek_local(thread_cache_t *thread_cache)
+{
+#if POSIX_PARALLEL
+  return (thread_cache_local_t *) pthread_getspecific(thread_cache->local_key);
+#else  /* #if POSIX_PARALLEL */
+  return (thread_cache_local_t *) thread_cache->local;
+#endif /* #if POSIX_PARALLEL */
+}
+
+/* Get the calling thread's magazines, creating them on first use. */
+static thread_cache_local_t *thread_cache_local(thread_cache_t *thread_cache)
+{
+  thread_cache_local_t *local;
+  size_t                size_class;
+
+  local = thread_cache_peek_local(thread_cache);
+  if (local)
+    return local;
+
+  local = memory_manager_mmalloc(thread_cache->inner, sizeof(*local));
+  if (!local)
+    return NULL;
+
+  local->owner = thread_cache;
+  for (size_class = 0; size_class < THREAD_CACHE_NUM_CLASSES; ++size_class)
+    local->magazines[size_class].num = 0;
+
+#if POSIX_PARALLEL
+  if (pthread_setspecific(thread_cache->local_key, local) != 0)
+  {
+    memory_manager_mfree(thread_cache->inner, local);
+    return NULL;
+  }
+#else  /* #if POSIX_PARALLEL */
+  thread_cache->local = local;
+#endif /* #if POSIX_PARALLEL */
+
+  return local;
+}
+
+/* ---------------------------------------------------------------- */
+/* thread_cache_t                                                   */
+/* ---------------------------------------------------------------- */
+
+thread_cache_t global_thread_cache;
+
+static void global_thread_cache_init(void)
+{
+  thread_cache_init(&global_thread_cache, &malloc_manager);
+}
+
+#if POSIX_PARALLEL
+static pthread_once_t global_thread_cache_once = PTHREAD_ONCE_INIT;
+#endif /* #if POSIX_PARALLEL */
+
+/* Resolve NULL to the global thread cache, initializing it if needed. */
+static thread_cache_t *require_thread_cache(thread_cache_t *thread_cache)
+{
+  if (!thread_cache || thread_cache == &global_thread_cache)
+  {
+#if POSIX_PARALLEL
+    pthread_once(&global_thread_cache_once, global_thread_cache_init);
+#else  /* #if POSIX_PARALLEL */
+    if (!global_thread_cache.initialized)
+      global_thread_cache_init();
+#endif /* #if POSIX_PARALLEL */
+
+    return &global_thread_cache;
+  }
+
+#if ERROR_CHECKING
+  if (!thread_cache->initialized)
+    return NULL;
+#endif /* #if ERROR_CHECKING */
+
+  return thread_cache;
+}
+
+thread_cache_t *thread_cache_init(thread_cache_t *thread_cache, const memory_manager_t *inner)
+{
+  size_t size_class;
+
+  if (!thread_cache)
+    return NULL;
+
+  thread_cache->inner = require_memory_manager(inner);
+
+  for (size_class = 0; size_class < THREAD_CACHE_NUM_CLASSES; ++size_class)
+  {
+    thread_cache_central_t *central = &thread_cache->central[size_class];
+
+    central->free_list  = NULL;
+    central->free_num   = 0;
+    central->chunks     = NULL;
+    central->chunks_num = 0;
+
+#if POSIX_PARALLEL
+    if (pthread_mutex_init(&central->lock, NULL) != 0)
+    {
+      while (size_class > 0)
+        pthread_mutex_destroy(&thread_cache->central[--size_class].lock);
+
+      return NULL;
+    }
+#endif /* #if POSIX_PARALLEL */
+  }
+
+#if POSIX_PARALLEL
+  if (pthread_key_create(&thread_cache->local_key, thread_cache_local_destroy) != 0)
+  {
+    for (size_class = 0; size_class < THREAD_CACHE_NUM_CLASSES; ++size_class)
+      pthread_mutex_destroy(&thread_cache->central[size_class].lock);
+
+    return NULL;
+  }
+#else  /* #if POSIX_PARALLEL */
+  thread_cache->local = NULL;
+#endif /* #if POSIX_PARALLEL */
+
+  thread_cache->initialized = 1;
+
+  return thread_cache;
+}
+
+size_t thread_cache_deinit(thread_cache_t *thread_cache)
+{
+  thread_cache_local_t *local;
+  size_t                num_freed;
+  size_t                size_class;
+
+  if (!thread_cache || !thread_cache->initialized)
+    return 0;
+
+  /* Drop the calling thread's magazines. */
+  local = thread_cache_peek_local(thread_cache);
+  if (local)
+    memory_manager_mfree(thread_cache->inner, local);
+
+#if POSIX_PARALLEL
+  pthread_key_delete(thread_cache->local_key);
+#else  /* #if POSIX_PARALLEL */
+  thread_cache->local = NULL;
+#endif /* #if POSIX_PARALLEL */
+
+  num_freed = 0;
+  for (size_class = 0; size_class < THREAD_CACHE_NUM_CLASSES; ++size_class)
+  {
+    thread_cache_central_t *central = &thread_cache->central[size_class];
+
+    while (central->chunks)
+    {
+      thread_cache_header_t *chunk = central->chunks;
+
+      central->chunks = chunk->align_ptr;
+
+      num_freed += memory_manager_mfree(thread_cache->inner, chunk);
+    }
+
+    central->free_list  = NULL;
+    central->free_num   = 0;
+    central->chunks_num = 0;
+
+#if POSIX_PARALLEL
+    pthread_mutex_destroy(&central->lock);
+#endif /* #if POSIX_PARALLEL */
+  }
+
+  thread_cache->initialized = 0;
+
+  return num_freed;
+}
+
+size_t thread_cache_flush(thread_cache_t *thread_cache)
+{
+  thread_cache_local_t *local;
+
+  thread_cache = require_thread_cache(thread_cache);
+  if (!thread_cache)
+    return 0;
+
+  local = thread_cache_peek_local(thread_cache);
+  if (!local)
+    return 0;
+
+  return thread_cache_local_release_all(thread_cache, local);
+}
+
+/* ---------------------------------------------------------------- */
+
+void *thread_cache_malloc(thread_cache_t *thread_cache, size_t size)
+{
+  size_t                   size_class;
+  thread_cache_local_t    *local;
+  thread_cache_magazine_t *magazine;
+
+  thread_cache = require_thread_cache(thread_cache);
+  if (!thread_cache)
+    return NULL;
+
+  size_class = thread_cache_size_class(size);
+
+  if (size_class == THREAD_CACHE_LARGE_CLASS)
+  {
+    thread_cache_header_t *header;
+
+    header = memory_manager_mmalloc(thread_cache->inner, sizeof(*header) + size);
+    if (!header)
+      return NULL;
+
+    header->info.size_class = THREAD_CACHE_LARGE_CLASS;
+    header->info.size       = size;
+
+    return BLOCK_PAYLOAD(header);
+  }
+
+  local = thread_cache_local(thread_cache);
+  if (!local)
+    return NULL;
+
+  magazine = &local->magazines[size_class];
+
+  if (magazine->num <= 0)
+  {
+    if (!thread_cache_refill(thread_cache, size_class, magazine))
+      return NULL;
+  }
+
+  return magazine->blocks[--magazine->num];
+}
+
+size_t thread_cache_free(thread_cache_t *thread_cache, void *ptr)
+{
+  size_t                   size_class;
+  thread_cache_local_t    *local;
+  thread_cache_magazine_t *magazine;
+
+  /* As "free" does, NULL is a no-op. */
+  if (!ptr)
+    return 0;
+
+  thread_cache = require_thread_cache(thread_cache);
+  if (!thread_cache)
+    return 0;
+
+  size_class = BLOCK_HEADER(ptr)->info.size_class;
+
+  if (size_class == THREAD_CACHE_LARGE_CLASS)
+    return memory_manager_mfree(thread_cache->inner, BLOCK_HEADER(ptr));
+
+#if ERROR_CHECKING
+  if (size_class >= THREAD_CACHE_NUM_CLASSES)
+    return 0;
+#endif /* #if ERROR_CHECKING */
+
+  local = thread_cache_local(thread_cache);
+  if (!local)
+  {
+    /* No magazines for this thread: give the block straight back. */
+    thread_cache_central_t *central = &thread_cache->central[size_class];
+
+    CENTRAL_LOCK(central);
+    {
+      BLOCK_NEXT(ptr)    = central->free_list;
+      central->free_list = ptr;
+      ++central->free_num;
+    }
+    CENTRAL_UNLOCK(central);
+
+    return 1;
+  }
+
+  magazine = &local->magazines[size_class];
+
+  if (magazine->num >= THREAD_CACHE_MAGAZINE_SIZE)
+    thread_cache_release(thread_cache, size_class, magazine, THREAD_CACHE_BATCH_SIZE);
+
+  magazine->blocks[magazine->num++] = ptr;
+
+  return 1;
+}
+
+void *thread_cache_realloc(thread_cache_t *thread_cache, void *ptr, size_t size)
+{
+  thread_cache_header_t *header;
+  size_t                 capacity;
+  void                  *resized;
+
+  if (!ptr)
+    return thread_cache_malloc(thread_cache, size);
+
+  thread_cache = require_thread_cache(thread_cache);
+  if (!thread_cache)
+    return NULL;
+
+  header = BLOCK_HEADER(ptr);
+
+  if (header->info.size_class == THREAD_CACHE_LARGE_CLASS)
+  {
+    /* Large to large: let the inner manager move it. */
+    if (size > THREAD_CACHE_MAX_CLASS_SIZE)
+    {
+      header = memory_manager_mrealloc(thread_cache->inner, header, sizeof(*header) + size);
+      if (!header)
+        return NULL;
+
+      header->info.size = size;
+
+      return BLOCK_PAYLOAD(header);
+    }
+
+    capacity = header->info.size;
+  }
+  else
+  {
+    capacity = THREAD_CACHE_CLASS_SIZE(header->info.size_class);
+
+    if (size <= capacity)
+      return ptr;
+  }
+
+  resized = thread_cache_malloc(thread_cache, size);
+  if (!resized)
+    return NULL;
+
+  memcpy(resized, ptr, MIN(capacity, size));
+  thread_cache_free(thread_cache, ptr);
+
+  return resized;
+}
+
+void *thread_cache_calloc(thread_cache_t *thread_cache, size_t nmemb, size_t size)
+{
+  void *mem;
+
+  if (size > 0 && nmemb > ((size_t) (-1)) / size)
+    return NULL;
+
+  mem = thread_cache_malloc(thread_cache, nmemb * size);
+  if (!mem)
+    return NULL;
+
+  memset(mem, 0, nmemb * size);
+
+  return mem;
+}
+
+size_t thread_cache_central_num(thread_cache_t *thread_cache, size_t size_class)
+{
+  thread_cache_central_t *central;
+  size_t                  num;
+
+  thread_cache = require_thread_cache(thread_cache);
+  if (!thread_cache)
+    return 0;
+
+  if (size_class >= THREAD_CACHE_NUM_CLASSES)
+    return 0;
+
+  central = &thread_cache->central[size_class];
+
+  CENTRAL_LOCK(central);
+  {
+    num = central->free_num;
+  }
+  CENTRAL_UNLOCK(central);
+
+  return num;
+}
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+static void   *thread_cache_manager_mmalloc (const memory_manager_t *self, size_t  size);
+static size_t  thread_cache_manager_mfree   (const memory_manager_t *self, void   *ptr);
+static void   *thread_cache_manager_mrealloc(const memory_manager_t *self, void   *ptr,   size_t size);
+static void   *thread_cache_manager_mcalloc (const memory_manager_t *self, size_t  nmemb, size_t size);
+
+const memory_manager_t thread_cache_manager =
+  { memory_manager_type
+
+  , thread_cache_manager_mmalloc
+  , thread_cache_manager_mfree
+  , thread_cache_manager_mrealloc
+  , thread_cache_manager_mcalloc
+
+  , NULL
+  , NULL
+
+  , memory_manager_default_on_oom
+  , memory_manager_default_on_err
+
+  , NULL
+  , 0
+  };
+
+static void   *thread_cache_manager_mmalloc (const memory_manager_t *self, size_t  size)
+  { return thread_cache_malloc (self->state, size); }
+static size_t  thread_cache_manager_mfree   (const memory_manager_t *self, void   *ptr)
+  { return thread_cache_free   (self->state, ptr); }
+static void   *thread_cache_manager_mrealloc(const memory_manager_t *self, void   *ptr,   size_t size)
+  { return thread_cache_realloc(self->state, ptr,   size); }
+static void   *thread_cache_manager_mcalloc (const memory_manager_t *self, size_t  nmemb, size_t size)
+  { return thread_cache_calloc (self->state, nmemb, size); }
+
+memory_manager_t *thread_cache_manager_init(memory_manager_t *dest, thread_cache_t *thread_cache)
+{
+  dest =
+    memory_manager_init
+      ( dest
+
+      , thread_cache_manager_mmalloc
+      , thread_cache_manager_mfree
+      , thread_cache_manager_mrealloc
+      , thread_cache_manager_mcalloc
+      );
+  if (!dest)
+    return NULL;
+
+  dest->state      = (void *) require_thread_cache(thread_cache);
+  dest->state_size = sizeof(thread_cache_t);
+
+  return dest;
+}
@@ -0,0 +1,187 @@
+/*
+ * opencurry: type_base_thread_cache.h
+ *
+ * Copyright (c) 2015, Byron James Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * type_base_thread_cache.h
+ * ------
+ *
+ * Thread-caching memory manager.
+ *
+ * Small requests are rounded up to one of "THREAD_CACHE_NUM_CLASSES" size
+ * classes.  Each thread keeps a "magazine" of recently freed blocks per size
+ * class, so the common malloc/free pair touches no shared state at all.  When
+ * a magazine overflows, a batch of its oldest blocks is returned to a shared
+ * central pool; when it runs dry, a batch is taken from the central pool, or
+ * carved from a fresh chunk obtained from the inner memory manager.
+ *
+ * Requests larger than the largest size class are forwarded to the inner
+ * memory manager directly.
+ *
+ * Without POSIX_PARALLEL, there is a single magazine set per cache.
+ */
+
+#ifndef TYPE_BASE_THREAD_CACHE_H
+#define TYPE_BASE_THREAD_CACHE_H
+/* stddef.h:
+ *   - NULL
+ *   - size_t
+ */
+#include <stddef.h>
+
+#include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - pthread_key_t
+ *   - pthread_mutex_t
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
+/* ---------------------------------------------------------------- */
+/* Dependencies.                                                    */
+/* ---------------------------------------------------------------- */
+
+#include "type_base_prim.h"
+#include "type_base_typed.h"
+#include "type_base_memory_manager.h"
+
+/* ---------------------------------------------------------------- */
+/* Size classes.                                                    */
+/* ---------------------------------------------------------------- */
+
+/* Size classes are powers of two: 16, 32, ..., 32768. */
+#define THREAD_CACHE_MIN_CLASS_BITS 4
+#define THREAD_CACHE_NUM_CLASSES    12
+
+#define THREAD_CACHE_CLASS_SIZE(size_class) \
+  (((size_t) 1) << ((size_class) + THREAD_CACHE_MIN_CLASS_BITS))
+#define THREAD_CACHE_MAX_CLASS_SIZE \
+  THREAD_CACHE_CLASS_SIZE(THREAD_CACHE_NUM_CLASSES - 1)
+
+/* The "size class" of allocations forwarded to the inner manager. */
+#define THREAD_CACHE_LARGE_CLASS ((size_t) (-1))
+
+/* Maximum number of blocks a thread holds per size class. */
+#define THREAD_CACHE_MAGAZINE_SIZE 64
+
+/* Number of blocks moved between a magazine and the central pool at once. */
+#define THREAD_CACHE_BATCH_SIZE    32
+
+size_t thread_cache_size_class(size_t size);
+
+/* ---------------------------------------------------------------- */
+/* thread_cache_t                                                   */
+/* ---------------------------------------------------------------- */
+
+/* Shared pool of free blocks for one size class. */
+typedef struct thread_cache_central_s thread_cache_central_t;
+struct thread_cache_central_s
+{
+  /* Free blocks, linked through their first word. */
+  void   *free_list;
+  size_t  free_num;
+
+  /* Chunks obtained from the inner manager, linked through their first word. */
+  void   *chunks;
+  size_t  chunks_num;
+
+#if POSIX_PARALLEL
+  pthread_mutex_t lock;
+#endif /* #if POSIX_PARALLEL */
+};
+
+typedef struct thread_cache_s thread_cache_t;
+struct thread_cache_s
+{
+  /* Where chunks and large allocations come from. */
+  const memory_manager_t *inner;
+
+  thread_cache_central_t central[THREAD_CACHE_NUM_CLASSES];
+
+  /* Per-thread magazines. */
+#if POSIX_PARALLEL
+  pthread_key_t  local_key;
+#else  /* #if POSIX_PARALLEL */
+  void          *local;
+#endif /* #if POSIX_PARALLEL */
+
+  int initialized;
+};
+
+/*
+ * A process-wide thread cache over "malloc_manager", initialized on first
+ * use.
+ */
+extern thread_cache_t global_thread_cache;
+
+/* ---------------------------------------------------------------- */
+
+/* If "inner" is NULL, "default_memory_manager" is used. */
+thread_cache_t *thread_cache_init(thread_cache_t *thread_cache, const memory_manager_t *inner);
+
+/*
+ * Release every chunk back to the inner manager.
+ *
+ * Only the calling thread's magazines are flushed; other threads that used
+ * this cache must have exited, or called "thread_cache_flush", beforehand.
+ *
+ * Returns the number of chunks freed.
+ */
+size_t thread_cache_deinit(thread_cache_t *thread_cache);
+
+/* Return the calling thread's cached blocks to the central pool. */
+size_t thread_cache_flush(thread_cache_t *thread_cache);
+
+void   *thread_cache_malloc (thread_cache_t *thread_cache, size_t  size);
+size_t  thread_cache_free   (thread_cache_t *thread_cache, void   *ptr);
+void   *thread_cache_realloc(thread_cache_t *thread_cache, void   *ptr,   size_t size);
+void   *thread_cache_calloc (thread_cache_t *thread_cache, size_t  nmemb, size_t size);
+
+/* Number of free blocks currently held in the central pool. */
+size_t thread_cache_central_num(thread_cache_t *thread_cache, size_t size_class);
+
+/* ---------------------------------------------------------------- */
+/* Memory manager front-end.                                        */
+/* ---------------------------------------------------------------- */
+
+/* Allocates from "global_thread_cache". */
+extern const memory_manager_t thread_cache_manager;
+
+/*
+ * Initialize a memory manager that allocates from "thread_cache".
+ *
+ * If "thread_cache" is NULL, "global_thread_cache" is used.
+ */
+memory_manager_t *thread_cache_manager_init(memory_manager_t *dest, thread_cache_t *thread_cache);
+
+#endif /* ifndef TYPE_BASE_THREAD_CACHE_H */
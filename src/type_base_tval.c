@@ -78,7 +78,7 @@ const type_t *typeof(const tval *val)
   if (!val)
     return NULL;
 
-  indirect_type_def = typeof_indirect(val);
+  indirect_type_def = TVAL_TYPEOF(val);
   if (!indirect_type_def)
     return NULL;
 
@@ -97,16 +97,10 @@ const type_t *typeof(const tval *val)
  */
 const type_t *typeof_indirect(const tval *val)
 {
-  typed_t typed;
-
   if (!val)
     return NULL;
 
-  typed = tval_get_typed(val);
-  if (!typed)
-    return NULL;
-
-  return (const type_t *) (typed());
+  return TVAL_TYPEOF(val);
 }
 
 /*
@@ -156,3 +150,42 @@ const typed_t *tval_to_typed(const tval *val)
 
   return (const typed_t *) val;
 }
+
+/* ---------------------------------------------------------------- */
+/* Resolved types.                                                  */
+/* ---------------------------------------------------------------- */
+
+const type_t * volatile typed_cache[TYPED_CACHE_SLOTS];
+
+void typed_cache_add(const type_t *type)
+{
+  const type_t * volatile *slot;
+
+  if (!type || !type->indirect)
+    return;
+
+  slot = &typed_cache[TYPED_CACHE_SLOT(type->indirect)];
+
+  /* Filled slots are never replaced. */
+  if (ATOMIC_LOAD(slot))
+    return;
+
+  if (type->indirect() != type)
+    return;
+
+  ATOMIC_CAS(slot, NULL, type);
+}
+
+const type_t *typed_resolve(typed_t typed)
+{
+  const type_t *type;
+
+  if (!typed)
+    return NULL;
+
+  type = typed();
+  if (type && type->indirect == typed)
+    typed_cache_add(type);
+
+  return type;
+}
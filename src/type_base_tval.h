@@ -269,6 +269,49 @@ const type_t  *typeof_indirect(const tval *val);
 typed_t        tval_get_typed (const tval *val);
 const typed_t *tval_to_typed  (const tval *val);
 
+/* ---------------------------------------------------------------- */
+/* Resolved types.                                                  */
+/* ---------------------------------------------------------------- */
+
+/*
+ * A cache of the "type_t" that each "typed_t" returns, so that finding a
+ * value's type needn't call its "typed_t".
+ *
+ * Types are recorded as values are created, as struct plans are built for
+ * their fields' types, and whenever a lookup misses.  The cache is direct
+ * mapped on the "typed_t", and a slot is filled at most once, so a slot read
+ * twice gives the same type; a type is the answer for a "typed_t" only if
+ * its "indirect" is that "typed_t".  Types that collide on a slot are
+ * resolved with a call, as before.
+ *
+ * "TVAL_TYPEOF" is "typeof", and "TYPED_TYPEOF" is the type returned by a
+ * "typed_t", without the call when the type is cached.  Unlike "typeof",
+ * "val" must not be NULL, and both macros evaluate their argument more than
+ * once.  Their use requires "type_base_type.h".
+ */
+#define TYPED_CACHE_SLOTS 256
+
+extern const type_t * volatile typed_cache[TYPED_CACHE_SLOTS];
+
+#define TYPED_CACHE_SLOT(typed) \
+  ((((size_t) (typed)) >> 4) & (TYPED_CACHE_SLOTS - 1))
+#define TYPED_CACHED(typed) \
+  ((const type_t *) ATOMIC_LOAD(&typed_cache[TYPED_CACHE_SLOT(typed)]))
+
+#define TYPED_TYPEOF(typed)                                    \
+  (  TYPED_CACHED(typed) && TYPED_CACHED(typed)->indirect == (typed) \
+   ? TYPED_CACHED(typed)                                       \
+   : typed_resolve(typed)                                      \
+  )
+#define TVAL_TYPEOF(val) \
+  TYPED_TYPEOF(*((const typed_t *) (val)))
+
+/* Record "type" for its "indirect", if that returns "type". */
+void          typed_cache_add(const type_t *type);
+
+/* Call "typed", caching the result; NULL if "typed" is NULL. */
+const type_t *typed_resolve  (typed_t typed);
+
 /* ---------------------------------------------------------------- */
 /* Post-dependencies.                                               */
 /* ---------------------------------------------------------------- */
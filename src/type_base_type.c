@@ -32,10 +32,22 @@
 
 /* string.h:
  *   - memcmp
+ *   - memmove
  */
 #include <string.h>
 
 #include "base.h"
+
+#if POSIX_PARALLEL
+/* pthread.h:
+ *   - PTHREAD_MUTEX_INITIALIZER
+ *   - pthread_mutex_lock
+ *   - pthread_mutex_t
+ *   - pthread_mutex_unlock
+ */
+#include <pthread.h>
+#endif /* #if POSIX_PARALLEL */
+
 #include "type_base_prim.h"
 #include "type_base_type.h"
 
@@ -63,6 +75,8 @@ static const tval          *type_type_has_default(const type_t *self);
 static void                *type_type_user       (const type_t *self, tval *val);
 static const void          *type_type_cuser      (const type_t *self, const tval *val);
 
+static const struct type_registry_entry_s *type_type_registry_entry = NULL;
+
 const type_t type_type_def =
   { type_type
 
@@ -100,6 +114,10 @@ const type_t type_type_def =
   , /* user                   */ type_type_user
   , /* cuser                  */ type_type_cuser
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &type_type_registry_entry
 
   , /* parity                 */ ""
   };
@@ -210,6 +228,19 @@ static const struct_info_t *type_type_is_struct  (const type_t *self)
     STRUCT_INFO_RADD(funp_type(), cuser);
     STRUCT_INFO_RADD(funp_type(), cmp);
 
+    /* size_t               (*hash)       ( const type_t *self                   */
+    /*                                    , const tval *val                      */
+    /*                                    , int deep                             */
+    /*                                    , ref_traversal_t *vals                */
+    /*                                    );                                     */
+    STRUCT_INFO_RADD(funp_type(), hash);
+
+    /* const type_t        *(*deref)      ( const type_t *self                   */
+    /*                                    , const tval *val                      */
+    /*                                    , const tval **out_ref                 */
+    /*                                    );                                     */
+    STRUCT_INFO_RADD(funp_type(), deref);
+
     /* const char *parity; */
     STRUCT_INFO_RADD(objp_type(), parity);
 
@@ -440,16 +471,22 @@ tval *type_mutable_from_struct(const type_t *self, const tval *val)
 
   const struct_info_t *struct_info;
   const field_info_t  *field_info;
+  memory_tracker_t    *tracker;
 
   /* See whether we have a struct_info. */
 
-  if (!self || val)
+  if (!self || !val)
     return NULL;
 
   struct_info = type_is_struct(self);
   if (!struct_info)
     return NULL;
 
+  /* Shared values are copied before they are modified. */
+  if ((tracker = struct_value_has_memory_tracker(struct_info, (void *) val)))
+    if (memory_tracker_is_shared(tracker))
+      return NULL;
+
   /* Check each field. */
 
   /* + 1: The field terminator requirement makes this safe. */
@@ -589,6 +626,20 @@ tval *type_has_template_cons_basic_initializer_force_memory_manager(const type_t
   return template_cons_basic_initializer(type, (template_cons_t *) cons, allow_alternate_memory_manager);
 }
 
+/*
+ * The default image of a struct's fields can't know the type; give a value
+ * initialized from it the type in its typed field.
+ */
+static void template_cons_stamp_typed(const type_t *type, const struct_info_t *struct_info, tval *val)
+{
+  const field_info_t *typed_field;
+
+  typed_field = struct_info_has_typed_field(struct_info);
+
+  if (typed_field && !*((const typed_t *) field_info_cref(typed_field, val)))
+    *((typed_t *) field_info_ref(typed_field, val)) = type->indirect;
+}
+
 /*
  * template_cons_basic_initializer:
  *
@@ -617,6 +668,8 @@ tval *template_cons_basic_initializer(const type_t *type, template_cons_t *cons,
   const tval                *mem_init_object;
   const memory_manager_t    *def_memory_manager;
 
+  tval                      *val;
+
   if (!type)
   {
     if (cons && cons->out_init_error_msg)
@@ -636,7 +689,16 @@ tval *template_cons_basic_initializer(const type_t *type, template_cons_t *cons,
   mem_init_object    = (const tval *) type;
   def_memory_manager = type_default_memory_manager(type, NULL);
 
-  return template_cons_dup_struct(cons, size, default_initials, struct_info, mem_init, mem_init_object, def_memory_manager, allow_alternate_memory_manager);
+  val = template_cons_dup_struct(cons, size, default_initials, struct_info, mem_init, mem_init_object, def_memory_manager, allow_alternate_memory_manager);
+
+  /* Later lookups of the value's type needn't call its "typed_t". */
+  if (val)
+    typed_cache_add(type);
+
+  if (val && !default_initials && (!cons || (!cons->initials && !cons->force_no_defaults && !cons->allocate_only_with_num)))
+    template_cons_stamp_typed(type, struct_info, val);
+
+  return val;
 }
 
 /* free */
@@ -789,7 +851,7 @@ const tval *type_has_default_value(const type_t *self, const tval *val)
  * Default memory tracker lookup method.
  *
  * Use the type's "struct_info" to obtain a value's "memory_tracker" field,
- * defaulting to the global memory tracker used valuelessly when absent.
+ * defaulting to the thread's memory tracker used valuelessly when absent.
  *
  * The type has no valueless memory unless it lacks a "struct_info" with a
  * designated "memory_tracker" field.
@@ -802,6 +864,18 @@ const tval *type_has_default_value(const type_t *self, const tval *val)
  *
  * Otherwise return a reference to the value's memory tracker field.
  */
+/* The calling thread's tracker, or the shared one if that is unavailable. */
+static memory_tracker_t *type_global_dyn_memory_tracker(void)
+{
+  memory_tracker_t *tracker;
+
+  tracker = thread_typed_dyn_memory_tracker();
+  if (!tracker)
+    return &global_typed_dyn_memory_tracker;
+
+  return tracker;
+}
+
 memory_tracker_t *type_mem_struct_or_global_dyn(const type_t *self, tval *val_raw)
 {
   const struct_info_t *struct_info;
@@ -813,15 +887,17 @@ memory_tracker_t *type_mem_struct_or_global_dyn(const type_t *self, tval *val_ra
   struct_info = type_is_struct(self);
   if (!struct_info)
   {
-    /* The type uses the global-dynamic-typed-allocations memory tracker valuelessly. */
-    return &global_typed_dyn_memory_tracker;
+    /* The type uses the calling thread's dynamic-typed-allocations memory */
+    /* tracker valuelessly.                                                */
+    return type_global_dyn_memory_tracker();
   }
 
   memory_tracker_field = struct_info_has_memory_tracker(struct_info);
   if (!memory_tracker_field)
   {
-    /* The type uses the global-dynamic-typed-allocations memory tracker valuelessly. */
-    return &global_typed_dyn_memory_tracker;
+    /* The type uses the calling thread's dynamic-typed-allocations memory */
+    /* tracker valuelessly.                                                */
+    return type_global_dyn_memory_tracker();
   }
 
   /* Yes, so track memory inside values. */
@@ -1412,6 +1488,10 @@ int mem_is_dyn_valueless_or_inside_value
 
     is_value_tracked = tracked_byte_allocation(valueless_memory_tracker, val);
 
+    /* Allocated by another thread, whose tracker will free it? */
+    if (is_value_tracked < 0 && memory_tracker_owner(val))
+      return 8;
+
     if (is_value_tracked < 0)
     {
       /* Error: memory_tracker_is_allocation_tracked failed! */
@@ -1812,6 +1892,15 @@ const memory_manager_t *type_prefers_given_memory_manager(const type_t *self, tv
   }
   else
   {
+    memory_tracker_t *memory_tracker;
+
+    /* A thread's tracker frees values into the thread's own heap, so */
+    /* allocate them there.                                          */
+    memory_tracker = type_mem(self, NULL);
+
+    if (memory_tracker && memory_tracker->owner_thread)
+      return &memory_tracker->memory_manager;
+
     return memory_manager;
   }
 }
@@ -1954,6 +2043,126 @@ tval *type_has_struct_dup_never_malloc( const type_t *self
   return dest;
 }
 
+/*
+ * The memory tracker of the value a reference refers to, writing the value
+ * and its type.
+ */
+static memory_tracker_t *type_ref_tracker(const type_t *ref_type, const tval *ref, const type_t **out_referent_type, tval **out_referent)
+{
+  const type_t *referent_type;
+  const tval   *referent;
+
+  referent_type = type_deref(ref_type, ref, &referent);
+
+  *out_referent_type = referent_type;
+  *out_referent      = (tval *) referent;
+
+  if (!referent_type || !referent)
+    return NULL;
+
+  return struct_value_has_memory_tracker(type_is_struct(referent_type), (void *) referent);
+}
+
+/*
+ * type_has_shared_ref_dup:
+ *
+ * A "dup" for reference types whose values refer to structs with a memory
+ * tracker: copying a reference, recursively or not, shares the value it
+ * refers to, adding an owner with "memory_tracker_share", instead of copying
+ * it.  Every copy is then released with "type_ref_release".
+ *
+ * The value is copied later, only if an owner asks to modify it with
+ * "type_ref_mutable" while it is shared.
+ *
+ * If "dest" is NULL, or the value has no memory tracker, returns NULL.
+ */
+tval *type_has_shared_ref_dup( const type_t *self
+                             , tval *dest
+                             , const tval *src
+                             , int defaults_src_unused
+                             , int rec_copy
+                             , int dup_metadata
+                             , ref_traversal_t *ref_traversal
+                             )
+{
+  const type_t     *referent_type;
+  tval             *referent;
+  memory_tracker_t *tracker;
+
+  if (!dest || !src)
+    return NULL;
+
+  /* Copying onto itself adds no reference. */
+  if (dest == src)
+    return dest;
+
+  tracker = type_ref_tracker(self, src, &referent_type, &referent);
+
+  if (!referent_type)
+    return NULL;
+
+  if (referent)
+  {
+    if (!tracker)
+      return NULL;
+
+    memory_tracker_share(tracker);
+  }
+
+  memmove(dest, src, type_size(self, src));
+
+  return dest;
+}
+
+tval *type_ref_mutable(const type_t *ref_type, tval *ref)
+{
+  const type_t     *referent_type;
+  tval             *referent;
+  memory_tracker_t *tracker;
+  tval             *copy;
+
+  tracker = type_ref_tracker(ref_type, ref, &referent_type, &referent);
+  if (!referent)
+    return NULL;
+
+  if (!tracker || !memory_tracker_is_shared(tracker))
+    return referent;
+
+  /* Copy this value alone; what it refers to is shared by the copy. */
+  copy = type_dup(referent_type, NULL, referent, 1, 1, 0, NULL);
+  if (!copy)
+    return NULL;
+
+  if (!memory_tracker_unshare(tracker))
+  {
+    /* The other owners let go meanwhile. */
+    type_free(referent_type, copy);
+    return referent;
+  }
+
+  *((tval **) ref) = copy;
+
+  return copy;
+}
+
+size_t type_ref_release(const type_t *ref_type, tval *ref)
+{
+  const type_t     *referent_type;
+  tval             *referent;
+  memory_tracker_t *tracker;
+
+  tracker = type_ref_tracker(ref_type, ref, &referent_type, &referent);
+  if (!referent)
+    return 0;
+
+  *((tval **) ref) = NULL;
+
+  if (tracker && memory_tracker_unshare(tracker))
+    return 0;
+
+  return type_free(referent_type, referent);
+}
+
 /* user */
 void *type_has_no_user_data(const type_t *self, tval *val)
 {
@@ -1998,6 +2207,79 @@ int type_has_standard_cmp(const type_t *self, const tval *check, const tval *bas
   }
 }
 
+/* hash */
+/* Hash fields if struct, otherwise hash memory, as "type_has_standard_cmp" compares. */
+size_t type_has_standard_hash(const type_t *self, const tval *val, int deep, ref_traversal_t *vals)
+{
+  const struct_info_t *struct_info;
+
+  if (!self || !val)
+    return 0;
+
+  if ((struct_info = type_is_struct(self)))
+    return struct_hash(struct_info, val, deep, vals);
+  else
+    return hash_mem(val, type_size(self, val));
+}
+
+/*
+ * For reference types with a "deref" method: compare and hash what the
+ * references refer to, rather than the references themselves, while "deep"
+ * allows.
+ *
+ * Identical references compare equal; otherwise a NULL reference sorts first.
+ */
+int type_has_deref_cmp(const type_t *self, const tval *check, const tval *baseline, int deep, ref_traversal_t *vals)
+{
+  const type_t *ref_type;
+  const tval   *check_ref;
+  const tval   *baseline_ref;
+
+  if (deep == 0 || !check || !baseline)
+    return type_has_standard_cmp(self, check, baseline, deep, vals);
+
+  ref_type = type_deref(self, check,    &check_ref);
+  if (!ref_type)
+    return type_has_standard_cmp(self, check, baseline, deep, vals);
+  type_deref(self, baseline, &baseline_ref);
+
+  if (check_ref == baseline_ref)
+    return 0;
+  else if (!check_ref)
+    return -1;
+  else if (!baseline_ref)
+    return 1;
+
+  return type_cmp(ref_type, check_ref, baseline_ref, deep, vals);
+}
+
+size_t type_has_deref_hash(const type_t *self, const tval *val, int deep, ref_traversal_t *vals)
+{
+  const type_t *ref_type;
+  const tval   *ref;
+
+  if (deep == 0 || !val)
+    return type_has_standard_hash(self, val, deep, vals);
+
+  ref_type = type_deref(self, val, &ref);
+  if (!ref_type)
+    return type_has_standard_hash(self, val, deep, vals);
+
+  if (!ref)
+    return 0;
+
+  return type_hash(ref_type, ref, deep, vals);
+}
+
+/* deref */
+const type_t *type_is_not_ref(const type_t *self, const tval *val, const tval **out_ref)
+{
+  if (out_ref)
+    *out_ref = NULL;
+
+  return NULL;
+}
+
 /* ---------------------------------------------------------------- */
 /* type_t: Defaults.                                                */
 /* ---------------------------------------------------------------- */
@@ -2131,6 +2413,8 @@ int type_has_standard_cmp(const type_t *self, const tval *check, const tval *bas
  * >   , /-* user                   *-/ NULL
  * >   , /-* cuser                  *-/ NULL
  * >   , /-* cmp                    *-/ NULL
+ * >   , /-* hash                   *-/ NULL
+ * >   , /-* deref                  *-/ NULL
  * >
  * >   , /-* parity                 *-/ ""
  * >   };
@@ -2200,8 +2484,9 @@ int type_has_standard_cmp(const type_t *self, const tval *check, const tval *bas
  *       valueless memory tracker.)
  *
  *       If a type is not a struct and lacks a valueless memory tracker, the
- *       global memory tracker "global_typed_dyn_memory_tracker" is used to
- *       track dynamic memory allocations.
+ *       calling thread's "thread_typed_dyn_memory_tracker" is used to track
+ *       dynamic memory allocations, so such values must be freed on the
+ *       thread that allocated them.
  *
  *   - whether the type is typed (values are "tval *"s):
  *       "type_is_typed_from_struct":
@@ -2354,6 +2639,19 @@ int                  default_type_cmp        ( const type_t *self
                                              )
   { return type_has_standard_cmp(self, check, baseline, deep, vals); }
 
+size_t               default_type_hash       ( const type_t *self
+                                             , const tval *val
+                                             , int deep
+                                             , ref_traversal_t *vals
+                                             )
+  { return type_has_standard_hash(self, val, deep, vals); }
+
+const type_t        *default_type_deref      ( const type_t *self
+                                             , const tval *val
+                                             , const tval **out_ref
+                                             )
+  { return type_is_not_ref(self, val, out_ref); }
+
 /* ---------------------------------------------------------------- */
 
 /*
@@ -2618,18 +2916,180 @@ int                  type_cmp        ( const type_t *type
     return type->cmp(type, check, baseline, deep, vals);
 }
 
+size_t               type_hash       ( const type_t *type
+                                     , const tval *val
+                                     , int deep
+                                     , ref_traversal_t *vals
+                                     )
+{
+  if (!type || !type->hash)
+    return type_defaults.hash(type, val, deep, vals);
+  else
+    return type->hash(type, val, deep, vals);
+}
+
+const type_t        *type_deref      ( const type_t *type
+                                     , const tval *val
+                                     , const tval **out_ref
+                                     )
+{
+  if (!type || !type->deref)
+    return type_defaults.deref(type, val, out_ref);
+  else
+    return type->deref(type, val, out_ref);
+}
+
 /* ---------------------------------------------------------------- */
 
 /*
  * Compositional "type_t" accessors.
  */
 
-const type_t *is_subtype(const type_t *sub, const type_t *super)
+/*
+ * Memoized "is_subtype" results: one open-addressing table of slots keyed by
+ * the ("sub", "super") pair, whose results are "subtype_memo_none" for
+ * negative answers.
+ *
+ * Slots are only written with the lock held, and never move, so "is_subtype"
+ * reads them without it.  A slot is live only while its "generation" is the
+ * current one: invalidation just advances the generation, and a writer
+ * zeroes a slot's generation before refilling it, so a reader that sees the
+ * same live generation before and after reading the pair saw a whole entry.
+ *
+ * Results are computed without the lock held, since the methods may query
+ * other pairs, and are only recorded if no invalidation happened meanwhile.
+ * When the table is mostly full, recording starts a new generation.
+ */
+#define SUBTYPE_MEMO_SIZE 1024
+
+typedef struct subtype_memo_slot_s subtype_memo_slot_t;
+struct subtype_memo_slot_s
 {
-  const type_t *is_sub;
+  size_t        generation;
 
-  if (!sub || !super)
-    return NULL;
+  const type_t *sub;
+  const type_t *super;
+  const type_t *result;
+};
+
+#if POSIX_PARALLEL
+static pthread_mutex_t subtype_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* #if POSIX_PARALLEL */
+
+static subtype_memo_slot_t subtype_memo[SUBTYPE_MEMO_SIZE];
+static size_t              subtype_memo_num        = 0;
+static size_t              subtype_memo_generation = 1;
+
+static const type_t        subtype_memo_none[1];
+
+static void subtype_memo_lock_acquire(void)
+{
+#if POSIX_PARALLEL
+  pthread_mutex_lock(&subtype_memo_lock);
+#endif /* #if POSIX_PARALLEL */
+}
+
+static void subtype_memo_lock_release(void)
+{
+#if POSIX_PARALLEL
+  pthread_mutex_unlock(&subtype_memo_lock);
+#endif /* #if POSIX_PARALLEL */
+}
+
+static size_t subtype_memo_index(const type_t *sub, const type_t *super)
+{
+  return hash_combine(hash_mix((size_t) sub), (size_t) super) & (SUBTYPE_MEMO_SIZE - 1);
+}
+
+/*
+ * Without the lock: the memoized result, "subtype_memo_none", or NULL when
+ * the pair is absent from "generation".
+ */
+static const type_t *subtype_memo_find(const type_t *sub, const type_t *super, size_t generation)
+{
+  size_t index;
+  size_t probes;
+
+  index = subtype_memo_index(sub, super);
+  for (probes = 0; probes < SUBTYPE_MEMO_SIZE; ++probes)
+  {
+    subtype_memo_slot_t *slot;
+    const type_t        *slot_sub;
+    const type_t        *slot_super;
+    const type_t        *result;
+
+    slot = &subtype_memo[index];
+
+    /* Live slots are contiguous from a pair's index. */
+    if (ATOMIC_LOAD(&slot->generation) != generation)
+      return NULL;
+
+    slot_sub   = ATOMIC_LOAD(&slot->sub);
+    slot_super = ATOMIC_LOAD(&slot->super);
+    result     = ATOMIC_LOAD(&slot->result);
+
+    /* Refilled meanwhile. */
+    if (ATOMIC_LOAD(&slot->generation) != generation)
+      return NULL;
+
+    if (slot_sub == sub && slot_super == super)
+      return result;
+
+    index = (index + 1) & (SUBTYPE_MEMO_SIZE - 1);
+  }
+
+  return NULL;
+}
+
+/* With the lock held. */
+static void subtype_memo_add(const type_t *sub, const type_t *super, const type_t *is_sub)
+{
+  subtype_memo_slot_t *slot;
+  size_t               index;
+
+  if ((subtype_memo_num + 1) * 4 > SUBTYPE_MEMO_SIZE * 3)
+  {
+    ATOMIC_STORE(&subtype_memo_generation, subtype_memo_generation + 1);
+    subtype_memo_num = 0;
+  }
+
+  index = subtype_memo_index(sub, super);
+  for (;;)
+  {
+    slot = &subtype_memo[index];
+
+    if (slot->generation != subtype_memo_generation)
+      break;
+
+    /* Recorded by another thread meanwhile. */
+    if (slot->sub == sub && slot->super == super)
+      return;
+
+    index = (index + 1) & (SUBTYPE_MEMO_SIZE - 1);
+  }
+
+  ATOMIC_STORE(&slot->generation, 0);
+  ATOMIC_STORE(&slot->sub,        sub);
+  ATOMIC_STORE(&slot->super,      super);
+  ATOMIC_STORE(&slot->result,     is_sub ? is_sub : subtype_memo_none);
+  ATOMIC_STORE(&slot->generation, subtype_memo_generation);
+
+  ++subtype_memo_num;
+}
+
+void type_subtype_memo_invalidate(void)
+{
+  subtype_memo_lock_acquire();
+  {
+    ATOMIC_STORE(&subtype_memo_generation, subtype_memo_generation + 1);
+    subtype_memo_num = 0;
+  }
+  subtype_memo_lock_release();
+}
+
+static const type_t *is_subtype_unmemoized(const type_t *sub, const type_t *super)
+{
+  const type_t *is_sub;
 
   if ((is_sub = type_is_subtype(super, sub)))
   {
@@ -2644,6 +3104,31 @@ const type_t *is_subtype(const type_t *sub, const type_t *super)
   return NULL;
 }
 
+const type_t *is_subtype(const type_t *sub, const type_t *super)
+{
+  size_t        generation;
+  const type_t *is_sub;
+
+  if (!sub || !super)
+    return NULL;
+
+  generation = ATOMIC_LOAD(&subtype_memo_generation);
+
+  if ((is_sub = subtype_memo_find(sub, super, generation)))
+    return is_sub == subtype_memo_none ? NULL : is_sub;
+
+  is_sub = is_subtype_unmemoized(sub, super);
+
+  subtype_memo_lock_acquire();
+  {
+    if (generation == subtype_memo_generation)
+      subtype_memo_add(sub, super, is_sub);
+  }
+  subtype_memo_lock_release();
+
+  return is_sub;
+}
+
 const type_t *is_type_equivalent(const type_t *this, const type_t *that)
 {
   const type_t *this_subof_that;
@@ -2717,6 +3202,220 @@ int cmp_with_type     (const type_t *type, const tval *check, const tval *baseli
   return cmp_with_type_deep(type, check, baseline, CMP_WITH_TYPE_DEFAULT_DEEP);
 }
 
+size_t hash_with_type_deep(const type_t *type, const tval *val, int deep)
+{
+  return type_hash(type, val, deep, NULL);
+}
+
+size_t hash_with_type     (const type_t *type, const tval *val)
+{
+  return hash_with_type_deep(type, val, HASH_WITH_TYPE_DEFAULT_DEEP);
+}
+
+size_t type_pod_size(const type_t *type)
+{
+  if (!type)
+    return 0;
+
+  if
+    (!
+      (  (  !type->dup
+         || type->dup == default_type_dup
+         || type->dup == type_has_struct_dup_allow_malloc
+         || type->dup == type_has_struct_dup_never_malloc
+         )
+      && (  !type->cmp
+         || type->cmp == default_type_cmp
+         || type->cmp == type_has_standard_cmp
+         )
+      )
+    )
+  {
+    return 0;
+  }
+
+  return struct_info_pod_size(type_is_struct(type));
+}
+
+tval *type_dup_array(const type_t *type, tval *dest, const tval *src, size_t num, int rec_copy, int dup_metadata)
+{
+  size_t size;
+  size_t pod_size;
+  size_t i;
+
+  if (!type || !dest || !src)
+    return NULL;
+
+  size = type_size(type, NULL);
+  if (size <= 0 || num > ((size_t) -1) / size)
+    return NULL;
+
+  pod_size = type_pod_size(type);
+
+  /* The fields cover each value: one copy for the whole array. */
+  if (pod_size && pod_size == size)
+  {
+    memmove(dest, src, num * size);
+    return dest;
+  }
+
+  for (i = 0; i < num; ++i)
+  {
+    if (pod_size)
+      memmove((char *) dest + i * size, (const char *) src + i * size, pod_size);
+    else if (!type_dup(type, (char *) dest + i * size, (const char *) src + i * size, 1, rec_copy, dup_metadata, NULL))
+      return NULL;
+  }
+
+  return dest;
+}
+
+/* Does "type" use only the standard "template_cons_t" initializer and freer? */
+static int type_is_basic_cons(const type_t *type)
+{
+  return
+       (  !type->init
+       || type->init == default_type_init
+       || type->init == type_has_template_cons_basic_initializer
+       || type->init == type_has_template_cons_basic_initializer_force_memory_manager
+       )
+    && (  !type->free
+       || type->free == default_type_free
+       || type->free == type_has_template_cons_basic_freer
+       );
+}
+
+tval *type_init_array(const type_t *type, template_cons_t *cons, size_t num)
+{
+  template_cons_t      block_cons;
+  template_cons_t      val_cons;
+  const struct_info_t *struct_info;
+  const tval          *initials;
+  int                  defaults_src_unused;
+  int                  stamp_typed;
+  tval                *vals;
+  size_t               size;
+  size_t               pod_size;
+  size_t               filled;
+  size_t               i;
+
+  if (!type || num <= 0 || !type_is_basic_cons(type))
+    return NULL;
+
+  struct_info = type_is_struct(type);
+  if (!struct_info)
+    return NULL;
+
+  size = type_size(type, NULL);
+  if (size <= 0 || num > ((size_t) -1) / size)
+    return NULL;
+
+  /* A single value is just a value. */
+  if (num == 1)
+    return type_init(type, (tval *) cons);
+
+  block_cons = cons ? *cons : template_cons_defaults;
+  if (block_cons.dest || block_cons.preserve_metadata)
+    return NULL;
+
+  /* One zeroed block, tracked once, with the first value. */
+  block_cons.allocate_only_with_num = num;
+  vals = type_init(type, (tval *) &block_cons);
+  if (!vals)
+    return NULL;
+
+  /* The first value's fields; without defaults, they stay zeroed. */
+  initials            = block_cons.initials;
+  defaults_src_unused = block_cons.force_no_defaults;
+  stamp_typed         = 0;
+  if (!initials && !block_cons.force_no_defaults)
+  {
+    initials = type_has_default(type);
+    if (!initials)
+    {
+      initials    = struct_info_default_image(struct_info);
+      stamp_typed = 1;
+    }
+
+    defaults_src_unused = 1;
+
+    if (!initials)
+    {
+      type_free(type, vals);
+      return NULL;
+    }
+  }
+
+  if (initials)
+  {
+    if (struct_dup(struct_info, vals, initials, defaults_src_unused, block_cons.initials_copy_rec, 0, block_cons.ref_traversal))
+    {
+      type_free(type, vals);
+      return NULL;
+    }
+
+    if (stamp_typed)
+      template_cons_stamp_typed(type, struct_info, vals);
+  }
+
+  /* The fields cover each value: fill the block by doubling the first. */
+  pod_size = type_pod_size(type);
+  if (pod_size && pod_size == size)
+  {
+    for (filled = 1; filled < num; filled *= 2)
+      memcpy((char *) vals + filled * size, vals, (filled <= num - filled ? filled : num - filled) * size);
+
+    return vals;
+  }
+
+  /* Otherwise each value may have its own memory tracker and metadata:
+   * initialize the rest in place, as "type_init" would with "dest".
+   */
+  val_cons                        = block_cons;
+  val_cons.allocate_only_with_num = 0;
+
+  for (i = 1; i < num; ++i)
+  {
+    val_cons.dest = (char *) vals + i * size;
+
+    if (!type_init(type, (tval *) &val_cons))
+    {
+      type_free_array(type, vals, i);
+      return NULL;
+    }
+  }
+
+  return vals;
+}
+
+size_t type_free_array(const type_t *type, tval *vals, size_t num)
+{
+  memory_tracker_t *tracker;
+  size_t            size;
+  size_t            i;
+
+  if (!type || !vals || num <= 0 || !type_is_basic_cons(type))
+    return 0;
+
+  size = type_size(type, NULL);
+
+  /* The values after the first weren't allocated on their own, so
+   * "type_free" would leave what their trackers hold; free that, then the
+   * first value with the block.
+   */
+  if (!type_mem(type, NULL))
+  {
+    for (i = num - 1; i >= 1; --i)
+    {
+      tracker = type_mem(type, (char *) vals + i * size);
+      if (tracker)
+        memory_tracker_free(tracker);
+    }
+  }
+
+  return type_free(type, vals);
+}
+
 /* ---------------------------------------------------------------- */
 
 /*
@@ -73,6 +73,9 @@
  */
 const type_t *type_type(void);
 extern const type_t type_type_def;
+/* See "type_base_registry.h". */
+struct type_registry_entry_s;
+
 /* Forward declaration: typedef struct type_s type_t; */
 struct type_s
 {
@@ -529,7 +532,7 @@ struct type_s
   /* (The default "mem" method type_mem_struct_or_global_dyn"         */
   /* method only assigns a valueless memory tracker when the type     */
   /* lacks a struct_info with a designated memory tracker field;      */
-  /* in this case it is assigned "global_typed_dyn_memory_tracker".)  */
+  /* in this case it is assigned "thread_typed_dyn_memory_tracker".)  */
   /*                                                                  */
   /* ---------------------------------------------------------------- */
   /*                                                                  */
@@ -712,6 +715,41 @@ struct type_s
                                      , ref_traversal_t *vals
                                      );
 
+  /* Hash a value, consistently with "cmp": values that "cmp" finds  */
+  /* equal with the same "deep" must hash equal.  A type that         */
+  /* overrides "cmp" should override "hash" to match.                 */
+  /*                                                                  */
+  /* "deep" and "vals" are as for "cmp"; references already being     */
+  /* hashed in "vals" are not hashed again.                           */
+  size_t               (*hash)       ( const type_t *self
+                                     , const tval *val
+                                     , int deep
+                                     , ref_traversal_t *vals
+                                     );
+
+  /* If values of this type are references, i.e. data pointers to     */
+  /* another value, return the referenced value's type and write the  */
+  /* reference, which may be NULL, to "out_ref"; otherwise return     */
+  /* NULL.                                                            */
+  /*                                                                  */
+  /* The referenced type must not depend on the reference: "val" and  */
+  /* "out_ref" may be NULL to ask for the type alone.  This lets e.g. */
+  /* serialization follow "is_recursible_ref" fields.                 */
+  const type_t        *(*deref)      ( const type_t *self
+                                     , const tval *val
+                                     , const tval **out_ref
+                                     );
+
+  /* ---------------------------------------------------------------- */
+  /* Registry.                                                        */
+  /* ---------------------------------------------------------------- */
+
+  /* Where "type_register" caches this type's registry entry, so that */
+  /* "type_registry_id" needs no lock; may be NULL.  Types are        */
+  /* usually constant, so this points to a separate pointer, initially*/
+  /* NULL.                                                            */
+  const struct type_registry_entry_s **registry_entry;
+
   /* ---------------------------------------------------------------- */
 
   const char *parity;
@@ -747,17 +785,25 @@ const char *type_has_no_info(const type_t *self, char *out_info_buf, size_t info
 size_t type_has_unknown_size(const type_t *self, const tval *val);
 
 /* is_struct */
-#define STRUCT_INFO_CACHE(struct_info)          \
-  static struct_info_t *struct_info = NULL;     \
-  if (struct_info)                              \
-  {                                             \
-    return (const struct_info_t *) struct_info; \
-  }                                             \
-  else                                          \
-  {                                             \
-    static struct_info_t struct_info_def;       \
-                                                \
-    struct_info = &struct_info_def;             \
+/*
+ * Build the "struct_info" once, on first use, even with concurrent callers;
+ * see "struct_info_once_begin".  "STRUCT_INFO_DONE_COMPLEX" finishes it, and
+ * "STRUCT_INFO_FAIL_COMPLEX" gives up, leaving it NULL; an "is_struct"
+ * method must not otherwise return in between.
+ */
+#define STRUCT_INFO_CACHE(struct_info)                  \
+  static struct_info_t      *struct_info = NULL;        \
+  static struct_info_once_t  struct_info_once;          \
+  if (!struct_info_once_begin(&struct_info_once))       \
+  {                                                     \
+    return                                              \
+      (const struct_info_t *) ATOMIC_LOAD(&struct_info); \
+  }                                                     \
+  else                                                  \
+  {                                                     \
+    static struct_info_t struct_info_def;               \
+                                                        \
+    struct_info = &struct_info_def;                     \
   }
 
 #define STRUCT_INFO_INIT_COMPLEX(struct_info, field_default_value, field_template_unused_value) \
@@ -778,11 +824,23 @@ size_t type_has_unknown_size(const type_t *self, const tval *val);
     struct_info = struct_info_add_field_terminator(struct_info);                \
                                                                                 \
     if (verify_struct_info(struct_info, NULL, 0) != verify_struct_info_success) \
-      struct_info = NULL;                                                       \
+      STRUCT_INFO_FAIL_COMPLEX(struct_info);                                    \
+                                                                                \
+    struct_info_once_end(&struct_info_once);                                    \
                                                                                 \
     return ((const struct_info_t *) struct_info);                               \
   } while(0)
 
+#define STRUCT_INFO_FAIL_COMPLEX(struct_info)                                   \
+  do                                                                            \
+  {                                                                             \
+    ATOMIC_STORE(&struct_info, NULL);                                           \
+                                                                                \
+    struct_info_once_fail(&struct_info_once);                                   \
+                                                                                \
+    return NULL;                                                                \
+  } while(0)
+
 /* -- */
 
 #define STRUCT_INFO_BEGIN_COMPLEX(struct_type, struct_info, field_default_value, field_template_unused_value) \
@@ -856,6 +914,118 @@ size_t type_has_unknown_size(const type_t *self, const tval *val);
 
 /* -- */
 
+/*
+ * Prebuilt struct_infos.
+ *
+ * Instead of building its "struct_info" at runtime, an "is_struct" method
+ * can return a table written out at compile time, so no type work happens
+ * at runtime at all:
+ *
+ * > DEF_FIELD_DEFAULT_VALUE_FROM_TYPE(mytype)
+ * > static field_info_t mytype_fields[] =
+ * >   { STATIC_FIELD_INFO(mytype, mytype_t, type, typed_type_def)
+ * >   , STATIC_FIELD_INFO(mytype, mytype_t, a,    int_type_def)
+ * >   , STATIC_FIELD_INFO(mytype, mytype_t, b,    int_type_def)
+ * >   , FIELD_INFO_TERMINATOR
+ * >   };
+ * > static struct_info_t mytype_struct_info =
+ * >   STATIC_STRUCT_INFO(mytype, mytype_fields);
+ * >
+ * > const struct_info_t *mytype_type_is_struct(const type_t *self)
+ * >   { return &mytype_struct_info; }
+ *
+ * Unlike "STRUCT_INFO_ADD", "STATIC_FIELD_INFO" does not look for memory
+ * tracker fields; structs that have one should use "STRUCT_INFO_BEGIN".
+ *
+ * The table must not be "const": its copy plan is cached in it on first
+ * use.  Tests should check prebuilt tables with "verify_struct_info".
+ *
+ * A table written out by hand silently goes stale when its struct changes,
+ * so follow it with a layout check that fails to compile instead:
+ *
+ * > STATIC_FIELD_INFO_FIRST  (mytype_t,    type)
+ * > STATIC_FIELD_INFO_FOLLOWS(mytype_t, type, a)
+ * > STATIC_FIELD_INFO_FOLLOWS(mytype_t, a,    b)
+ * > STATIC_FIELD_INFO_LAST   (mytype_t,       b)
+ *
+ * Each field must sit right after the previous one, leaving room only for
+ * alignment padding, and the last must end the struct.  A field added,
+ * removed, or resized breaks the chain, unless it only fills or frees what
+ * would otherwise be padding.  Alignment is taken to be the field's size, up
+ * to that of a pointer.
+ */
+#define STATIC_FIELD_INFO(type_name, struct_type, field_name, field_type_def) \
+  { field_info_type                                                          \
+                                                                             \
+  , (ptrdiff_t) (OFFSET_FIELD(struct_type, field_name))                      \
+  , (size_t)    (SIZEOF_FIELD(struct_type, field_name))                      \
+  , &(field_type_def)                                                        \
+                                                                             \
+  , 0                                                                        \
+  , 0                                                                        \
+                                                                             \
+  , CAT(type_name, _default_field_value)                                     \
+  , field_template_unused_value_zero                                         \
+  }
+
+#define STATIC_FIELD_INFO_ALIGN(size) \
+  ((size) < sizeof(void *) ? (size) : sizeof(void *))
+
+#define STATIC_FIELD_INFO_ROUND(pos, align) \
+  (((pos) + (align) - 1) / (align) * (align))
+
+#define STATIC_FIELD_INFO_END(struct_type, field_name) \
+  (OFFSET_FIELD(struct_type, field_name) + SIZEOF_FIELD(struct_type, field_name))
+
+#define STATIC_FIELD_INFO_CHECK(field_name, cond)                       \
+  typedef char CAT3(static_field_info_check_, field_name, __LINE__)     \
+    [(cond) ? 1 : -1];
+
+#define STATIC_FIELD_INFO_FIRST(struct_type, field_name) \
+  STATIC_FIELD_INFO_CHECK                                \
+    ( field_name                                         \
+    , OFFSET_FIELD(struct_type, field_name) == 0         \
+    )
+
+#define STATIC_FIELD_INFO_FOLLOWS(struct_type, prev_name, field_name)        \
+  STATIC_FIELD_INFO_CHECK                                                     \
+    ( field_name                                                              \
+    , OFFSET_FIELD(struct_type, field_name) == STATIC_FIELD_INFO_ROUND        \
+        ( STATIC_FIELD_INFO_END(struct_type, prev_name)                       \
+        , STATIC_FIELD_INFO_ALIGN(SIZEOF_FIELD(struct_type, field_name))      \
+        )                                                                     \
+    )
+
+#define STATIC_FIELD_INFO_LAST(struct_type, field_name)                      \
+  STATIC_FIELD_INFO_CHECK                                                     \
+    ( field_name                                                              \
+    , sizeof(struct_type) == STATIC_FIELD_INFO_ROUND                          \
+        ( STATIC_FIELD_INFO_END(struct_type, field_name)                      \
+        , STATIC_FIELD_INFO_ALIGN(sizeof(struct_type))                        \
+        )                                                                     \
+    )
+
+#define STATIC_STRUCT_INFO(type_name, fields) \
+  { struct_info_type                          \
+                                              \
+  , (fields)                                  \
+  , ARRAY_NUM(fields) - 1                     \
+  , ARRAY_NUM(fields)                         \
+                                              \
+  , NULL                                      \
+                                              \
+  , CAT(type_name, _default_field_value)      \
+  , field_template_unused_value_zero          \
+                                              \
+  , 0                                         \
+  , 0                                         \
+                                              \
+  , NULL                                      \
+  , NULL                                      \
+  }
+
+/* -- */
+
 const struct_info_t *type_is_not_struct(const type_t *self);
 
 /* TODO: from_type: use the type's has_default, otherwise from_field_type. */
@@ -994,6 +1164,28 @@ tval *type_has_struct_dup_never_malloc( const type_t *self
                                       , int dup_metadata
                                       , ref_traversal_t *ref_traversal
                                       );
+tval *type_has_shared_ref_dup        ( const type_t *self
+                                      , tval *dest
+                                      , const tval *src
+                                      , int defaults_src_unused
+                                      , int rec_copy
+                                      , int dup_metadata
+                                      , ref_traversal_t *ref_traversal
+                                      );
+
+/*
+ * Copy-on-write references, for reference types with
+ * "type_has_shared_ref_dup".  References are data pointers.
+ *
+ * "type_ref_mutable" returns the value "ref" refers to, ready to be
+ * modified: if it is shared, "ref" is first pointed to a copy of it, and the
+ * original loses an owner.  Returns NULL on failure or a NULL reference.
+ *
+ * "type_ref_release" clears "ref", freeing the value it referred to unless
+ * it had other owners.  Returns the number of allocations freed.
+ */
+tval  *type_ref_mutable(const type_t *ref_type, tval *ref);
+size_t type_ref_release(const type_t *ref_type, tval *ref);
 
 /* user */
 void *type_has_no_user_data(const type_t *self, tval *val);
@@ -1004,6 +1196,16 @@ const void *type_has_no_cuser_data(const type_t *self, const tval *val);
 /* cmp */
 int type_has_standard_cmp(const type_t *self, const tval *check, const tval *baseline, int deep, ref_traversal_t *vals);
 
+/* hash */
+size_t type_has_standard_hash(const type_t *self, const tval *val, int deep, ref_traversal_t *vals);
+
+/* cmp and hash through "deref", for reference types. */
+int type_has_deref_cmp(const type_t *self, const tval *check, const tval *baseline, int deep, ref_traversal_t *vals);
+size_t type_has_deref_hash(const type_t *self, const tval *val, int deep, ref_traversal_t *vals);
+
+/* deref */
+const type_t *type_is_not_ref(const type_t *self, const tval *val, const tval **out_ref);
+
 /* ---------------------------------------------------------------- */
 
 /*
@@ -1064,6 +1266,15 @@ int                  default_type_cmp        ( const type_t *self
                                              , int deep
                                              , ref_traversal_t *vals
                                              );
+size_t               default_type_hash       ( const type_t *self
+                                             , const tval *val
+                                             , int deep
+                                             , ref_traversal_t *vals
+                                             );
+const type_t        *default_type_deref      ( const type_t *self
+                                             , const tval *val
+                                             , const tval **out_ref
+                                             );
 
 #define TYPE_DEFAULTS                                                \
   { type_type                                                        \
@@ -1102,6 +1313,10 @@ int                  default_type_cmp        ( const type_t *self
   , /* user                   */ default_type_user                   \
   , /* cuser                  */ default_type_cuser                  \
   , /* cmp                    */ default_type_cmp                    \
+  , /* hash                   */ default_type_hash                   \
+  , /* deref                  */ default_type_deref                  \
+                                                                     \
+  , /* registry_entry         */ NULL                                \
                                                                      \
   , /* parity                 */ ""                                  \
   }
@@ -1171,6 +1386,15 @@ int                  type_cmp        ( const type_t *type
                                      , int deep
                                      , ref_traversal_t *vals
                                      );
+size_t               type_hash       ( const type_t *type
+                                     , const tval *val
+                                     , int deep
+                                     , ref_traversal_t *vals
+                                     );
+const type_t        *type_deref      ( const type_t *type
+                                     , const tval *val
+                                     , const tval **out_ref
+                                     );
 
 /* ---------------------------------------------------------------- */
 
@@ -1186,11 +1410,63 @@ const type_t *is_supertype(const type_t *super, const type_t *sub);
 const type_t *is_supertype_via(const type_t *super, const type_t *mid, const type_t *sub);
 const type_t *is_proper_supertype(const type_t *super, const type_t *sub);
 
+/*
+ * "is_subtype" results are memoized by ("sub", "super") pair, so each pair
+ * consults the types' "is_subtype" and "is_supertype" methods only once, as
+ * long as the memo has room for it; the other queries are built on
+ * "is_subtype".  Memoized answers are read without locking.
+ *
+ * Call this when the answer to a query may change: after adding types that
+ * existing types' methods recognize, or before freeing a queried "type_t".
+ */
+void type_subtype_memo_invalidate(void);
+
 #define CMP_WITH_TYPE_DEFAULT_DEEP (DEEP_RECURSE())
 
 int cmp_with_type_deep(const type_t *type, const tval *check, const tval *baseline, int deep);
 int cmp_with_type     (const type_t *type, const tval *check, const tval *baseline);
 
+#define HASH_WITH_TYPE_DEFAULT_DEEP (CMP_WITH_TYPE_DEFAULT_DEEP)
+
+size_t hash_with_type_deep(const type_t *type, const tval *val, int deep);
+size_t hash_with_type     (const type_t *type, const tval *val);
+
+/*
+ * Plain old data types: structs whose fields are plain old data, see
+ * "struct_info_pod_size", and that keep the struct "dup" and "cmp".  Their
+ * values are copied and compared as bytes.
+ *
+ * Returns the number of bytes, or 0 if "type" isn't plain old data.
+ */
+size_t type_pod_size(const type_t *type);
+
+/*
+ * Copy "num" constant-width values from "src" to "dest", as "type_dup"
+ * does with "defaults_src_unused".  Arrays of plain old data are copied in
+ * one call.  Returns "dest", or NULL on failure.
+ */
+tval *type_dup_array(const type_t *type, tval *dest, const tval *src, size_t num, int rec_copy, int dup_metadata);
+
+/*
+ * Allocate "num" values of "type" as one block, tracked as one allocation,
+ * and initialize each as "type_init" would with "cons", which may be NULL
+ * but must not provide "dest".  Each value gets its own memory tracking and
+ * metadata; arrays of plain old data are filled from the first value.
+ *
+ * Only for struct types that keep the standard "template_cons_t"
+ * initializer and freer.  Returns the first value, or NULL on failure,
+ * having freed whatever was initialized.
+ */
+tval *type_init_array(const type_t *type, template_cons_t *cons, size_t num);
+
+/*
+ * Free the "num" values of a block from "type_init_array": what each
+ * value's own memory tracker holds, and then the block.  Returns as "type_free" does for
+ * the first value, or 0 if "type" doesn't use the standard
+ * "template_cons_t" freer.
+ */
+size_t type_free_array(const type_t *type, tval *vals, size_t num);
+
 /* ---------------------------------------------------------------- */
 
 /*
@@ -65,6 +65,8 @@ static const type_t        *typed_type_is_supertype ( const type_t *self
                                                     );
 static const tval          *typed_type_has_default  (const type_t *self);
 
+static const struct type_registry_entry_s *typed_type_registry_entry = NULL;
+
 const type_t typed_type_def =
   { type_type
 
@@ -102,6 +104,10 @@ const type_t typed_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &typed_type_registry_entry
 
   , /* parity                 */ ""
   };
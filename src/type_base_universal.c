@@ -55,6 +55,8 @@ static const type_t *universal_type_is_subtype( const type_t *self
                                               , const type_t *is_subtype
                                               );
 
+static const struct type_registry_entry_s *universal_type_registry_entry = NULL;
+
 const type_t universal_type_def =
   { type_type
 
@@ -92,6 +94,10 @@ const type_t universal_type_def =
   , /* user                   */ NULL
   , /* cuser                  */ NULL
   , /* cmp                    */ NULL
+  , /* hash                   */ NULL
+  , /* deref                  */ NULL
+
+  , /* registry_entry         */ &universal_type_registry_entry
 
   , /* parity                 */ ""
   };